@@ -0,0 +1,452 @@
+#include "BVH.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <limits>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+// Deepest node, traversal stacks are sized from it
+#define BVH_MAX_DEPTH 64
+
+static float getHalfArea(const glm::vec3& _min, const glm::vec3& _max)
+{
+	glm::vec3 size = _max - _min;
+	return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+
+// Entry distance of the ray into the box, negative on a miss
+static float intersectBox(const glm::vec3& _origin, const glm::vec3& _inverseDirection, float _maxDistance, const glm::vec3& _min, const glm::vec3& _max)
+{
+	glm::vec3 t0 = (_min - _origin) * _inverseDirection;
+	glm::vec3 t1 = (_max - _origin) * _inverseDirection;
+	glm::vec3 tMin = glm::min(t0, t1);
+	glm::vec3 tMax = glm::max(t0, t1);
+
+	float entry = std::max(std::max(tMin.x, tMin.y), std::max(tMin.z, 0.0f));
+	float exit = std::min(std::min(tMax.x, tMax.y), std::min(tMax.z, _maxDistance));
+	return entry <= exit ? entry : -1.0f;
+}
+
+static bool intersectsSphere(const glm::vec3& _center, float _radiusSquared, const glm::vec3& _min, const glm::vec3& _max)
+{
+	glm::vec3 offset = glm::clamp(_center, _min, _max) - _center;
+	return glm::dot(offset, offset) <= _radiusSquared;
+}
+
+BVH::BVH()
+	: m_buildCost(1.0f)
+{
+	m_stats.Nodes = 0;
+	m_stats.Depth = 0;
+	m_stats.BuildMilliseconds = 0.0;
+	m_stats.RefitMilliseconds = 0.0;
+	m_stats.CostRatio = 1.0f;
+}
+
+void BVH::Build(const glm::vec3* _mins, const glm::vec3* _maxs, unsigned int _count)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	m_objectMin.assign(_mins, _mins + _count);
+	m_objectMax.assign(_maxs, _maxs + _count);
+	m_centroids.resize(_count);
+	m_indices.resize(_count);
+	for (unsigned int i = 0; i < _count; i++)
+	{
+		m_centroids[i] = (_mins[i] + _maxs[i]) * 0.5f;
+		m_indices[i] = i;
+	}
+
+	m_nodes.clear();
+	m_stats.Depth = 0;
+	if (_count > 0)
+	{
+		// A binary tree over n leaves never needs more than 2n - 1 nodes
+		m_nodes.reserve(2 * _count);
+
+		BVHNode root;
+		root.Left = 0;
+		root.First = 0;
+		root.Count = _count;
+		updateLeafBounds(root);
+		m_nodes.push_back(root);
+
+		subdivide(0, 1);
+	}
+
+	m_buildCost = std::max(computeCost(), std::numeric_limits<float>::min());
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+	m_stats.BuildMilliseconds = elapsed.count();
+	m_stats.Nodes = (unsigned int)m_nodes.size();
+	m_stats.CostRatio = 1.0f;
+}
+
+void BVH::updateLeafBounds(BVHNode& _node) const
+{
+	_node.Min = glm::vec3(std::numeric_limits<float>::max());
+	_node.Max = glm::vec3(-std::numeric_limits<float>::max());
+	for (unsigned int i = _node.First; i < _node.First + _node.Count; i++)
+	{
+		_node.Min = glm::min(_node.Min, m_objectMin[m_indices[i]]);
+		_node.Max = glm::max(_node.Max, m_objectMax[m_indices[i]]);
+	}
+}
+
+void BVH::subdivide(unsigned int _nodeIndex, unsigned int _depth)
+{
+	m_stats.Depth = std::max(m_stats.Depth, _depth);
+
+	unsigned int first = m_nodes[_nodeIndex].First;
+	unsigned int count = m_nodes[_nodeIndex].Count;
+	if (count <= BVH_LEAF_SIZE || _depth >= BVH_MAX_DEPTH)
+	{
+		return;
+	}
+
+	// Split candidates are the bin borders of the centroid bounds
+	glm::vec3 centroidMin = m_centroids[m_indices[first]];
+	glm::vec3 centroidMax = centroidMin;
+	for (unsigned int i = first + 1; i < first + count; i++)
+	{
+		centroidMin = glm::min(centroidMin, m_centroids[m_indices[i]]);
+		centroidMax = glm::max(centroidMax, m_centroids[m_indices[i]]);
+	}
+
+	int bestAxis = -1;
+	int bestSplit = 0;
+	float bestCost = std::numeric_limits<float>::max();
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float extent = centroidMax[axis] - centroidMin[axis];
+		if (extent <= 0.0f)
+		{
+			continue;
+		}
+
+		unsigned int binCount[BVH_BIN_COUNT] = {};
+		glm::vec3 binMin[BVH_BIN_COUNT];
+		glm::vec3 binMax[BVH_BIN_COUNT];
+		for (int bin = 0; bin < BVH_BIN_COUNT; bin++)
+		{
+			binMin[bin] = glm::vec3(std::numeric_limits<float>::max());
+			binMax[bin] = glm::vec3(-std::numeric_limits<float>::max());
+		}
+
+		float scale = BVH_BIN_COUNT / extent;
+		for (unsigned int i = first; i < first + count; i++)
+		{
+			unsigned int object = m_indices[i];
+			int bin = std::min(BVH_BIN_COUNT - 1, (int)((m_centroids[object][axis] - centroidMin[axis]) * scale));
+			binCount[bin]++;
+			binMin[bin] = glm::min(binMin[bin], m_objectMin[object]);
+			binMax[bin] = glm::max(binMax[bin], m_objectMax[object]);
+		}
+
+		// Sweep from both sides, split s puts bins [0, s] on the left
+		float leftArea[BVH_BIN_COUNT - 1], rightArea[BVH_BIN_COUNT - 1];
+		unsigned int leftCount[BVH_BIN_COUNT - 1], rightCount[BVH_BIN_COUNT - 1];
+		glm::vec3 leftMin(std::numeric_limits<float>::max()), leftMax(-std::numeric_limits<float>::max());
+		glm::vec3 rightMin(std::numeric_limits<float>::max()), rightMax(-std::numeric_limits<float>::max());
+		unsigned int leftSum = 0, rightSum = 0;
+		for (int i = 0; i < BVH_BIN_COUNT - 1; i++)
+		{
+			leftSum += binCount[i];
+			leftCount[i] = leftSum;
+			leftMin = glm::min(leftMin, binMin[i]);
+			leftMax = glm::max(leftMax, binMax[i]);
+			leftArea[i] = leftSum > 0 ? getHalfArea(leftMin, leftMax) : 0.0f;
+
+			int right = BVH_BIN_COUNT - 1 - i;
+			rightSum += binCount[right];
+			rightCount[right - 1] = rightSum;
+			rightMin = glm::min(rightMin, binMin[right]);
+			rightMax = glm::max(rightMax, binMax[right]);
+			rightArea[right - 1] = rightSum > 0 ? getHalfArea(rightMin, rightMax) : 0.0f;
+		}
+
+		for (int split = 0; split < BVH_BIN_COUNT - 1; split++)
+		{
+			float cost = leftCount[split] * leftArea[split] + rightCount[split] * rightArea[split];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = split;
+			}
+		}
+	}
+
+	// Keep the leaf when no split beats testing every object
+	float leafCost = count * getHalfArea(m_nodes[_nodeIndex].Min, m_nodes[_nodeIndex].Max);
+	if (bestAxis < 0 || bestCost >= leafCost)
+	{
+		return;
+	}
+
+	float scale = BVH_BIN_COUNT / (centroidMax[bestAxis] - centroidMin[bestAxis]);
+	unsigned int i = first;
+	unsigned int j = first + count;
+	while (i < j)
+	{
+		int bin = std::min(BVH_BIN_COUNT - 1, (int)((m_centroids[m_indices[i]][bestAxis] - centroidMin[bestAxis]) * scale));
+		if (bin <= bestSplit)
+		{
+			i++;
+		}
+		else
+		{
+			std::swap(m_indices[i], m_indices[--j]);
+		}
+	}
+
+	unsigned int leftCount = i - first;
+	if (leftCount == 0 || leftCount == count)
+	{
+		return;
+	}
+
+	unsigned int left = (unsigned int)m_nodes.size();
+	BVHNode child;
+	child.Left = 0;
+	child.First = first;
+	child.Count = leftCount;
+	updateLeafBounds(child);
+	m_nodes.push_back(child);
+
+	child.First = first + leftCount;
+	child.Count = count - leftCount;
+	updateLeafBounds(child);
+	m_nodes.push_back(child);
+
+	m_nodes[_nodeIndex].Left = left;
+	subdivide(left, _depth + 1);
+	subdivide(left + 1, _depth + 1);
+}
+
+float BVH::computeCost() const
+{
+	if (m_nodes.empty())
+	{
+		return 0.0f;
+	}
+
+	// Traversal steps weighted by the chance a random ray hits each node
+	float cost = 0.0f;
+	for (const BVHNode& node : m_nodes)
+	{
+		cost += getHalfArea(node.Min, node.Max) * (node.Left ? 1.0f : (float)node.Count);
+	}
+	return cost / std::max(getHalfArea(m_nodes[0].Min, m_nodes[0].Max), std::numeric_limits<float>::min());
+}
+
+void BVH::Refit(const glm::vec3* _mins, const glm::vec3* _maxs)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	std::copy(_mins, _mins + m_objectMin.size(), m_objectMin.begin());
+	std::copy(_maxs, _maxs + m_objectMax.size(), m_objectMax.begin());
+
+	// Children always come after their parent, so a reverse walk is bottom up
+	for (size_t i = m_nodes.size(); i-- > 0;)
+	{
+		BVHNode& node = m_nodes[i];
+		if (node.Left == 0)
+		{
+			updateLeafBounds(node);
+		}
+		else
+		{
+			node.Min = glm::min(m_nodes[node.Left].Min, m_nodes[node.Left + 1].Min);
+			node.Max = glm::max(m_nodes[node.Left].Max, m_nodes[node.Left + 1].Max);
+		}
+	}
+
+	m_stats.CostRatio = computeCost() / m_buildCost;
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+	m_stats.RefitMilliseconds = elapsed.count();
+}
+
+void BVH::QueryFrustum(const Frustum& _frustum, std::vector<unsigned int>& _result) const
+{
+	if (m_nodes.empty())
+	{
+		return;
+	}
+
+	unsigned int stack[BVH_MAX_DEPTH + 1];
+	unsigned int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const BVHNode& node = m_nodes[stack[--stackSize]];
+
+		FrustumTest test = _frustum.ClassifyBox(node.Min, node.Max);
+		if (test == FRUSTUM_OUTSIDE)
+		{
+			continue;
+		}
+
+		if (test == FRUSTUM_INSIDE)
+		{
+			// The whole subtree is a contiguous run of the index list
+			_result.insert(_result.end(), m_indices.begin() + node.First, m_indices.begin() + node.First + node.Count);
+		}
+		else if (node.Left == 0)
+		{
+			for (unsigned int i = node.First; i < node.First + node.Count; i++)
+			{
+				unsigned int object = m_indices[i];
+				if (_frustum.ClassifyBox(m_objectMin[object], m_objectMax[object]) != FRUSTUM_OUTSIDE)
+				{
+					_result.push_back(object);
+				}
+			}
+		}
+		else
+		{
+			stack[stackSize++] = node.Left;
+			stack[stackSize++] = node.Left + 1;
+		}
+	}
+}
+
+void BVH::QuerySphere(const glm::vec3& _center, float _radius, std::vector<unsigned int>& _result) const
+{
+	if (m_nodes.empty())
+	{
+		return;
+	}
+
+	float radiusSquared = _radius * _radius;
+
+	unsigned int stack[BVH_MAX_DEPTH + 1];
+	unsigned int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const BVHNode& node = m_nodes[stack[--stackSize]];
+		if (!intersectsSphere(_center, radiusSquared, node.Min, node.Max))
+		{
+			continue;
+		}
+
+		if (node.Left == 0)
+		{
+			for (unsigned int i = node.First; i < node.First + node.Count; i++)
+			{
+				unsigned int object = m_indices[i];
+				if (intersectsSphere(_center, radiusSquared, m_objectMin[object], m_objectMax[object]))
+				{
+					_result.push_back(object);
+				}
+			}
+		}
+		else
+		{
+			stack[stackSize++] = node.Left;
+			stack[stackSize++] = node.Left + 1;
+		}
+	}
+}
+
+bool BVH::Raycast(const glm::vec3& _origin, const glm::vec3& _direction, float _maxDistance, unsigned int& _index, float& _distance) const
+{
+	if (m_nodes.empty())
+	{
+		return false;
+	}
+
+	glm::vec3 inverseDirection = 1.0f / _direction;
+	float closest = _maxDistance;
+	bool hit = false;
+
+	unsigned int stack[BVH_MAX_DEPTH + 1];
+	unsigned int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const BVHNode& node = m_nodes[stack[--stackSize]];
+		if (intersectBox(_origin, inverseDirection, closest, node.Min, node.Max) < 0.0f)
+		{
+			continue;
+		}
+
+		if (node.Left == 0)
+		{
+			for (unsigned int i = node.First; i < node.First + node.Count; i++)
+			{
+				unsigned int object = m_indices[i];
+				float distance = intersectBox(_origin, inverseDirection, closest, m_objectMin[object], m_objectMax[object]);
+				if (distance >= 0.0f && distance <= closest)
+				{
+					closest = distance;
+					_index = object;
+					hit = true;
+				}
+			}
+		}
+		else
+		{
+			// Visit the nearer child first so it can shorten the ray for the other one
+			float leftDistance = intersectBox(_origin, inverseDirection, closest, m_nodes[node.Left].Min, m_nodes[node.Left].Max);
+			float rightDistance = intersectBox(_origin, inverseDirection, closest, m_nodes[node.Left + 1].Min, m_nodes[node.Left + 1].Max);
+			if (rightDistance < 0.0f || (leftDistance >= 0.0f && leftDistance <= rightDistance))
+			{
+				stack[stackSize++] = node.Left + 1;
+				stack[stackSize++] = node.Left;
+			}
+			else
+			{
+				stack[stackSize++] = node.Left;
+				stack[stackSize++] = node.Left + 1;
+			}
+		}
+	}
+
+	if (hit)
+	{
+		_distance = closest;
+	}
+	return hit;
+}
+
+void BVH::benchmark(unsigned int _count, double& _buildMilliseconds, double& _refitMilliseconds, double& _queryMilliseconds)
+{
+	// Boxes of 0.5 to 2.5 units in a 1000 unit cube around a camera at the origin looking down -z
+	std::vector<glm::vec3> mins(_count), maxs(_count);
+	for (unsigned int i = 0; i < _count; i++)
+	{
+		glm::vec3 center((float)rand() / RAND_MAX * 1000.0f - 500.0f, (float)rand() / RAND_MAX * 1000.0f - 500.0f, (float)rand() / RAND_MAX * 1000.0f - 500.0f);
+		glm::vec3 extents(0.25f + (float)rand() / RAND_MAX);
+		mins[i] = center - extents;
+		maxs[i] = center + extents;
+	}
+
+	BVH bvh;
+	bvh.Build(mins.data(), maxs.data(), _count);
+	_buildMilliseconds = bvh.getStats().BuildMilliseconds;
+
+	// Every object moves a little, like one frame of animation
+	for (unsigned int i = 0; i < _count; i++)
+	{
+		glm::vec3 offset((float)rand() / RAND_MAX - 0.5f, (float)rand() / RAND_MAX - 0.5f, (float)rand() / RAND_MAX - 0.5f);
+		mins[i] += offset;
+		maxs[i] += offset;
+	}
+	bvh.Refit(mins.data(), maxs.data());
+	_refitMilliseconds = bvh.getStats().RefitMilliseconds;
+
+	Frustum frustum;
+	frustum.Extract(glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 500.0f));
+	std::vector<unsigned int> visible;
+	visible.reserve(_count);
+
+	auto start = std::chrono::high_resolution_clock::now();
+	bvh.QueryFrustum(frustum, visible);
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+	_queryMilliseconds = elapsed.count();
+}
@@ -0,0 +1,75 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "Frustum.h"
+
+// Leaves stop splitting at this many objects
+#define BVH_LEAF_SIZE 4
+
+// Centroid bins per axis for the SAH split search
+#define BVH_BIN_COUNT 16
+
+struct BVHNode
+{
+	glm::vec3 Min;
+	unsigned int Left;		// left child, the right one follows it; 0 for leaves
+	glm::vec3 Max;
+	unsigned int First;		// objects [First, First + Count) of the index list, also for inner nodes
+	unsigned int Count;
+};
+
+struct BVHStats
+{
+	unsigned int Nodes;
+	unsigned int Depth;
+	double BuildMilliseconds;
+	double RefitMilliseconds;
+	float CostRatio;		// SAH cost now / after the last build, rebuild when refits drift it up
+};
+
+// Bounding volume hierarchy over object boxes.
+// Build() does a binned SAH split, Refit() keeps the topology and only moves the boxes,
+// so dynamic objects refit every frame and rebuild once the cost ratio gets too high.
+class BVH
+{
+public:
+	BVH();
+
+	void Build(const glm::vec3* _mins, const glm::vec3* _maxs, unsigned int _count);
+
+	// Same objects in the same order as the last Build
+	void Refit(const glm::vec3* _mins, const glm::vec3* _maxs);
+
+	// Queries append object indices to _result
+	void QueryFrustum(const Frustum& _frustum, std::vector<unsigned int>& _result) const;
+	void QuerySphere(const glm::vec3& _center, float _radius, std::vector<unsigned int>& _result) const;
+
+	// Closest object box hit along the ray within _maxDistance
+	bool Raycast(const glm::vec3& _origin, const glm::vec3& _direction, float _maxDistance, unsigned int& _index, float& _distance) const;
+
+	unsigned int getObjectCount() const { return (unsigned int)m_indices.size(); }
+	const BVHStats& getStats() const { return m_stats; }
+
+	// Build, refit and frustum query times in ms for _count random boxes
+	static void benchmark(unsigned int _count, double& _buildMilliseconds, double& _refitMilliseconds, double& _queryMilliseconds);
+
+private:
+	void subdivide(unsigned int _nodeIndex, unsigned int _depth);
+	void updateLeafBounds(BVHNode& _node) const;
+	float computeCost() const;
+
+	std::vector<BVHNode> m_nodes;
+	std::vector<unsigned int> m_indices;
+	std::vector<glm::vec3> m_objectMin;
+	std::vector<glm::vec3> m_objectMax;
+	std::vector<glm::vec3> m_centroids;
+
+	float m_buildCost;
+	BVHStats m_stats;
+};
+
+#endif
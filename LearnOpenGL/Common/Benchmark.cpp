@@ -0,0 +1,672 @@
+#include "Benchmark.h"
+#include "GLStateCache.h"
+#include "Shader.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// Yaw swing of the scripted camera either side of where the demo put it, in degrees
+#define BENCHMARK_PATH_YAW 30.0
+
+Benchmark* Benchmark::m_instance = nullptr;
+
+// Nearest rank percentile of sorted values
+static double getPercentile(const std::vector<double>& _sorted, double _percent)
+{
+	size_t rank = (size_t)std::ceil(_percent / 100.0 * _sorted.size());
+	return _sorted[std::min(std::max(rank, (size_t)1), _sorted.size()) - 1];
+}
+
+static std::string getString(GLenum _name)
+{
+	const GLubyte* value = glGetString(_name);
+	std::string result = value ? (const char*)value : "";
+	std::replace(result.begin(), result.end(), '"', '\'');
+	std::replace(result.begin(), result.end(), '\\', '/');
+	return result;
+}
+
+// Run length encoded 24 bit TGA, rows bottom up like glReadPixels, BGR on disk.
+// Packets stay within a row, renders have enough flat areas for the golden images to stay small
+static bool writeImage(const std::string& _path, int _width, int _height, const std::vector<unsigned char>& _rgb)
+{
+	std::ofstream file(_path.c_str(), std::ios::binary);
+	if (!file)
+	{
+		return false;
+	}
+
+	unsigned char header[18] = { 0, 0, 10 };
+	header[12] = (unsigned char)(_width & 0xFF);
+	header[13] = (unsigned char)(_width >> 8);
+	header[14] = (unsigned char)(_height & 0xFF);
+	header[15] = (unsigned char)(_height >> 8);
+	header[16] = 24;
+	file.write((const char*)header, sizeof(header));
+
+	std::vector<unsigned char> bgr(_rgb);
+	for (size_t i = 0; i + 2 < bgr.size(); i += 3)
+	{
+		std::swap(bgr[i], bgr[i + 2]);
+	}
+
+	std::vector<unsigned char> packets;
+	packets.reserve(bgr.size() / 4);
+	for (int y = 0; y < _height; y++)
+	{
+		const unsigned char* row = bgr.data() + (size_t)y * _width * 3;
+		int x = 0;
+		while (x < _width)
+		{
+			// Repeated pixels go in a run packet, anything else in a raw packet up to where the next run starts
+			int count = 1;
+			while (x + count < _width && count < 128 && std::memcmp(row + (x + count) * 3, row + x * 3, 3) == 0)
+			{
+				count++;
+			}
+			if (count > 1)
+			{
+				packets.push_back((unsigned char)(0x80 | (count - 1)));
+				packets.insert(packets.end(), row + x * 3, row + x * 3 + 3);
+				x += count;
+				continue;
+			}
+
+			while (x + count < _width && count < 128
+				&& (x + count + 1 == _width || std::memcmp(row + (x + count) * 3, row + (x + count + 1) * 3, 3) != 0))
+			{
+				count++;
+			}
+			packets.push_back((unsigned char)(count - 1));
+			packets.insert(packets.end(), row + x * 3, row + (x + count) * 3);
+			x += count;
+		}
+	}
+	file.write((const char*)packets.data(), packets.size());
+	return (bool)file;
+}
+
+// Reads back what writeImage() wrote, or the same without compression, nothing else
+static bool readImage(const std::string& _path, int& _width, int& _height, std::vector<unsigned char>& _rgb)
+{
+	std::ifstream file(_path.c_str(), std::ios::binary);
+	unsigned char header[18] = {};
+	if (!file.read((char*)header, sizeof(header)) || (header[2] != 2 && header[2] != 10) || header[16] != 24 || header[0] != 0)
+	{
+		return false;
+	}
+
+	_width = header[12] | (header[13] << 8);
+	_height = header[14] | (header[15] << 8);
+	_rgb.resize((size_t)_width * _height * 3);
+	if (header[2] == 2)
+	{
+		if (!file.read((char*)_rgb.data(), _rgb.size()))
+		{
+			return false;
+		}
+	}
+	else
+	{
+		size_t offset = 0;
+		while (offset < _rgb.size())
+		{
+			int packet = file.get();
+			if (packet == EOF)
+			{
+				return false;
+			}
+
+			size_t count = (size_t)(packet & 0x7F) + 1;
+			if (offset + count * 3 > _rgb.size())
+			{
+				return false;
+			}
+			if (packet & 0x80)
+			{
+				unsigned char pixel[3];
+				if (!file.read((char*)pixel, sizeof(pixel)))
+				{
+					return false;
+				}
+				for (size_t i = 0; i < count; i++, offset += 3)
+				{
+					std::memcpy(&_rgb[offset], pixel, sizeof(pixel));
+				}
+			}
+			else
+			{
+				if (!file.read((char*)&_rgb[offset], count * 3))
+				{
+					return false;
+				}
+				offset += count * 3;
+			}
+		}
+	}
+
+	for (size_t i = 0; i + 2 < _rgb.size(); i += 3)
+	{
+		std::swap(_rgb[i], _rgb[i + 2]);
+	}
+	return true;
+}
+
+Benchmark::Benchmark(int& _argc, char** _argv)
+	: m_enabled(false), m_microbench(false), m_frames(0), m_timestep(BENCHMARK_TIMESTEP), m_time(0.0), m_frame(0), m_started(false), m_loadMilliseconds(0.0),
+	m_yaw(0.0f), m_cameraPath(BENCHMARK_TIMESTEP), m_recording(BENCHMARK_TIMESTEP), m_updateGolden(false), m_imagesFailed(0), m_oldest(0), m_pending(0), m_counting(false)
+{
+	m_initTime = std::chrono::high_resolution_clock::now();
+	m_frameStart = m_initTime;
+
+	// Demo name from the executable, without directory and extension
+	m_demo = _argc > 0 ? _argv[0] : "LearnOpenGL";
+	m_demo = m_demo.substr(m_demo.find_last_of("/\\") + 1);
+	m_demo = m_demo.substr(0, m_demo.find_last_of('.'));
+
+	std::string context;
+	int kept = 1;
+	for (int i = 1; i < _argc; i++)
+	{
+		if (std::strcmp(_argv[i], "--benchmark") == 0)
+		{
+			m_enabled = true;
+		}
+		else if (std::strncmp(_argv[i], "--benchmark=", 12) == 0)
+		{
+			// Joined to the flag, a number after it stays an argument of the demo
+			m_enabled = true;
+			m_frames = (unsigned int)std::max(std::atoi(_argv[i] + 12), 0);
+		}
+		else if (std::strcmp(_argv[i], "--microbench") == 0)
+		{
+			m_microbench = true;
+		}
+		else if (std::strcmp(_argv[i], "--spirv") == 0)
+		{
+			Shader::setPreferSPIRV(true);
+		}
+		else if (std::strcmp(_argv[i], "--benchmark-out") == 0 && i + 1 < _argc)
+		{
+			m_path = _argv[++i];
+		}
+		else if (std::strcmp(_argv[i], "--benchmark-context") == 0 && i + 1 < _argc)
+		{
+			context = _argv[++i];
+		}
+		else if (std::strcmp(_argv[i], "--benchmark-camera") == 0 && i + 1 < _argc)
+		{
+			m_cameraPathName = _argv[++i];
+		}
+		else if (std::strcmp(_argv[i], "--record-camera") == 0 && i + 1 < _argc)
+		{
+			m_recordPath = _argv[++i];
+		}
+		else if (std::strcmp(_argv[i], "--benchmark-golden") == 0 && i + 1 < _argc)
+		{
+			m_goldenDirectory = _argv[++i];
+		}
+		else if (std::strcmp(_argv[i], "--benchmark-update-golden") == 0)
+		{
+			m_updateGolden = true;
+		}
+		else
+		{
+			_argv[kept++] = _argv[i];
+		}
+	}
+	if (_argc > 0)
+	{
+		_argc = kept;
+		_argv[_argc] = nullptr;
+	}
+
+	if (m_path.empty())
+	{
+		m_path = m_demo + "_Benchmark.json";
+	}
+
+	if (!m_enabled)
+	{
+		return;
+	}
+
+	// A recorded path sets the pace it was recorded at and, unless told otherwise, the length of the run
+	if (!m_cameraPathName.empty())
+	{
+		if (m_cameraPath.Load(m_cameraPathName))
+		{
+			m_timestep = m_cameraPath.getTimestep();
+			m_frames = m_frames > 0 ? m_frames : m_cameraPath.getFrameCount();
+		}
+		else
+		{
+			m_cameraPathName.clear();
+		}
+	}
+	m_frames = m_frames > 0 ? m_frames : BENCHMARK_DEFAULT_FRAMES;
+
+	// A run on another context than the one asked for would measure the wrong thing, so it does not run at all
+	bool contextAvailable = true;
+	glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+	if (context == "egl")
+	{
+#ifdef GLFW_EGL_CONTEXT_API
+		glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+#else
+		std::cout << "ERROR::BENCHMARK::EGL_NEEDS_GLFW_3.2" << std::endl;
+		contextAvailable = false;
+#endif
+	}
+	else if (context == "osmesa")
+	{
+#ifdef GLFW_OSMESA_CONTEXT_API
+		glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+#else
+		std::cout << "ERROR::BENCHMARK::OSMESA_NEEDS_GLFW_3.3" << std::endl;
+		contextAvailable = false;
+#endif
+	}
+	else if (!context.empty())
+	{
+		std::cout << "ERROR::BENCHMARK::UNKNOWN_CONTEXT " << context << std::endl;
+		contextAvailable = false;
+	}
+
+	if (!contextAvailable)
+	{
+		glfwTerminate();
+		std::exit(EXIT_FAILURE);
+	}
+
+	std::cout << "Benchmark: " << m_demo << ", " << m_frames << " frames" << std::endl;
+}
+
+Benchmark::~Benchmark()
+{
+	if (!m_recordPath.empty())
+	{
+		m_recording.Save(m_recordPath);
+	}
+
+	if (m_started)
+	{
+		glDeleteQueries(BENCHMARK_QUERIES, m_queries);
+	}
+}
+
+void Benchmark::Init(int& _argc, char** _argv)
+{
+	if (!m_instance)
+	{
+		m_instance = new Benchmark(_argc, _argv);
+	}
+}
+
+void Benchmark::Destroy()
+{
+	if (m_instance) {
+		delete m_instance;
+		m_instance = nullptr;
+	}
+}
+
+Benchmark* Benchmark::getInstance()
+{
+	if (!m_instance)
+	{
+		int argc = 0;
+		Init(argc, nullptr);
+	}
+	return m_instance;
+}
+
+void Benchmark::start()
+{
+	// Everything before the first frame counts as loading
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - m_initTime;
+	m_loadMilliseconds = elapsed.count();
+
+	glfwSwapInterval(0);
+	glGenQueries(BENCHMARK_QUERIES, m_queries);
+	m_frameMilliseconds.reserve(m_frames);
+	m_primitives.reserve(m_frames);
+	m_frameStart = std::chrono::high_resolution_clock::now();
+	m_started = true;
+
+	if (isComparingImages())
+	{
+		checkGoldenRenderer();
+	}
+}
+
+void Benchmark::checkGoldenRenderer()
+{
+	// Golden images only hold for the GL implementation that rendered them
+	std::string renderer = getString(GL_RENDERER);
+	std::string path = m_goldenDirectory + "/" + m_demo + "_renderer.txt";
+	if (m_updateGolden)
+	{
+		std::ofstream file(path.c_str());
+		file << renderer << "\n";
+		if (!file)
+		{
+			std::cout << "ERROR::BENCHMARK::FILE_NOT_WRITTEN " << path << std::endl;
+		}
+		m_goldenRenderer = renderer;
+		return;
+	}
+
+	std::ifstream file(path.c_str());
+	if (!std::getline(file, m_goldenRenderer))
+	{
+		std::cout << "ERROR::BENCHMARK::GOLDEN_NOT_FOUND " << path << std::endl;
+	}
+	else if (m_goldenRenderer != renderer)
+	{
+		std::cout << "ERROR::BENCHMARK::GOLDEN_RENDERER_MISMATCH golden images are from " << m_goldenRenderer << ", this run is on " << renderer << std::endl;
+	}
+}
+
+double Benchmark::getTime()
+{
+	if (!m_enabled)
+	{
+		m_time = glfwGetTime();
+		return m_time;
+	}
+
+	if (!m_started)
+	{
+		start();
+	}
+
+	// Every query still waits for the GPU, this frame goes uncounted rather than stalling
+	if (m_pending < BENCHMARK_QUERIES)
+	{
+		glBeginQuery(GL_PRIMITIVES_GENERATED, m_queries[(m_oldest + m_pending) % BENCHMARK_QUERIES]);
+		m_counting = true;
+	}
+
+	m_time = m_frame * m_timestep;
+	return m_time;
+}
+
+void Benchmark::Update(Camera& _camera)
+{
+	if (m_enabled && !m_cameraPathName.empty())
+	{
+		m_cameraPath.Apply(_camera, m_frame);
+	}
+	else if (m_enabled)
+	{
+		// Swings left and right while moving forth and back, one loop ends where it started
+		double phase = 2.0 * 3.14159265358979 * m_time / BENCHMARK_PATH_SECONDS;
+		float yaw = (float)(BENCHMARK_PATH_YAW * std::sin(phase));
+		_camera.ProcessMouseMovement((yaw - m_yaw) / _camera.MouseSensitiviy, 0.0f);
+		m_yaw = yaw;
+		_camera.ProcessKeyboard(std::cos(phase) >= 0.0 ? FORWARD : BACKWARD, (GLfloat)m_timestep);
+	}
+
+	if (!m_recordPath.empty())
+	{
+		m_recording.Record(_camera, m_time);
+	}
+}
+
+void Benchmark::EndFrame(GLFWwindow* _window)
+{
+	if (!m_enabled || !m_started)
+	{
+		return;
+	}
+
+	if (m_counting)
+	{
+		glEndQuery(GL_PRIMITIVES_GENERATED);
+		m_pending++;
+		m_counting = false;
+	}
+	readResults();
+
+	// From the end of the last frame, so the swap and the events are in
+	std::chrono::high_resolution_clock::time_point now = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double, std::milli> elapsed = now - m_frameStart;
+	m_frameMilliseconds.push_back(elapsed.count());
+	m_frameStart = now;
+
+	// The read back stalls, it is left out of the next frame's time
+	for (unsigned int i = 1; isComparingImages() && i <= BENCHMARK_GOLDEN_CAPTURES; i++)
+	{
+		if (std::max(m_frames * i / BENCHMARK_GOLDEN_CAPTURES, 1u) - 1 == m_frame)
+		{
+			compareImage(_window);
+			m_frameStart = std::chrono::high_resolution_clock::now();
+			break;
+		}
+	}
+
+	if (++m_frame < m_frames)
+	{
+		return;
+	}
+
+	// Last frame, the remaining counts are worth a wait
+	glFinish();
+	readResults();
+	writeReport();
+	glfwSetWindowShouldClose(_window, GL_TRUE);
+	m_enabled = false;
+}
+
+void Benchmark::readResults()
+{
+	while (m_pending > 0)
+	{
+		GLuint query = m_queries[m_oldest];
+		GLint available = 0;
+		glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+		{
+			return;
+		}
+
+		GLuint primitives = 0;
+		glGetQueryObjectuiv(query, GL_QUERY_RESULT, &primitives);
+		m_primitives.push_back(primitives);
+		m_oldest = (m_oldest + 1) % BENCHMARK_QUERIES;
+		m_pending--;
+	}
+}
+
+// Averages _factor x _factor squares of pixels into one, partial squares at the right and top edges are dropped
+static void downsampleImage(int& _width, int& _height, std::vector<unsigned char>& _rgb, int _factor)
+{
+	int width = _width / _factor;
+	int height = _height / _factor;
+	int area = _factor * _factor;
+	std::vector<unsigned char> result((size_t)width * height * 3);
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			for (int c = 0; c < 3; c++)
+			{
+				int sum = 0;
+				for (int sy = 0; sy < _factor; sy++)
+				{
+					const unsigned char* row = _rgb.data() + ((size_t)(y * _factor + sy) * _width + x * _factor) * 3;
+					for (int sx = 0; sx < _factor; sx++)
+					{
+						sum += row[sx * 3 + c];
+					}
+				}
+				result[((size_t)y * width + x) * 3 + c] = (unsigned char)((sum + area / 2) / area);
+			}
+		}
+	}
+
+	_width = width;
+	_height = height;
+	_rgb.swap(result);
+}
+
+void Benchmark::compareImage(GLFWwindow* _window)
+{
+	int width = 0;
+	int height = 0;
+	glfwGetFramebufferSize(_window, &width, &height);
+
+	std::vector<unsigned char> pixels((size_t)width * height * 3);
+	GLint alignment = 4;
+	glGetIntegerv(GL_PACK_ALIGNMENT, &alignment);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	GLStateCache::getInstance()->bindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+	glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+	glPixelStorei(GL_PACK_ALIGNMENT, alignment);
+	downsampleImage(width, height, pixels, BENCHMARK_GOLDEN_DOWNSAMPLE);
+
+	std::string name = m_demo + "_" + std::to_string(m_frame);
+	std::string golden = m_goldenDirectory + "/" + name + ".tga";
+	ImageResult result = { m_frame, "match", 0, 0.0 };
+
+	// What is rendered now becomes the reference, only when asked to
+	if (m_updateGolden)
+	{
+		result.Result = "updated";
+		if (!writeImage(golden, width, height, pixels))
+		{
+			std::cout << "ERROR::BENCHMARK::FILE_NOT_WRITTEN " << golden << std::endl;
+			result.Result = "error";
+			m_imagesFailed++;
+		}
+		m_images.push_back(result);
+		return;
+	}
+
+	int goldenWidth = 0;
+	int goldenHeight = 0;
+	std::vector<unsigned char> goldenPixels;
+	if (!readImage(golden, goldenWidth, goldenHeight, goldenPixels))
+	{
+		std::cout << "ERROR::BENCHMARK::GOLDEN_NOT_FOUND " << golden << std::endl;
+		result.Result = "missing";
+		m_imagesFailed++;
+		m_images.push_back(result);
+		return;
+	}
+
+	// Different pixels show red on a dimmed copy of the golden image
+	std::vector<unsigned char> diff(pixels.size(), 0);
+	if (goldenWidth != width || goldenHeight != height)
+	{
+		result.MaxDifference = 255;
+		result.DifferentPixels = 1.0;
+	}
+	else
+	{
+		size_t different = 0;
+		for (size_t i = 0; i < pixels.size(); i += 3)
+		{
+			int difference = 0;
+			for (size_t c = 0; c < 3; c++)
+			{
+				difference = std::max(difference, std::abs((int)pixels[i + c] - (int)goldenPixels[i + c]));
+				diff[i + c] = goldenPixels[i + c] / 4;
+			}
+
+			result.MaxDifference = std::max(result.MaxDifference, difference);
+			if (difference > BENCHMARK_GOLDEN_TOLERANCE)
+			{
+				different++;
+				diff[i] = 255;
+				diff[i + 1] = 0;
+				diff[i + 2] = 0;
+			}
+		}
+		result.DifferentPixels = pixels.empty() ? 0.0 : (double)different / (pixels.size() / 3);
+	}
+
+	if (result.DifferentPixels > BENCHMARK_GOLDEN_MAX_DIFFERENT)
+	{
+		result.Result = "mismatch";
+		m_imagesFailed++;
+
+		// Next to the report, to look at what changed
+		std::string directory = m_path.substr(0, m_path.find_last_of("/\\") + 1);
+		writeImage(directory + name + "_actual.tga", width, height, pixels);
+		writeImage(directory + name + "_diff.tga", width, height, diff);
+		std::cout << "ERROR::BENCHMARK::IMAGE_MISMATCH " << name << ", " << result.DifferentPixels * 100.0 << "% of the pixels differ" << std::endl;
+	}
+	m_images.push_back(result);
+}
+
+bool Benchmark::writeReport() const
+{
+	std::ofstream file(m_path.c_str());
+	if (!file)
+	{
+		std::cout << "ERROR::BENCHMARK::FILE_NOT_WRITTEN " << m_path << std::endl;
+		return false;
+	}
+
+	// Percentiles of the frames after the warm up, all of them when the run is that short
+	size_t warmup = m_frameMilliseconds.size() > BENCHMARK_WARMUP_FRAMES ? BENCHMARK_WARMUP_FRAMES : 0;
+	std::vector<double> sorted(m_frameMilliseconds.begin() + warmup, m_frameMilliseconds.end());
+	std::sort(sorted.begin(), sorted.end());
+	double total = 0.0;
+	for (double milliseconds : sorted)
+	{
+		total += milliseconds;
+	}
+
+	GLuint minPrimitives = m_primitives.empty() ? 0 : *std::min_element(m_primitives.begin(), m_primitives.end());
+	GLuint maxPrimitives = m_primitives.empty() ? 0 : *std::max_element(m_primitives.begin(), m_primitives.end());
+	double totalPrimitives = 0.0;
+	for (GLuint primitives : m_primitives)
+	{
+		totalPrimitives += primitives;
+	}
+
+	file.setf(std::ios::fixed);
+	file.precision(3);
+	file << "{\n";
+	file << "\t\"demo\": \"" << m_demo << "\",\n";
+	file << "\t\"renderer\": \"" << getString(GL_RENDERER) << "\",\n";
+	file << "\t\"version\": \"" << getString(GL_VERSION) << "\",\n";
+	file << "\t\"frames\": " << m_frameMilliseconds.size() << ",\n";
+	file << "\t\"warmupFrames\": " << warmup << ",\n";
+	file << "\t\"camera\": \"" << (m_cameraPathName.empty() ? std::string("scripted") : m_cameraPathName) << "\",\n";
+	file << "\t\"timestepMilliseconds\": " << m_timestep * 1000.0 << ",\n";
+	file << "\t\"loadMilliseconds\": " << m_loadMilliseconds << ",\n";
+	file << "\t\"frameMilliseconds\": { \"mean\": " << (sorted.empty() ? 0.0 : total / sorted.size());
+	if (!sorted.empty())
+	{
+		file << ", \"min\": " << sorted.front() << ", \"p50\": " << getPercentile(sorted, 50.0) << ", \"p90\": " << getPercentile(sorted, 90.0)
+			<< ", \"p95\": " << getPercentile(sorted, 95.0) << ", \"p99\": " << getPercentile(sorted, 99.0) << ", \"max\": " << sorted.back();
+	}
+	file << " },\n";
+	file << "\t\"primitives\": { \"frames\": " << m_primitives.size() << ", \"mean\": " << (m_primitives.empty() ? 0.0 : totalPrimitives / m_primitives.size())
+		<< ", \"min\": " << minPrimitives << ", \"max\": " << maxPrimitives << " },\n";
+	if (isComparingImages())
+	{
+		file << "\t\"goldenRenderer\": \"" << m_goldenRenderer << "\",\n";
+	}
+	file << "\t\"imagesFailed\": " << m_imagesFailed << ",\n";
+	file << "\t\"images\": [";
+	for (size_t i = 0; i < m_images.size(); i++)
+	{
+		const ImageResult& image = m_images[i];
+		file << (i == 0 ? "\n" : ",\n") << "\t\t{ \"frame\": " << image.Frame << ", \"result\": \"" << image.Result << "\", \"maxDifference\": " << image.MaxDifference
+			<< ", \"differentPercent\": " << image.DifferentPixels * 100.0 << " }";
+	}
+	file << (m_images.empty() ? "]\n" : "\n\t]\n");
+	file << "}\n";
+
+	std::cout << "Benchmark: " << m_demo << " written to " << m_path << std::endl;
+	return true;
+}
@@ -0,0 +1,152 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include "Camera.h"
+#include "CameraPath.h"
+
+// Frames rendered by "--benchmark" without a count or a camera path
+#define BENCHMARK_DEFAULT_FRAMES 600
+
+// First frames compile shaders and page in resources, they are timed but left out of the percentiles
+#define BENCHMARK_WARMUP_FRAMES 10
+
+// Fixed timestep of a benchmark frame and of recorded camera paths, in seconds
+#define BENCHMARK_TIMESTEP (1.0 / 60.0)
+
+// Length of one loop of the scripted camera, in seconds
+#define BENCHMARK_PATH_SECONDS 10.0
+
+// Queries in flight for the primitive counts, results are read back without stalling
+#define BENCHMARK_QUERIES 4
+
+// Frames of a run compared against golden images, evenly spread with the last one at the end
+#define BENCHMARK_GOLDEN_CAPTURES 4
+
+// Side of the pixel squares averaged into one before an image is compared or stored, keeps golden images small
+#define BENCHMARK_GOLDEN_DOWNSAMPLE 4
+
+// Channel difference out of 255 a pixel may have before it counts as different,
+// covers rounding and filtering differences between two runs of one GL implementation
+#define BENCHMARK_GOLDEN_TOLERANCE 8
+
+// Fraction of different pixels an image may have and still match
+#define BENCHMARK_GOLDEN_MAX_DIFFERENT 0.005
+
+// Runs a demo unattended for a fixed number of frames and writes what it measured as JSON.
+// With "--benchmark" or "--benchmark=frames" on the command line the window is hidden, vsync is off, time advances
+// by BENCHMARK_TIMESTEP per frame and the camera follows a scripted path, so two runs of a build
+// render the same frames. "--benchmark-out path" picks the JSON file, "--benchmark-context egl|osmesa"
+// the context API, osmesa needs no display at all and renders on the CPU. A context API this build of GLFW
+// cannot create ends the process with EXIT_FAILURE rather than benchmarking another context.
+// "--benchmark-camera path" replays a recorded CameraPath instead of the scripted camera, one step per
+// frame, for as many frames as it holds unless a count is given.
+// "--benchmark-golden dir" reads the backbuffer back at BENCHMARK_GOLDEN_CAPTURES frames, downsampled by
+// BENCHMARK_GOLDEN_DOWNSAMPLE, and compares it to <dir>/<demo>_<frame>.tga; mismatches are kept next to the
+// report with a diff image and counted in it, as are missing golden images.
+// <dir>/<demo>_renderer.txt names the GL_RENDERER they were rendered on, the report
+// carries it as "goldenRenderer" to check against its own. Golden images and renderer are only ever written
+// with "--benchmark-update-golden", which replaces them with what this run renders.
+// Without "--benchmark" every call passes through and the demo runs as usual; "--record-camera path"
+// then records the camera of the session, written when the demo exits.
+// "--spirv" loads shaders from their SPIR-V modules where it can, see Shader::setPreferSPIRV().
+// "--microbench" runs the CPU microbenchmarks some demos have at startup, they are skipped otherwise
+// so they neither slow every launch down nor end up in the load time.
+//
+// Init() right after glfwInit(), getTime() for the frame time, Update() after the input,
+// EndFrame() before the swap, Destroy() before the GL context goes away.
+class Benchmark
+{
+private:
+
+	static Benchmark *m_instance;
+
+	Benchmark(int& _argc, char** _argv);
+
+	~Benchmark();
+
+public:
+
+	// Removes the arguments it understands, the demo parses what is left
+	static void Init(int& _argc, char** _argv);
+	static void Destroy();
+
+	static Benchmark* getInstance();
+
+	bool isEnabled() const { return m_enabled; }
+
+	// Startup microbenchmarks were asked for, independent of --benchmark
+	bool isMicrobenchmarking() const { return m_microbench; }
+
+	// Frames are compared to golden images, anything that changes the output from run to run has to hold still
+	bool isComparingImages() const { return m_enabled && !m_goldenDirectory.empty(); }
+
+	// glfwGetTime() as a demo sees it, the first call ends the load time
+	double getTime();
+
+	// Drives the camera along the scripted or recorded path, overriding the input of this frame,
+	// and records where it ended up when asked to
+	void Update(Camera& _camera);
+
+	// Records the frame, writes the report and closes the window after the last one
+	void EndFrame(GLFWwindow* _window);
+
+private:
+	struct ImageResult
+	{
+		unsigned int Frame;
+		const char* Result;		// "match", "mismatch", "missing", "updated", or "error" when it could not be written
+		int MaxDifference;
+		double DifferentPixels;	// fraction of the image
+	};
+
+	void start();
+	void checkGoldenRenderer();
+	void readResults();
+	void compareImage(GLFWwindow* _window);
+	bool writeReport() const;
+
+	bool m_enabled;
+	bool m_microbench;
+	unsigned int m_frames;
+	std::string m_demo;
+	std::string m_path;
+	double m_timestep;
+	double m_time;		// of the current frame
+
+	unsigned int m_frame;
+	bool m_started;
+	std::chrono::high_resolution_clock::time_point m_initTime;
+	std::chrono::high_resolution_clock::time_point m_frameStart;
+	double m_loadMilliseconds;
+
+	float m_yaw;		// scripted yaw offset applied so far, in degrees
+
+	CameraPath m_cameraPath;
+	std::string m_cameraPathName;	// played back, empty for the scripted camera
+	CameraPath m_recording;
+	std::string m_recordPath;		// recorded to, empty when not recording
+
+	std::string m_goldenDirectory;	// empty when images are not compared
+	bool m_updateGolden;
+	std::string m_goldenRenderer;	// read from the golden directory, empty when it has none
+	std::vector<ImageResult> m_images;
+	unsigned int m_imagesFailed;
+
+	std::vector<double> m_frameMilliseconds;
+	std::vector<GLuint> m_primitives;
+
+	// Ring of GL_PRIMITIVES_GENERATED queries, oldest pending at m_oldest
+	GLuint m_queries[BENCHMARK_QUERIES];
+	unsigned int m_oldest;
+	unsigned int m_pending;
+	bool m_counting;
+};
+
+#endif
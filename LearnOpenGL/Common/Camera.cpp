@@ -86,6 +86,16 @@ void Camera::ProcessMouseScroll(GLfloat yoffset)
 	Zoom = glm::clamp(Zoom, 1.0f, 45.0f);
 }
 
+void Camera::SetState(glm::vec3 position, GLfloat yaw, GLfloat pitch, GLfloat zoom)
+{
+	this->Position = position;
+	this->Yaw = yaw;
+	this->Pitch = pitch;
+	this->Zoom = zoom;
+
+	this->UpdateCameraVectors();
+}
+
 void Camera::UpdateCameraVectors()
 {
 	// Calculate the new Front Vector
@@ -56,6 +56,9 @@ public:
 
 	void ProcessMouseScroll(GLfloat yoffset);
 
+	// Jump to a recorded state, e.g. from a CameraPath
+	void SetState(glm::vec3 position, GLfloat yaw, GLfloat pitch, GLfloat zoom);
+
 private:
 
 	void UpdateCameraVectors();
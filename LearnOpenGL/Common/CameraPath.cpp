@@ -0,0 +1,153 @@
+#include "CameraPath.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+static const char s_magic[4] = { 'C', 'A', 'M', 'P' };
+
+static CameraPathFrame getFrame(const Camera& _camera)
+{
+	CameraPathFrame frame;
+	frame.Position = _camera.Position;
+	frame.Yaw = _camera.Yaw;
+	frame.Pitch = _camera.Pitch;
+	frame.Zoom = _camera.Zoom;
+	return frame;
+}
+
+CameraPath::CameraPath(double _timestep)
+	: m_timestep(_timestep), m_lastTime(0.0), m_startTime(-1.0)
+{
+	m_last = CameraPathFrame();
+}
+
+void CameraPath::Clear()
+{
+	m_frames.clear();
+	m_startTime = -1.0;
+}
+
+void CameraPath::Record(const Camera& _camera, double _time)
+{
+	CameraPathFrame current = getFrame(_camera);
+	if (m_startTime < 0.0)
+	{
+		m_startTime = _time;
+		m_lastTime = 0.0;
+		m_last = current;
+		m_frames.push_back(current);
+		return;
+	}
+
+	// Camera never wraps the yaw, so a lerp of the angles follows the turn that actually happened
+	double time = _time - m_startTime;
+	double span = time - m_lastTime;
+	while (m_frames.size() * m_timestep <= time)
+	{
+		double stepTime = m_frames.size() * m_timestep;
+		float t = span > 0.0 ? (float)((stepTime - m_lastTime) / span) : 1.0f;
+
+		CameraPathFrame frame;
+		frame.Position = glm::mix(m_last.Position, current.Position, t);
+		frame.Yaw = glm::mix(m_last.Yaw, current.Yaw, t);
+		frame.Pitch = glm::mix(m_last.Pitch, current.Pitch, t);
+		frame.Zoom = glm::mix(m_last.Zoom, current.Zoom, t);
+		m_frames.push_back(frame);
+	}
+
+	m_last = current;
+	m_lastTime = time;
+}
+
+void CameraPath::Apply(Camera& _camera, unsigned int _frame) const
+{
+	if (m_frames.empty())
+	{
+		return;
+	}
+
+	const CameraPathFrame& frame = m_frames[std::min(_frame, (unsigned int)m_frames.size() - 1)];
+	_camera.SetState(frame.Position, frame.Yaw, frame.Pitch, frame.Zoom);
+}
+
+bool CameraPath::Save(const std::string& _path) const
+{
+	std::ofstream file(_path.c_str(), std::ios::binary);
+	if (!file)
+	{
+		std::cout << "ERROR::CAMERA_PATH::FILE_NOT_WRITTEN " << _path << std::endl;
+		return false;
+	}
+
+	unsigned int version = CAMERA_PATH_VERSION;
+	unsigned int count = (unsigned int)m_frames.size();
+	file.write(s_magic, sizeof(s_magic));
+	file.write((const char*)&version, sizeof(version));
+	file.write((const char*)&count, sizeof(count));
+	file.write((const char*)&m_timestep, sizeof(m_timestep));
+	for (const CameraPathFrame& frame : m_frames)
+	{
+		GLfloat values[6] = { frame.Position.x, frame.Position.y, frame.Position.z, frame.Yaw, frame.Pitch, frame.Zoom };
+		file.write((const char*)values, sizeof(values));
+	}
+
+	std::cout << "Camera path: " << count << " frames written to " << _path << std::endl;
+	return true;
+}
+
+bool CameraPath::Load(const std::string& _path)
+{
+	std::ifstream file(_path.c_str(), std::ios::binary);
+	if (!file)
+	{
+		std::cout << "ERROR::CAMERA_PATH::FILE_NOT_FOUND " << _path << std::endl;
+		return false;
+	}
+
+	char magic[4] = {};
+	unsigned int version = 0;
+	unsigned int count = 0;
+	double timestep = 0.0;
+	file.read(magic, sizeof(magic));
+	file.read((char*)&version, sizeof(version));
+	file.read((char*)&count, sizeof(count));
+	file.read((char*)&timestep, sizeof(timestep));
+	if (!file || std::memcmp(magic, s_magic, sizeof(magic)) != 0 || version != CAMERA_PATH_VERSION || timestep <= 0.0)
+	{
+		std::cout << "ERROR::CAMERA_PATH::BAD_HEADER " << _path << std::endl;
+		return false;
+	}
+
+	// The count comes from the file, it is only trusted as far as the file holds that many frames
+	std::streampos framesStart = file.tellg();
+	file.seekg(0, std::ios::end);
+	std::streamoff remaining = file.tellg() - framesStart;
+	file.seekg(framesStart);
+	if (remaining < 0 || (unsigned long long)count * CAMERA_PATH_FRAME_BYTES > (unsigned long long)remaining)
+	{
+		std::cout << "ERROR::CAMERA_PATH::TRUNCATED " << _path << std::endl;
+		return false;
+	}
+
+	std::vector<CameraPathFrame> frames(count);
+	for (CameraPathFrame& frame : frames)
+	{
+		GLfloat values[6];
+		file.read((char*)values, sizeof(values));
+		frame.Position = glm::vec3(values[0], values[1], values[2]);
+		frame.Yaw = values[3];
+		frame.Pitch = values[4];
+		frame.Zoom = values[5];
+	}
+	if (!file)
+	{
+		std::cout << "ERROR::CAMERA_PATH::TRUNCATED " << _path << std::endl;
+		return false;
+	}
+
+	m_frames.swap(frames);
+	m_timestep = timestep;
+	return true;
+}
@@ -0,0 +1,60 @@
+#ifndef CAMERA_PATH_H
+#define CAMERA_PATH_H
+
+#include <string>
+#include <vector>
+
+#include "Camera.h"
+
+// Bumped whenever the file layout changes, older files are refused
+#define CAMERA_PATH_VERSION 1
+
+// Size of one frame on disk, position, yaw, pitch and zoom as floats
+#define CAMERA_PATH_FRAME_BYTES (6 * sizeof(GLfloat))
+
+// Camera state at one fixed step of a path, CAMERA_PATH_FRAME_BYTES on disk
+struct CameraPathFrame
+{
+	glm::vec3 Position;
+	GLfloat Yaw;
+	GLfloat Pitch;
+	GLfloat Zoom;
+};
+
+// Camera motion sampled at a fixed timestep, recorded from a live session and played back frame by frame.
+// Recording stores the state rather than the input, so playback does not depend on the frame rate of
+// either run: Record() resamples whatever the live frames were onto the fixed steps, Apply() puts the
+// camera of step N in place. The file is a small header followed by the raw frames, little endian.
+class CameraPath
+{
+public:
+	CameraPath(double _timestep);
+
+	// Starts a recording, the first Record() is step 0
+	void Clear();
+
+	// Adds the steps between the last call and _time, interpolating the camera from its last state
+	void Record(const Camera& _camera, double _time);
+
+	// Camera of step _frame, held at the last step past the end
+	void Apply(Camera& _camera, unsigned int _frame) const;
+
+	bool Save(const std::string& _path) const;
+
+	// Keeps the path as it was if the file cannot be read
+	bool Load(const std::string& _path);
+
+	unsigned int getFrameCount() const { return (unsigned int)m_frames.size(); }
+	double getTimestep() const { return m_timestep; }
+
+private:
+	double m_timestep;
+	std::vector<CameraPathFrame> m_frames;
+
+	// Live state of the previous Record() and the time it was taken at, relative to the first one
+	CameraPathFrame m_last;
+	double m_lastTime;
+	double m_startTime;
+};
+
+#endif
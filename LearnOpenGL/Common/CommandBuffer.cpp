@@ -0,0 +1,249 @@
+#include "CommandBuffer.h"
+#include "GLStateCache.h"
+#include "JobSystem.h"
+#include "Shader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+// Payloads, stored right after their header
+struct UseShaderCommand { Shader* Program; };
+struct BindVertexArrayCommand { GLuint VAO; };
+struct BindTextureCommand { unsigned int Unit; GLenum Target; GLuint Texture; };
+struct SetIntCommand { const char* Name; int Value; };
+struct SetFloatCommand { const char* Name; float Value; };
+struct SetVec3Command { const char* Name; float Value[3]; };
+struct SetMat4Command { const char* Name; float Value[16]; };
+struct UpdateUniformBufferCommand { GLuint Buffer; unsigned int Offset; unsigned int Size; };	// followed by Size bytes
+struct DrawArraysCommand { GLenum Mode; GLint First; GLsizei Count; };
+struct DrawElementsCommand { GLenum Mode; GLsizei Count; unsigned int FirstIndex; GLsizei InstanceCount; };
+
+CommandBuffer::CommandBuffer()
+	: m_commandCount(0)
+{
+}
+
+void CommandBuffer::Reset()
+{
+	m_data.clear();
+	m_commandCount = 0;
+}
+
+void* CommandBuffer::allocate(CommandType _type, unsigned int _size)
+{
+	// Keep every header and payload 8 byte aligned for the pointers they hold
+	unsigned int paddedSize = (_size + 7) & ~7u;
+
+	size_t offset = m_data.size();
+	m_data.resize(offset + sizeof(CommandHeader) + paddedSize);
+
+	CommandHeader* header = reinterpret_cast<CommandHeader*>(&m_data[offset]);
+	header->Type = _type;
+	header->Size = paddedSize;
+
+	m_commandCount++;
+	return &m_data[offset + sizeof(CommandHeader)];
+}
+
+void CommandBuffer::useShader(Shader* _shader)
+{
+	UseShaderCommand* command = static_cast<UseShaderCommand*>(allocate(COMMAND_USE_SHADER, sizeof(UseShaderCommand)));
+	command->Program = _shader;
+}
+
+void CommandBuffer::bindVertexArray(GLuint _vao)
+{
+	BindVertexArrayCommand* command = static_cast<BindVertexArrayCommand*>(allocate(COMMAND_BIND_VERTEX_ARRAY, sizeof(BindVertexArrayCommand)));
+	command->VAO = _vao;
+}
+
+void CommandBuffer::bindTexture(unsigned int _unit, GLenum _target, GLuint _texture)
+{
+	BindTextureCommand* command = static_cast<BindTextureCommand*>(allocate(COMMAND_BIND_TEXTURE, sizeof(BindTextureCommand)));
+	command->Unit = _unit;
+	command->Target = _target;
+	command->Texture = _texture;
+}
+
+void CommandBuffer::setInt(const char* _name, int _value)
+{
+	SetIntCommand* command = static_cast<SetIntCommand*>(allocate(COMMAND_SET_INT, sizeof(SetIntCommand)));
+	command->Name = _name;
+	command->Value = _value;
+}
+
+void CommandBuffer::setFloat(const char* _name, float _value)
+{
+	SetFloatCommand* command = static_cast<SetFloatCommand*>(allocate(COMMAND_SET_FLOAT, sizeof(SetFloatCommand)));
+	command->Name = _name;
+	command->Value = _value;
+}
+
+void CommandBuffer::setVec3(const char* _name, const glm::vec3& _value)
+{
+	SetVec3Command* command = static_cast<SetVec3Command*>(allocate(COMMAND_SET_VEC3, sizeof(SetVec3Command)));
+	command->Name = _name;
+	command->Value[0] = _value.x;
+	command->Value[1] = _value.y;
+	command->Value[2] = _value.z;
+}
+
+void CommandBuffer::setMat4(const char* _name, const glm::mat4& _value)
+{
+	SetMat4Command* command = static_cast<SetMat4Command*>(allocate(COMMAND_SET_MAT4, sizeof(SetMat4Command)));
+	command->Name = _name;
+	memcpy(command->Value, &_value[0][0], sizeof(command->Value));
+}
+
+void CommandBuffer::updateUniformBuffer(GLuint _buffer, unsigned int _offset, const void* _data, unsigned int _size)
+{
+	UpdateUniformBufferCommand* command = static_cast<UpdateUniformBufferCommand*>(allocate(COMMAND_UPDATE_UNIFORM_BUFFER, sizeof(UpdateUniformBufferCommand) + _size));
+	command->Buffer = _buffer;
+	command->Offset = _offset;
+	command->Size = _size;
+	memcpy(command + 1, _data, _size);
+}
+
+void CommandBuffer::drawArrays(GLenum _mode, GLint _first, GLsizei _count)
+{
+	DrawArraysCommand* command = static_cast<DrawArraysCommand*>(allocate(COMMAND_DRAW_ARRAYS, sizeof(DrawArraysCommand)));
+	command->Mode = _mode;
+	command->First = _first;
+	command->Count = _count;
+}
+
+void CommandBuffer::drawElements(GLenum _mode, GLsizei _count, unsigned int _firstIndex)
+{
+	DrawElementsCommand* command = static_cast<DrawElementsCommand*>(allocate(COMMAND_DRAW_ELEMENTS, sizeof(DrawElementsCommand)));
+	command->Mode = _mode;
+	command->Count = _count;
+	command->FirstIndex = _firstIndex;
+	command->InstanceCount = 1;
+}
+
+void CommandBuffer::drawElementsInstanced(GLenum _mode, GLsizei _count, unsigned int _firstIndex, GLsizei _instanceCount)
+{
+	DrawElementsCommand* command = static_cast<DrawElementsCommand*>(allocate(COMMAND_DRAW_ELEMENTS_INSTANCED, sizeof(DrawElementsCommand)));
+	command->Mode = _mode;
+	command->Count = _count;
+	command->FirstIndex = _firstIndex;
+	command->InstanceCount = _instanceCount;
+}
+
+void CommandBuffer::Execute() const
+{
+	GLStateCache* state = GLStateCache::getInstance();
+	Shader* shader = nullptr;
+
+	size_t offset = 0;
+	while (offset < m_data.size())
+	{
+		const CommandHeader* header = reinterpret_cast<const CommandHeader*>(&m_data[offset]);
+		const void* payload = &m_data[offset + sizeof(CommandHeader)];
+		offset += sizeof(CommandHeader) + header->Size;
+
+		switch (header->Type)
+		{
+		case COMMAND_USE_SHADER:
+			shader = static_cast<const UseShaderCommand*>(payload)->Program;
+			shader->Use();
+			break;
+		case COMMAND_BIND_VERTEX_ARRAY:
+			state->bindVertexArray(static_cast<const BindVertexArrayCommand*>(payload)->VAO);
+			break;
+		case COMMAND_BIND_TEXTURE:
+		{
+			const BindTextureCommand* command = static_cast<const BindTextureCommand*>(payload);
+			state->bindTextureUnit(command->Unit, command->Target, command->Texture);
+			break;
+		}
+		case COMMAND_SET_INT:
+		{
+			const SetIntCommand* command = static_cast<const SetIntCommand*>(payload);
+			shader->setInt(command->Name, command->Value);
+			break;
+		}
+		case COMMAND_SET_FLOAT:
+		{
+			const SetFloatCommand* command = static_cast<const SetFloatCommand*>(payload);
+			shader->setFloat(command->Name, command->Value);
+			break;
+		}
+		case COMMAND_SET_VEC3:
+		{
+			const SetVec3Command* command = static_cast<const SetVec3Command*>(payload);
+			shader->setVec3(command->Name, glm::vec3(command->Value[0], command->Value[1], command->Value[2]));
+			break;
+		}
+		case COMMAND_SET_MAT4:
+		{
+			const SetMat4Command* command = static_cast<const SetMat4Command*>(payload);
+			glm::mat4 value;
+			memcpy(&value[0][0], command->Value, sizeof(command->Value));
+			shader->setMat4(command->Name, value);
+			break;
+		}
+		case COMMAND_UPDATE_UNIFORM_BUFFER:
+		{
+			const UpdateUniformBufferCommand* command = static_cast<const UpdateUniformBufferCommand*>(payload);
+			glBindBuffer(GL_UNIFORM_BUFFER, command->Buffer);
+			glBufferSubData(GL_UNIFORM_BUFFER, command->Offset, command->Size, command + 1);
+			break;
+		}
+		case COMMAND_DRAW_ARRAYS:
+		{
+			const DrawArraysCommand* command = static_cast<const DrawArraysCommand*>(payload);
+			glDrawArrays(command->Mode, command->First, command->Count);
+			break;
+		}
+		case COMMAND_DRAW_ELEMENTS:
+		{
+			const DrawElementsCommand* command = static_cast<const DrawElementsCommand*>(payload);
+			glDrawElements(command->Mode, command->Count, GL_UNSIGNED_INT, (void*)(command->FirstIndex * sizeof(GLuint)));
+			break;
+		}
+		case COMMAND_DRAW_ELEMENTS_INSTANCED:
+		{
+			const DrawElementsCommand* command = static_cast<const DrawElementsCommand*>(payload);
+			glDrawElementsInstanced(command->Mode, command->Count, GL_UNSIGNED_INT, (void*)(command->FirstIndex * sizeof(GLuint)), command->InstanceCount);
+			break;
+		}
+		default:
+			std::cout << "ERROR::COMMAND_BUFFER::UNKNOWN_COMMAND " << header->Type << std::endl;
+			return;
+		}
+	}
+}
+
+void CommandBuffer::RecordParallel(std::vector<CommandBuffer>& _buffers, unsigned int _itemCount,
+	const std::function<void(CommandBuffer&, unsigned int, unsigned int)>& _record)
+{
+	if (_buffers.empty())
+	{
+		return;
+	}
+
+	unsigned int bufferCount = (unsigned int)_buffers.size();
+	unsigned int sliceSize = (_itemCount + bufferCount - 1) / bufferCount;
+
+	JobSystem::getInstance()->ParallelFor(bufferCount, 1, [&](unsigned int _begin, unsigned int _end)
+	{
+		for (unsigned int i = _begin; i < _end; i++)
+		{
+			_buffers[i].Reset();
+
+			unsigned int begin = std::min(i * sliceSize, _itemCount);
+			unsigned int end = std::min(begin + sliceSize, _itemCount);
+			_record(_buffers[i], begin, end);
+		}
+	});
+}
+
+void CommandBuffer::ExecuteAll(const std::vector<CommandBuffer>& _buffers)
+{
+	for (const CommandBuffer& buffer : _buffers)
+	{
+		buffer.Execute();
+	}
+}
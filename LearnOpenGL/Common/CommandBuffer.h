@@ -0,0 +1,83 @@
+#ifndef COMMAND_BUFFER_H
+#define COMMAND_BUFFER_H
+
+#include <vector>
+#include <functional>
+
+#include <GL/glew.h>
+
+#include "glm/glm.hpp"
+
+class Shader;
+
+enum CommandType
+{
+	COMMAND_USE_SHADER = 0,
+	COMMAND_BIND_VERTEX_ARRAY,
+	COMMAND_BIND_TEXTURE,
+	COMMAND_SET_INT,
+	COMMAND_SET_FLOAT,
+	COMMAND_SET_VEC3,
+	COMMAND_SET_MAT4,
+	COMMAND_UPDATE_UNIFORM_BUFFER,
+	COMMAND_DRAW_ARRAYS,
+	COMMAND_DRAW_ELEMENTS,
+	COMMAND_DRAW_ELEMENTS_INSTANCED
+};
+
+// Linear list of draw commands.
+// Recording only writes plain data and never touches GL or the Shader objects,
+// so any thread can fill its own buffer. Execute() must run on the thread owning the context.
+// Uniform names are kept as pointers, they have to outlive the buffer (literals, Mesh bindings).
+class CommandBuffer
+{
+public:
+	CommandBuffer();
+
+	// Drop recorded commands, memory is kept for the next frame
+	void Reset();
+
+	void useShader(Shader* _shader);
+	void bindVertexArray(GLuint _vao);
+	void bindTexture(unsigned int _unit, GLenum _target, GLuint _texture);
+
+	// Uniforms of the shader selected last in this buffer
+	void setInt(const char* _name, int _value);
+	void setFloat(const char* _name, float _value);
+	void setVec3(const char* _name, const glm::vec3& _value);
+	void setMat4(const char* _name, const glm::mat4& _value);
+
+	// The data is copied into the buffer, uploaded with glBufferSubData on replay
+	void updateUniformBuffer(GLuint _buffer, unsigned int _offset, const void* _data, unsigned int _size);
+
+	void drawArrays(GLenum _mode, GLint _first, GLsizei _count);
+	void drawElements(GLenum _mode, GLsizei _count, unsigned int _firstIndex);
+	void drawElementsInstanced(GLenum _mode, GLsizei _count, unsigned int _firstIndex, GLsizei _instanceCount);
+
+	// Replay every command in order, GL thread only
+	void Execute() const;
+
+	unsigned int getCommandCount() const { return m_commandCount; }
+	size_t getSize() const { return m_data.size(); }
+
+	// Split [0, _itemCount) in one slice per buffer and record the slices as jobs on the JobSystem,
+	// the calling thread records slices too. Buffers are reset first.
+	static void RecordParallel(std::vector<CommandBuffer>& _buffers, unsigned int _itemCount,
+		const std::function<void(CommandBuffer&, unsigned int, unsigned int)>& _record);
+
+	static void ExecuteAll(const std::vector<CommandBuffer>& _buffers);
+
+private:
+	struct CommandHeader
+	{
+		unsigned int Type;
+		unsigned int Size;	// payload bytes following the header, multiple of 8
+	};
+
+	void* allocate(CommandType _type, unsigned int _size);
+
+	std::vector<unsigned char> m_data;
+	unsigned int m_commandCount;
+};
+
+#endif
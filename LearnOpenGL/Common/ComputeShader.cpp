@@ -0,0 +1,141 @@
+#include "ComputeShader.h"
+#include "GLStateCache.h"
+
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <vector>
+
+#include "glm/gtc/type_ptr.hpp"
+
+ComputeShader::ComputeShader(const GLchar* computePath)
+	: Program(0), m_path(computePath)
+{
+	if (!isSupported())
+	{
+		std::cout << "ERROR::COMPUTE_SHADER::NOT_SUPPORTED " << m_path << std::endl;
+		return;
+	}
+
+	std::string code;
+	std::ifstream shaderFile;
+	shaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+	try
+	{
+		shaderFile.open(computePath);
+		std::stringstream shaderStream;
+		shaderStream << shaderFile.rdbuf();
+		shaderFile.close();
+		code = shaderStream.str();
+	}
+	catch (std::ifstream::failure e)
+	{
+		std::cout << "ERROR::COMPUTE_SHADER::FILE_NOT_SUCCESSFULLY_READ " << m_path << std::endl;
+		return;
+	}
+
+	const GLchar* shaderCode = code.c_str();
+	GLint success;
+
+	GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+	glShaderSource(shader, 1, &shaderCode, NULL);
+	glCompileShader(shader);
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+	if (!success)
+	{
+		GLint logLength = 0;
+		glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logLength);
+		std::vector<GLchar> infoLog(logLength > 0 ? logLength : 1, '\0');
+		glGetShaderInfoLog(shader, (GLsizei)infoLog.size(), NULL, infoLog.data());
+		std::cout << "ERROR::COMPUTE_SHADER::COMPILATION_FAILED " << m_path << "\n" << infoLog.data() << std::endl;
+		glDeleteShader(shader);
+		return;
+	}
+
+	Program = glCreateProgram();
+	glAttachShader(Program, shader);
+	glLinkProgram(Program);
+	glDeleteShader(shader);
+
+	glGetProgramiv(Program, GL_LINK_STATUS, &success);
+	if (!success)
+	{
+		GLint logLength = 0;
+		glGetProgramiv(Program, GL_INFO_LOG_LENGTH, &logLength);
+		std::vector<GLchar> infoLog(logLength > 0 ? logLength : 1, '\0');
+		glGetProgramInfoLog(Program, (GLsizei)infoLog.size(), NULL, infoLog.data());
+		std::cout << "ERROR::COMPUTE_SHADER::LINKING_FAILED " << m_path << "\n" << infoLog.data() << std::endl;
+		glDeleteProgram(Program);
+		Program = 0;
+	}
+	m_uniforms.Reset(Program);
+}
+
+ComputeShader::~ComputeShader()
+{
+	if (Program != 0)
+	{
+		glDeleteProgram(Program);
+		GLStateCache::getInstance()->invalidate();
+	}
+}
+
+bool ComputeShader::isSupported()
+{
+	return GLEW_VERSION_4_3 || (GLEW_ARB_compute_shader && GLEW_ARB_shader_storage_buffer_object);
+}
+
+void ComputeShader::Use()
+{
+	GLStateCache::getInstance()->useProgram(Program);
+}
+
+void ComputeShader::Dispatch(unsigned int _invocations, unsigned int _groupSize)
+{
+	glDispatchCompute((_invocations + _groupSize - 1) / _groupSize, 1, 1);
+}
+
+void ComputeShader::setUInt(const char* _varName, unsigned int _value)
+{
+	UniformCache::Slot* slot = m_uniforms.getSlot(_varName);
+	if (UniformCache::Update(slot, &_value, 1))
+	{
+		glUniform1ui(slot ? slot->Location : glGetUniformLocation(Program, _varName), _value);
+	}
+}
+
+void ComputeShader::setFloat(const char* _varName, float _value)
+{
+	UniformCache::Slot* slot = m_uniforms.getSlot(_varName);
+	if (UniformCache::Update(slot, &_value, 1))
+	{
+		glUniform1f(slot ? slot->Location : glGetUniformLocation(Program, _varName), _value);
+	}
+}
+
+void ComputeShader::setVec4(const char* _varName, glm::vec4 _value)
+{
+	UniformCache::Slot* slot = m_uniforms.getSlot(_varName);
+	if (UniformCache::Update(slot, glm::value_ptr(_value), 4))
+	{
+		glUniform4f(slot ? slot->Location : glGetUniformLocation(Program, _varName), _value.x, _value.y, _value.z, _value.w);
+	}
+}
+
+void ComputeShader::setVec4Array(const char* _varName, const glm::vec4* _values, unsigned int _count)
+{
+	UniformCache::Slot* slot = m_uniforms.getSlot(_varName);
+	if (UniformCache::Update(slot, &_values[0].x, _count * 4))
+	{
+		glUniform4fv(slot ? slot->Location : glGetUniformLocation(Program, _varName), _count, &_values[0].x);
+	}
+}
+
+void ComputeShader::setMat4(const char* _varName, glm::mat4 _value)
+{
+	UniformCache::Slot* slot = m_uniforms.getSlot(_varName);
+	if (UniformCache::Update(slot, glm::value_ptr(_value), 16))
+	{
+		glUniformMatrix4fv(slot ? slot->Location : glGetUniformLocation(Program, _varName), 1, GL_FALSE, glm::value_ptr(_value));
+	}
+}
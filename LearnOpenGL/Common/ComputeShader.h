@@ -0,0 +1,43 @@
+#ifndef COMPUTE_SHADER_H
+#define COMPUTE_SHADER_H
+
+#include <string>
+
+#include <GL/glew.h>
+
+#include "glm/glm.hpp"
+
+#include "UniformCache.h"
+
+// Program made of a single compute stage, needs GL 4.3 or ARB_compute_shader
+class ComputeShader
+{
+public:
+	// The program ID, 0 when the driver has no compute support or the build failed
+	GLuint Program;
+
+	ComputeShader(const GLchar* computePath);
+	virtual ~ComputeShader();
+
+	static bool isSupported();
+
+	bool isValid() const { return Program != 0; }
+
+	void Use();
+
+	// Run enough work groups to cover the invocation count with the given group size
+	void Dispatch(unsigned int _invocations, unsigned int _groupSize);
+
+	// Through the same location cache and value shadow as Shader, repeated values issue no GL call
+	void setUInt(const char* _varName, unsigned int _value);
+	void setFloat(const char* _varName, float _value);
+	void setVec4(const char* _varName, glm::vec4 _value);
+	void setVec4Array(const char* _varName, const glm::vec4* _values, unsigned int _count);
+	void setMat4(const char* _varName, glm::mat4 _value);
+
+private:
+	std::string m_path;
+	UniformCache m_uniforms;
+};
+
+#endif
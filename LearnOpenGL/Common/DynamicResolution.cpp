@@ -0,0 +1,179 @@
+#include "DynamicResolution.h"
+#include "GLStateCache.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Weight of a new result in the moving average
+#define DYNAMIC_RESOLUTION_SMOOTHING 0.25
+
+DynamicResolution::DynamicResolution(int _width, int _height, double _targetMilliseconds, float _minScale, float _maxScale)
+	: m_fullWidth(_width), m_fullHeight(_height), m_targetMilliseconds(_targetMilliseconds),
+	m_minScale(_minScale), m_maxScale(std::max(_minScale, _maxScale)), m_changed(false), m_locked(false), m_oldest(0), m_pending(0), m_timing(false)
+{
+	glGenQueries(DYNAMIC_RESOLUTION_QUERIES, m_queries);
+	for (int i = 0; i < DYNAMIC_RESOLUTION_QUERIES; i++)
+	{
+		m_queryScales[i] = 0.0f;
+	}
+
+	m_stats = DynamicResolutionStats();
+	setScale(m_maxScale);
+	m_changed = false;
+}
+
+DynamicResolution::~DynamicResolution()
+{
+	glDeleteQueries(DYNAMIC_RESOLUTION_QUERIES, m_queries);
+}
+
+void DynamicResolution::BeginFrame()
+{
+	// Every query still waits for the GPU, this frame goes untimed rather than stalling
+	if (m_pending == DYNAMIC_RESOLUTION_QUERIES)
+	{
+		m_timing = false;
+		m_stats.SkippedFrames++;
+		return;
+	}
+
+	unsigned int index = (m_oldest + m_pending) % DYNAMIC_RESOLUTION_QUERIES;
+	m_queryScales[index] = m_stats.Scale;
+	glBeginQuery(GL_TIME_ELAPSED, m_queries[index]);
+	m_timing = true;
+}
+
+void DynamicResolution::EndFrame()
+{
+	m_changed = false;
+	if (m_timing)
+	{
+		glEndQuery(GL_TIME_ELAPSED);
+		m_pending++;
+		m_timing = false;
+	}
+
+	readResults();
+	Decide();
+}
+
+void DynamicResolution::readResults()
+{
+	while (m_pending > 0)
+	{
+		GLuint query = m_queries[m_oldest];
+		GLint available = 0;
+		glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+		{
+			return;
+		}
+
+		GLuint64 nanoseconds = 0;
+		glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+		float scale = m_queryScales[m_oldest];
+		m_oldest = (m_oldest + 1) % DYNAMIC_RESOLUTION_QUERIES;
+		m_pending--;
+
+		AddResult(nanoseconds / 1000000.0, scale);
+	}
+}
+
+void DynamicResolution::AddResult(double _gpuMilliseconds, float _scale)
+{
+	m_stats.GpuMilliseconds = _gpuMilliseconds;
+	if (_scale != m_stats.Scale)
+	{
+		return;
+	}
+
+	if (m_stats.Samples == 0)
+	{
+		m_stats.AverageMilliseconds = m_stats.GpuMilliseconds;
+	}
+	else
+	{
+		m_stats.AverageMilliseconds += (m_stats.GpuMilliseconds - m_stats.AverageMilliseconds) * DYNAMIC_RESOLUTION_SMOOTHING;
+	}
+	m_stats.Samples++;
+}
+
+void DynamicResolution::Decide()
+{
+	if (m_locked)
+	{
+		m_stats.Decision = DYNAMIC_RESOLUTION_HOLD;
+		return;
+	}
+
+	if (m_stats.Samples < DYNAMIC_RESOLUTION_SAMPLES)
+	{
+		m_stats.Decision = DYNAMIC_RESOLUTION_WAIT;
+		return;
+	}
+
+	double average = m_stats.AverageMilliseconds;
+	if (average > m_targetMilliseconds)
+	{
+		if (m_stats.Scale <= m_minScale)
+		{
+			m_stats.Decision = DYNAMIC_RESOLUTION_MIN;
+			return;
+		}
+
+		// GPU time follows the pixel count, the square of the scale; aim a little under the target
+		float scale = m_stats.Scale * (float)std::sqrt(m_targetMilliseconds * 0.9 / average);
+		scale = std::floor(scale / DYNAMIC_RESOLUTION_STEP + 0.001f) * DYNAMIC_RESOLUTION_STEP;
+		setScale(std::min(scale, m_stats.Scale - DYNAMIC_RESOLUTION_STEP));
+		m_stats.Decision = DYNAMIC_RESOLUTION_DOWN;
+		m_stats.Decreases++;
+	}
+	else if (average < m_targetMilliseconds * DYNAMIC_RESOLUTION_HEADROOM)
+	{
+		if (m_stats.Scale >= m_maxScale)
+		{
+			m_stats.Decision = DYNAMIC_RESOLUTION_MAX;
+			return;
+		}
+
+		setScale(m_stats.Scale + DYNAMIC_RESOLUTION_STEP);
+		m_stats.Decision = DYNAMIC_RESOLUTION_UP;
+		m_stats.Increases++;
+	}
+	else
+	{
+		m_stats.Decision = DYNAMIC_RESOLUTION_HOLD;
+	}
+}
+
+void DynamicResolution::setScale(float _scale)
+{
+	// Snapped to the step so repeated steps do not drift
+	_scale = std::floor(_scale / DYNAMIC_RESOLUTION_STEP + 0.5f) * DYNAMIC_RESOLUTION_STEP;
+	m_stats.Scale = std::max(m_minScale, std::min(_scale, m_maxScale));
+	m_stats.Samples = 0;
+	m_stats.Width = std::max(1, (int)(m_fullWidth * m_stats.Scale + 0.5f));
+	m_stats.Height = std::max(1, (int)(m_fullHeight * m_stats.Scale + 0.5f));
+	m_changed = true;
+}
+
+void DynamicResolution::Upscale(GLuint _framebuffer) const
+{
+	GLStateCache::getInstance()->bindFramebuffer(GL_READ_FRAMEBUFFER, _framebuffer);
+	GLStateCache::getInstance()->bindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glBlitFramebuffer(0, 0, m_stats.Width, m_stats.Height, 0, 0, m_fullWidth, m_fullHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+	GLStateCache::getInstance()->bindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+const char* DynamicResolution::getDecisionName(DynamicResolutionDecision _decision)
+{
+	switch (_decision)
+	{
+	case DYNAMIC_RESOLUTION_HOLD: return "hold";
+	case DYNAMIC_RESOLUTION_DOWN: return "down";
+	case DYNAMIC_RESOLUTION_UP: return "up";
+	case DYNAMIC_RESOLUTION_MIN: return "at min";
+	case DYNAMIC_RESOLUTION_MAX: return "at max";
+	default: return "measuring";
+	}
+}
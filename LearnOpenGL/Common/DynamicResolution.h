@@ -0,0 +1,108 @@
+#ifndef DYNAMIC_RESOLUTION_H
+#define DYNAMIC_RESOLUTION_H
+
+#include <GL/glew.h>
+
+// Timer queries in flight, a result is read back up to this many frames late without stalling
+#define DYNAMIC_RESOLUTION_QUERIES 4
+
+// Scales are multiples of this, so the pool sees a handful of target sizes
+#define DYNAMIC_RESOLUTION_STEP 0.05f
+
+// GPU times measured at the current scale before it may change again
+#define DYNAMIC_RESOLUTION_SAMPLES 8
+
+// Below this fraction of the target the scale goes up one step, above the target it goes down
+#define DYNAMIC_RESOLUTION_HEADROOM 0.75
+
+enum DynamicResolutionDecision
+{
+	DYNAMIC_RESOLUTION_WAIT = 0,	// not enough samples at the current scale
+	DYNAMIC_RESOLUTION_HOLD,		// within budget
+	DYNAMIC_RESOLUTION_DOWN,		// over budget, scaled down in proportion
+	DYNAMIC_RESOLUTION_UP,			// well under budget, one step up
+	DYNAMIC_RESOLUTION_MIN,			// over budget but already at the lowest scale
+	DYNAMIC_RESOLUTION_MAX,			// under budget and already at full scale
+};
+
+struct DynamicResolutionStats
+{
+	double GpuMilliseconds;			// last result read back
+	double AverageMilliseconds;		// moving average at the current scale, what decisions use
+	unsigned int Samples;			// results at the current scale
+	float Scale;
+	int Width;
+	int Height;
+	DynamicResolutionDecision Decision;
+	unsigned int Decreases;
+	unsigned int Increases;
+	unsigned int SkippedFrames;		// not timed because every query was still in flight
+};
+
+// Holds a GPU frame time budget by rendering at a fraction of the window size.
+// Each frame is timed with a GL_TIME_ELAPSED query read back a few frames later; once enough
+// results at the current scale are in, the scale moves down in proportion to the overshoot or
+// up one step when there is headroom. Results measured at an older scale are ignored.
+//
+// Each frame: BeginFrame(), rebuild targets if hasChanged(), render at getWidth() x getHeight(),
+// Upscale() or draw to the backbuffer, EndFrame().
+class DynamicResolution
+{
+public:
+	DynamicResolution(int _width, int _height, double _targetMilliseconds, float _minScale = 0.5f, float _maxScale = 1.0f);
+	~DynamicResolution();
+
+	void BeginFrame();
+
+	// Ends the frame's query, reads back the finished ones and picks the scale of the next frame
+	void EndFrame();
+
+	// What EndFrame() does with each timer result it reads back, and then once per frame. Public so the
+	// controller can be driven with GPU times that did not come from a query
+	void AddResult(double _gpuMilliseconds, float _scale);
+	void Decide();
+
+	// Linear blit of the color of _framebuffer, getWidth() x getHeight(), over the whole backbuffer
+	void Upscale(GLuint _framebuffer) const;
+
+	int getWidth() const { return m_stats.Width; }
+	int getHeight() const { return m_stats.Height; }
+	float getScale() const { return m_stats.Scale; }
+
+	// The last EndFrame() changed the size, targets of the old size are due for a rebuild
+	bool hasChanged() const { return m_changed; }
+
+	// A locked controller keeps its scale whatever the frame times, for runs that need the same pixels every time
+	void setLocked(bool _locked) { m_locked = _locked; }
+	bool isLocked() const { return m_locked; }
+
+	void setTargetMilliseconds(double _milliseconds) { m_targetMilliseconds = _milliseconds; }
+	double getTargetMilliseconds() const { return m_targetMilliseconds; }
+
+	const DynamicResolutionStats& getStats() const { return m_stats; }
+
+	static const char* getDecisionName(DynamicResolutionDecision _decision);
+
+private:
+	void readResults();
+	void setScale(float _scale);
+
+	int m_fullWidth;
+	int m_fullHeight;
+	double m_targetMilliseconds;
+	float m_minScale;
+	float m_maxScale;
+	bool m_changed;
+	bool m_locked;
+
+	// Ring of queries, oldest pending at m_oldest
+	GLuint m_queries[DYNAMIC_RESOLUTION_QUERIES];
+	float m_queryScales[DYNAMIC_RESOLUTION_QUERIES];
+	unsigned int m_oldest;
+	unsigned int m_pending;
+	bool m_timing;
+
+	DynamicResolutionStats m_stats;
+};
+
+#endif
@@ -0,0 +1,114 @@
+#include "FrameContext.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+// Wait granularity while the GPU holds a frame, in nanoseconds
+#define FRAME_CONTEXT_WAIT_TIMEOUT 1000000
+
+FrameContext::FrameContext(unsigned int _framesInFlight)
+	: m_framesInFlight(std::max(1u, std::min(_framesInFlight, (unsigned int)FRAME_CONTEXT_MAX_FRAMES))), m_frameIndex(0), m_frameNumber(0)
+{
+	for (int i = 0; i < FRAME_CONTEXT_MAX_FRAMES; i++)
+	{
+		m_fences[i] = 0;
+	}
+	resetStats();
+}
+
+FrameContext::~FrameContext()
+{
+	for (int i = 0; i < FRAME_CONTEXT_MAX_FRAMES; i++)
+	{
+		if (m_fences[i])
+		{
+			glDeleteSync(m_fences[i]);
+		}
+	}
+}
+
+void FrameContext::resetStats()
+{
+	m_stats.Frames = 0;
+	m_stats.Waits = 0;
+	m_stats.LastWaitMilliseconds = 0.0;
+	m_stats.TotalWaitMilliseconds = 0.0;
+}
+
+void FrameContext::BeginFrame()
+{
+	m_stats.Frames++;
+	m_stats.LastWaitMilliseconds = wait(m_frameIndex);
+	if (m_stats.LastWaitMilliseconds > 0.0)
+	{
+		m_stats.Waits++;
+		m_stats.TotalWaitMilliseconds += m_stats.LastWaitMilliseconds;
+	}
+}
+
+void FrameContext::EndFrame()
+{
+	if (m_fences[m_frameIndex])
+	{
+		glDeleteSync(m_fences[m_frameIndex]);
+	}
+	m_fences[m_frameIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	m_frameNumber++;
+	m_frameIndex = (m_frameIndex + 1) % m_framesInFlight;
+}
+
+void FrameContext::setFramesInFlight(unsigned int _framesInFlight)
+{
+	_framesInFlight = std::max(1u, std::min(_framesInFlight, (unsigned int)FRAME_CONTEXT_MAX_FRAMES));
+	if (_framesInFlight == m_framesInFlight)
+	{
+		return;
+	}
+
+	// Frame indices get a new meaning, nothing queued may still read any copy
+	waitIdle();
+	m_framesInFlight = _framesInFlight;
+	m_frameIndex = 0;
+}
+
+double FrameContext::wait(unsigned int _frameIndex)
+{
+	GLsync fence = m_fences[_frameIndex];
+	if (!fence)
+	{
+		return 0.0;
+	}
+
+	double milliseconds = 0.0;
+	GLenum result = glClientWaitSync(fence, 0, 0);
+	if (result == GL_TIMEOUT_EXPIRED)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		do
+		{
+			result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FRAME_CONTEXT_WAIT_TIMEOUT);
+		} while (result == GL_TIMEOUT_EXPIRED);
+
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+		milliseconds = elapsed.count();
+	}
+
+	if (result == GL_WAIT_FAILED)
+	{
+		std::cout << "ERROR::FRAME_CONTEXT::WAIT_FAILED" << std::endl;
+	}
+
+	glDeleteSync(fence);
+	m_fences[_frameIndex] = 0;
+	return milliseconds;
+}
+
+void FrameContext::waitIdle()
+{
+	for (unsigned int i = 0; i < FRAME_CONTEXT_MAX_FRAMES; i++)
+	{
+		wait(i);
+	}
+}
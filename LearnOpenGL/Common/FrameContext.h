@@ -0,0 +1,59 @@
+#ifndef FRAME_CONTEXT_H
+#define FRAME_CONTEXT_H
+
+#include <GL/glew.h>
+
+// Most frames the CPU may record ahead of the GPU, ring buffered resources keep this many copies
+#define FRAME_CONTEXT_MAX_FRAMES 3
+
+struct FrameContextStats
+{
+	unsigned int Frames;
+	unsigned int Waits;				// BeginFrame() calls that had to wait for the GPU
+	double LastWaitMilliseconds;
+	double TotalWaitMilliseconds;
+};
+
+// Paces the CPU against the GPU with one fence per frame in flight.
+// With 1 frame in flight the CPU starts a frame only once the GPU finished the previous one, lowest latency;
+// with 3 it may run up to two frames ahead, highest throughput.
+// getFrameIndex() picks the copy of a ring buffered resource that no queued frame reads anymore.
+//
+// Each frame: BeginFrame(), write per frame resources, issue GL, EndFrame(), glfwSwapBuffers().
+class FrameContext
+{
+public:
+	FrameContext(unsigned int _framesInFlight = 2);
+	~FrameContext();
+
+	// Waits until the GPU is done with the frame that last used this frame index
+	void BeginFrame();
+
+	// Fences the frame after its last GL call and moves to the next frame index
+	void EndFrame();
+
+	// 1 to FRAME_CONTEXT_MAX_FRAMES, waits for the GPU to finish every queued frame first
+	void setFramesInFlight(unsigned int _framesInFlight);
+	unsigned int getFramesInFlight() const { return m_framesInFlight; }
+
+	// Copy of ring buffered resources owned by the current frame, below getFramesInFlight()
+	unsigned int getFrameIndex() const { return m_frameIndex; }
+	unsigned long long getFrameNumber() const { return m_frameNumber; }
+
+	const FrameContextStats& getStats() const { return m_stats; }
+	void resetStats();
+
+private:
+	// Returns the milliseconds spent waiting, 0 when the fence was already signaled
+	double wait(unsigned int _frameIndex);
+	void waitIdle();
+
+	unsigned int m_framesInFlight;
+	unsigned int m_frameIndex;
+	unsigned long long m_frameNumber;
+	GLsync m_fences[FRAME_CONTEXT_MAX_FRAMES];
+
+	FrameContextStats m_stats;
+};
+
+#endif
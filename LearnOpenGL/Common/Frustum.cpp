@@ -0,0 +1,105 @@
+#include "Frustum.h"
+
+void Frustum::Extract(const glm::mat4& _viewProjection)
+{
+	// glm is column major, row i of the matrix is (m[0][i], m[1][i], m[2][i], m[3][i])
+	glm::vec4 row0(_viewProjection[0][0], _viewProjection[1][0], _viewProjection[2][0], _viewProjection[3][0]);
+	glm::vec4 row1(_viewProjection[0][1], _viewProjection[1][1], _viewProjection[2][1], _viewProjection[3][1]);
+	glm::vec4 row2(_viewProjection[0][2], _viewProjection[1][2], _viewProjection[2][2], _viewProjection[3][2]);
+	glm::vec4 row3(_viewProjection[0][3], _viewProjection[1][3], _viewProjection[2][3], _viewProjection[3][3]);
+
+	Planes[0] = row3 + row0;
+	Planes[1] = row3 - row0;
+	Planes[2] = row3 + row1;
+	Planes[3] = row3 - row1;
+	Planes[4] = row3 + row2;
+	Planes[5] = row3 - row2;
+
+	for (int i = 0; i < 6; i++)
+	{
+		Planes[i] /= glm::length(glm::vec3(Planes[i]));
+	}
+}
+
+bool Frustum::IntersectsSphere(const glm::vec3& _center, float _radius) const
+{
+	for (int i = 0; i < 6; i++)
+	{
+		if (glm::dot(glm::vec3(Planes[i]), _center) + Planes[i].w < -_radius)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+FrustumTest Frustum::ClassifyBox(const glm::vec3& _min, const glm::vec3& _max) const
+{
+	glm::vec3 center = (_min + _max) * 0.5f;
+	glm::vec3 extents = (_max - _min) * 0.5f;
+
+	FrustumTest result = FRUSTUM_INSIDE;
+	for (int i = 0; i < 6; i++)
+	{
+		glm::vec3 normal(Planes[i]);
+		float distance = glm::dot(normal, center) + Planes[i].w;
+		float reach = glm::dot(glm::abs(normal), extents);
+		if (distance < -reach)
+		{
+			return FRUSTUM_OUTSIDE;
+		}
+		if (distance < reach)
+		{
+			result = FRUSTUM_INTERSECTS;
+		}
+	}
+	return result;
+}
+
+float getBoundingRadius(const glm::vec3* _positions, unsigned int _count, unsigned int _stride)
+{
+	float radiusSquared = 0.0f;
+	const unsigned char* data = reinterpret_cast<const unsigned char*>(_positions);
+	for (unsigned int i = 0; i < _count; i++)
+	{
+		const glm::vec3& position = *reinterpret_cast<const glm::vec3*>(data + i * _stride);
+		radiusSquared = glm::max(radiusSquared, glm::dot(position, position));
+	}
+	return glm::sqrt(radiusSquared);
+}
+
+float getMaxScale(const glm::mat4& _transform)
+{
+	float x = glm::dot(glm::vec3(_transform[0]), glm::vec3(_transform[0]));
+	float y = glm::dot(glm::vec3(_transform[1]), glm::vec3(_transform[1]));
+	float z = glm::dot(glm::vec3(_transform[2]), glm::vec3(_transform[2]));
+	return glm::sqrt(glm::max(x, glm::max(y, z)));
+}
+
+void getBoundingBox(const glm::vec3* _positions, unsigned int _count, unsigned int _stride, glm::vec3& _min, glm::vec3& _max)
+{
+	_min = glm::vec3(0.0f);
+	_max = glm::vec3(0.0f);
+	const unsigned char* data = reinterpret_cast<const unsigned char*>(_positions);
+	for (unsigned int i = 0; i < _count; i++)
+	{
+		const glm::vec3& position = *reinterpret_cast<const glm::vec3*>(data + i * _stride);
+		_min = (i == 0) ? position : glm::min(_min, position);
+		_max = (i == 0) ? position : glm::max(_max, position);
+	}
+}
+
+void transformBoundingBox(const glm::vec3& _min, const glm::vec3& _max, const glm::mat4& _transform, glm::vec3& _outMin, glm::vec3& _outMax)
+{
+	// Arvo: each axis of the transform widens the box by its projection on the extents
+	glm::vec3 center = (_min + _max) * 0.5f;
+	glm::vec3 extents = (_max - _min) * 0.5f;
+
+	glm::vec3 newCenter(_transform * glm::vec4(center, 1.0f));
+	glm::vec3 newExtents = glm::abs(glm::vec3(_transform[0])) * extents.x
+		+ glm::abs(glm::vec3(_transform[1])) * extents.y
+		+ glm::abs(glm::vec3(_transform[2])) * extents.z;
+
+	_outMin = newCenter - newExtents;
+	_outMax = newCenter + newExtents;
+}
@@ -0,0 +1,40 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include "glm/glm.hpp"
+
+enum FrustumTest
+{
+	FRUSTUM_OUTSIDE = 0,
+	FRUSTUM_INTERSECTS,
+	FRUSTUM_INSIDE
+};
+
+// Six planes of a view frustum, xyz is the inward normal and w the distance
+struct Frustum
+{
+	// left, right, bottom, top, near, far
+	glm::vec4 Planes[6];
+
+	// Gribb/Hartmann extraction, planes are normalized so sphere tests can use world units
+	void Extract(const glm::mat4& _viewProjection);
+
+	bool IntersectsSphere(const glm::vec3& _center, float _radius) const;
+
+	// INSIDE when the whole box is in the frustum, lets hierarchies skip testing children
+	FrustumTest ClassifyBox(const glm::vec3& _min, const glm::vec3& _max) const;
+};
+
+// Radius of the sphere around the model origin that contains every vertex of a set of positions
+float getBoundingRadius(const glm::vec3* _positions, unsigned int _count, unsigned int _stride);
+
+// Axis aligned box containing a set of positions
+void getBoundingBox(const glm::vec3* _positions, unsigned int _count, unsigned int _stride, glm::vec3& _min, glm::vec3& _max);
+
+// Axis aligned box containing a transformed box
+void transformBoundingBox(const glm::vec3& _min, const glm::vec3& _max, const glm::mat4& _transform, glm::vec3& _outMin, glm::vec3& _outMax);
+
+// Largest axis scale of a transform, to scale a bounding radius with it
+float getMaxScale(const glm::mat4& _transform);
+
+#endif
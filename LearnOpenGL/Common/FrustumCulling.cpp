@@ -0,0 +1,287 @@
+#include "FrustumCulling.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+#include <immintrin.h>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include "JobSystem.h"
+
+// Padding volumes sit behind every plane so they never show up as visible
+static const float s_paddingRadius = -1.0e30f;
+
+FrustumCuller::FrustumCuller()
+	: m_count(0)
+{
+}
+
+void FrustumCuller::Clear()
+{
+	m_count = 0;
+	m_centerX.clear();
+	m_centerY.clear();
+	m_centerZ.clear();
+	m_radius.clear();
+	m_extentX.clear();
+	m_extentY.clear();
+	m_extentZ.clear();
+}
+
+void FrustumCuller::Reserve(unsigned int _count)
+{
+	unsigned int padded = (_count + FRUSTUM_CULLING_BATCH - 1) / FRUSTUM_CULLING_BATCH * FRUSTUM_CULLING_BATCH;
+	m_centerX.reserve(padded);
+	m_centerY.reserve(padded);
+	m_centerZ.reserve(padded);
+	m_radius.reserve(padded);
+	m_extentX.reserve(padded);
+	m_extentY.reserve(padded);
+	m_extentZ.reserve(padded);
+}
+
+unsigned int FrustumCuller::add(const glm::vec3& _center, float _radius, const glm::vec3& _extents)
+{
+	unsigned int index = m_count++;
+	if (index == m_radius.size())
+	{
+		// Grow by a whole batch of padding volumes
+		unsigned int padded = index + FRUSTUM_CULLING_BATCH;
+		m_centerX.resize(padded, 0.0f);
+		m_centerY.resize(padded, 0.0f);
+		m_centerZ.resize(padded, 0.0f);
+		m_radius.resize(padded, s_paddingRadius);
+		m_extentX.resize(padded, 0.0f);
+		m_extentY.resize(padded, 0.0f);
+		m_extentZ.resize(padded, 0.0f);
+	}
+
+	set(index, _center, _radius, _extents);
+	return index;
+}
+
+void FrustumCuller::set(unsigned int _index, const glm::vec3& _center, float _radius, const glm::vec3& _extents)
+{
+	m_centerX[_index] = _center.x;
+	m_centerY[_index] = _center.y;
+	m_centerZ[_index] = _center.z;
+	m_radius[_index] = _radius;
+	m_extentX[_index] = _extents.x;
+	m_extentY[_index] = _extents.y;
+	m_extentZ[_index] = _extents.z;
+}
+
+unsigned int FrustumCuller::AddSphere(const glm::vec3& _center, float _radius)
+{
+	return add(_center, _radius, glm::vec3(0.0f));
+}
+
+unsigned int FrustumCuller::AddBox(const glm::vec3& _center, const glm::vec3& _extents)
+{
+	return add(_center, 0.0f, _extents);
+}
+
+void FrustumCuller::SetSphere(unsigned int _index, const glm::vec3& _center, float _radius)
+{
+	set(_index, _center, _radius, glm::vec3(0.0f));
+}
+
+void FrustumCuller::SetBox(unsigned int _index, const glm::vec3& _center, const glm::vec3& _extents)
+{
+	set(_index, _center, 0.0f, _extents);
+}
+
+unsigned int FrustumCuller::cullRange(const Frustum& _frustum, unsigned int _begin, unsigned int _end, unsigned int* _out) const
+{
+	const float* centerX = m_centerX.data();
+	const float* centerY = m_centerY.data();
+	const float* centerZ = m_centerZ.data();
+	const float* radius = m_radius.data();
+	const float* extentX = m_extentX.data();
+	const float* extentY = m_extentY.data();
+	const float* extentZ = m_extentZ.data();
+
+	unsigned int visibleCount = 0;
+
+#if defined(__AVX__)
+	__m256 planeX[6], planeY[6], planeZ[6], planeW[6], absX[6], absY[6], absZ[6];
+	for (int p = 0; p < 6; p++)
+	{
+		const glm::vec4& plane = _frustum.Planes[p];
+		planeX[p] = _mm256_set1_ps(plane.x);
+		planeY[p] = _mm256_set1_ps(plane.y);
+		planeZ[p] = _mm256_set1_ps(plane.z);
+		planeW[p] = _mm256_set1_ps(plane.w);
+		absX[p] = _mm256_set1_ps(std::fabs(plane.x));
+		absY[p] = _mm256_set1_ps(std::fabs(plane.y));
+		absZ[p] = _mm256_set1_ps(std::fabs(plane.z));
+	}
+
+	const __m256 zero = _mm256_setzero_ps();
+	for (unsigned int i = _begin; i < _end; i += FRUSTUM_CULLING_BATCH)
+	{
+		__m256 cx = _mm256_loadu_ps(centerX + i);
+		__m256 cy = _mm256_loadu_ps(centerY + i);
+		__m256 cz = _mm256_loadu_ps(centerZ + i);
+		__m256 r = _mm256_loadu_ps(radius + i);
+		__m256 ex = _mm256_loadu_ps(extentX + i);
+		__m256 ey = _mm256_loadu_ps(extentY + i);
+		__m256 ez = _mm256_loadu_ps(extentZ + i);
+
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		for (int p = 0; p < 6; p++)
+		{
+			// distance + radius + box extent projected on the plane normal
+			__m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(planeX[p], cx), _mm256_mul_ps(planeY[p], cy)), _mm256_add_ps(_mm256_mul_ps(planeZ[p], cz), planeW[p]));
+			__m256 reach = _mm256_add_ps(r, _mm256_add_ps(_mm256_mul_ps(absX[p], ex), _mm256_add_ps(_mm256_mul_ps(absY[p], ey), _mm256_mul_ps(absZ[p], ez))));
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, reach), zero, _CMP_GE_OQ));
+		}
+
+		int batchMask = _mm256_movemask_ps(inside);
+		for (unsigned int lane = 0; batchMask; lane++, batchMask >>= 1)
+		{
+			if (batchMask & 1)
+			{
+				_out[visibleCount++] = i + lane;
+			}
+		}
+	}
+#else
+	__m128 planeX[6], planeY[6], planeZ[6], planeW[6], absX[6], absY[6], absZ[6];
+	for (int p = 0; p < 6; p++)
+	{
+		const glm::vec4& plane = _frustum.Planes[p];
+		planeX[p] = _mm_set1_ps(plane.x);
+		planeY[p] = _mm_set1_ps(plane.y);
+		planeZ[p] = _mm_set1_ps(plane.z);
+		planeW[p] = _mm_set1_ps(plane.w);
+		absX[p] = _mm_set1_ps(std::fabs(plane.x));
+		absY[p] = _mm_set1_ps(std::fabs(plane.y));
+		absZ[p] = _mm_set1_ps(std::fabs(plane.z));
+	}
+
+	const __m128 zero = _mm_setzero_ps();
+	for (unsigned int i = _begin; i < _end; i += FRUSTUM_CULLING_BATCH)
+	{
+		// Two SSE registers make up one batch of 8
+		int batchMask = 0;
+		for (unsigned int half = 0; half < 2; half++)
+		{
+			unsigned int base = i + half * 4;
+			__m128 cx = _mm_loadu_ps(centerX + base);
+			__m128 cy = _mm_loadu_ps(centerY + base);
+			__m128 cz = _mm_loadu_ps(centerZ + base);
+			__m128 r = _mm_loadu_ps(radius + base);
+			__m128 ex = _mm_loadu_ps(extentX + base);
+			__m128 ey = _mm_loadu_ps(extentY + base);
+			__m128 ez = _mm_loadu_ps(extentZ + base);
+
+			__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (int p = 0; p < 6; p++)
+			{
+				// distance + radius + box extent projected on the plane normal
+				__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], cx), _mm_mul_ps(planeY[p], cy)), _mm_add_ps(_mm_mul_ps(planeZ[p], cz), planeW[p]));
+				__m128 reach = _mm_add_ps(r, _mm_add_ps(_mm_mul_ps(absX[p], ex), _mm_add_ps(_mm_mul_ps(absY[p], ey), _mm_mul_ps(absZ[p], ez))));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, reach), zero));
+			}
+			batchMask |= _mm_movemask_ps(inside) << (half * 4);
+		}
+
+		for (unsigned int lane = 0; batchMask; lane++, batchMask >>= 1)
+		{
+			if (batchMask & 1)
+			{
+				_out[visibleCount++] = i + lane;
+			}
+		}
+	}
+#endif
+
+	return visibleCount;
+}
+
+unsigned int FrustumCuller::Cull(const Frustum& _frustum, std::vector<unsigned int>& _visible) const
+{
+	_visible.resize(m_radius.size());
+	unsigned int visibleCount = cullRange(_frustum, 0, (unsigned int)m_radius.size(), _visible.data());
+	_visible.resize(visibleCount);
+	return visibleCount;
+}
+
+unsigned int FrustumCuller::CullParallel(const Frustum& _frustum, std::vector<unsigned int>& _visible) const
+{
+	JobSystem* jobs = JobSystem::getInstance();
+	unsigned int total = (unsigned int)m_radius.size();
+	unsigned int batches = total / FRUSTUM_CULLING_BATCH;
+
+	// A few slices per thread so stealing evens out slices with more visible objects
+	unsigned int sliceCount = std::min(batches, jobs->getThreadCount() * 4);
+	if (jobs->getThreadCount() <= 1 || sliceCount <= 1)
+	{
+		return Cull(_frustum, _visible);
+	}
+	unsigned int batchesPerSlice = (batches + sliceCount - 1) / sliceCount;
+	sliceCount = (batches + batchesPerSlice - 1) / batchesPerSlice;
+
+	// Each slice writes from its own start, slices are packed afterwards
+	_visible.resize(total);
+	std::vector<unsigned int> counts(sliceCount, 0);
+	jobs->ParallelFor(sliceCount, 1, [this, &_frustum, &_visible, &counts, batches, batchesPerSlice](unsigned int _begin, unsigned int _end)
+	{
+		for (unsigned int slice = _begin; slice < _end; slice++)
+		{
+			unsigned int begin = slice * batchesPerSlice * FRUSTUM_CULLING_BATCH;
+			unsigned int end = std::min((slice + 1) * batchesPerSlice, batches) * FRUSTUM_CULLING_BATCH;
+			counts[slice] = cullRange(_frustum, begin, end, _visible.data() + begin);
+		}
+	});
+
+	unsigned int visibleCount = 0;
+	for (unsigned int slice = 0; slice < sliceCount; slice++)
+	{
+		unsigned int begin = slice * batchesPerSlice * FRUSTUM_CULLING_BATCH;
+		std::copy(_visible.begin() + begin, _visible.begin() + begin + counts[slice], _visible.begin() + visibleCount);
+		visibleCount += counts[slice];
+	}
+	_visible.resize(visibleCount);
+	return visibleCount;
+}
+
+double FrustumCuller::benchmark(unsigned int _count, unsigned int _iterations, bool _parallel)
+{
+	// Objects spread in a 200 unit cube around a camera at the origin looking down -z
+	FrustumCuller culler;
+	culler.Reserve(_count);
+	for (unsigned int i = 0; i < _count; i++)
+	{
+		glm::vec3 center((float)rand() / RAND_MAX * 200.0f - 100.0f, (float)rand() / RAND_MAX * 200.0f - 100.0f, (float)rand() / RAND_MAX * 200.0f - 100.0f);
+		culler.AddSphere(center, 0.5f + (float)rand() / RAND_MAX);
+	}
+
+	Frustum frustum;
+	frustum.Extract(glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f));
+
+	std::vector<unsigned int> visible;
+	visible.reserve(_count + FRUSTUM_CULLING_BATCH);
+
+	double total = 0.0;
+	for (unsigned int iteration = 0; iteration < _iterations; iteration++)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		if (_parallel)
+		{
+			culler.CullParallel(frustum, visible);
+		}
+		else
+		{
+			culler.Cull(frustum, visible);
+		}
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+		total += elapsed.count();
+	}
+
+	return _iterations > 0 ? total / _iterations : 0.0;
+}
@@ -0,0 +1,59 @@
+#ifndef FRUSTUM_CULLING_H
+#define FRUSTUM_CULLING_H
+
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "Frustum.h"
+
+// Objects tested per iteration of the culling loop, arrays are padded to a multiple of it
+#define FRUSTUM_CULLING_BATCH 8
+
+// Bounding volumes in structure of arrays form, culled 8 at a time with SSE (or AVX when the build enables it).
+// A volume is a sphere around a box: spheres have zero extents, boxes zero radius.
+class FrustumCuller
+{
+public:
+	FrustumCuller();
+
+	void Clear();
+	void Reserve(unsigned int _count);
+
+	// Return the index of the new volume
+	unsigned int AddSphere(const glm::vec3& _center, float _radius);
+	unsigned int AddBox(const glm::vec3& _center, const glm::vec3& _extents);
+
+	void SetSphere(unsigned int _index, const glm::vec3& _center, float _radius);
+	void SetBox(unsigned int _index, const glm::vec3& _center, const glm::vec3& _extents);
+
+	unsigned int getCount() const { return m_count; }
+
+	// Write the indices of the volumes touching the frustum in ascending order, return how many
+	unsigned int Cull(const Frustum& _frustum, std::vector<unsigned int>& _visible) const;
+
+	// Same result, the range is split in jobs on the JobSystem
+	unsigned int CullParallel(const Frustum& _frustum, std::vector<unsigned int>& _visible) const;
+
+	// Average ms to cull _count random spheres against a typical frustum
+	static double benchmark(unsigned int _count, unsigned int _iterations, bool _parallel);
+
+private:
+	unsigned int add(const glm::vec3& _center, float _radius, const glm::vec3& _extents);
+	void set(unsigned int _index, const glm::vec3& _center, float _radius, const glm::vec3& _extents);
+
+	// Cull [_begin, _end), both multiples of FRUSTUM_CULLING_BATCH, output written from _out
+	unsigned int cullRange(const Frustum& _frustum, unsigned int _begin, unsigned int _end, unsigned int* _out) const;
+
+	unsigned int m_count;
+
+	std::vector<float> m_centerX;
+	std::vector<float> m_centerY;
+	std::vector<float> m_centerZ;
+	std::vector<float> m_radius;
+	std::vector<float> m_extentX;
+	std::vector<float> m_extentY;
+	std::vector<float> m_extentZ;
+};
+
+#endif
@@ -0,0 +1,383 @@
+#include "GLStateCache.h"
+
+static const GLenum s_cachedCaps[8] =
+{
+	GL_DEPTH_TEST,
+	GL_BLEND,
+	GL_CULL_FACE,
+	GL_STENCIL_TEST,
+	GL_MULTISAMPLE,
+	GL_TEXTURE_CUBE_MAP_SEAMLESS,
+	GL_FRAMEBUFFER_SRGB,
+	GL_SCISSOR_TEST
+};
+
+GLStateCache* GLStateCache::m_instance = nullptr;
+
+GLStateCache::GLStateCache()
+{
+	invalidate();
+	resetStats();
+}
+
+GLStateCache::~GLStateCache()
+{
+}
+
+void GLStateCache::Init()
+{
+	if (!m_instance)
+	{
+		m_instance = new GLStateCache();
+	}
+}
+
+void GLStateCache::Destroy()
+{
+	if (m_instance) {
+		delete m_instance;
+		m_instance = nullptr;
+	}
+}
+
+GLStateCache* GLStateCache::getInstance()
+{
+	if (!m_instance)
+	{
+		Init();
+	}
+	return m_instance;
+}
+
+void GLStateCache::invalidate()
+{
+	m_program = GL_STATE_CACHE_UNKNOWN;
+	m_vertexArray = GL_STATE_CACHE_UNKNOWN;
+	m_drawFramebuffer = GL_STATE_CACHE_UNKNOWN;
+	m_readFramebuffer = GL_STATE_CACHE_UNKNOWN;
+
+	m_activeUnit = GL_STATE_CACHE_UNKNOWN;
+	for (unsigned int i = 0; i < GL_STATE_CACHE_MAX_TEXTURE_UNITS; i++)
+	{
+		m_textureUnits[i].Texture2D = GL_STATE_CACHE_UNKNOWN;
+		m_textureUnits[i].TextureCubeMap = GL_STATE_CACHE_UNKNOWN;
+		m_textureUnits[i].Texture2DMultisample = GL_STATE_CACHE_UNKNOWN;
+	}
+
+	for (unsigned int i = 0; i < 8; i++)
+	{
+		m_caps[i] = -1;
+	}
+
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		m_blend[i] = GL_STATE_CACHE_UNKNOWN;
+		m_viewport[i] = -1;
+	}
+	m_depthFunc = GL_STATE_CACHE_UNKNOWN;
+	m_depthMask = GL_STATE_CACHE_UNKNOWN;
+	m_cullFace = GL_STATE_CACHE_UNKNOWN;
+	m_frontFace = GL_STATE_CACHE_UNKNOWN;
+	m_stencilFuncKnown = false;
+	for (unsigned int i = 0; i < 3; i++)
+	{
+		m_stencilOp[i] = GL_STATE_CACHE_UNKNOWN;
+	}
+	m_stencilMaskKnown = false;
+}
+
+void GLStateCache::forgetTexture(GLuint _texture)
+{
+	for (unsigned int i = 0; i < GL_STATE_CACHE_MAX_TEXTURE_UNITS; i++)
+	{
+		TextureUnit& unit = m_textureUnits[i];
+		if (unit.Texture2D == _texture)
+		{
+			unit.Texture2D = GL_STATE_CACHE_UNKNOWN;
+		}
+		if (unit.TextureCubeMap == _texture)
+		{
+			unit.TextureCubeMap = GL_STATE_CACHE_UNKNOWN;
+		}
+		if (unit.Texture2DMultisample == _texture)
+		{
+			unit.Texture2DMultisample = GL_STATE_CACHE_UNKNOWN;
+		}
+	}
+}
+
+void GLStateCache::forgetFramebuffer(GLuint _fbo)
+{
+	if (m_drawFramebuffer == _fbo)
+	{
+		m_drawFramebuffer = GL_STATE_CACHE_UNKNOWN;
+	}
+	if (m_readFramebuffer == _fbo)
+	{
+		m_readFramebuffer = GL_STATE_CACHE_UNKNOWN;
+	}
+}
+
+void GLStateCache::resetStats()
+{
+	m_stats.Requested = 0;
+	m_stats.Issued = 0;
+}
+
+bool GLStateCache::changed(bool _differs)
+{
+	m_stats.Requested++;
+	if (_differs)
+	{
+		m_stats.Issued++;
+	}
+	return _differs;
+}
+
+void GLStateCache::useProgram(GLuint _program)
+{
+	if (changed(m_program != _program))
+	{
+		m_program = _program;
+		glUseProgram(_program);
+	}
+}
+
+void GLStateCache::bindVertexArray(GLuint _vao)
+{
+	if (changed(m_vertexArray != _vao))
+	{
+		m_vertexArray = _vao;
+		glBindVertexArray(_vao);
+	}
+}
+
+void GLStateCache::bindFramebuffer(GLenum _target, GLuint _fbo)
+{
+	bool draw = (_target == GL_FRAMEBUFFER || _target == GL_DRAW_FRAMEBUFFER);
+	bool read = (_target == GL_FRAMEBUFFER || _target == GL_READ_FRAMEBUFFER);
+	if (changed((draw && m_drawFramebuffer != _fbo) || (read && m_readFramebuffer != _fbo)))
+	{
+		if (draw)
+		{
+			m_drawFramebuffer = _fbo;
+		}
+		if (read)
+		{
+			m_readFramebuffer = _fbo;
+		}
+		glBindFramebuffer(_target, _fbo);
+	}
+}
+
+void GLStateCache::activeTexture(GLenum _unit)
+{
+	unsigned int unit = _unit - GL_TEXTURE0;
+	if (changed(m_activeUnit != unit))
+	{
+		m_activeUnit = unit;
+		glActiveTexture(_unit);
+	}
+}
+
+GLuint* GLStateCache::getTextureSlot(unsigned int _unit, GLenum _target)
+{
+	if (_unit >= GL_STATE_CACHE_MAX_TEXTURE_UNITS)
+	{
+		return nullptr;
+	}
+
+	switch (_target)
+	{
+	case GL_TEXTURE_2D:
+		return &m_textureUnits[_unit].Texture2D;
+	case GL_TEXTURE_CUBE_MAP:
+		return &m_textureUnits[_unit].TextureCubeMap;
+	case GL_TEXTURE_2D_MULTISAMPLE:
+		return &m_textureUnits[_unit].Texture2DMultisample;
+	default:
+		return nullptr;
+	}
+}
+
+void GLStateCache::bindTexture(GLenum _target, GLuint _texture)
+{
+	GLuint* slot = getTextureSlot(m_activeUnit, _target);
+	if (changed(!slot || *slot != _texture))
+	{
+		if (slot)
+		{
+			*slot = _texture;
+		}
+		glBindTexture(_target, _texture);
+	}
+}
+
+void GLStateCache::bindTextureUnit(unsigned int _unit, GLenum _target, GLuint _texture)
+{
+	GLuint* slot = getTextureSlot(_unit, _target);
+	if (slot && *slot == _texture)
+	{
+		changed(false);
+		return;
+	}
+
+	activeTexture(GL_TEXTURE0 + _unit);
+	bindTexture(_target, _texture);
+}
+
+int GLStateCache::getCapIndex(GLenum _cap) const
+{
+	for (int i = 0; i < 8; i++)
+	{
+		if (s_cachedCaps[i] == _cap)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+void GLStateCache::setEnabled(GLenum _cap, bool _enabled)
+{
+	int index = getCapIndex(_cap);
+	if (changed(index < 0 || m_caps[index] != (_enabled ? 1 : 0)))
+	{
+		if (index >= 0)
+		{
+			m_caps[index] = _enabled ? 1 : 0;
+		}
+
+		if (_enabled)
+		{
+			glEnable(_cap);
+		}
+		else
+		{
+			glDisable(_cap);
+		}
+	}
+}
+
+void GLStateCache::enable(GLenum _cap)
+{
+	setEnabled(_cap, true);
+}
+
+void GLStateCache::disable(GLenum _cap)
+{
+	setEnabled(_cap, false);
+}
+
+bool GLStateCache::isEnabled(GLenum _cap)
+{
+	int index = getCapIndex(_cap);
+	if (index < 0)
+	{
+		return glIsEnabled(_cap) == GL_TRUE;
+	}
+
+	if (m_caps[index] < 0)
+	{
+		m_caps[index] = glIsEnabled(_cap) == GL_TRUE ? 1 : 0;
+	}
+	return m_caps[index] == 1;
+}
+
+void GLStateCache::blendFunc(GLenum _src, GLenum _dst)
+{
+	blendFuncSeparate(_src, _dst, _src, _dst);
+}
+
+void GLStateCache::blendFuncSeparate(GLenum _srcRGB, GLenum _dstRGB, GLenum _srcAlpha, GLenum _dstAlpha)
+{
+	if (changed(m_blend[0] != _srcRGB || m_blend[1] != _dstRGB || m_blend[2] != _srcAlpha || m_blend[3] != _dstAlpha))
+	{
+		m_blend[0] = _srcRGB;
+		m_blend[1] = _dstRGB;
+		m_blend[2] = _srcAlpha;
+		m_blend[3] = _dstAlpha;
+		glBlendFuncSeparate(_srcRGB, _dstRGB, _srcAlpha, _dstAlpha);
+	}
+}
+
+void GLStateCache::depthFunc(GLenum _func)
+{
+	if (changed(m_depthFunc != _func))
+	{
+		m_depthFunc = _func;
+		glDepthFunc(_func);
+	}
+}
+
+void GLStateCache::depthMask(GLboolean _mask)
+{
+	if (changed(m_depthMask != (GLuint)_mask))
+	{
+		m_depthMask = _mask;
+		glDepthMask(_mask);
+	}
+}
+
+void GLStateCache::cullFace(GLenum _mode)
+{
+	if (changed(m_cullFace != _mode))
+	{
+		m_cullFace = _mode;
+		glCullFace(_mode);
+	}
+}
+
+void GLStateCache::frontFace(GLenum _mode)
+{
+	if (changed(m_frontFace != _mode))
+	{
+		m_frontFace = _mode;
+		glFrontFace(_mode);
+	}
+}
+
+void GLStateCache::stencilFunc(GLenum _func, GLint _ref, GLuint _mask)
+{
+	if (changed(!m_stencilFuncKnown || m_stencilFunc != _func || m_stencilRef != _ref || m_stencilFuncMask != _mask))
+	{
+		m_stencilFuncKnown = true;
+		m_stencilFunc = _func;
+		m_stencilRef = _ref;
+		m_stencilFuncMask = _mask;
+		glStencilFunc(_func, _ref, _mask);
+	}
+}
+
+void GLStateCache::stencilOp(GLenum _sfail, GLenum _dpfail, GLenum _dppass)
+{
+	if (changed(m_stencilOp[0] != _sfail || m_stencilOp[1] != _dpfail || m_stencilOp[2] != _dppass))
+	{
+		m_stencilOp[0] = _sfail;
+		m_stencilOp[1] = _dpfail;
+		m_stencilOp[2] = _dppass;
+		glStencilOp(_sfail, _dpfail, _dppass);
+	}
+}
+
+void GLStateCache::stencilMask(GLuint _mask)
+{
+	if (changed(!m_stencilMaskKnown || m_stencilMask != _mask))
+	{
+		m_stencilMaskKnown = true;
+		m_stencilMask = _mask;
+		glStencilMask(_mask);
+	}
+}
+
+void GLStateCache::viewport(GLint _x, GLint _y, GLsizei _width, GLsizei _height)
+{
+	if (changed(m_viewport[0] != _x || m_viewport[1] != _y || m_viewport[2] != _width || m_viewport[3] != _height))
+	{
+		m_viewport[0] = _x;
+		m_viewport[1] = _y;
+		m_viewport[2] = _width;
+		m_viewport[3] = _height;
+		glViewport(_x, _y, _width, _height);
+	}
+}
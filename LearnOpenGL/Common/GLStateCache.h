@@ -0,0 +1,129 @@
+#ifndef GL_STATE_CACHE_H
+#define GL_STATE_CACHE_H
+
+#include <GL/glew.h>
+
+// Texture units shadowed by the cache, binds on higher units go straight to GL
+#define GL_STATE_CACHE_MAX_TEXTURE_UNITS 32
+
+// Value used for state that was never set or was invalidated, the next request always reaches GL
+#define GL_STATE_CACHE_UNKNOWN 0xFFFFFFFFu
+
+// State change counters since the last GLStateCache::resetStats()
+struct GLStateStats
+{
+	unsigned int Requested;	// calls made to the cache
+	unsigned int Issued;	// calls forwarded to GL because the state actually changed
+};
+
+// Shadows the bound program, VAO, framebuffers, textures and fixed-function state
+// so that redundant binds never reach the driver.
+// Every bind has to go through the cache, call invalidate() after touching GL directly.
+class GLStateCache
+{
+private:
+
+	static GLStateCache *m_instance;
+
+	GLStateCache();
+
+	~GLStateCache();
+
+public:
+
+	static void Init();
+	static void Destroy();
+
+	// Created on first use, the cache does not need GL at construction
+	static GLStateCache* getInstance();
+
+	// Forget everything, next request of each state is forwarded to GL
+	void invalidate();
+
+	// Call before deleting a texture or framebuffer, GL reuses names and a stale
+	// binding of the old object would make the bind of a new one look redundant
+	void forgetTexture(GLuint _texture);
+	void forgetFramebuffer(GLuint _fbo);
+
+	void useProgram(GLuint _program);
+	void bindVertexArray(GLuint _vao);
+
+	// GL_FRAMEBUFFER binds both draw and read targets
+	void bindFramebuffer(GLenum _target, GLuint _fbo);
+
+	void activeTexture(GLenum _unit);
+	void bindTexture(GLenum _target, GLuint _texture);
+
+	// Bind to a unit, glActiveTexture is only issued if the unit binding changes
+	void bindTextureUnit(unsigned int _unit, GLenum _target, GLuint _texture);
+
+	void enable(GLenum _cap);
+	void disable(GLenum _cap);
+	void setEnabled(GLenum _cap, bool _enabled);
+
+	// Asks GL only while the cap is unknown to the cache
+	bool isEnabled(GLenum _cap);
+
+	void blendFunc(GLenum _src, GLenum _dst);
+	void blendFuncSeparate(GLenum _srcRGB, GLenum _dstRGB, GLenum _srcAlpha, GLenum _dstAlpha);
+	void depthFunc(GLenum _func);
+	void depthMask(GLboolean _mask);
+	void cullFace(GLenum _mode);
+	void frontFace(GLenum _mode);
+	void stencilFunc(GLenum _func, GLint _ref, GLuint _mask);
+	void stencilOp(GLenum _sfail, GLenum _dpfail, GLenum _dppass);
+	void stencilMask(GLuint _mask);
+	void viewport(GLint _x, GLint _y, GLsizei _width, GLsizei _height);
+
+	GLuint getProgram() const { return m_program; }
+	GLuint getVertexArray() const { return m_vertexArray; }
+	GLuint getDrawFramebuffer() const { return m_drawFramebuffer; }
+
+	const GLStateStats& getStats() const { return m_stats; }
+	void resetStats();
+
+private:
+
+	// Bindings of one texture unit, one slot per target used by the demos
+	struct TextureUnit
+	{
+		GLuint Texture2D;
+		GLuint TextureCubeMap;
+		GLuint Texture2DMultisample;
+	};
+
+	GLuint* getTextureSlot(unsigned int _unit, GLenum _target);
+	int getCapIndex(GLenum _cap) const;
+
+	// Counts the request, returns true when the caller has to issue the GL call
+	bool changed(bool _differs);
+
+	GLuint m_program;
+	GLuint m_vertexArray;
+	GLuint m_drawFramebuffer;
+	GLuint m_readFramebuffer;
+
+	unsigned int m_activeUnit;
+	TextureUnit m_textureUnits[GL_STATE_CACHE_MAX_TEXTURE_UNITS];
+
+	// -1 unknown, 0 disabled, 1 enabled
+	signed char m_caps[8];
+
+	GLenum m_blend[4];
+	GLenum m_depthFunc;
+	GLuint m_depthMask;
+	GLenum m_cullFace;
+	GLenum m_frontFace;
+	GLenum m_stencilFunc;
+	GLint m_stencilRef;
+	GLuint m_stencilFuncMask;
+	bool m_stencilFuncKnown;	// every mask is a valid value, so no sentinel for these
+	GLenum m_stencilOp[3];
+	GLuint m_stencilMask;
+	bool m_stencilMaskKnown;
+	GLint m_viewport[4];
+
+	GLStateStats m_stats;
+};
+
+#endif
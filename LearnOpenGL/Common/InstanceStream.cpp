@@ -0,0 +1,148 @@
+#include "InstanceStream.h"
+
+#include <chrono>
+#include <iostream>
+
+// Wait granularity while the GPU holds a region, in nanoseconds
+#define INSTANCE_STREAM_WAIT_TIMEOUT 1000000
+
+InstanceStream::InstanceStream(unsigned int _regionSize, FrameContext* _frameContext)
+	: m_buffer(0), m_regionSize(_regionSize), m_region(0), m_persistent(isPersistentSupported()), m_frameContext(_frameContext), m_mapped(nullptr)
+{
+	for (int i = 0; i < INSTANCE_STREAM_REGIONS; i++)
+	{
+		m_fences[i] = 0;
+	}
+	resetStats();
+
+	glGenBuffers(1, &m_buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+
+	if (m_persistent)
+	{
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_ARRAY_BUFFER, (GLsizeiptr)m_regionSize * INSTANCE_STREAM_REGIONS, NULL, flags);
+		m_mapped = static_cast<unsigned char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, (GLsizeiptr)m_regionSize * INSTANCE_STREAM_REGIONS, flags));
+		if (m_mapped == nullptr)
+		{
+			std::cout << "ERROR::INSTANCE_STREAM::MAP_FAILED, falling back to buffer orphaning" << std::endl;
+			glDeleteBuffers(1, &m_buffer);
+			glGenBuffers(1, &m_buffer);
+			glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+			m_persistent = false;
+		}
+	}
+
+	if (!m_persistent)
+	{
+		glBufferData(GL_ARRAY_BUFFER, m_regionSize, NULL, GL_STREAM_DRAW);
+		m_staging.resize(m_regionSize);
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+InstanceStream::~InstanceStream()
+{
+	for (int i = 0; i < INSTANCE_STREAM_REGIONS; i++)
+	{
+		if (m_fences[i])
+		{
+			glDeleteSync(m_fences[i]);
+		}
+	}
+
+	if (m_mapped)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+	glDeleteBuffers(1, &m_buffer);
+}
+
+bool InstanceStream::isPersistentSupported()
+{
+	return GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+}
+
+void InstanceStream::resetStats()
+{
+	m_stats.Frames = 0;
+	m_stats.Stalls = 0;
+	m_stats.LastStallMilliseconds = 0.0;
+	m_stats.TotalStallMilliseconds = 0.0;
+}
+
+void* InstanceStream::Map()
+{
+	m_stats.Frames++;
+	m_stats.LastStallMilliseconds = 0.0;
+
+	if (!m_persistent)
+	{
+		return m_staging.data();
+	}
+
+	// BeginFrame() already waited for the frames that read this region
+	if (m_frameContext)
+	{
+		m_region = m_frameContext->getFrameIndex();
+		return m_mapped + m_region * m_regionSize;
+	}
+
+	GLsync fence = m_fences[m_region];
+	if (fence)
+	{
+		// Only a fence that is not signaled yet costs time
+		GLenum result = glClientWaitSync(fence, 0, 0);
+		if (result == GL_TIMEOUT_EXPIRED)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			do
+			{
+				result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, INSTANCE_STREAM_WAIT_TIMEOUT);
+			} while (result == GL_TIMEOUT_EXPIRED);
+
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+			m_stats.Stalls++;
+			m_stats.LastStallMilliseconds = elapsed.count();
+			m_stats.TotalStallMilliseconds += elapsed.count();
+		}
+
+		if (result == GL_WAIT_FAILED)
+		{
+			std::cout << "ERROR::INSTANCE_STREAM::WAIT_FAILED" << std::endl;
+		}
+
+		glDeleteSync(fence);
+		m_fences[m_region] = 0;
+	}
+
+	return m_mapped + m_region * m_regionSize;
+}
+
+void InstanceStream::Unmap(unsigned int _bytesWritten)
+{
+	if (m_persistent || _bytesWritten == 0)
+	{
+		return;
+	}
+
+	// Orphan the old storage so the upload never waits on draws still reading it
+	glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+	glBufferData(GL_ARRAY_BUFFER, m_regionSize, NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, _bytesWritten, m_staging.data());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstanceStream::Fence()
+{
+	if (!m_persistent || m_frameContext)
+	{
+		return;
+	}
+
+	m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	m_region = (m_region + 1) % INSTANCE_STREAM_REGIONS;
+}
@@ -0,0 +1,69 @@
+#ifndef INSTANCE_STREAM_H
+#define INSTANCE_STREAM_H
+
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "FrameContext.h"
+
+// Frames the CPU may run ahead of the GPU, one buffer region each
+#define INSTANCE_STREAM_REGIONS FRAME_CONTEXT_MAX_FRAMES
+
+struct InstanceStreamStats
+{
+	unsigned int Frames;
+	unsigned int Stalls;			// Map() calls that had to wait for the GPU
+	double LastStallMilliseconds;
+	double TotalStallMilliseconds;
+};
+
+// Per frame instance data written straight into GPU memory.
+// With GL 4.4 / ARB_buffer_storage the buffer is mapped once, persistent and coherent, and split
+// in INSTANCE_STREAM_REGIONS regions; a fence per region makes the CPU wait only when it catches up
+// with a region the GPU is still reading. Older contexts fall back to orphaning one region.
+//
+// Each frame: Map(), write, Unmap(bytes), draw from getBuffer() at getOffset(), Fence().
+// Given a FrameContext the stream uses its frame index as region and its fences instead of its own.
+class InstanceStream
+{
+public:
+	InstanceStream(unsigned int _regionSize, FrameContext* _frameContext = nullptr);
+	~InstanceStream();
+
+	// Pointer to this frame's region, waits if the GPU still reads it
+	void* Map();
+
+	// Uploads on the fallback path, nothing to do when persistent
+	void Unmap(unsigned int _bytesWritten);
+
+	// After the last draw reading this frame's region, moves to the next region. Nothing to do with a FrameContext.
+	void Fence();
+
+	GLuint getBuffer() const { return m_buffer; }
+	unsigned int getOffset() const { return m_persistent ? m_region * m_regionSize : 0; }
+	unsigned int getRegionSize() const { return m_regionSize; }
+	bool isPersistent() const { return m_persistent; }
+
+	const InstanceStreamStats& getStats() const { return m_stats; }
+	void resetStats();
+
+	static bool isPersistentSupported();
+
+private:
+	GLuint m_buffer;
+	unsigned int m_regionSize;
+	unsigned int m_region;
+	bool m_persistent;
+	FrameContext* m_frameContext;
+
+	unsigned char* m_mapped;
+	GLsync m_fences[INSTANCE_STREAM_REGIONS];
+
+	// Fallback staging memory
+	std::vector<unsigned char> m_staging;
+
+	InstanceStreamStats m_stats;
+};
+
+#endif
@@ -0,0 +1,373 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+JobSystem* JobSystem::m_instance = nullptr;
+
+// Queue of the current thread, workers set theirs on start
+static thread_local unsigned int t_queueIndex = 0;
+
+unsigned int JobSystem::currentQueue() const
+{
+	// Threads of another job system (the benchmark makes its own) share queue 0
+	return t_queueIndex < m_queues.size() ? t_queueIndex : 0;
+}
+
+JobSystem::JobSystem(unsigned int _threadCount)
+	: m_mainThread(std::this_thread::get_id()), m_running(true), m_queued(0), m_executed(0), m_stolen(0), m_splits(0)
+{
+	_threadCount = std::max(1u, _threadCount);
+	for (unsigned int i = 0; i < _threadCount; i++)
+	{
+		m_queues.push_back(new Queue());
+	}
+	for (unsigned int i = 1; i < _threadCount; i++)
+	{
+		m_threads.push_back(std::thread(&JobSystem::workerLoop, this, i));
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_sleepLock);
+		m_running = false;
+	}
+	m_wake.notify_all();
+	for (auto& thread : m_threads)
+	{
+		thread.join();
+	}
+	for (auto queue : m_queues)
+	{
+		delete queue;
+	}
+}
+
+void JobSystem::Init(unsigned int _threadCount)
+{
+	if (_threadCount == 0)
+	{
+		_threadCount = std::max(1u, std::thread::hardware_concurrency());
+	}
+	delete m_instance;
+	m_instance = new JobSystem(_threadCount);
+}
+
+void JobSystem::Destroy()
+{
+	delete m_instance;
+	m_instance = nullptr;
+}
+
+JobSystem* JobSystem::getInstance()
+{
+	if (!m_instance)
+	{
+		Init();
+	}
+	return m_instance;
+}
+
+JobSystemStats JobSystem::getStats() const
+{
+	JobSystemStats stats;
+	stats.Executed = m_executed;
+	stats.Stolen = m_stolen;
+	stats.Splits = m_splits;
+	return stats;
+}
+
+void JobSystem::resetStats()
+{
+	m_executed = 0;
+	m_stolen = 0;
+	m_splits = 0;
+}
+
+void JobSystem::Run(const std::function<void()>& _task, JobCounter* _counter, JobCounter* _dependency, JobAffinity _affinity)
+{
+	Job job = { _task, nullptr, 0, 0, 0, _counter, _affinity };
+	if (_counter)
+	{
+		_counter->m_pending++;
+	}
+
+	if (_dependency)
+	{
+		// Checked under the lock the last finishing job takes, so the job is either held or released, never lost
+		std::lock_guard<std::mutex> lock(_dependency->m_lock);
+		if (_dependency->m_pending > 0)
+		{
+			_dependency->m_waiting.push_back(job);
+			return;
+		}
+	}
+
+	enqueue(job);
+}
+
+void JobSystem::Wait(JobCounter* _counter)
+{
+	unsigned int queue = currentQueue();
+	while (!_counter->isDone())
+	{
+		if (!runOne(queue))
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	// The last job may still hold the lock it released waiting jobs under
+	std::lock_guard<std::mutex> lock(_counter->m_lock);
+}
+
+void JobSystem::ParallelFor(unsigned int _count, unsigned int _grain, const JobRange& _body)
+{
+	if (_count == 0)
+	{
+		return;
+	}
+
+	JobCounter counter;
+	unsigned int queue = currentQueue();
+	if (_grain == 0)
+	{
+		// One job for the whole range, halved on demand
+		unsigned int grain = std::max(1u, _count / (getThreadCount() * JOB_SYSTEM_SPLITS_PER_THREAD));
+		Job job = { nullptr, &_body, 0, _count, grain, &counter, JOB_AFFINITY_ANY };
+		counter.m_pending++;
+		push(queue, job);
+	}
+	else
+	{
+		// Pushed back to front so the owner pops them in order while thieves take the far end
+		unsigned int jobCount = (_count + _grain - 1) / _grain;
+		counter.m_pending += jobCount;
+		for (unsigned int i = jobCount; i-- > 0;)
+		{
+			Job job = { nullptr, &_body, i * _grain, std::min(_count, (i + 1) * _grain), 0, &counter, JOB_AFFINITY_ANY };
+			push(queue, job);
+		}
+	}
+
+	Wait(&counter);
+}
+
+unsigned int JobSystem::PumpMainThread()
+{
+	unsigned int count = 0;
+	Job job;
+	while (popMain(job))
+	{
+		execute(currentQueue(), job);
+		count++;
+	}
+	return count;
+}
+
+void JobSystem::enqueue(const Job& _job)
+{
+	if (_job.Affinity == JOB_AFFINITY_MAIN)
+	{
+		std::lock_guard<std::mutex> lock(m_mainQueue.Lock);
+		m_mainQueue.Jobs.push_back(_job);
+		return;
+	}
+	push(currentQueue(), _job);
+}
+
+void JobSystem::push(unsigned int _queue, const Job& _job)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_queues[_queue]->Lock);
+		m_queues[_queue]->Jobs.push_back(_job);
+		m_queued++;
+	}
+
+	// Taking the lock orders the notify after a sleeper checked m_queued
+	{
+		std::lock_guard<std::mutex> lock(m_sleepLock);
+	}
+	m_wake.notify_one();
+}
+
+bool JobSystem::pop(unsigned int _queue, Job& _job)
+{
+	std::lock_guard<std::mutex> lock(m_queues[_queue]->Lock);
+	if (m_queues[_queue]->Jobs.empty())
+	{
+		return false;
+	}
+	_job = m_queues[_queue]->Jobs.back();
+	m_queues[_queue]->Jobs.pop_back();
+	m_queued--;
+	return true;
+}
+
+bool JobSystem::popMain(Job& _job)
+{
+	if (!isMainThread())
+	{
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mainQueue.Lock);
+	if (m_mainQueue.Jobs.empty())
+	{
+		return false;
+	}
+	_job = m_mainQueue.Jobs.front();
+	m_mainQueue.Jobs.pop_front();
+	return true;
+}
+
+bool JobSystem::steal(unsigned int _thief, Job& _job)
+{
+	unsigned int count = (unsigned int)m_queues.size();
+	for (unsigned int i = 1; i < count; i++)
+	{
+		Queue* victim = m_queues[(_thief + i) % count];
+		std::lock_guard<std::mutex> lock(victim->Lock);
+		if (!victim->Jobs.empty())
+		{
+			_job = victim->Jobs.front();
+			victim->Jobs.pop_front();
+			m_queued--;
+			m_stolen++;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool JobSystem::isEmpty(unsigned int _queue)
+{
+	std::lock_guard<std::mutex> lock(m_queues[_queue]->Lock);
+	return m_queues[_queue]->Jobs.empty();
+}
+
+bool JobSystem::runOne(unsigned int _queue)
+{
+	Job job;
+	if (!popMain(job) && !pop(_queue, job) && !steal(_queue, job))
+	{
+		return false;
+	}
+
+	execute(_queue, job);
+	return true;
+}
+
+void JobSystem::execute(unsigned int _queue, Job& _job)
+{
+	if (_job.Task)
+	{
+		_job.Task();
+	}
+	else if (_job.Grain == 0)
+	{
+		(*_job.Body)(_job.Begin, _job.End);
+	}
+	else
+	{
+		unsigned int begin = _job.Begin;
+		unsigned int end = _job.End;
+		while (begin < end)
+		{
+			// Keep half of what is left stealable whenever this thread's queue ran dry
+			if (end - begin >= 2 * _job.Grain && isEmpty(_queue))
+			{
+				Job half = _job;
+				half.Begin = begin + (end - begin) / 2;
+				half.End = end;
+				end = half.Begin;
+				_job.Counter->m_pending++;
+				push(_queue, half);
+				m_splits++;
+				continue;
+			}
+
+			unsigned int chunkEnd = std::min(end, begin + _job.Grain);
+			(*_job.Body)(begin, chunkEnd);
+			begin = chunkEnd;
+		}
+	}
+
+	m_executed++;
+	finish(_job.Counter);
+}
+
+void JobSystem::finish(JobCounter* _counter)
+{
+	if (!_counter)
+	{
+		return;
+	}
+
+	std::vector<Job> released;
+	{
+		std::lock_guard<std::mutex> lock(_counter->m_lock);
+		if (--_counter->m_pending == 0)
+		{
+			released.swap(_counter->m_waiting);
+		}
+	}
+
+	for (const Job& job : released)
+	{
+		enqueue(job);
+	}
+}
+
+void JobSystem::workerLoop(unsigned int _queue)
+{
+	t_queueIndex = _queue;
+	while (m_running)
+	{
+		if (runOne(_queue))
+		{
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_sleepLock);
+		m_wake.wait(lock, [this]() { return m_queued > 0 || !m_running; });
+	}
+}
+
+void JobSystem::benchmark(unsigned int _maxThreads, std::vector<double>& _milliseconds)
+{
+	// Uneven work per item, the cost grows along the range so fixed slices would not balance
+	const unsigned int count = 1 << 20;
+	const int iterations = 5;
+	std::vector<float> results(count);
+	JobRange body = [&results](unsigned int _begin, unsigned int _end)
+	{
+		for (unsigned int i = _begin; i < _end; i++)
+		{
+			float value = (float)i;
+			for (unsigned int step = 0; step < 1 + (i >> 16); step++)
+			{
+				value = std::sqrt(value + 1.0f) + std::sin(value);
+			}
+			results[i] = value;
+		}
+	};
+
+	_milliseconds.clear();
+	for (unsigned int threads = 1; threads <= std::max(1u, _maxThreads); threads++)
+	{
+		JobSystem system(threads);
+		double best = 0.0;
+		for (int i = 0; i < iterations; i++)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			system.ParallelFor(count, 0, body);
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+			best = (i == 0) ? elapsed.count() : std::min(best, elapsed.count());
+		}
+		_milliseconds.push_back(best);
+	}
+}
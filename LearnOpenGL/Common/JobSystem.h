@@ -0,0 +1,147 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Adaptive ParallelFor ranges are not split below 1 / (threads * this) of the loop
+#define JOB_SYSTEM_SPLITS_PER_THREAD 16
+
+// Body of a parallel loop, called with a sub range [_begin, _end)
+typedef std::function<void(unsigned int _begin, unsigned int _end)> JobRange;
+
+enum JobAffinity
+{
+	JOB_AFFINITY_ANY = 0,
+	JOB_AFFINITY_MAIN,		// GL work, only run by the thread that created the job system
+};
+
+class JobCounter;
+
+struct Job
+{
+	std::function<void()> Task;		// a single job, or else a range of Body
+	const JobRange* Body;
+	unsigned int Begin;
+	unsigned int End;
+	unsigned int Grain;				// adaptive ranges split down to this size, 0 runs the range whole
+	JobCounter* Counter;
+	JobAffinity Affinity;
+};
+
+// Number of unfinished jobs in a group. Jobs can be held back until a counter reaches zero.
+// A counter has to outlive its jobs, JobSystem::Wait() makes that safe for stack counters.
+class JobCounter
+{
+public:
+	JobCounter() : m_pending(0) {}
+
+	bool isDone() const { return m_pending == 0; }
+
+private:
+	friend class JobSystem;
+
+	std::atomic<unsigned int> m_pending;
+	std::mutex m_lock;
+	std::vector<Job> m_waiting;
+};
+
+// Counters since the last JobSystem::resetStats()
+struct JobSystemStats
+{
+	unsigned int Executed;	// jobs run on any thread
+	unsigned int Stolen;	// jobs taken from another thread's queue
+	unsigned int Splits;	// adaptive ranges halved because a queue ran dry
+};
+
+// Worker threads with one job deque each. A thread pushes and pops its own jobs at the back,
+// idle threads steal from the front of the others, so the work spreads without a shared queue.
+// Threads that wait for jobs run jobs meanwhile; jobs with JOB_AFFINITY_MAIN only run on the
+// main thread, in Wait() or PumpMainThread().
+class JobSystem
+{
+private:
+
+	static JobSystem *m_instance;
+
+	JobSystem(unsigned int _threadCount);
+
+	~JobSystem();
+
+public:
+
+	// 0 uses every hardware thread, the calling thread included. The calling thread becomes the main thread.
+	static void Init(unsigned int _threadCount = 0);
+	static void Destroy();
+
+	// Created on first use with every hardware thread
+	static JobSystem* getInstance();
+
+	// Queue _task, counted by _counter until done. With a _dependency it starts once that counter reaches zero.
+	void Run(const std::function<void()>& _task, JobCounter* _counter = nullptr, JobCounter* _dependency = nullptr,
+		JobAffinity _affinity = JOB_AFFINITY_ANY);
+
+	// Run jobs on this thread until _counter reaches zero
+	void Wait(JobCounter* _counter);
+
+	// Split [0, _count) in chunks of _grain items and run them on all threads, returns once all are done.
+	// A _grain of 0 adapts: a range is halved whenever its thread has nothing left for others to steal.
+	void ParallelFor(unsigned int _count, unsigned int _grain, const JobRange& _body);
+
+	// Run the main thread jobs queued so far, once per frame. Returns how many ran.
+	unsigned int PumpMainThread();
+
+	bool isMainThread() const { return std::this_thread::get_id() == m_mainThread; }
+
+	// Worker threads plus the calling thread
+	unsigned int getThreadCount() const { return (unsigned int)m_queues.size(); }
+
+	JobSystemStats getStats() const;
+	void resetStats();
+
+	// Milliseconds of the same adaptive ParallelFor with 1 to _maxThreads threads, one entry each
+	static void benchmark(unsigned int _maxThreads, std::vector<double>& _milliseconds);
+
+private:
+	struct Queue
+	{
+		std::mutex Lock;
+		std::deque<Job> Jobs;
+	};
+
+	unsigned int currentQueue() const;
+	void enqueue(const Job& _job);
+	void push(unsigned int _queue, const Job& _job);
+	bool pop(unsigned int _queue, Job& _job);
+	bool popMain(Job& _job);
+	bool steal(unsigned int _thief, Job& _job);
+	bool isEmpty(unsigned int _queue);
+	bool runOne(unsigned int _queue);
+	void execute(unsigned int _queue, Job& _job);
+	void finish(JobCounter* _counter);
+	void workerLoop(unsigned int _queue);
+
+	// Queue 0 belongs to the threads that are not workers
+	std::vector<Queue*> m_queues;
+	std::vector<std::thread> m_threads;
+	std::thread::id m_mainThread;
+
+	// Never stolen, only popped by the main thread
+	Queue m_mainQueue;
+
+	std::atomic<bool> m_running;
+	std::atomic<unsigned int> m_queued;
+	std::mutex m_sleepLock;
+	std::condition_variable m_wake;
+
+	std::atomic<unsigned int> m_executed;
+	std::atomic<unsigned int> m_stolen;
+	std::atomic<unsigned int> m_splits;
+};
+
+#endif
@@ -1,4 +1,6 @@
 #include "Mesh.h"
+#include "GLStateCache.h"
+#include "CommandBuffer.h"
 
 #include <GL/glew.h>
 
@@ -9,47 +11,46 @@ Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std:
 	this->textures = textures;
 
 	setupMesh();
+	setupTextureBindings();
 }
 
 void Mesh::Draw(Shader* shader)
 {
-	unsigned int diffuseNr = 0;
-	unsigned int specualrNr = 0;
-	for(unsigned int i = 0; i < textures.size(); i++)
+	GLStateCache* state = GLStateCache::getInstance();
+
+	// Sampler locations are cached per program and the shader skips values its program already holds,
+	// so this loop does no allocation, no name lookup and no redundant uniform upload
+	for (unsigned int i = 0; i < textureBindings.size(); i++)
 	{
-		glActiveTexture(GL_TEXTURE0 + i); // activate texture unit before binding
-		// retrieve texture number
-		std::stringstream ss;
-		std::string number;
-		std::string name = textures[i].type;
-		if (name == "diffuse")
+		TextureBinding& binding = textureBindings[i];
+		if (binding.program != shader->Program)
 		{
-			if (diffuseNr > 0)
-			{
-				ss << diffuseNr;
-			}
-			diffuseNr++;
+			binding.program = shader->Program;
+			binding.location = shader->getUniformPosition(binding.uniformName.c_str());
 		}
-		else if(name == "specular")
-		{
-			if (specualrNr > 0)
-			{
-				ss << specualrNr;
-			}
-			specualrNr++;
-		}
-		number = ss.str();
-
-		shader->setFloat(("material." + name + number).c_str(), i);
-		glBindTexture(GL_TEXTURE_2D, textures[i].id);
+		shader->setInt(binding.location, binding.unit);
+		// Meshes sharing a material leave the units untouched
+		state->bindTextureUnit(binding.unit, GL_TEXTURE_2D, binding.textureId);
 	}
 
-	glActiveTexture(GL_TEXTURE_2D);
+	state->activeTexture(GL_TEXTURE0);
 
-	// draw mesh
-	glBindVertexArray(VAO);
+	// draw mesh, the VAO stays bound so the next draw of this mesh needs no bind
+	state->bindVertexArray(VAO);
 	glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-	glBindVertexArray(0);
+}
+
+void Mesh::Record(CommandBuffer& buffer) const
+{
+	for (unsigned int i = 0; i < textureBindings.size(); i++)
+	{
+		const TextureBinding& binding = textureBindings[i];
+		buffer.setInt(binding.uniformName.c_str(), binding.unit);
+		buffer.bindTexture(binding.unit, GL_TEXTURE_2D, binding.textureId);
+	}
+
+	buffer.bindVertexArray(VAO);
+	buffer.drawElements(GL_TRIANGLES, (GLsizei)indices.size(), 0);
 }
 
 void Mesh::Release()
@@ -65,7 +66,7 @@ void Mesh::setupMesh()
 	glGenVertexArrays(1, &VAO);
 	glGenBuffers(1, &EBO);
 
-	glBindVertexArray(VAO);
+	GLStateCache::getInstance()->bindVertexArray(VAO);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO);
 	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
 
@@ -85,7 +86,45 @@ void Mesh::setupMesh()
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
 
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
+}
+
+void Mesh::setupTextureBindings()
+{
+	unsigned int diffuseNr = 0;
+	unsigned int specularNr = 0;
+	textureBindings.clear();
+	textureBindings.reserve(textures.size());
+	for (unsigned int i = 0; i < textures.size(); i++)
+	{
+		// retrieve texture number, the first of each type has none (material.diffuse, material.diffuse1, ...)
+		std::stringstream ss;
+		std::string name = textures[i].type;
+		if (name == "diffuse")
+		{
+			if (diffuseNr > 0)
+			{
+				ss << diffuseNr;
+			}
+			diffuseNr++;
+		}
+		else if (name == "specular")
+		{
+			if (specularNr > 0)
+			{
+				ss << specularNr;
+			}
+			specularNr++;
+		}
+
+		TextureBinding binding;
+		binding.unit = i;
+		binding.textureId = textures[i].id;
+		binding.uniformName = "material." + name + ss.str();
+		binding.program = 0;
+		binding.location = -1;
+		textureBindings.push_back(binding);
+	}
 }
 
 Mesh::~Mesh()
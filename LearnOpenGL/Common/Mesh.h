@@ -9,6 +9,8 @@
 
 #include "Shader.h"
 
+class CommandBuffer;
+
 struct Vertex {
 	glm::vec3 Position;
 	glm::vec3 Normal;
@@ -21,6 +23,16 @@ struct Texture {
 	std::string path;
 };
 
+// Texture of a mesh resolved at load to the unit and sampler uniform it binds to,
+// the sampler location is looked up again only when the mesh is drawn with another program
+struct TextureBinding {
+	unsigned int unit;
+	unsigned int textureId;
+	std::string uniformName;
+	GLuint program;
+	GLint location;
+};
+
 class Mesh
 {
 
@@ -29,16 +41,20 @@ public:
 	Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures);
 	~Mesh(); 
 	void Draw(Shader* shader);
+	// Same as Draw but into a command buffer, safe to call from a worker thread
+	void Record(CommandBuffer& buffer) const;
 	void Release();
 
 private:
 	void setupMesh();
+	void setupTextureBindings();
 
 /* Mesh Data */
 public:
 	std::vector<Vertex> vertices;
 	std::vector<unsigned int> indices;
 	std::vector<Texture> textures;
+	std::vector<TextureBinding> textureBindings;
 
 public:
 	unsigned int VAO, VBO, EBO;
@@ -1,5 +1,9 @@
 #include "Model.h"
+#include "GLStateCache.h"
+#include "JobSystem.h"
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 
 #include <GL/glew.h>
@@ -7,6 +11,7 @@
 
 
 Model::Model(char *path)
+	: m_indirectVAO(0), m_indirectVBO(0), m_indirectEBO(0), m_instanceVBO(0), m_indirectBuffer(0), m_instanceCapacity(0)
 {
 	loadModel(path);
 }
@@ -17,12 +22,199 @@ void Model::Draw(Shader* shader)
 		meshes[i].Draw(shader);
 }
 
+void Model::Record(CommandBuffer& buffer) const
+{
+	for (unsigned int i = 0; i < meshes.size(); i++)
+		meshes[i].Record(buffer);
+}
+
 void Model::Release()
 {
 	for (unsigned int i = 0; i < meshes.size(); i++)
 		meshes[i].Release();
+
+	if (m_indirectVAO != 0)
+	{
+		glDeleteVertexArrays(1, &m_indirectVAO);
+		glDeleteBuffers(1, &m_indirectVBO);
+		glDeleteBuffers(1, &m_indirectEBO);
+		glDeleteBuffers(1, &m_instanceVBO);
+		glDeleteBuffers(1, &m_indirectBuffer);
+		m_indirectVAO = 0;
+	}
+}
+
+bool Model::isMultiDrawIndirectSupported()
+{
+	return GLEW_VERSION_4_3 || (GLEW_ARB_multi_draw_indirect && GLEW_ARB_base_instance);
+}
+
+void Model::setupIndirect()
+{
+	// Group meshes by the textures they bind, each group becomes one contiguous command range
+	std::vector<unsigned int> order;
+	for (unsigned int i = 0; i < meshes.size(); i++)
+	{
+		order.push_back(i);
+	}
+	std::stable_sort(order.begin(), order.end(), [this](unsigned int a, unsigned int b)
+	{
+		const std::vector<TextureBinding>& bindingsA = meshes[a].textureBindings;
+		const std::vector<TextureBinding>& bindingsB = meshes[b].textureBindings;
+		return std::lexicographical_compare(bindingsA.begin(), bindingsA.end(), bindingsB.begin(), bindingsB.end(),
+			[](const TextureBinding& x, const TextureBinding& y) { return x.textureId < y.textureId; });
+	});
+
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+	m_indirectCommands.clear();
+	m_indirectBatches.clear();
+
+	for (unsigned int i = 0; i < order.size(); i++)
+	{
+		const Mesh& mesh = meshes[order[i]];
+
+		DrawElementsIndirectCommand command;
+		command.count = (GLuint)mesh.indices.size();
+		command.instanceCount = 0;
+		command.firstIndex = (GLuint)indices.size();
+		command.baseVertex = (GLint)vertices.size();
+		// Every mesh is drawn for all copies, so they all start at the first instance matrix
+		command.baseInstance = 0;
+
+		vertices.insert(vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+		indices.insert(indices.end(), mesh.indices.begin(), mesh.indices.end());
+
+		bool sameMaterial = !m_indirectBatches.empty() && m_indirectBatches.back().textureBindings.size() == mesh.textureBindings.size() &&
+			std::equal(mesh.textureBindings.begin(), mesh.textureBindings.end(), m_indirectBatches.back().textureBindings.begin(),
+				[](const TextureBinding& x, const TextureBinding& y) { return x.textureId == y.textureId && x.unit == y.unit; });
+		if (!sameMaterial)
+		{
+			IndirectBatch batch;
+			batch.textureBindings = mesh.textureBindings;
+			batch.firstCommand = (unsigned int)m_indirectCommands.size();
+			batch.commandCount = 0;
+			m_indirectBatches.push_back(batch);
+		}
+		m_indirectBatches.back().commandCount++;
+		m_indirectCommands.push_back(command);
+	}
+
+	glGenVertexArrays(1, &m_indirectVAO);
+	glGenBuffers(1, &m_indirectVBO);
+	glGenBuffers(1, &m_indirectEBO);
+	glGenBuffers(1, &m_instanceVBO);
+	glGenBuffers(1, &m_indirectBuffer);
+
+	GLStateCache::getInstance()->bindVertexArray(m_indirectVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, m_indirectVBO);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+	glEnableVertexAttribArray(2);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indirectEBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+
+	// mat4 per copy, one column per attribute
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		glEnableVertexAttribArray(MODEL_INSTANCE_ATTRIBUTE + i);
+		glVertexAttribPointer(MODEL_INSTANCE_ATTRIBUTE + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(i * sizeof(glm::vec4)));
+		glVertexAttribDivisor(MODEL_INSTANCE_ATTRIBUTE + i, 1);
+	}
+
+	GLStateCache::getInstance()->bindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
+void Model::DrawIndirect(Shader* shader, const glm::mat4* instances, unsigned int instanceCount)
+{
+	if (m_indirectVAO == 0)
+	{
+		setupIndirect();
+	}
+
+	if (instanceCount == 0 || m_indirectCommands.empty())
+	{
+		return;
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+	if (instanceCount > m_instanceCapacity)
+	{
+		m_instanceCapacity = instanceCount;
+		glBufferData(GL_ARRAY_BUFFER, instanceCount * sizeof(glm::mat4), instances, GL_DYNAMIC_DRAW);
+	}
+	else
+	{
+		glBufferSubData(GL_ARRAY_BUFFER, 0, instanceCount * sizeof(glm::mat4), instances);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	bool multiDraw = isMultiDrawIndirectSupported();
+	if (multiDraw && m_indirectCommands[0].instanceCount != instanceCount)
+	{
+		for (auto& command : m_indirectCommands)
+		{
+			command.instanceCount = instanceCount;
+		}
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer);
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, m_indirectCommands.size() * sizeof(DrawElementsIndirectCommand), m_indirectCommands.data(), GL_DYNAMIC_DRAW);
+	}
+
+	GLStateCache* state = GLStateCache::getInstance();
+	state->bindVertexArray(m_indirectVAO);
+	if (multiDraw)
+	{
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer);
+	}
+
+	for (const IndirectBatch& batch : m_indirectBatches)
+	{
+		for (const TextureBinding& binding : batch.textureBindings)
+		{
+			shader->setInt(binding.uniformName.c_str(), binding.unit);
+			state->bindTextureUnit(binding.unit, GL_TEXTURE_2D, binding.textureId);
+		}
+
+		if (multiDraw)
+		{
+			glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)(batch.firstCommand * sizeof(DrawElementsIndirectCommand)), batch.commandCount, 0);
+		}
+		else
+		{
+			// GL 3.3 fallback, same draws one call each
+			for (unsigned int i = batch.firstCommand; i < batch.firstCommand + batch.commandCount; i++)
+			{
+				const DrawElementsIndirectCommand& command = m_indirectCommands[i];
+				glDrawElementsInstancedBaseVertex(GL_TRIANGLES, command.count, GL_UNSIGNED_INT, (void*)(command.firstIndex * sizeof(GLuint)), instanceCount, command.baseVertex);
+			}
+		}
+	}
+
+	if (multiDraw)
+	{
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+	state->activeTexture(GL_TEXTURE0);
+}
+
+// Image of a material texture, decoded on a worker and uploaded on the main thread
+struct DecodedTexture
+{
+	std::string path;
+	std::string type;
+	int width;
+	int height;
+	unsigned char* pixels;
+};
+
 void Model::loadModel(std::string path)
 {
 	Assimp::Importer importer;
@@ -36,32 +228,92 @@ void Model::loadModel(std::string path)
 
 	directory = path.substr(0, path.find_last_of('/'));
 
-	processNode(scene->mRootNode, scene);
+	// Every texture the materials use, once
+	std::vector<DecodedTexture> decodedTextures;
+	const aiTextureType types[] = { aiTextureType_DIFFUSE, aiTextureType_SPECULAR };
+	const char* typeNames[] = { "diffuse", "specular" };
+	for (unsigned int m = 0; m < scene->mNumMaterials; m++)
+	{
+		for (int t = 0; t < 2; t++)
+		{
+			for (unsigned int i = 0; i < scene->mMaterials[m]->GetTextureCount(types[t]); i++)
+			{
+				aiString str;
+				scene->mMaterials[m]->GetTexture(types[t], i, &str);
+				bool known = std::any_of(decodedTextures.begin(), decodedTextures.end(),
+					[&str](const DecodedTexture& texture) { return texture.path == str.C_Str(); });
+				if (!known)
+				{
+					DecodedTexture texture = { str.C_Str(), typeNames[t], 0, 0, nullptr };
+					decodedTextures.push_back(texture);
+				}
+			}
+		}
+	}
+
+	// Decode on any thread, upload each one on the main thread as soon as its image is ready
+	JobSystem* jobs = JobSystem::getInstance();
+	unsigned int textureCount = (unsigned int)decodedTextures.size();
+	std::vector<JobCounter> decoded(textureCount);
+	JobCounter uploaded;
+	textures_loaded.resize(textureCount);
+	for (unsigned int i = 0; i < textureCount; i++)
+	{
+		DecodedTexture* texture = &decodedTextures[i];
+		jobs->Run([this, texture]()
+		{
+			texture->pixels = stbi_load((directory + "/" + texture->path).c_str(), &texture->width, &texture->height, 0, 3);
+		}, &decoded[i]);
+
+		Texture* loaded = &textures_loaded[i];
+		jobs->Run([texture, loaded]()
+		{
+			loaded->id = TextureFromImage(texture->pixels, texture->width, texture->height);
+			loaded->type = texture->type;
+			loaded->path = texture->path;
+			stbi_image_free(texture->pixels);
+		}, &uploaded, &decoded[i], JOB_AFFINITY_MAIN);
+	}
+
+	// Geometry converts meanwhile, one job per mesh; GL objects are made on this thread afterwards
+	std::vector<aiMesh*> sceneMeshes;
+	processNode(scene->mRootNode, scene, sceneMeshes);
+	std::vector<std::vector<Vertex>> vertices(sceneMeshes.size());
+	std::vector<std::vector<unsigned int>> indices(sceneMeshes.size());
+	jobs->ParallelFor((unsigned int)sceneMeshes.size(), 1, [&](unsigned int _begin, unsigned int _end)
+	{
+		for (unsigned int i = _begin; i < _end; i++)
+		{
+			convertMesh(sceneMeshes[i], vertices[i], indices[i]);
+		}
+	});
+	jobs->Wait(&uploaded);
+
+	for (unsigned int i = 0; i < sceneMeshes.size(); i++)
+	{
+		meshes.push_back(processMesh(sceneMeshes[i], scene, vertices[i], indices[i]));
+	}
 }
 
-void Model::processNode(aiNode* node, const aiScene* scene)
+void Model::processNode(aiNode* node, const aiScene* scene, std::vector<aiMesh*>& sceneMeshes)
 {
 
 	// Process meshes
 	for (unsigned int i = 0; i < node->mNumMeshes; i++)
 	{
-		aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-		meshes.push_back(processMesh(mesh, scene));
+		sceneMeshes.push_back(scene->mMeshes[node->mMeshes[i]]);
 	}
 
 	// Process children of node
 	for (unsigned int i = 0; i < node->mNumChildren; i++)
 	{
-		processNode(node->mChildren[i], scene);
+		processNode(node->mChildren[i], scene, sceneMeshes);
 	}
 }
 
-Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene)
+void Model::convertMesh(const aiMesh* mesh, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
 {
-	std::vector<Vertex> vertices;
-	std::vector<unsigned int> indices;
-	std::vector<Texture> textures;
-
+	vertices.reserve(mesh->mNumVertices);
 	for (unsigned int i = 0; i < mesh->mNumVertices; i++)
 	{
 		Vertex vertex;
@@ -94,6 +346,11 @@ Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene)
 			indices.push_back(face.mIndices[j]);
 		}
 	}
+}
+
+Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+	std::vector<Texture> textures;
 
 	// process materials
 	if (mesh->mMaterialIndex >= 0)
@@ -118,37 +375,40 @@ std::vector<Texture> Model::loadMaterialTextures(aiMaterial* mat, aiTextureType
 		bool skip = false;
 		for (unsigned int j = 0; j < textures_loaded.size(); j++)
 		{
-			if (std::strcmp(textures_loaded[i].path.c_str(), str.C_Str()) == 0)
+			if (std::strcmp(textures_loaded[j].path.c_str(), str.C_Str()) == 0)
 			{
-				textures.push_back(textures_loaded[i]);
+				// Same image may serve as another type in this material
+				Texture texture = textures_loaded[j];
+				texture.type = typeName;
+				textures.push_back(texture);
 				skip = true;
 				break;
 			}
 		}
 		if (!skip)
 		{
+			int width, height;
+			unsigned char* image = stbi_load((directory + "/" + str.C_Str()).c_str(), &width, &height, 0, 3);
 			Texture texture;
-			texture.id = TextureFromFile(str.C_Str(), directory);
+			texture.id = TextureFromImage(image, width, height);
 			texture.type = typeName;
 			texture.path = str.C_Str();
 			textures.push_back(texture);
 			textures_loaded.push_back(texture); // add to loaded textures
+			stbi_image_free(image);
 		}
 	}
 
 	return textures;
 }
 
-unsigned int Model::TextureFromFile(std::string file, std::string directory)
+unsigned int Model::TextureFromImage(const unsigned char* image, int width, int height)
 {
-	int width, height;
-	unsigned char* image = stbi_load((directory + "/" + file).c_str(), &width, &height, 0, 3);
-
 	unsigned int id;
 
 	glGenTextures(1, &id);
 
-	glBindTexture(GL_TEXTURE_2D, id);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, id);
 
 	// Set Texture Parameters
 	// Set Weap function
@@ -162,10 +422,7 @@ unsigned int Model::TextureFromFile(std::string file, std::string directory)
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
 	glGenerateMipmap(GL_TEXTURE_2D);
 
-	glBindTexture(GL_TEXTURE_2D, 0);
-
-	stbi_image_free(image);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
 
 	return id;
 }
-
@@ -11,20 +11,54 @@
 #include "Mesh.h"
 #include "Shader.h"
 
+// Model matrices of the copies drawn by Model::DrawIndirect are read from attributes 3 to 6
+#define MODEL_INSTANCE_ATTRIBUTE 3
+
+// Layout glMultiDrawElementsIndirect reads from GL_DRAW_INDIRECT_BUFFER
+struct DrawElementsIndirectCommand
+{
+	GLuint count;
+	GLuint instanceCount;
+	GLuint firstIndex;
+	GLint baseVertex;
+	GLuint baseInstance;
+};
+
+// Meshes sharing the same textures, drawn with one indirect call
+struct IndirectBatch
+{
+	std::vector<TextureBinding> textureBindings;
+	unsigned int firstCommand;
+	unsigned int commandCount;
+};
+
 class Model
 {
 
 public:
 	Model(char *path);
 	void Draw(Shader* shader);
+	void Record(CommandBuffer& buffer) const;
+
+	// Draw every mesh for each model matrix with one multi-draw per material.
+	// The shader has to read its model matrix from the instance attribute.
+	void DrawIndirect(Shader* shader, const glm::mat4* instances, unsigned int instanceCount);
+
+	// GL calls a DrawIndirect issues for its draws, one per material batch
+	unsigned int getIndirectBatchCount() const { return (unsigned int)m_indirectBatches.size(); }
+
+	static bool isMultiDrawIndirectSupported();
 
 	void Release();
 private:
 	void loadModel(std::string path);
-	void processNode(aiNode* node, const aiScene* scene);
-	Mesh processMesh(aiMesh* mesh, const aiScene* scene);
+	void processNode(aiNode* node, const aiScene* scene, std::vector<aiMesh*>& sceneMeshes);
+	// CPU side only, safe on any thread
+	static void convertMesh(const aiMesh* mesh, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+	Mesh processMesh(aiMesh* mesh, const aiScene* scene, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
 	std::vector<Texture> loadMaterialTextures(aiMaterial* mat, aiTextureType type, std::string typeName);
-	unsigned int TextureFromFile(std::string file, std::string directory);
+	static unsigned int TextureFromImage(const unsigned char* image, int width, int height);
+	void setupIndirect();
 
 public:
 	std::vector<Mesh> meshes;
@@ -33,6 +67,16 @@ public:
 private:
 	/* Model Data */
 	std::string directory;
+
+	/* Merged geometry for DrawIndirect, built on first use */
+	GLuint m_indirectVAO;
+	GLuint m_indirectVBO;
+	GLuint m_indirectEBO;
+	GLuint m_instanceVBO;
+	GLuint m_indirectBuffer;
+	unsigned int m_instanceCapacity;
+	std::vector<DrawElementsIndirectCommand> m_indirectCommands;
+	std::vector<IndirectBatch> m_indirectBatches;
 };
 
 #endif
@@ -0,0 +1,359 @@
+#include "OcclusionCulling.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+#include <emmintrin.h>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+// Clip space w below this is treated as crossing the near plane
+static const float s_nearW = 1.0e-4f;
+
+OcclusionCuller::OcclusionCuller(unsigned int _width, unsigned int _height)
+{
+	m_tilesX = std::max(1u, (_width + OCCLUSION_TILE_SIZE - 1) / OCCLUSION_TILE_SIZE);
+	m_tilesY = std::max(1u, (_height + OCCLUSION_TILE_SIZE - 1) / OCCLUSION_TILE_SIZE);
+	m_width = m_tilesX * OCCLUSION_TILE_SIZE;
+	m_height = m_tilesY * OCCLUSION_TILE_SIZE;
+
+	m_depth.assign(m_width * m_height, 1.0f);
+	m_tileDepth.assign(m_tilesX * m_tilesY, 1.0f);
+
+	m_stats.Occluders = 0;
+	m_stats.Triangles = 0;
+	m_stats.Tested = 0;
+	m_stats.Occluded = 0;
+	m_stats.RasterMilliseconds = 0.0;
+	m_stats.TestMilliseconds = 0.0;
+}
+
+void OcclusionCuller::Begin(const glm::mat4& _viewProjection)
+{
+	m_viewProjection = _viewProjection;
+	std::fill(m_depth.begin(), m_depth.end(), 1.0f);
+	std::fill(m_tileDepth.begin(), m_tileDepth.end(), 1.0f);
+
+	m_stats.Occluders = 0;
+	m_stats.Triangles = 0;
+	m_stats.Tested = 0;
+	m_stats.Occluded = 0;
+	m_stats.RasterMilliseconds = 0.0;
+	m_stats.TestMilliseconds = 0.0;
+}
+
+void OcclusionCuller::AddOccluder(const glm::vec3* _positions, unsigned int _vertexCount, unsigned int _stride,
+	const unsigned int* _indices, unsigned int _indexCount, const glm::mat4& _model)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	glm::mat4 modelViewProjection = m_viewProjection * _model;
+	m_clipPositions.resize(_vertexCount);
+	const unsigned char* data = reinterpret_cast<const unsigned char*>(_positions);
+	for (unsigned int i = 0; i < _vertexCount; i++)
+	{
+		const glm::vec3& position = *reinterpret_cast<const glm::vec3*>(data + i * _stride);
+		m_clipPositions[i] = modelViewProjection * glm::vec4(position, 1.0f);
+	}
+
+	for (unsigned int i = 0; i + 2 < _indexCount; i += 3)
+	{
+		rasterizeTriangle(m_clipPositions[_indices[i]], m_clipPositions[_indices[i + 1]], m_clipPositions[_indices[i + 2]]);
+	}
+
+	m_stats.Occluders++;
+	m_stats.Triangles += _indexCount / 3;
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+	m_stats.RasterMilliseconds += elapsed.count();
+}
+
+void OcclusionCuller::AddOccluderBox(const glm::vec3& _min, const glm::vec3& _max, const glm::mat4& _model)
+{
+	glm::vec3 corners[8];
+	for (int i = 0; i < 8; i++)
+	{
+		corners[i] = glm::vec3((i & 1) ? _max.x : _min.x, (i & 2) ? _max.y : _min.y, (i & 4) ? _max.z : _min.z);
+	}
+
+	static const unsigned int indices[36] =
+	{
+		0, 2, 1, 1, 2, 3,	// -z
+		4, 5, 6, 5, 7, 6,	// +z
+		0, 1, 4, 1, 5, 4,	// -y
+		2, 6, 3, 3, 6, 7,	// +y
+		0, 4, 2, 2, 4, 6,	// -x
+		1, 3, 5, 3, 7, 5	// +x
+	};
+	AddOccluder(corners, 8, sizeof(glm::vec3), indices, 36, _model);
+}
+
+void OcclusionCuller::rasterizeTriangle(const glm::vec4& _v0, const glm::vec4& _v1, const glm::vec4& _v2)
+{
+	if (_v0.w < s_nearW || _v1.w < s_nearW || _v2.w < s_nearW)
+	{
+		return;
+	}
+
+	// Screen space with pixel centers at .5, depth in [0, 1]
+	glm::vec3 screen[3];
+	const glm::vec4* clip[3] = { &_v0, &_v1, &_v2 };
+	for (int i = 0; i < 3; i++)
+	{
+		float inverseW = 1.0f / clip[i]->w;
+		screen[i].x = (clip[i]->x * inverseW * 0.5f + 0.5f) * m_width;
+		screen[i].y = (clip[i]->y * inverseW * 0.5f + 0.5f) * m_height;
+		screen[i].z = clip[i]->z * inverseW * 0.5f + 0.5f;
+	}
+
+	// Both windings are drawn, occluders are solid from every side
+	float area = (screen[2].x - screen[0].x) * (screen[1].y - screen[0].y) - (screen[2].y - screen[0].y) * (screen[1].x - screen[0].x);
+	if (area == 0.0f)
+	{
+		return;
+	}
+	if (area < 0.0f)
+	{
+		std::swap(screen[1], screen[2]);
+		area = -area;
+	}
+
+	float minX = std::min(screen[0].x, std::min(screen[1].x, screen[2].x));
+	float maxX = std::max(screen[0].x, std::max(screen[1].x, screen[2].x));
+	float minY = std::min(screen[0].y, std::min(screen[1].y, screen[2].y));
+	float maxY = std::max(screen[0].y, std::max(screen[1].y, screen[2].y));
+
+	int startX = std::max(0, (int)std::floor(minX)) & ~3;
+	int endX = std::min((int)m_width - 1, (int)std::ceil(maxX));
+	int startY = std::max(0, (int)std::floor(minY));
+	int endY = std::min((int)m_height - 1, (int)std::ceil(maxY));
+	if (startX > endX || startY > endY)
+	{
+		return;
+	}
+
+	// edge(a, b, p) = A * p.x + B * p.y + C, positive on the inner side of every edge
+	__m128 edgeA[3], edgeB[3], edgeC[3];
+	for (int i = 0; i < 3; i++)
+	{
+		const glm::vec3& a = screen[(i + 1) % 3];
+		const glm::vec3& b = screen[(i + 2) % 3];
+		float A = b.y - a.y;
+		float B = a.x - b.x;
+		edgeA[i] = _mm_set1_ps(A);
+		edgeB[i] = _mm_set1_ps(B);
+		edgeC[i] = _mm_set1_ps(-a.x * A - a.y * B);
+	}
+
+	// The edge opposite a vertex weights its depth
+	float inverseArea = 1.0f / area;
+	__m128 depth0 = _mm_set1_ps(screen[0].z * inverseArea);
+	__m128 depth1 = _mm_set1_ps(screen[1].z * inverseArea);
+	__m128 depth2 = _mm_set1_ps(screen[2].z * inverseArea);
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 laneOffset = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+	for (int y = startY; y <= endY; y++)
+	{
+		__m128 pixelY = _mm_set1_ps(y + 0.5f);
+		float* row = &m_depth[y * m_width];
+		for (int x = startX; x <= endX; x += 4)
+		{
+			__m128 pixelX = _mm_add_ps(_mm_set1_ps((float)x), laneOffset);
+
+			__m128 weight0 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(edgeA[0], pixelX), _mm_mul_ps(edgeB[0], pixelY)), edgeC[0]);
+			__m128 weight1 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(edgeA[1], pixelX), _mm_mul_ps(edgeB[1], pixelY)), edgeC[1]);
+			__m128 weight2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(edgeA[2], pixelX), _mm_mul_ps(edgeB[2], pixelY)), edgeC[2]);
+
+			__m128 inside = _mm_and_ps(_mm_cmpge_ps(weight0, zero), _mm_and_ps(_mm_cmpge_ps(weight1, zero), _mm_cmpge_ps(weight2, zero)));
+			if (_mm_movemask_ps(inside) == 0)
+			{
+				continue;
+			}
+
+			__m128 depth = _mm_add_ps(_mm_mul_ps(weight0, depth0), _mm_add_ps(_mm_mul_ps(weight1, depth1), _mm_mul_ps(weight2, depth2)));
+			__m128 previous = _mm_loadu_ps(row + x);
+			__m128 nearest = _mm_min_ps(previous, depth);
+			_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, previous)));
+		}
+	}
+}
+
+void OcclusionCuller::Finish()
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	for (unsigned int tileY = 0; tileY < m_tilesY; tileY++)
+	{
+		for (unsigned int tileX = 0; tileX < m_tilesX; tileX++)
+		{
+			__m128 farthest = _mm_setzero_ps();
+			for (unsigned int y = 0; y < OCCLUSION_TILE_SIZE; y++)
+			{
+				const float* row = &m_depth[(tileY * OCCLUSION_TILE_SIZE + y) * m_width + tileX * OCCLUSION_TILE_SIZE];
+				for (unsigned int x = 0; x < OCCLUSION_TILE_SIZE; x += 4)
+				{
+					farthest = _mm_max_ps(farthest, _mm_loadu_ps(row + x));
+				}
+			}
+
+			float lanes[4];
+			_mm_storeu_ps(lanes, farthest);
+			m_tileDepth[tileY * m_tilesX + tileX] = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+		}
+	}
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+	m_stats.RasterMilliseconds += elapsed.count();
+}
+
+bool OcclusionCuller::IsVisible(const glm::vec3& _min, const glm::vec3& _max) const
+{
+	float minX = (float)m_width, maxX = 0.0f;
+	float minY = (float)m_height, maxY = 0.0f;
+	float nearest = 1.0f;
+	for (int i = 0; i < 8; i++)
+	{
+		glm::vec4 corner((i & 1) ? _max.x : _min.x, (i & 2) ? _max.y : _min.y, (i & 4) ? _max.z : _min.z, 1.0f);
+		glm::vec4 clip = m_viewProjection * corner;
+		if (clip.w < s_nearW)
+		{
+			return true;
+		}
+
+		float inverseW = 1.0f / clip.w;
+		float x = (clip.x * inverseW * 0.5f + 0.5f) * m_width;
+		float y = (clip.y * inverseW * 0.5f + 0.5f) * m_height;
+		minX = std::min(minX, x);
+		maxX = std::max(maxX, x);
+		minY = std::min(minY, y);
+		maxY = std::max(maxY, y);
+		nearest = std::min(nearest, clip.z * inverseW * 0.5f + 0.5f);
+	}
+
+	// Occluders cover pixels by their center, one extra pixel around the box keeps silhouettes conservative.
+	// Off screen boxes are the frustum culler's business.
+	int startX = std::max(0, (int)std::floor(minX) - 1);
+	int endX = std::min((int)m_width - 1, (int)std::ceil(maxX));
+	int startY = std::max(0, (int)std::floor(minY) - 1);
+	int endY = std::min((int)m_height - 1, (int)std::ceil(maxY));
+	if (startX > endX || startY > endY)
+	{
+		return true;
+	}
+
+	const __m128 nearestDepth = _mm_set1_ps(nearest);
+	const __m128 laneOffset = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+	const __m128 rectStart = _mm_set1_ps((float)startX);
+	const __m128 rectEnd = _mm_set1_ps((float)endX);
+
+	for (int tileY = startY / OCCLUSION_TILE_SIZE; tileY <= endY / OCCLUSION_TILE_SIZE; tileY++)
+	{
+		for (int tileX = startX / OCCLUSION_TILE_SIZE; tileX <= endX / OCCLUSION_TILE_SIZE; tileX++)
+		{
+			// Everything drawn in the tile is in front of the box
+			if (m_tileDepth[tileY * m_tilesX + tileX] < nearest)
+			{
+				continue;
+			}
+
+			int y0 = std::max(startY, tileY * OCCLUSION_TILE_SIZE);
+			int y1 = std::min(endY, tileY * OCCLUSION_TILE_SIZE + OCCLUSION_TILE_SIZE - 1);
+			for (int y = y0; y <= y1; y++)
+			{
+				const float* row = &m_depth[y * m_width];
+				for (int x = tileX * OCCLUSION_TILE_SIZE; x < (tileX + 1) * OCCLUSION_TILE_SIZE; x += 4)
+				{
+					__m128 pixelX = _mm_add_ps(_mm_set1_ps((float)x), laneOffset);
+					__m128 inRect = _mm_and_ps(_mm_cmpge_ps(pixelX, rectStart), _mm_cmple_ps(pixelX, rectEnd));
+					__m128 behind = _mm_cmpge_ps(_mm_loadu_ps(row + x), nearestDepth);
+					if (_mm_movemask_ps(_mm_and_ps(inRect, behind)))
+					{
+						return true;
+					}
+				}
+			}
+		}
+	}
+	return false;
+}
+
+void OcclusionCuller::Filter(const glm::vec3* _mins, const glm::vec3* _maxs, std::vector<unsigned int>& _indices)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	unsigned int visibleCount = 0;
+	for (unsigned int i = 0; i < _indices.size(); i++)
+	{
+		unsigned int index = _indices[i];
+		if (IsVisible(_mins[index], _maxs[index]))
+		{
+			_indices[visibleCount++] = index;
+		}
+	}
+
+	m_stats.Tested += (unsigned int)_indices.size();
+	m_stats.Occluded += (unsigned int)_indices.size() - visibleCount;
+	_indices.resize(visibleCount);
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+	m_stats.TestMilliseconds += elapsed.count();
+}
+
+void OcclusionCuller::benchmark(unsigned int _boxCount, OcclusionStats& _stats, unsigned int& _trulyOccluded, unsigned int& _falselyOccluded)
+{
+	// Camera at the origin looking down -z, a 20 x 10 wall at z = -20, boxes behind and around it
+	const float wallZ = -20.0f;
+	const glm::vec3 wallMin(-10.0f, -5.0f, wallZ - 1.0f);
+	const glm::vec3 wallMax(10.0f, 5.0f, wallZ);
+
+	std::vector<glm::vec3> mins(_boxCount), maxs(_boxCount);
+	std::vector<unsigned int> indices(_boxCount);
+	for (unsigned int i = 0; i < _boxCount; i++)
+	{
+		glm::vec3 center((float)rand() / RAND_MAX * 80.0f - 40.0f, (float)rand() / RAND_MAX * 30.0f - 15.0f, -25.0f - (float)rand() / RAND_MAX * 75.0f);
+		glm::vec3 extents(0.25f + (float)rand() / RAND_MAX * 0.75f);
+		mins[i] = center - extents;
+		maxs[i] = center + extents;
+		indices[i] = i;
+	}
+
+	OcclusionCuller culler;
+	culler.Begin(glm::perspective(glm::radians(60.0f), 2.0f, 0.1f, 200.0f));
+	culler.AddOccluderBox(wallMin, wallMax, glm::mat4(1.0f));
+	culler.Finish();
+	culler.Filter(mins.data(), maxs.data(), indices);
+	_stats = culler.getStats();
+
+	// Exact answer: a box behind the wall is hidden when the rays to all its corners cross the wall face
+	_trulyOccluded = 0;
+	_falselyOccluded = 0;
+	unsigned int next = 0;
+	for (unsigned int i = 0; i < _boxCount; i++)
+	{
+		bool hidden = true;
+		for (int c = 0; c < 8 && hidden; c++)
+		{
+			glm::vec3 corner((c & 1) ? maxs[i].x : mins[i].x, (c & 2) ? maxs[i].y : mins[i].y, (c & 4) ? maxs[i].z : mins[i].z);
+			float t = wallZ / corner.z;
+			hidden = corner.z < wallZ && std::fabs(corner.x * t) <= wallMax.x && std::fabs(corner.y * t) <= wallMax.y;
+		}
+
+		bool culled = next >= indices.size() || indices[next] != i;
+		if (!culled)
+		{
+			next++;
+		}
+
+		if (hidden)
+		{
+			_trulyOccluded++;
+		}
+		else if (culled)
+		{
+			_falselyOccluded++;
+		}
+	}
+}
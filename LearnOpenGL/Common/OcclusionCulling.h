@@ -0,0 +1,73 @@
+#ifndef OCCLUSION_CULLING_H
+#define OCCLUSION_CULLING_H
+
+#include <vector>
+
+#include "glm/glm.hpp"
+
+// Pixels per side of a hierarchical depth tile, buffer sizes are rounded up to it
+#define OCCLUSION_TILE_SIZE 8
+
+struct OcclusionStats
+{
+	unsigned int Occluders;
+	unsigned int Triangles;
+	unsigned int Tested;
+	unsigned int Occluded;
+	double RasterMilliseconds;
+	double TestMilliseconds;
+};
+
+// Software occlusion culling, GL free.
+// A few large occluders are rasterized with SSE into a small depth buffer, every tile keeps
+// its farthest depth so most boxes are accepted or rejected without touching pixels.
+// Triangles crossing the near plane are skipped, which only ever makes the test more conservative.
+class OcclusionCuller
+{
+public:
+	OcclusionCuller(unsigned int _width = 256, unsigned int _height = 128);
+
+	// Clear the depth buffer for a new view
+	void Begin(const glm::mat4& _viewProjection);
+
+	// Indexed triangles, positions with a byte stride like Vertex::Position
+	void AddOccluder(const glm::vec3* _positions, unsigned int _vertexCount, unsigned int _stride,
+		const unsigned int* _indices, unsigned int _indexCount, const glm::mat4& _model);
+
+	// Solid box, for walls and buildings
+	void AddOccluderBox(const glm::vec3& _min, const glm::vec3& _max, const glm::mat4& _model);
+
+	// Build the tile depths, call once after the last occluder
+	void Finish();
+
+	// False when the world space box is hidden behind the occluders
+	bool IsVisible(const glm::vec3& _min, const glm::vec3& _max) const;
+
+	// Drop the occluded entries of _indices (indices into _mins / _maxs), timed in the stats
+	void Filter(const glm::vec3* _mins, const glm::vec3* _maxs, std::vector<unsigned int>& _indices);
+
+	const OcclusionStats& getStats() const { return m_stats; }
+	unsigned int getWidth() const { return m_width; }
+	unsigned int getHeight() const { return m_height; }
+	const float* getDepth() const { return m_depth.data(); }
+
+	// Wall in front of _boxCount random boxes; counts are checked against the exact answer
+	static void benchmark(unsigned int _boxCount, OcclusionStats& _stats, unsigned int& _trulyOccluded, unsigned int& _falselyOccluded);
+
+private:
+	void rasterizeTriangle(const glm::vec4& _v0, const glm::vec4& _v1, const glm::vec4& _v2);
+
+	unsigned int m_width;
+	unsigned int m_height;
+	unsigned int m_tilesX;
+	unsigned int m_tilesY;
+
+	std::vector<float> m_depth;
+	std::vector<float> m_tileDepth;
+	std::vector<glm::vec4> m_clipPositions;
+
+	glm::mat4 m_viewProjection;
+	OcclusionStats m_stats;
+};
+
+#endif
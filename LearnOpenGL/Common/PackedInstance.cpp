@@ -0,0 +1,123 @@
+#include "PackedInstance.h"
+
+#include <cmath>
+
+#include <emmintrin.h>
+
+glm::mat4 unpackInstance(const PackedInstance& _instance)
+{
+	const glm::vec4& q = _instance.Rotation;
+	float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+	float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+	float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+	float s = _instance.Scale;
+	glm::mat4 result;
+	result[0] = glm::vec4(s * (1.0f - 2.0f * (yy + zz)), s * 2.0f * (xy + wz), s * 2.0f * (xz - wy), 0.0f);
+	result[1] = glm::vec4(s * 2.0f * (xy - wz), s * (1.0f - 2.0f * (xx + zz)), s * 2.0f * (yz + wx), 0.0f);
+	result[2] = glm::vec4(s * 2.0f * (xz + wy), s * 2.0f * (yz - wx), s * (1.0f - 2.0f * (xx + yy)), 0.0f);
+	result[3] = glm::vec4(_instance.Position, 1.0f);
+	return result;
+}
+
+uint64_t SplitMix64::next()
+{
+	uint64_t z = (m_state += 0x9E3779B97F4A7C15ull);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+SplitMix64 SplitMix64::split(uint64_t _key) const
+{
+	// Mix the key through one step so neighbouring keys give unrelated streams
+	SplitMix64 mixer(m_state ^ (_key * 0xD1B54A32D192ED03ull));
+	return SplitMix64(mixer.next());
+}
+
+float SplitMix64::nextFloat()
+{
+	// Top 24 bits fill the float mantissa exactly
+	return (float)(next() >> 40) * (1.0f / 16777216.0f);
+}
+
+void sinCos4(const float* _angles, float* _sines, float* _cosines)
+{
+	const __m128 twoPi = _mm_set1_ps(6.28318530718f);
+	const __m128 inverseTwoPi = _mm_set1_ps(0.159154943092f);
+	const __m128 pi = _mm_set1_ps(3.14159265359f);
+	const __m128 halfPi = _mm_set1_ps(1.57079632679f);
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+
+	// Reduce to [-pi, pi]
+	__m128 x = _mm_loadu_ps(_angles);
+	__m128 turns = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(x, inverseTwoPi)));
+	x = _mm_sub_ps(x, _mm_mul_ps(turns, twoPi));
+
+	// sin(x) = sin(pi - x) folds into [-pi / 2, pi / 2]; cos(x) = sin(x + pi / 2)
+	__m128 angles[2] = { x, _mm_add_ps(x, halfPi) };
+	__m128 results[2];
+	for (int i = 0; i < 2; i++)
+	{
+		__m128 a = angles[i];
+		a = _mm_sub_ps(a, _mm_and_ps(_mm_cmpgt_ps(a, pi), twoPi));
+
+		__m128 sign = _mm_and_ps(a, signMask);
+		__m128 absolute = _mm_andnot_ps(signMask, a);
+		__m128 folded = _mm_or_ps(_mm_and_ps(_mm_cmpgt_ps(absolute, halfPi), _mm_sub_ps(pi, absolute)), _mm_andnot_ps(_mm_cmpgt_ps(absolute, halfPi), absolute));
+		a = _mm_or_ps(folded, sign);
+
+		// Taylor series to x^11 on [-pi / 2, pi / 2]
+		__m128 a2 = _mm_mul_ps(a, a);
+		__m128 p = _mm_set1_ps(-2.50521083854e-8f);
+		p = _mm_add_ps(_mm_mul_ps(p, a2), _mm_set1_ps(2.75573192240e-6f));
+		p = _mm_add_ps(_mm_mul_ps(p, a2), _mm_set1_ps(-1.98412698413e-4f));
+		p = _mm_add_ps(_mm_mul_ps(p, a2), _mm_set1_ps(8.33333333333e-3f));
+		p = _mm_add_ps(_mm_mul_ps(p, a2), _mm_set1_ps(-1.66666666667e-1f));
+		p = _mm_add_ps(_mm_mul_ps(p, a2), _mm_set1_ps(1.0f));
+		results[i] = _mm_mul_ps(p, a);
+	}
+
+	_mm_storeu_ps(_sines, results[0]);
+	_mm_storeu_ps(_cosines, results[1]);
+}
+
+void packInstances(const float* _x, const float* _y, const float* _z, const float* _scales, const float* _angles,
+	const glm::vec3& _axis, unsigned int _count, PackedInstance* _out)
+{
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 axisX = _mm_set1_ps(_axis.x);
+	const __m128 axisY = _mm_set1_ps(_axis.y);
+	const __m128 axisZ = _mm_set1_ps(_axis.z);
+
+	unsigned int i = 0;
+	for (; i + 4 <= _count; i += 4)
+	{
+		float halfAngles[4], sines[4], cosines[4];
+		_mm_storeu_ps(halfAngles, _mm_mul_ps(_mm_loadu_ps(_angles + i), half));
+		sinCos4(halfAngles, sines, cosines);
+		__m128 s = _mm_loadu_ps(sines);
+
+		// Rows are the 8 floats of each instance, transposed from the input columns
+		__m128 positionScale[4] = { _mm_loadu_ps(_x + i), _mm_loadu_ps(_y + i), _mm_loadu_ps(_z + i), _mm_loadu_ps(_scales + i) };
+		__m128 rotation[4] = { _mm_mul_ps(axisX, s), _mm_mul_ps(axisY, s), _mm_mul_ps(axisZ, s), _mm_loadu_ps(cosines) };
+		_MM_TRANSPOSE4_PS(positionScale[0], positionScale[1], positionScale[2], positionScale[3]);
+		_MM_TRANSPOSE4_PS(rotation[0], rotation[1], rotation[2], rotation[3]);
+
+		for (int lane = 0; lane < 4; lane++)
+		{
+			float* out = reinterpret_cast<float*>(&_out[i + lane]);
+			_mm_storeu_ps(out, positionScale[lane]);
+			_mm_storeu_ps(out + 4, rotation[lane]);
+		}
+	}
+
+	for (; i < _count; i++)
+	{
+		float halfAngle = _angles[i] * 0.5f;
+		float s = std::sin(halfAngle);
+		_out[i].Position = glm::vec3(_x[i], _y[i], _z[i]);
+		_out[i].Scale = _scales[i];
+		_out[i].Rotation = glm::vec4(_axis * s, std::cos(halfAngle));
+	}
+}
@@ -0,0 +1,47 @@
+#ifndef PACKED_INSTANCE_H
+#define PACKED_INSTANCE_H
+
+#include <cstdint>
+
+#include "glm/glm.hpp"
+
+// 32 byte instance transform, half of a mat4: world = Position + Scale * rotate(Rotation, local).
+// Read in shaders as two vec4 attributes, see Shaders/Include/PackedInstance.glsl
+struct PackedInstance
+{
+	glm::vec3 Position;
+	float Scale;
+	glm::vec4 Rotation;		// unit quaternion, xyz = axis * sin(angle / 2), w = cos(angle / 2)
+};
+
+glm::mat4 unpackInstance(const PackedInstance& _instance);
+
+// Deterministic generator with 64 bits of state.
+// split() derives an independent stream from a key, so instance i can draw from split(i)
+// and the result does not depend on which thread generated it or in what order.
+class SplitMix64
+{
+public:
+	explicit SplitMix64(uint64_t _seed) : m_state(_seed) {}
+
+	uint64_t next();
+	SplitMix64 split(uint64_t _key) const;
+
+	// [0, 1)
+	float nextFloat();
+	float nextFloat(float _min, float _max) { return _min + (_max - _min) * nextFloat(); }
+
+private:
+	uint64_t m_state;
+};
+
+// Sine and cosine of four angles at once, absolute error below 1e-6 within a few turns;
+// larger angles lose what float spacing already lost in the input
+void sinCos4(const float* _angles, float* _sines, float* _cosines);
+
+// Pack _count instances from structure of arrays input, four at a time.
+// Every rotation turns around the same normalized _axis by its own angle (radians).
+void packInstances(const float* _x, const float* _y, const float* _z, const float* _scales, const float* _angles,
+	const glm::vec3& _axis, unsigned int _count, PackedInstance* _out);
+
+#endif
@@ -0,0 +1,270 @@
+#include "Profiler.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+Profiler* Profiler::m_instance = nullptr;
+
+// Scope names are free text, quotes, backslashes and control characters would break the trace
+static std::string escapeJson(const std::string& _text)
+{
+	std::string result;
+	result.reserve(_text.size());
+	for (char c : _text)
+	{
+		if (c == '"' || c == '\\')
+		{
+			result += '\\';
+			result += c;
+		}
+		else if ((unsigned char)c < 0x20)
+		{
+			char code[7];
+			std::snprintf(code, sizeof(code), "\\u%04x", (unsigned char)c);
+			result += code;
+		}
+		else
+		{
+			result += c;
+		}
+	}
+	return result;
+}
+
+Profiler::Profiler()
+	: m_frameIndex(0), m_inFrame(false), m_capturing(false)
+{
+	m_start = std::chrono::high_resolution_clock::now();
+	for (unsigned int i = 0; i < PROFILER_FRAMES; i++)
+	{
+		glGenQueries(PROFILER_MAX_SCOPES * 2, m_frames[i].Queries);
+		m_frames[i].QueryCount = 0;
+		m_frames[i].GpuToCpu = 0.0;
+		m_frames[i].Recorded = false;
+	}
+	m_stats = ProfilerStats();
+}
+
+Profiler::~Profiler()
+{
+	for (unsigned int i = 0; i < PROFILER_FRAMES; i++)
+	{
+		glDeleteQueries(PROFILER_MAX_SCOPES * 2, m_frames[i].Queries);
+	}
+}
+
+void Profiler::Init()
+{
+	if (!m_instance)
+	{
+		m_instance = new Profiler();
+	}
+}
+
+void Profiler::Destroy()
+{
+	if (m_instance) {
+		delete m_instance;
+		m_instance = nullptr;
+	}
+}
+
+Profiler* Profiler::getInstance()
+{
+	if (!m_instance)
+	{
+		Init();
+	}
+	return m_instance;
+}
+
+double Profiler::now() const
+{
+	std::chrono::duration<double, std::micro> elapsed = std::chrono::high_resolution_clock::now() - m_start;
+	return elapsed.count();
+}
+
+void Profiler::BeginFrame()
+{
+	m_frameIndex = (m_frameIndex + 1) % PROFILER_FRAMES;
+	Frame& frame = m_frames[m_frameIndex];
+	if (frame.Recorded)
+	{
+		resolve(frame);
+	}
+
+	frame.Scopes.clear();
+	frame.QueryCount = 0;
+	frame.Recorded = true;
+	m_open.clear();
+
+	// Both clocks read back to back, good enough to line the GPU track up with the CPU one
+	GLint64 gpuNow = 0;
+	glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+	frame.GpuToCpu = now() - gpuNow / 1000.0;
+
+	m_stats.Frames++;
+	m_inFrame = true;
+	Begin("Frame");
+}
+
+void Profiler::EndFrame()
+{
+	while (!m_open.empty())
+	{
+		End();
+	}
+	m_inFrame = false;
+}
+
+void Profiler::Begin(const std::string& _name, bool _gpu)
+{
+	// Outside BeginFrame() and EndFrame() scopes are not recorded
+	Frame& frame = m_frames[m_frameIndex];
+	if (!m_inFrame || frame.Scopes.size() >= PROFILER_MAX_SCOPES)
+	{
+		m_stats.DroppedScopes += m_inFrame ? 1 : 0;
+		m_open.push_back(PROFILER_MAX_SCOPES);
+		return;
+	}
+
+	Scope scope;
+	scope.Name = _name;
+	scope.Depth = (unsigned int)m_open.size();
+	scope.CpuBegin = now();
+	scope.CpuEnd = scope.CpuBegin;
+	scope.Query = -1;
+	if (_gpu)
+	{
+		scope.Query = (int)frame.QueryCount;
+		glQueryCounter(frame.Queries[frame.QueryCount], GL_TIMESTAMP);
+		frame.QueryCount += 2;
+	}
+
+	m_open.push_back((unsigned int)frame.Scopes.size());
+	frame.Scopes.push_back(scope);
+}
+
+void Profiler::End()
+{
+	if (m_open.empty())
+	{
+		std::cout << "ERROR::PROFILER::END_WITHOUT_BEGIN" << std::endl;
+		return;
+	}
+
+	unsigned int index = m_open.back();
+	m_open.pop_back();
+	if (index >= PROFILER_MAX_SCOPES)
+	{
+		return;
+	}
+
+	Frame& frame = m_frames[m_frameIndex];
+	Scope& scope = frame.Scopes[index];
+	scope.CpuEnd = now();
+	if (scope.Query >= 0)
+	{
+		glQueryCounter(frame.Queries[scope.Query + 1], GL_TIMESTAMP);
+	}
+}
+
+void Profiler::resolve(Frame& _frame)
+{
+	// Timestamps complete in order, once the last one is there all are
+	bool gpuReady = true;
+	if (_frame.QueryCount > 0)
+	{
+		GLint available = 0;
+		glGetQueryObjectiv(_frame.Queries[_frame.QueryCount - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+		gpuReady = available != 0;
+		if (!gpuReady)
+		{
+			m_stats.LateFrames++;
+		}
+	}
+
+	m_results.clear();
+	for (const Scope& scope : _frame.Scopes)
+	{
+		ProfilerResult result;
+		result.Name = scope.Name;
+		result.Depth = scope.Depth;
+		result.CpuMilliseconds = (scope.CpuEnd - scope.CpuBegin) / 1000.0;
+		result.GpuMilliseconds = 0.0;
+
+		GLuint64 gpuBegin = 0;
+		GLuint64 gpuEnd = 0;
+		bool gpu = scope.Query >= 0 && gpuReady;
+		if (gpu)
+		{
+			glGetQueryObjectui64v(_frame.Queries[scope.Query], GL_QUERY_RESULT, &gpuBegin);
+			glGetQueryObjectui64v(_frame.Queries[scope.Query + 1], GL_QUERY_RESULT, &gpuEnd);
+			result.GpuMilliseconds = (gpuEnd - gpuBegin) / 1000000.0;
+		}
+		m_results.push_back(result);
+
+		if (m_capturing && m_events.size() + 2 <= PROFILER_MAX_EVENTS)
+		{
+			TraceEvent cpuEvent = { scope.Name, false, scope.CpuBegin, scope.CpuEnd - scope.CpuBegin };
+			m_events.push_back(cpuEvent);
+			if (gpu)
+			{
+				TraceEvent gpuEvent = { scope.Name, true, gpuBegin / 1000.0 + _frame.GpuToCpu, (gpuEnd - gpuBegin) / 1000.0 };
+				m_events.push_back(gpuEvent);
+			}
+		}
+	}
+	_frame.Recorded = false;
+}
+
+void Profiler::StartCapture()
+{
+	m_events.clear();
+	m_capturing = true;
+}
+
+bool Profiler::StopCapture(const std::string& _path)
+{
+	m_capturing = false;
+
+	std::ofstream file(_path.c_str());
+	if (!file)
+	{
+		std::cout << "ERROR::PROFILER::FILE_NOT_WRITTEN " << _path << std::endl;
+		return false;
+	}
+
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n";
+	file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+	file.setf(std::ios::fixed);
+	file.precision(3);
+	for (const TraceEvent& event : m_events)
+	{
+		file << ",\n{\"name\":\"" << escapeJson(event.Name) << "\",\"cat\":\"" << (event.Gpu ? "gpu" : "cpu") << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+			<< (event.Gpu ? 2 : 1) << ",\"ts\":" << event.Begin << ",\"dur\":" << event.Duration << "}";
+	}
+	file << "\n]}\n";
+
+	std::cout << "Profiler trace: " << m_events.size() << " events written to " << _path << std::endl;
+	m_events.clear();
+	return true;
+}
+
+std::string Profiler::getSummary() const
+{
+	std::string summary;
+	for (const ProfilerResult& result : m_results)
+	{
+		if (result.Depth != 1)
+		{
+			continue;
+		}
+
+		double milliseconds = result.GpuMilliseconds > 0.0 ? result.GpuMilliseconds : result.CpuMilliseconds;
+		summary += (summary.empty() ? " " : ", ") + result.Name + " " + std::to_string(milliseconds);
+	}
+	return summary;
+}
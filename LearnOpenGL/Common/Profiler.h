@@ -0,0 +1,131 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+// Frames between recording GPU timestamps and reading them back, reading earlier would stall
+#define PROFILER_FRAMES 4
+
+// Scopes a frame can hold, more are dropped
+#define PROFILER_MAX_SCOPES 128
+
+// Trace events kept by one capture, a few minutes of a busy demo
+#define PROFILER_MAX_EVENTS 1000000
+
+// Timings of one scope of the last frame read back
+struct ProfilerResult
+{
+	std::string Name;
+	unsigned int Depth;
+	double CpuMilliseconds;
+	double GpuMilliseconds;		// 0 for CPU only scopes
+};
+
+struct ProfilerStats
+{
+	unsigned long long Frames;
+	unsigned int DroppedScopes;		// over PROFILER_MAX_SCOPES
+	unsigned int LateFrames;		// GPU still busy after PROFILER_FRAMES, their GPU times are lost
+};
+
+// CPU and GPU timings of nested scopes, exported as a Chrome trace for chrome://tracing or Perfetto.
+// GPU scopes put a GL_TIMESTAMP query at each end; a frame's queries are read back PROFILER_FRAMES
+// frames later, when the GPU is long done with them, so profiling never waits on the GPU.
+// GPU times are shifted onto the CPU clock, so both show on one timeline.
+//
+// Each frame: BeginFrame(), Begin()/End() or ProfilerScope around the work, EndFrame().
+class Profiler
+{
+private:
+
+	static Profiler *m_instance;
+
+	Profiler();
+
+	~Profiler();
+
+public:
+
+	static void Init();
+	static void Destroy();
+
+	// Created on first use, the GL context has to be current
+	static Profiler* getInstance();
+
+	// Reads back the frame recorded PROFILER_FRAMES ago and opens a "Frame" scope
+	void BeginFrame();
+	void EndFrame();
+
+	// _gpu also times the GL commands issued inside the scope
+	void Begin(const std::string& _name, bool _gpu = true);
+	void End();
+
+	// Every scope read back from now on goes to the trace
+	void StartCapture();
+	// Writes the trace as Chrome trace event JSON, false if the file could not be written
+	bool StopCapture(const std::string& _path);
+	bool isCapturing() const { return m_capturing; }
+
+	// Scopes of the last frame read back, in the order they began
+	const std::vector<ProfilerResult>& getResults() const { return m_results; }
+	// "name ms" of the scopes right below the frame, GPU time or CPU time for CPU only scopes, for window titles
+	std::string getSummary() const;
+	const ProfilerStats& getStats() const { return m_stats; }
+
+private:
+	struct Scope
+	{
+		std::string Name;
+		unsigned int Depth;
+		double CpuBegin;		// microseconds since the profiler started
+		double CpuEnd;
+		int Query;				// first of two queries in the frame, -1 for CPU only
+	};
+
+	struct Frame
+	{
+		std::vector<Scope> Scopes;
+		GLuint Queries[PROFILER_MAX_SCOPES * 2];
+		unsigned int QueryCount;
+		double GpuToCpu;		// microseconds to add to a GPU timestamp to land on the CPU clock
+		bool Recorded;
+	};
+
+	struct TraceEvent
+	{
+		std::string Name;
+		bool Gpu;
+		double Begin;
+		double Duration;
+	};
+
+	double now() const;
+	void resolve(Frame& _frame);
+
+	Frame m_frames[PROFILER_FRAMES];
+	unsigned int m_frameIndex;
+	bool m_inFrame;
+	std::vector<unsigned int> m_open;	// indices in the current frame's scopes, PROFILER_MAX_SCOPES for unrecorded ones
+
+	std::chrono::high_resolution_clock::time_point m_start;
+
+	bool m_capturing;
+	std::vector<TraceEvent> m_events;
+
+	std::vector<ProfilerResult> m_results;
+	ProfilerStats m_stats;
+};
+
+// Times the enclosing block
+class ProfilerScope
+{
+public:
+	ProfilerScope(const std::string& _name, bool _gpu = true) { Profiler::getInstance()->Begin(_name, _gpu); }
+	~ProfilerScope() { Profiler::getInstance()->End(); }
+};
+
+#endif
@@ -0,0 +1,360 @@
+#include "RenderGraph.h"
+#include "GLStateCache.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <iostream>
+
+RenderGraphResource RenderGraphBuilder::Create(const std::string& _name, const RenderGraphTextureDesc& _desc)
+{
+	RenderGraph::Resource resource = { _name, _desc, m_pass, std::vector<unsigned int>(), -1 };
+	m_graph->m_resources.push_back(resource);
+	RenderGraphResource handle = (RenderGraphResource)m_graph->m_resources.size() - 1;
+
+	RenderGraph::Pass& pass = m_graph->m_passes[m_pass];
+	bool depth = _desc.InternalFormat == GL_DEPTH_COMPONENT24 || _desc.InternalFormat == GL_DEPTH_COMPONENT;
+	if (depth)
+	{
+		pass.Depth = (int)handle;
+	}
+	else
+	{
+		pass.Colors.push_back(handle);
+	}
+	return handle;
+}
+
+void RenderGraphBuilder::Read(RenderGraphResource _resource)
+{
+	if (_resource >= m_graph->m_resources.size())
+	{
+		std::cout << "ERROR::RENDER_GRAPH::UNKNOWN_RESOURCE read by " << m_graph->m_passes[m_pass].Name << std::endl;
+		return;
+	}
+	m_graph->m_passes[m_pass].Reads.push_back(_resource);
+	m_graph->m_resources[_resource].Readers.push_back(m_pass);
+}
+
+void RenderGraphBuilder::WriteBackbuffer()
+{
+	m_graph->m_passes[m_pass].Backbuffer = true;
+}
+
+RenderGraph::RenderGraph()
+{
+	m_stats = RenderGraphStats();
+}
+
+RenderGraph::~RenderGraph()
+{
+	Reset();
+	for (const Texture& texture : m_textures)
+	{
+		RenderTargetPool::getInstance()->Release(texture.Target);
+	}
+}
+
+void RenderGraph::AddPass(const std::string& _name, const RenderGraphSetup& _setup, const RenderGraphExecute& _execute)
+{
+	Pass pass;
+	pass.Name = _name;
+	pass.Execute = _execute;
+	pass.Depth = -1;
+	pass.Backbuffer = false;
+	pass.Culled = false;
+	pass.Framebuffer = 0;
+	m_passes.push_back(pass);
+
+	RenderGraphBuilder builder(this, (unsigned int)m_passes.size() - 1);
+	_setup(builder);
+}
+
+void RenderGraph::Reset()
+{
+	for (const Pass& pass : m_passes)
+	{
+		if (pass.Framebuffer)
+		{
+			GLStateCache::getInstance()->forgetFramebuffer(pass.Framebuffer);
+			glDeleteFramebuffers(1, &pass.Framebuffer);
+		}
+	}
+	m_passes.clear();
+	m_resources.clear();
+	m_order.clear();
+}
+
+void RenderGraph::Compile()
+{
+	cull();
+	order();
+	assignTextures();
+	createFramebuffers();
+}
+
+void RenderGraph::cull()
+{
+	// Readers always come after their writer, so one walk from the back settles every pass
+	for (unsigned int i = (unsigned int)m_passes.size(); i-- > 0;)
+	{
+		Pass& pass = m_passes[i];
+		bool needed = pass.Backbuffer;
+		std::vector<RenderGraphResource> outputs = pass.Colors;
+		if (pass.Depth >= 0)
+		{
+			outputs.push_back((RenderGraphResource)pass.Depth);
+		}
+		for (RenderGraphResource output : outputs)
+		{
+			for (unsigned int reader : m_resources[output].Readers)
+			{
+				needed = needed || !m_passes[reader].Culled;
+			}
+		}
+		pass.Culled = !needed;
+	}
+}
+
+void RenderGraph::order()
+{
+	// Kahn's algorithm over the live passes, ties keep the order they were added in
+	unsigned int count = (unsigned int)m_passes.size();
+	std::vector<unsigned int> waitingOn(count, 0);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		waitingOn[i] = (unsigned int)m_passes[i].Reads.size();
+	}
+
+	m_order.clear();
+	std::vector<bool> done(count, false);
+	for (;;)
+	{
+		unsigned int next = count;
+		for (unsigned int i = 0; i < count && next == count; i++)
+		{
+			if (!done[i] && waitingOn[i] == 0)
+			{
+				next = i;
+			}
+		}
+		if (next == count)
+		{
+			break;
+		}
+
+		done[next] = true;
+		if (!m_passes[next].Culled)
+		{
+			m_order.push_back(next);
+		}
+		for (unsigned int i = 0; i < count; i++)
+		{
+			for (RenderGraphResource read : m_passes[i].Reads)
+			{
+				if (m_resources[read].Writer == next)
+				{
+					waitingOn[i]--;
+				}
+			}
+		}
+	}
+
+	if (std::count(done.begin(), done.end(), false) > 0)
+	{
+		std::cout << "ERROR::RENDER_GRAPH::CYCLE, passes left out" << std::endl;
+	}
+}
+
+void RenderGraph::assignTextures()
+{
+	std::vector<int> position(m_passes.size(), -1);
+	for (unsigned int i = 0; i < m_order.size(); i++)
+	{
+		position[m_order[i]] = (int)i;
+	}
+
+	// Lifetime of every live transient, from its writer to its last reader
+	std::vector<unsigned int> live;
+	std::vector<int> first(m_resources.size(), -1), last(m_resources.size(), -1);
+	for (unsigned int i = 0; i < m_resources.size(); i++)
+	{
+		Resource& resource = m_resources[i];
+		resource.Texture = -1;
+		if (position[resource.Writer] < 0)
+		{
+			continue;
+		}
+		first[i] = last[i] = position[resource.Writer];
+		for (unsigned int reader : resource.Readers)
+		{
+			last[i] = std::max(last[i], position[reader]);
+		}
+		live.push_back(i);
+	}
+	std::stable_sort(live.begin(), live.end(), [&first](unsigned int a, unsigned int b) { return first[a] < first[b]; });
+
+	for (Texture& texture : m_textures)
+	{
+		texture.FreeAfter = -1;
+		texture.Used = false;
+	}
+
+	m_stats = RenderGraphStats();
+	m_stats.Passes = (unsigned int)m_passes.size();
+	m_stats.CulledPasses = (unsigned int)(m_passes.size() - m_order.size());
+	m_stats.Resources = (unsigned int)live.size();
+
+	for (unsigned int index : live)
+	{
+		Resource& resource = m_resources[index];
+		m_stats.UnaliasedBytes += getBytes(resource.Desc);
+
+		// First texture of the same description that nobody uses anymore when this one is written
+		for (unsigned int t = 0; t < m_textures.size() && resource.Texture < 0; t++)
+		{
+			Texture& texture = m_textures[t];
+			bool sameDesc = texture.Desc.Width == resource.Desc.Width && texture.Desc.Height == resource.Desc.Height &&
+				texture.Desc.InternalFormat == resource.Desc.InternalFormat && texture.Desc.Filter == resource.Desc.Filter;
+			if (sameDesc && texture.FreeAfter < first[index])
+			{
+				resource.Texture = (int)t;
+			}
+		}
+
+		if (resource.Texture < 0)
+		{
+			Texture texture;
+			texture.Desc = resource.Desc;
+			texture.Target = nullptr;
+			texture.Used = false;
+			m_textures.push_back(texture);
+			resource.Texture = (int)m_textures.size() - 1;
+		}
+
+		Texture& texture = m_textures[resource.Texture];
+		texture.FreeAfter = last[index];
+		texture.Used = true;
+	}
+
+	// Hand back what this compile does not need, take what is new from the pool
+	std::vector<Texture> kept;
+	std::vector<int> remap(m_textures.size(), -1);
+	for (unsigned int t = 0; t < m_textures.size(); t++)
+	{
+		Texture& texture = m_textures[t];
+		if (!texture.Used)
+		{
+			RenderTargetPool::getInstance()->Release(texture.Target);
+			continue;
+		}
+
+		if (!texture.Target)
+		{
+			const RenderGraphTextureDesc& desc = texture.Desc;
+			RenderTargetDesc targetDesc = { desc.Width, desc.Height, desc.InternalFormat, 0, GL_NONE };
+			texture.Target = RenderTargetPool::getInstance()->Acquire(targetDesc, desc.Filter);
+		}
+
+		remap[t] = (int)kept.size();
+		kept.push_back(texture);
+		m_stats.AliasedBytes += getBytes(texture.Desc);
+	}
+	m_textures.swap(kept);
+	m_stats.Textures = (unsigned int)m_textures.size();
+
+	for (Resource& resource : m_resources)
+	{
+		if (resource.Texture >= 0)
+		{
+			resource.Texture = remap[resource.Texture];
+		}
+	}
+}
+
+void RenderGraph::createFramebuffers()
+{
+	for (unsigned int index : m_order)
+	{
+		Pass& pass = m_passes[index];
+		if (pass.Backbuffer || (pass.Colors.empty() && pass.Depth < 0))
+		{
+			continue;
+		}
+
+		glGenFramebuffers(1, &pass.Framebuffer);
+		GLStateCache::getInstance()->bindFramebuffer(GL_FRAMEBUFFER, pass.Framebuffer);
+
+		std::vector<GLenum> attachments;
+		for (unsigned int i = 0; i < pass.Colors.size(); i++)
+		{
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, getTexture(pass.Colors[i]), 0);
+			attachments.push_back(GL_COLOR_ATTACHMENT0 + i);
+		}
+		if (pass.Depth >= 0)
+		{
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, getTexture(pass.Depth), 0);
+		}
+
+		if (attachments.empty())
+		{
+			glDrawBuffer(GL_NONE);
+		}
+		else
+		{
+			glDrawBuffers((GLsizei)attachments.size(), attachments.data());
+		}
+
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		{
+			std::cout << "ERROR::RENDER_GRAPH::FRAMEBUFFER_INCOMPLETE " << pass.Name << std::endl;
+		}
+	}
+	GLStateCache::getInstance()->bindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void RenderGraph::Execute()
+{
+	for (unsigned int index : m_order)
+	{
+		const Pass& pass = m_passes[index];
+		ProfilerScope scope(pass.Name);
+
+		GLStateCache::getInstance()->bindFramebuffer(GL_FRAMEBUFFER, pass.Framebuffer);
+		if (pass.Framebuffer)
+		{
+			RenderGraphResource target = pass.Colors.empty() ? (RenderGraphResource)pass.Depth : pass.Colors[0];
+			const RenderGraphTextureDesc& desc = m_resources[target].Desc;
+			GLStateCache::getInstance()->viewport(0, 0, desc.Width, desc.Height);
+		}
+
+		pass.Execute(*this);
+	}
+}
+
+GLuint RenderGraph::getTexture(RenderGraphResource _resource) const
+{
+	if (_resource >= m_resources.size() || m_resources[_resource].Texture < 0)
+	{
+		return 0;
+	}
+	return m_textures[m_resources[_resource].Texture].Target->Texture;
+}
+
+size_t RenderGraph::getBytes(const RenderGraphTextureDesc& _desc)
+{
+	RenderTargetDesc targetDesc = { _desc.Width, _desc.Height, _desc.InternalFormat, 0, GL_NONE };
+	return RenderTargetPool::getBytes(targetDesc);
+}
+
+void RenderGraph::printReport(const std::string& _title) const
+{
+	std::cout << _title << " render graph: " << m_stats.Passes - m_stats.CulledPasses << " of " << m_stats.Passes << " passes,";
+	for (unsigned int index : m_order)
+	{
+		std::cout << " " << m_passes[index].Name;
+	}
+	std::cout << std::endl;
+
+	std::cout << _title << " VRAM: " << m_stats.Resources << " transients in " << m_stats.Textures << " textures, "
+		<< m_stats.UnaliasedBytes / (1024.0 * 1024.0) << " MB unaliased, " << m_stats.AliasedBytes / (1024.0 * 1024.0) << " MB aliased" << std::endl;
+}
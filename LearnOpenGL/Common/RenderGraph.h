@@ -0,0 +1,138 @@
+#ifndef RENDER_GRAPH_H
+#define RENDER_GRAPH_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "RenderTargetPool.h"
+
+// Handle of a transient texture, valid until the next RenderGraph::Reset()
+typedef unsigned int RenderGraphResource;
+
+// Size and format of a transient render target, edges always clamp
+struct RenderGraphTextureDesc
+{
+	int Width;
+	int Height;
+	GLenum InternalFormat;	// GL_RGBA16F, GL_RGB16F, GL_RGBA8, GL_R8 or GL_DEPTH_COMPONENT24
+	GLenum Filter;			// GL_NEAREST or GL_LINEAR
+};
+
+struct RenderGraphStats
+{
+	unsigned int Passes;
+	unsigned int CulledPasses;
+	unsigned int Resources;		// transient textures the live passes declared
+	unsigned int Textures;		// GL textures backing them
+	size_t UnaliasedBytes;		// one texture per transient
+	size_t AliasedBytes;		// what the graph allocates
+};
+
+class RenderGraph;
+
+// Declares what one pass reads and writes, handed to the setup function of RenderGraph::AddPass()
+class RenderGraphBuilder
+{
+public:
+	// New texture this pass renders to: the next color attachment, or the depth attachment for a depth format
+	RenderGraphResource Create(const std::string& _name, const RenderGraphTextureDesc& _desc);
+
+	// Texture this pass samples
+	void Read(RenderGraphResource _resource);
+
+	// The pass draws to the default framebuffer, it is never culled
+	void WriteBackbuffer();
+
+private:
+	friend class RenderGraph;
+
+	RenderGraphBuilder(RenderGraph* _graph, unsigned int _pass) : m_graph(_graph), m_pass(_pass) {}
+
+	RenderGraph* m_graph;
+	unsigned int m_pass;
+};
+
+typedef std::function<void(RenderGraphBuilder&)> RenderGraphSetup;
+typedef std::function<void(const RenderGraph&)> RenderGraphExecute;
+
+// Frame graph of render passes over transient textures.
+// Passes declare their reads and writes up front; Compile() drops passes whose output nobody reads,
+// orders the rest by their dependencies and backs transients with GL textures. Transients with the
+// same description whose lifetimes do not overlap share one texture, GL 3.3 cannot alias memory
+// between different textures. A shared texture holds garbage at first use, passes clear or overwrite.
+// Textures come from the RenderTargetPool and go back to it when a compile no longer needs them.
+//
+// Build once: AddPass() per pass, Compile(). Every frame: Execute(). Reset() to change the passes.
+class RenderGraph
+{
+public:
+	RenderGraph();
+	~RenderGraph();
+
+	// _setup runs now to declare the resources, _execute runs every Execute() with the pass targets bound
+	void AddPass(const std::string& _name, const RenderGraphSetup& _setup, const RenderGraphExecute& _execute);
+
+	void Compile();
+
+	// Each live pass in order, with its framebuffer bound and the viewport covering its targets, in a profiler scope
+	void Execute();
+
+	// Forget the passes, textures are kept for the next Compile() to reuse or hand back to the pool
+	void Reset();
+
+	GLuint getTexture(RenderGraphResource _resource) const;
+	const RenderGraphStats& getStats() const { return m_stats; }
+
+	// Passes, culling and memory with and without aliasing, to stdout
+	void printReport(const std::string& _title) const;
+
+	static size_t getBytes(const RenderGraphTextureDesc& _desc);
+
+private:
+	friend class RenderGraphBuilder;
+
+	struct Resource
+	{
+		std::string Name;
+		RenderGraphTextureDesc Desc;
+		unsigned int Writer;
+		std::vector<unsigned int> Readers;
+		int Texture;
+	};
+
+	struct Pass
+	{
+		std::string Name;
+		RenderGraphExecute Execute;
+		std::vector<RenderGraphResource> Reads;
+		std::vector<RenderGraphResource> Colors;
+		int Depth;
+		bool Backbuffer;
+		bool Culled;
+		GLuint Framebuffer;
+	};
+
+	struct Texture
+	{
+		RenderGraphTextureDesc Desc;
+		RenderTarget* Target;
+		int FreeAfter;		// order index of the last pass using the current occupant
+		bool Used;
+	};
+
+	void cull();
+	void order();
+	void assignTextures();
+	void createFramebuffers();
+
+	std::vector<Resource> m_resources;
+	std::vector<Pass> m_passes;
+	std::vector<unsigned int> m_order;
+	std::vector<Texture> m_textures;
+	RenderGraphStats m_stats;
+};
+
+#endif
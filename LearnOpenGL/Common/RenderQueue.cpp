@@ -0,0 +1,229 @@
+#include "RenderQueue.h"
+#include "GLStateCache.h"
+#include "Shader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+RenderQueue::RenderQueue()
+	: m_cameraPosition(0.0f), m_farPlane(100.0f)
+{
+	m_stats.Items = 0;
+	m_stats.Batches = 0;
+	m_stats.SortMilliseconds = 0.0;
+}
+
+void RenderQueue::Begin(const glm::vec3& _cameraPosition, float _farPlane)
+{
+	m_cameraPosition = _cameraPosition;
+	m_farPlane = _farPlane;
+
+	m_keys.clear();
+	m_indices.clear();
+	m_commands.clear();
+	m_models.clear();
+}
+
+unsigned long long RenderQueue::makeKey(RenderPass _pass, unsigned int _layer, unsigned int _program, unsigned int _material, unsigned int _vao, float _depth)
+{
+	const unsigned long long depthMax = (1ull << RENDER_KEY_DEPTH_BITS) - 1;
+
+	float depth = glm::clamp(_depth, 0.0f, 1.0f);
+	unsigned long long quantizedDepth = (unsigned long long)(depth * (float)depthMax);
+
+	unsigned long long pass = (unsigned long long)_pass & 0x3;
+	unsigned long long layer = _layer & ((1u << RENDER_KEY_LAYER_BITS) - 1);
+	unsigned long long program = _program & ((1u << RENDER_KEY_PROGRAM_BITS) - 1);
+	unsigned long long material = _material & ((1u << RENDER_KEY_MATERIAL_BITS) - 1);
+	unsigned long long vao = _vao & ((1u << RENDER_KEY_VAO_BITS) - 1);
+
+	unsigned long long key = (pass << 62) | (layer << 58);
+	if (_pass == RENDER_PASS_TRANSPARENT)
+	{
+		// Farthest first
+		key |= (depthMax - quantizedDepth) << 34;
+		key |= program << 24;
+		key |= material << 12;
+		key |= vao;
+	}
+	else
+	{
+		key |= program << 48;
+		key |= material << 36;
+		key |= vao << 24;
+		key |= quantizedDepth;
+	}
+	return key;
+}
+
+void RenderQueue::Submit(RenderPass _pass, unsigned int _layer, const RenderCommand& _command, const glm::mat4& _model)
+{
+	// Execute() would have nothing to draw it with
+	if (!_command.Program)
+	{
+		std::cout << "ERROR::RENDER_QUEUE::COMMAND_WITHOUT_PROGRAM" << std::endl;
+		return;
+	}
+
+	glm::vec3 position(_model[3][0], _model[3][1], _model[3][2]);
+	float depth = glm::length(position - m_cameraPosition) / m_farPlane;
+
+	m_keys.push_back(makeKey(_pass, _layer, _command.Program->Program, _command.Texture, _command.VAO, depth));
+	m_indices.push_back((unsigned int)m_commands.size());
+
+	m_commands.push_back(_command);
+	m_commands.back().ModelIndex = (unsigned int)m_models.size();
+	m_models.push_back(_model);
+}
+
+void RenderQueue::radixSort(std::vector<unsigned long long>& _keys, std::vector<unsigned int>& _values,
+	std::vector<unsigned long long>& _keyScratch, std::vector<unsigned int>& _valueScratch)
+{
+	size_t count = _keys.size();
+	_keyScratch.resize(count);
+	_valueScratch.resize(count);
+
+	unsigned long long* srcKeys = _keys.data();
+	unsigned int* srcValues = _values.data();
+	unsigned long long* dstKeys = _keyScratch.data();
+	unsigned int* dstValues = _valueScratch.data();
+
+	// All eight histograms in one read of the keys
+	unsigned int histograms[8][256] = {};
+	for (size_t i = 0; i < count; i++)
+	{
+		unsigned long long key = srcKeys[i];
+		for (unsigned int digit = 0; digit < 8; digit++)
+		{
+			histograms[digit][(key >> (digit * 8)) & 0xFF]++;
+		}
+	}
+
+	for (unsigned int digit = 0; digit < 8; digit++)
+	{
+		unsigned int* histogram = histograms[digit];
+
+		// Every key has the same byte here, this pass would not move anything
+		if (histogram[(srcKeys[0] >> (digit * 8)) & 0xFF] == count)
+		{
+			continue;
+		}
+
+		unsigned int offset = 0;
+		for (unsigned int bucket = 0; bucket < 256; bucket++)
+		{
+			unsigned int bucketCount = histogram[bucket];
+			histogram[bucket] = offset;
+			offset += bucketCount;
+		}
+
+		for (size_t i = 0; i < count; i++)
+		{
+			unsigned int destination = histogram[(srcKeys[i] >> (digit * 8)) & 0xFF]++;
+			dstKeys[destination] = srcKeys[i];
+			dstValues[destination] = srcValues[i];
+		}
+
+		std::swap(srcKeys, dstKeys);
+		std::swap(srcValues, dstValues);
+	}
+
+	// Odd number of passes left the result in the scratch buffers
+	if (srcKeys != _keys.data())
+	{
+		_keys.swap(_keyScratch);
+		_values.swap(_valueScratch);
+	}
+}
+
+void RenderQueue::Sort()
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	if (!m_keys.empty())
+	{
+		radixSort(m_keys, m_indices, m_keyScratch, m_indexScratch);
+	}
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+	m_stats.SortMilliseconds = elapsed.count();
+	m_stats.Items = (unsigned int)m_keys.size();
+}
+
+void RenderQueue::Execute(const char* _modelUniform)
+{
+	GLStateCache* state = GLStateCache::getInstance();
+	Shader* currentShader = nullptr;
+	int currentPass = -1;
+	bool blend = state->isEnabled(GL_BLEND);
+
+	m_stats.Batches = 0;
+
+	for (size_t i = 0; i < m_keys.size(); i++)
+	{
+		const RenderCommand& command = m_commands[m_indices[i]];
+
+		int pass = (int)(m_keys[i] >> 62);
+		if (pass != currentPass)
+		{
+			currentPass = pass;
+			state->setEnabled(GL_BLEND, pass == RENDER_PASS_TRANSPARENT);
+		}
+
+		if (command.Program != currentShader)
+		{
+			currentShader = command.Program;
+			currentShader->Use();
+			m_stats.Batches++;
+		}
+
+		if (command.Texture != 0)
+		{
+			state->bindTextureUnit(0, GL_TEXTURE_2D, command.Texture);
+		}
+		state->bindVertexArray(command.VAO);
+
+		currentShader->setMat4(_modelUniform, m_models[command.ModelIndex]);
+
+		if (command.Indexed)
+		{
+			glDrawElements(command.Mode, command.Count, GL_UNSIGNED_INT, (void*)(command.First * sizeof(GLuint)));
+		}
+		else
+		{
+			glDrawArrays(command.Mode, command.First, command.Count);
+		}
+	}
+
+	// The passes toggled blending, leave it as the caller had it
+	state->setEnabled(GL_BLEND, blend);
+}
+
+double RenderQueue::benchmarkSort(unsigned int _itemCount, unsigned int _iterations)
+{
+	std::vector<unsigned long long> keys(_itemCount);
+	std::vector<unsigned int> values(_itemCount);
+	std::vector<unsigned long long> keyScratch;
+	std::vector<unsigned int> valueScratch;
+
+	double total = 0.0;
+	for (unsigned int iteration = 0; iteration < _iterations; iteration++)
+	{
+		// Realistic spread: a handful of programs, materials and VAOs, random depth
+		for (unsigned int i = 0; i < _itemCount; i++)
+		{
+			RenderPass pass = (rand() % 8 == 0) ? RENDER_PASS_TRANSPARENT : RENDER_PASS_OPAQUE;
+			keys[i] = makeKey(pass, 0, rand() % 16, rand() % 256, rand() % 64, (float)rand() / (float)RAND_MAX);
+			values[i] = i;
+		}
+
+		auto start = std::chrono::high_resolution_clock::now();
+		radixSort(keys, values, keyScratch, valueScratch);
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+		total += elapsed.count();
+	}
+
+	return _iterations > 0 ? total / _iterations : 0.0;
+}
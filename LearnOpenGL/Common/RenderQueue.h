@@ -0,0 +1,91 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "glm/glm.hpp"
+
+class Shader;
+
+// Passes run in this order, the pass is the most significant part of the sort key
+enum RenderPass
+{
+	RENDER_PASS_OPAQUE = 0,
+	RENDER_PASS_TRANSPARENT = 1,
+	RENDER_PASS_OVERLAY = 2
+};
+
+// Sort key layout, most significant bits first
+//  opaque      : pass(2) layer(4) program(10) material(12) vao(12) depth(24)  - state changes first, then front to back
+//  transparent : pass(2) layer(4) depth(24) program(10) material(12) vao(12)  - back to front wins over state
+#define RENDER_KEY_DEPTH_BITS 24
+#define RENDER_KEY_VAO_BITS 12
+#define RENDER_KEY_MATERIAL_BITS 12
+#define RENDER_KEY_PROGRAM_BITS 10
+#define RENDER_KEY_LAYER_BITS 4
+
+// One draw call, everything needed to issue it without touching the scene again
+struct RenderCommand
+{
+	Shader* Program;
+	GLuint VAO;
+	GLuint Texture;		// bound to unit 0, 0 for none
+	GLenum Mode;
+	GLint First;
+	GLsizei Count;
+	bool Indexed;		// glDrawElements with unsigned int indices, First is the index offset
+	unsigned int ModelIndex;
+};
+
+struct RenderQueueStats
+{
+	unsigned int Items;
+	unsigned int Batches;		// program changes while executing
+	double SortMilliseconds;
+};
+
+class RenderQueue
+{
+public:
+	RenderQueue();
+
+	// Clear the items of the last frame, buffers are kept
+	void Begin(const glm::vec3& _cameraPosition, float _farPlane);
+
+	// Queue a draw, depth is taken from the model translation. Commands without a program are dropped
+	void Submit(RenderPass _pass, unsigned int _layer, const RenderCommand& _command, const glm::mat4& _model);
+
+	// Radix sort the keys then issue the draws through GLStateCache, GL_BLEND is restored afterwards
+	void Sort();
+	void Execute(const char* _modelUniform = "model");
+
+	const RenderQueueStats& getStats() const { return m_stats; }
+
+	static unsigned long long makeKey(RenderPass _pass, unsigned int _layer, unsigned int _program, unsigned int _material, unsigned int _vao, float _depth);
+
+	// LSD radix sort on 8 bit digits, digits every key shares are skipped
+	static void radixSort(std::vector<unsigned long long>& _keys, std::vector<unsigned int>& _values,
+		std::vector<unsigned long long>& _keyScratch, std::vector<unsigned int>& _valueScratch);
+
+	// Average time in ms to sort _itemCount random keys, used to track the sort cost
+	static double benchmarkSort(unsigned int _itemCount, unsigned int _iterations);
+
+private:
+	glm::vec3 m_cameraPosition;
+	float m_farPlane;
+
+	// Sorted parallel arrays: key and index of its command
+	std::vector<unsigned long long> m_keys;
+	std::vector<unsigned int> m_indices;
+	std::vector<unsigned long long> m_keyScratch;
+	std::vector<unsigned int> m_indexScratch;
+
+	std::vector<RenderCommand> m_commands;
+	std::vector<glm::mat4> m_models;
+
+	RenderQueueStats m_stats;
+};
+
+#endif
@@ -0,0 +1,251 @@
+#include "RenderTargetPool.h"
+#include "GLStateCache.h"
+
+#include <iostream>
+
+RenderTargetPool* RenderTargetPool::m_instance = nullptr;
+
+static bool isDepthFormat(GLenum _format)
+{
+	return _format == GL_DEPTH_COMPONENT24 || _format == GL_DEPTH_COMPONENT || _format == GL_DEPTH24_STENCIL8;
+}
+
+static size_t bytesPerPixel(GLenum _format)
+{
+	switch (_format)
+	{
+	case GL_NONE: return 0;
+	case GL_RGBA16F: return 8;
+	case GL_RGB16F: return 6;
+	case GL_RGB8: return 3;
+	case GL_R8: return 1;
+	}
+	return 4;
+}
+
+RenderTargetPool::RenderTargetPool(unsigned int _idleFrames)
+	: m_idleFrames(_idleFrames), m_frame(0), m_created(0), m_reused(0), m_evicted(0)
+{
+}
+
+RenderTargetPool::~RenderTargetPool()
+{
+	for (RenderTarget* target : m_targets)
+	{
+		if (target->InUse)
+		{
+			std::cout << "ERROR::RENDER_TARGET_POOL::TARGET_NOT_RELEASED " << target->Desc.Width << "x" << target->Desc.Height << std::endl;
+		}
+		destroy(target);
+	}
+}
+
+void RenderTargetPool::Init(unsigned int _idleFrames)
+{
+	if (!m_instance)
+	{
+		m_instance = new RenderTargetPool(_idleFrames);
+	}
+}
+
+void RenderTargetPool::Destroy()
+{
+	if (m_instance) {
+		delete m_instance;
+		m_instance = nullptr;
+	}
+}
+
+RenderTargetPool* RenderTargetPool::getInstance()
+{
+	if (!m_instance)
+	{
+		Init();
+	}
+	return m_instance;
+}
+
+RenderTarget* RenderTargetPool::Acquire(const RenderTargetDesc& _desc, GLenum _filter)
+{
+	RenderTarget* found = nullptr;
+	for (unsigned int i = 0; i < m_targets.size() && !found; i++)
+	{
+		RenderTarget* target = m_targets[i];
+		const RenderTargetDesc& desc = target->Desc;
+		if (!target->InUse && desc.Width == _desc.Width && desc.Height == _desc.Height && desc.InternalFormat == _desc.InternalFormat &&
+			desc.Samples == _desc.Samples && desc.DepthFormat == _desc.DepthFormat)
+		{
+			found = target;
+		}
+	}
+
+	if (found)
+	{
+		m_reused++;
+	}
+	else
+	{
+		found = create(_desc);
+		m_targets.push_back(found);
+	}
+
+	if (found->Desc.Samples == 0 && found->Filter != _filter)
+	{
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, found->Texture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, _filter);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, _filter);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
+		found->Filter = _filter;
+	}
+
+	found->InUse = true;
+	found->LastUsed = m_frame;
+	return found;
+}
+
+void RenderTargetPool::Release(RenderTarget* _target)
+{
+	if (!_target)
+	{
+		return;
+	}
+	_target->InUse = false;
+	_target->LastUsed = m_frame;
+}
+
+void RenderTargetPool::EndFrame()
+{
+	m_frame++;
+
+	unsigned int kept = 0;
+	for (RenderTarget* target : m_targets)
+	{
+		if (!target->InUse && m_frame - target->LastUsed > m_idleFrames)
+		{
+			destroy(target);
+			m_evicted++;
+		}
+		else
+		{
+			m_targets[kept++] = target;
+		}
+	}
+	m_targets.resize(kept);
+}
+
+RenderTarget* RenderTargetPool::create(const RenderTargetDesc& _desc)
+{
+	RenderTarget* target = new RenderTarget();
+	target->Desc = _desc;
+	target->DepthBuffer = 0;
+	target->Filter = GL_NONE;
+	target->InUse = false;
+	target->LastUsed = m_frame;
+	m_created++;
+
+	GLenum format = GL_RGBA;
+	GLenum type = GL_UNSIGNED_BYTE;
+	switch (_desc.InternalFormat)
+	{
+	case GL_RGBA16F: type = GL_FLOAT; break;
+	case GL_RGB16F: format = GL_RGB; type = GL_FLOAT; break;
+	case GL_RGB8: format = GL_RGB; break;
+	case GL_R8: format = GL_RED; break;
+	case GL_DEPTH_COMPONENT24: format = GL_DEPTH_COMPONENT; type = GL_FLOAT; break;
+	}
+
+	glGenTextures(1, &target->Texture);
+	if (_desc.Samples > 0)
+	{
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D_MULTISAMPLE, target->Texture);
+		glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, _desc.Samples, _desc.InternalFormat, _desc.Width, _desc.Height, GL_TRUE);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
+	}
+	else
+	{
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, target->Texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, _desc.InternalFormat, _desc.Width, _desc.Height, 0, format, type, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
+	}
+
+	glGenFramebuffers(1, &target->Framebuffer);
+	GLStateCache::getInstance()->bindFramebuffer(GL_FRAMEBUFFER, target->Framebuffer);
+
+	GLenum textureTarget = _desc.Samples > 0 ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D;
+	if (isDepthFormat(_desc.InternalFormat))
+	{
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, textureTarget, target->Texture, 0);
+		glDrawBuffer(GL_NONE);
+		glReadBuffer(GL_NONE);
+	}
+	else
+	{
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, textureTarget, target->Texture, 0);
+	}
+
+	if (_desc.DepthFormat != GL_NONE)
+	{
+		GLenum attachment = _desc.DepthFormat == GL_DEPTH24_STENCIL8 ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+		glGenRenderbuffers(1, &target->DepthBuffer);
+		glBindRenderbuffer(GL_RENDERBUFFER, target->DepthBuffer);
+		if (_desc.Samples > 0)
+		{
+			glRenderbufferStorageMultisample(GL_RENDERBUFFER, _desc.Samples, _desc.DepthFormat, _desc.Width, _desc.Height);
+		}
+		else
+		{
+			glRenderbufferStorage(GL_RENDERBUFFER, _desc.DepthFormat, _desc.Width, _desc.Height);
+		}
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, attachment, GL_RENDERBUFFER, target->DepthBuffer);
+	}
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "ERROR::RENDER_TARGET_POOL::FRAMEBUFFER_INCOMPLETE " << _desc.Width << "x" << _desc.Height << std::endl;
+	}
+	GLStateCache::getInstance()->bindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	return target;
+}
+
+void RenderTargetPool::destroy(RenderTarget* _target)
+{
+	GLStateCache::getInstance()->forgetFramebuffer(_target->Framebuffer);
+	GLStateCache::getInstance()->forgetTexture(_target->Texture);
+	glDeleteFramebuffers(1, &_target->Framebuffer);
+	glDeleteTextures(1, &_target->Texture);
+	if (_target->DepthBuffer)
+	{
+		glDeleteRenderbuffers(1, &_target->DepthBuffer);
+	}
+	delete _target;
+}
+
+RenderTargetPoolStats RenderTargetPool::getStats() const
+{
+	RenderTargetPoolStats stats = RenderTargetPoolStats();
+	stats.Created = m_created;
+	stats.Reused = m_reused;
+	stats.Evicted = m_evicted;
+	for (const RenderTarget* target : m_targets)
+	{
+		if (target->InUse)
+		{
+			stats.InUse++;
+		}
+		else
+		{
+			stats.Idle++;
+		}
+		stats.Bytes += getBytes(target->Desc);
+	}
+	return stats;
+}
+
+size_t RenderTargetPool::getBytes(const RenderTargetDesc& _desc)
+{
+	size_t samples = _desc.Samples > 0 ? (size_t)_desc.Samples : 1;
+	return (size_t)_desc.Width * _desc.Height * samples * (bytesPerPixel(_desc.InternalFormat) + bytesPerPixel(_desc.DepthFormat));
+}
@@ -0,0 +1,93 @@
+#ifndef RENDER_TARGET_POOL_H
+#define RENDER_TARGET_POOL_H
+
+#include <cstddef>
+#include <vector>
+
+#include <GL/glew.h>
+
+// Frames a released target stays in the pool unused before it is deleted
+#define RENDER_TARGET_POOL_IDLE_FRAMES 60
+
+// What a render target is looked up by
+struct RenderTargetDesc
+{
+	int Width;
+	int Height;
+	GLenum InternalFormat;	// color format, or GL_DEPTH_COMPONENT24 for a depth only target
+	int Samples;			// 0 for a sampleable texture, more for a multisampled one to resolve with a blit
+	GLenum DepthFormat;		// depth renderbuffer next to the color texture, GL_NONE for none
+};
+
+// Framebuffer with its attachments, owned by the pool
+struct RenderTarget
+{
+	RenderTargetDesc Desc;
+	GLuint Framebuffer;
+	GLuint Texture;			// GL_TEXTURE_2D, or GL_TEXTURE_2D_MULTISAMPLE with Samples
+	GLuint DepthBuffer;		// 0 without DepthFormat
+
+	GLenum Filter;
+	bool InUse;
+	unsigned long long LastUsed;
+};
+
+struct RenderTargetPoolStats
+{
+	unsigned int Created;
+	unsigned int Reused;		// Acquire() calls served by a released target
+	unsigned int Evicted;
+	unsigned int InUse;
+	unsigned int Idle;
+	size_t Bytes;				// held by the pool, in use or idle
+};
+
+// Hands out framebuffers with their attachments by description and takes them back for the next
+// user, so passes and demos stop allocating near identical FBO sets each. A released target is
+// reused by the next Acquire() of the same description and deleted once it sat unused for
+// RENDER_TARGET_POOL_IDLE_FRAMES, which also cleans up after a resolution change.
+//
+// Acquire() when a pass starts, Release() once nothing reads the target anymore, EndFrame() once per frame.
+class RenderTargetPool
+{
+private:
+
+	static RenderTargetPool *m_instance;
+
+	RenderTargetPool(unsigned int _idleFrames);
+
+	~RenderTargetPool();
+
+public:
+
+	static void Init(unsigned int _idleFrames = RENDER_TARGET_POOL_IDLE_FRAMES);
+	static void Destroy();
+
+	// Created on first use, Destroy() before the GL context goes away
+	static RenderTargetPool* getInstance();
+
+	// Edges clamp, _filter is ignored for multisampled targets
+	RenderTarget* Acquire(const RenderTargetDesc& _desc, GLenum _filter = GL_LINEAR);
+	void Release(RenderTarget* _target);
+
+	// Deletes the targets idle for too long
+	void EndFrame();
+
+	RenderTargetPoolStats getStats() const;
+
+	static size_t getBytes(const RenderTargetDesc& _desc);
+
+private:
+	RenderTarget* create(const RenderTargetDesc& _desc);
+	void destroy(RenderTarget* _target);
+
+	std::vector<RenderTarget*> m_targets;
+	unsigned int m_idleFrames;
+	unsigned long long m_frame;
+
+	unsigned int m_created;
+	unsigned int m_reused;
+	unsigned int m_evicted;
+};
+
+#endif
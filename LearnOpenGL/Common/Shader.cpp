@@ -1,168 +1,604 @@
 #include "Shader.h"
+#include "GLStateCache.h"
 
+#include <algorithm>
+#include <cstring>
+#include <sys/stat.h>
 
+bool Shader::s_preferSPIRV = false;
+
+static bool readBinaryFile(const std::string& _path, std::string& _out)
+{
+	std::ifstream file(_path, std::ios::binary);
+	if (!file)
+	{
+		return false;
+	}
+	std::stringstream stream;
+	stream << file.rdbuf();
+	_out = stream.str();
+	return !_out.empty();
+}
+
+static time_t getFileWriteTime(const std::string& _path)
+{
+	struct stat fileStat;
+	if (stat(_path.c_str(), &fileStat) != 0)
+	{
+		return 0;
+	}
+	return fileStat.st_mtime;
+}
 
 Shader::Shader(const GLchar* vertexPath, const GLchar* fragmentPath, const GLchar* geometryPath)
 {
-	// 1. Retreive the vertex/fragment source code from filePath
-	std::string vertexCode;
-	std::string fragmentCode;
-	std::string geometryCode;
-	std::ifstream vShaderFile;
-	std::ifstream fShaderFile;
+	m_vertex.Path = normalizePath(vertexPath);
+	m_fragment.Path = normalizePath(fragmentPath);
+	if (geometryPath)
+	{
+		m_geometry.Path = normalizePath(geometryPath);
+	}
+
+	// 1. Retreive the vertex/fragment source code from filePath, expanding #include
+	loadSources();
+
+	// 2. Base variant is the one without any define
+	m_currentPermutation = 0;
+	this->Program = compileProgram(0);
+	m_permutationPrograms[0].Program = this->Program;
+	m_permutationPrograms[0].Uniforms.Reset(this->Program);
+	m_currentVariant = &m_permutationPrograms[0];
+}
+
+void Shader::loadSources()
+{
+	m_dependencies.clear();
+
+	loadStage(m_vertex);
+	loadStage(m_fragment);
+	if (!m_geometry.Path.empty())
+	{
+		loadStage(m_geometry);
+	}
+}
+
+bool Shader::loadStage(StageSource& _stage)
+{
+	_stage.Code.clear();
+	_stage.Files.clear();
+
+	std::set<std::string> included;
+	return preprocessFile(_stage.Path, _stage, included, 0, _stage.Code);
+}
+
+bool Shader::preprocessFile(const std::string& _path, StageSource& _stage, std::set<std::string>& _included, int _depth, std::string& _out)
+{
+	if (_depth > SHADER_MAX_INCLUDE_DEPTH)
+	{
+		std::cout << "ERROR::SHADER::INCLUDE_TOO_DEEP " << _path << std::endl;
+		return false;
+	}
+
+	std::string code;
+	std::ifstream shaderFile;
 	// ensure ifstream objects can throw exceptions
-	vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-	fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+	shaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
 	try
 	{
-		// Open files
-		vShaderFile.open(vertexPath);
-		fShaderFile.open(fragmentPath);
-		std::stringstream vShaderStream, fShaderStream;
-		// Read file's biffer contents into streams
-		vShaderStream << vShaderFile.rdbuf();
-		fShaderStream << fShaderFile.rdbuf();
-		// close file handlers
-		vShaderFile.close();
-		fShaderFile.close();
-		// Convert stream into string
-		vertexCode = vShaderStream.str();
-		fragmentCode = fShaderStream.str();
+		shaderFile.open(_path);
+		std::stringstream shaderStream;
+		// Read file's buffer contents into stream
+		shaderStream << shaderFile.rdbuf();
+		shaderFile.close();
+		code = shaderStream.str();
 	}
 	catch (std::ifstream::failure e)
 	{
-		std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ" << std::endl;
+		std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ " << _path << std::endl;
+		return false;
 	}
 
-	if (geometryPath)
+	_included.insert(_path);
+	m_dependencies[_path] = getFileWriteTime(_path);
+
+	unsigned int fileIndex = (unsigned int)_stage.Files.size();
+	_stage.Files.push_back(_path);
+
+	std::string directory;
+	size_t slash = _path.find_last_of('/');
+	if (slash != std::string::npos)
 	{
-		std::ifstream gShaderFile;
-		gShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-		try
+		directory = _path.substr(0, slash + 1);
+	}
+
+	bool success = true;
+	std::istringstream lines(code);
+	std::string line;
+	unsigned int lineNumber = 0;
+	while (std::getline(lines, line))
+	{
+		lineNumber++;
+
+		size_t start = line.find_first_not_of(" \t");
+		if (start == std::string::npos || line.compare(start, 8, "#include") != 0)
+		{
+			_out += line;
+			_out += '\n';
+			continue;
+		}
+
+		size_t open = line.find_first_of("\"<", start + 8);
+		size_t close = (open == std::string::npos) ? std::string::npos : line.find_first_of("\">", open + 1);
+		if (close == std::string::npos)
 		{
-			gShaderFile.open(geometryPath);
-			std::stringstream gShaderStream;
-			gShaderStream << gShaderFile.rdbuf();
-			gShaderFile.close();
-			geometryCode = gShaderStream.str();
+			std::cout << "ERROR::SHADER::MALFORMED_INCLUDE " << _path << "(" << lineNumber << ")" << std::endl;
+			success = false;
+			_out += '\n';
+			continue;
 		}
-		catch (std::ifstream::failure e)
+
+		// Include paths are relative to the file containing the directive
+		std::string includePath = normalizePath(directory + line.substr(open + 1, close - open - 1));
+
+		// Each file is pasted only once per stage, so shared libraries can include each other freely
+		if (_included.count(includePath) > 0)
 		{
-			std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ" << std::endl;
+			_out += '\n';
+			continue;
 		}
+
+		std::stringstream lineDirective;
+		lineDirective << "#line 1 " << _stage.Files.size() << "\n";
+		_out += lineDirective.str();
+
+		success = preprocessFile(includePath, _stage, _included, _depth + 1, _out) && success;
+
+		// Back to the including file, on the line after the directive
+		lineDirective.str("");
+		lineDirective << "#line " << (lineNumber + 1) << " " << fileIndex << "\n";
+		_out += lineDirective.str();
 	}
-	
-	const GLchar* vShaderCode = vertexCode.c_str();
-	const GLchar* fShaderCode = fragmentCode.c_str();
-	const GLchar* gShaderCode = geometryCode.c_str();
 
-	// Compile shader
-	GLuint vertex, fragment, geometry;
+	return success;
+}
+
+GLuint Shader::compileStage(GLenum _type, const StageSource& _stage, unsigned int _permutationMask, const char* _stageName)
+{
+	std::string code = injectDefines(_stage.Code, _permutationMask);
+	const GLchar* shaderCode = code.c_str();
+
 	GLint success;
-	GLchar infoLog[512];
 
-	// Vertex Shader
-	vertex = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vertex, 1, &vShaderCode, NULL);
-	glCompileShader(vertex);
+	GLuint shader = glCreateShader(_type);
+	glShaderSource(shader, 1, &shaderCode, NULL);
+	glCompileShader(shader);
 	// Print compile errors if any
-	glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
 	if (!success) {
-		glGetShaderInfoLog(vertex, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
+		GLint logLength = 0;
+		glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logLength);
+		std::vector<GLchar> infoLog(logLength > 0 ? logLength : 1, '\0');
+		glGetShaderInfoLog(shader, (GLsizei)infoLog.size(), NULL, infoLog.data());
+		std::cout << "ERROR::SHADER::" << _stageName << "::COMPILATION_FAILED\n" << infoLog.data() << std::endl;
+		// Errors are reported as source(line), map source numbers back to files
+		for (unsigned int i = 0; i < _stage.Files.size(); i++)
+		{
+			std::cout << "  source " << i << ": " << _stage.Files[i] << std::endl;
+		}
 	}
 
-	// Fragment Shader
-	fragment = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragment, 1, &fShaderCode, NULL);
-	glCompileShader(fragment);
-	// Print compile errors if any
-	glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
-	if (!success) {
-		glGetShaderInfoLog(fragment, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
-	}
+	return shader;
+}
 
-	if (geometryPath)
+GLuint Shader::compileProgram(unsigned int _permutationMask)
+{
+	// Offline modules only exist for the base variant, defines still go through GLSL
+	if (s_preferSPIRV && _permutationMask == 0)
 	{
-		// Geometry shader
-		geometry = glCreateShader(GL_GEOMETRY_SHADER);
-		glShaderSource(geometry, 1, &gShaderCode, NULL);
-		glCompileShader(geometry);
-		// Print compile errors if any
-		glGetShaderiv(geometry, GL_COMPILE_STATUS, &success);
-		if (!success) {
-			glGetShaderInfoLog(geometry, 512, NULL, infoLog);
-			std::cout << "ERROR::SHADER::GEOMETRY::COMPILATION_FAILED\n" << infoLog << std::endl;
+		GLuint program = loadSPIRVProgram();
+		if (program != 0)
+		{
+			return program;
 		}
 	}
 
+	bool hasGeometry = !m_geometry.Path.empty();
+
+	// Compile shader
+	GLuint vertex = compileStage(GL_VERTEX_SHADER, m_vertex, _permutationMask, "VERTEX");
+	GLuint fragment = compileStage(GL_FRAGMENT_SHADER, m_fragment, _permutationMask, "FRAGMENT");
+	GLuint geometry = hasGeometry ? compileStage(GL_GEOMETRY_SHADER, m_geometry, _permutationMask, "GEOMETRY") : 0;
+
+	return linkProgram(vertex, fragment, geometry);
+}
+
+GLuint Shader::linkProgram(GLuint _vertex, GLuint _fragment, GLuint _geometry)
+{
+	GLint success;
+
 	// Shader Program
-	this->Program = glCreateProgram();
-	glAttachShader(this->Program, vertex);
-	glAttachShader(this->Program, fragment);
-	if (geometryPath)
+	GLuint program = glCreateProgram();
+	glAttachShader(program, _vertex);
+	glAttachShader(program, _fragment);
+	if (_geometry != 0)
 	{
-		glAttachShader(this->Program, geometry);
+		glAttachShader(program, _geometry);
 	}
-	glLinkProgram(this->Program);
+	glLinkProgram(program);
 	// Print linking errors if any
-	glGetProgramiv(this->Program, GL_LINK_STATUS, &success);
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
 	if (!success) {
-		glGetProgramInfoLog(this->Program, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << std::endl;
+		GLint logLength = 0;
+		glGetProgramiv(program, GL_INFO_LOG_LENGTH, &logLength);
+		std::vector<GLchar> infoLog(logLength > 0 ? logLength : 1, '\0');
+		glGetProgramInfoLog(program, (GLsizei)infoLog.size(), NULL, infoLog.data());
+		std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog.data() << std::endl;
 	}
 
-	if (geometryPath)
+	if (_geometry != 0)
+	{
+		glDeleteShader(_geometry);
+	}
+
+	glDeleteShader(_vertex);
+	glDeleteShader(_fragment);
+
+	if (success)
 	{
+		applyUniformBlockBindings(program);
+	}
+
+	return program;
+}
+
+GLuint Shader::loadSPIRVStage(GLenum _type, const std::string& _binary, const StageSource& _stage, const char* _stageName)
+{
+	GLuint shader = glCreateShader(_type);
+	glShaderBinary(1, &shader, GL_SHADER_BINARY_FORMAT_SPIR_V_ARB, _binary.data(), (GLsizei)_binary.size());
+	glSpecializeShaderARB(shader, "main", 0, NULL, NULL);
+
+	GLint success;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+	if (!success)
+	{
+		std::cout << "ERROR::SHADER::" << _stageName << "::SPIRV_SPECIALIZATION_FAILED " << _stage.Path << std::endl;
+		glDeleteShader(shader);
+		return 0;
+	}
+	return shader;
+}
+
+GLuint Shader::loadSPIRVProgram()
+{
+	if (!GLEW_ARB_gl_spirv)
+	{
+		return 0;
+	}
+
+	// GL refuses to link SPIR-V stages with GLSL ones, so every stage needs its module
+	bool hasGeometry = !m_geometry.Path.empty();
+	std::string vertexBinary, fragmentBinary, geometryBinary;
+	if (!readBinaryFile(getSPIRVPath(m_vertex.Path), vertexBinary) ||
+		!readBinaryFile(getSPIRVPath(m_fragment.Path), fragmentBinary) ||
+		(hasGeometry && !readBinaryFile(getSPIRVPath(m_geometry.Path), geometryBinary)))
+	{
+		return 0;
+	}
+
+	GLuint vertex = loadSPIRVStage(GL_VERTEX_SHADER, vertexBinary, m_vertex, "VERTEX");
+	GLuint fragment = loadSPIRVStage(GL_FRAGMENT_SHADER, fragmentBinary, m_fragment, "FRAGMENT");
+	GLuint geometry = hasGeometry ? loadSPIRVStage(GL_GEOMETRY_SHADER, geometryBinary, m_geometry, "GEOMETRY") : 0;
+	if (vertex == 0 || fragment == 0 || (hasGeometry && geometry == 0))
+	{
+		glDeleteShader(vertex);
+		glDeleteShader(fragment);
 		glDeleteShader(geometry);
+		return 0;
 	}
 
-	glDeleteShader(vertex);
-	glDeleteShader(fragment);
+	GLuint program = linkProgram(vertex, fragment, geometry);
+	GLint success;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (!success)
+	{
+		// Fall back to the GLSL sources
+		glDeleteProgram(program);
+		return 0;
+	}
+
+	// Every setter goes by name, a uniform outside a block without a location by name could never be set
+	GLint uniformCount = 0;
+	glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &uniformCount);
+	for (GLuint i = 0; i < (GLuint)uniformCount; i++)
+	{
+		GLchar name[256];
+		GLsizei length = 0;
+		GLint size = 0;
+		GLenum type = GL_NONE;
+		GLint blockIndex = -1;
+		glGetActiveUniform(program, i, sizeof(name), &length, &size, &type, name);
+		glGetActiveUniformsiv(program, 1, &i, GL_UNIFORM_BLOCK_INDEX, &blockIndex);
+		if (blockIndex < 0 && (length == 0 || glGetUniformLocation(program, name) < 0))
+		{
+			std::cout << "ERROR::SHADER::SPIRV_UNIFORM_WITHOUT_NAME " << m_vertex.Path << ", loading the GLSL sources" << std::endl;
+			glDeleteProgram(program);
+			return 0;
+		}
+	}
+	return program;
+}
+
+std::string Shader::injectDefines(const std::string& _code, unsigned int _permutationMask)
+{
+	if (_permutationMask == 0 || _code.empty())
+	{
+		return _code;
+	}
+
+	// #version has to stay the first statement, so defines go on the line right after it
+	size_t insertPos = 0;
+	size_t versionPos = _code.find("#version");
+	if (versionPos != std::string::npos)
+	{
+		insertPos = _code.find('\n', versionPos);
+		insertPos = (insertPos == std::string::npos) ? _code.size() : insertPos + 1;
+	}
+
+	std::stringstream defines;
+	for (unsigned int i = 0; i < m_permutationDefines.size(); i++)
+	{
+		if (_permutationMask & (1u << i))
+		{
+			defines << "#define " << m_permutationDefines[i] << "\n";
+		}
+	}
+
+	// Keep compile error line numbers matching the file on disk
+	unsigned int nextLine = 1 + (unsigned int)std::count(_code.begin(), _code.begin() + insertPos, '\n');
+	defines << "#line " << nextLine << "\n";
+
+	std::string result = _code;
+	result.insert(insertPos, defines.str());
+	return result;
 }
 
 Shader::~Shader()
 {
-	glDeleteProgram(Program);
+	for (auto& variant : m_permutationPrograms)
+	{
+		glDeleteProgram(variant.second.Program);
+	}
 }
 
 GLint Shader::getUniformPosition(const char* _varName)
 {
-	return glGetUniformLocation(Program, _varName);
+	return m_currentVariant->Uniforms.getLocation(_varName);
 }
 
 void Shader::setVec3(const char* _varName, glm::vec3 _value)
 {
-	glUniform3f(getUniformPosition(_varName), _value.x, _value.y, _value.z);
+	UniformCache::Slot* slot = m_currentVariant->Uniforms.getSlot(_varName);
+	float value[3] = { _value.x, _value.y, _value.z };
+	if (UniformCache::Update(slot, value, 3))
+	{
+		glUniform3f(slot ? slot->Location : glGetUniformLocation(Program, _varName), _value.x, _value.y, _value.z);
+	}
 }
 
 void Shader::setVec2(const char* _varName, glm::vec2 _value)
 {
-	glUniform2f(getUniformPosition(_varName), _value.x, _value.y);
+	UniformCache::Slot* slot = m_currentVariant->Uniforms.getSlot(_varName);
+	float value[2] = { _value.x, _value.y };
+	if (UniformCache::Update(slot, value, 2))
+	{
+		glUniform2f(slot ? slot->Location : glGetUniformLocation(Program, _varName), _value.x, _value.y);
+	}
 }
 
 void Shader::setFloat(const char* _varName, float _value)
 {
-	glUniform1f(getUniformPosition(_varName), _value);
+	UniformCache::Slot* slot = m_currentVariant->Uniforms.getSlot(_varName);
+	if (UniformCache::Update(slot, &_value, 1))
+	{
+		glUniform1f(slot ? slot->Location : glGetUniformLocation(Program, _varName), _value);
+	}
 }
 
 void Shader::setInt(const char* _varName, int _value)
 {
-	glUniform1i(getUniformPosition(_varName), _value);
+	UniformCache::Slot* slot = m_currentVariant->Uniforms.getSlot(_varName);
+	if (UniformCache::Update(slot, &_value, 1))
+	{
+		glUniform1i(slot ? slot->Location : glGetUniformLocation(Program, _varName), _value);
+	}
+}
+
+void Shader::setInt(GLint _location, int _value)
+{
+	if (_location < 0)
+	{
+		UniformCache::countSkipped();
+		return;
+	}
+
+	if (UniformCache::Update(m_currentVariant->Uniforms.getSlot(_location), &_value, 1))
+	{
+		glUniform1i(_location, _value);
+	}
 }
 
 void Shader::setMat4(const char* _varName, glm::mat4 _value)
 {
-	glUniformMatrix4fv(getUniformPosition(_varName), 1, GL_FALSE, glm::value_ptr(_value));
+	UniformCache::Slot* slot = m_currentVariant->Uniforms.getSlot(_varName);
+	if (UniformCache::Update(slot, glm::value_ptr(_value), 16))
+	{
+		glUniformMatrix4fv(slot ? slot->Location : glGetUniformLocation(Program, _varName), 1, GL_FALSE, glm::value_ptr(_value));
+	}
 }
 
 void Shader::setBool(const char* _varName, bool _value)
 {
-	glUniform1i(getUniformPosition(_varName), _value);
+	setInt(_varName, _value ? 1 : 0);
+}
+
+void Shader::setUniformBlockBinding(const char* _blockName, GLuint _binding)
+{
+	m_uniformBlockBindings[_blockName] = _binding;
+
+	for (auto& variant : m_permutationPrograms)
+	{
+		applyUniformBlockBindings(variant.second.Program);
+	}
+}
+
+void Shader::applyUniformBlockBindings(GLuint _program)
+{
+	for (auto& block : m_uniformBlockBindings)
+	{
+		GLuint blockIndex = glGetUniformBlockIndex(_program, block.first.c_str());
+		if (blockIndex != GL_INVALID_INDEX)
+		{
+			glUniformBlockBinding(_program, blockIndex, block.second);
+		}
+	}
+}
+
+unsigned int Shader::addPermutationDefine(const char* _define)
+{
+	for (unsigned int i = 0; i < m_permutationDefines.size(); i++)
+	{
+		if (m_permutationDefines[i] == _define)
+		{
+			return 1u << i;
+		}
+	}
+
+	if (m_permutationDefines.size() >= SHADER_MAX_PERMUTATION_DEFINES)
+	{
+		std::cout << "ERROR::SHADER::TOO_MANY_PERMUTATION_DEFINES " << _define << std::endl;
+		return 0;
+	}
+
+	m_permutationDefines.push_back(_define);
+	return 1u << (m_permutationDefines.size() - 1);
+}
+
+void Shader::setPermutation(unsigned int _permutationMask)
+{
+	if (_permutationMask == m_currentPermutation)
+	{
+		return;
+	}
+
+	auto it = m_permutationPrograms.find(_permutationMask);
+	if (it == m_permutationPrograms.end())
+	{
+		// Compile the specialised variant on demand and keep it around
+		it = m_permutationPrograms.insert(std::make_pair(_permutationMask, ProgramVariant())).first;
+		it->second.Program = compileProgram(_permutationMask);
+		it->second.Uniforms.Reset(it->second.Program);
+	}
+
+	m_currentPermutation = _permutationMask;
+	m_currentVariant = &it->second;
+	this->Program = it->second.Program;
 }
 
 void Shader::Use()
 {
-	glUseProgram(this->Program);
+	GLStateCache::getInstance()->useProgram(this->Program);
+}
+
+void Shader::Use(unsigned int _permutationMask)
+{
+	setPermutation(_permutationMask);
+	Use();
+}
+
+bool Shader::dependsOn(const std::string& _path) const
+{
+	return m_dependencies.count(normalizePath(_path)) > 0;
+}
+
+void Shader::Reload()
+{
+	loadSources();
+
+	// Only the selected permutation is rebuilt now, the others compile again on demand.
+	// It is built before the old programs go, so it never gets the name of the program it replaces
+	GLuint program = compileProgram(m_currentPermutation);
+
+	for (auto& variant : m_permutationPrograms)
+	{
+		glDeleteProgram(variant.second.Program);
+	}
+	m_permutationPrograms.clear();
+
+	// Deleted program names can be handed out again, the cache must not skip binding them
+	GLStateCache::getInstance()->invalidate();
+
+	this->Program = program;
+	m_permutationPrograms[m_currentPermutation].Program = this->Program;
+	m_permutationPrograms[m_currentPermutation].Uniforms.Reset(this->Program);
+	m_currentVariant = &m_permutationPrograms[m_currentPermutation];
+}
+
+bool Shader::reloadIfChanged()
+{
+	for (auto& dependency : m_dependencies)
+	{
+		if (getFileWriteTime(dependency.first) != dependency.second)
+		{
+			Reload();
+			return true;
+		}
+	}
+	return false;
+}
+
+std::string Shader::normalizePath(const std::string& _path)
+{
+	std::string path = _path;
+	std::replace(path.begin(), path.end(), '\\', '/');
+
+	std::vector<std::string> segments;
+	std::istringstream stream(path);
+	std::string segment;
+	while (std::getline(stream, segment, '/'))
+	{
+		if (segment.empty() || segment == ".")
+		{
+			continue;
+		}
+		if (segment == ".." && !segments.empty() && segments.back() != "..")
+		{
+			segments.pop_back();
+			continue;
+		}
+		segments.push_back(segment);
+	}
+
+	std::string result = (!path.empty() && path[0] == '/') ? "/" : "";
+	for (unsigned int i = 0; i < segments.size(); i++)
+	{
+		if (i > 0)
+		{
+			result += '/';
+		}
+		result += segments[i];
+	}
+	return result;
+}
+
+std::string Shader::getSPIRVPath(const std::string& _path)
+{
+	// Shaders/<dir>/<file> -> Shaders/SPIRV/<dir>/<file>.spv, mirroring the premake "shaders" action
+	std::string path = normalizePath(_path);
+	size_t root = path.rfind("Shaders/");
+	if (root == std::string::npos)
+	{
+		return path + ".spv";
+	}
+	root += 8;
+	return path.substr(0, root) + "SPIRV/" + path.substr(root) + ".spv";
 }
@@ -5,6 +5,10 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <map>
+#include <set>
+#include <vector>
+#include <ctime>
 
 #include <GL/glew.h> // Include glew to get all the required OpenGL Headers
 
@@ -12,28 +16,119 @@
 #include "glm/gtc/matrix_transform.hpp"
 #include "glm/gtc/type_ptr.hpp"
 
+#include "UniformCache.h"
+
+// Maximum number of #define switches a single shader can be permuted with
+#define SHADER_MAX_PERMUTATION_DEFINES 32
+
+// Maximum depth of nested #include, guards against include cycles
+#define SHADER_MAX_INCLUDE_DEPTH 16
+
 class Shader
 {
 public:
-	// The program ID
+	// The program ID (program of the currently selected permutation)
 	GLuint Program;
 
 	// Constructor reads and builds the shader
 	Shader(const GLchar* vertexPath, const GLchar* fragmentPath, const GLchar* geometryPath = nullptr);
 
 	virtual ~Shader();
-	
+
 	GLint getUniformPosition(const char* _varName);
 
 	void setVec3(const char* _varName, glm::vec3 _value);
 	void setVec2(const char* _varName, glm::vec2 _value);
 	void setFloat(const char* _varName, float _value);
 	void setInt(const char* _varName, int _value);
+	// By a location getUniformPosition() returned for the current program, no name lookup
+	void setInt(GLint _location, int _value);
 	void setMat4(const char* _varName, glm::mat4 _value);
 	void setBool(const char* _varName, bool _value);
 
+	// Attach a uniform block to a GL_UNIFORM_BUFFER binding point, kept across permutations and reloads
+	void setUniformBlockBinding(const char* _blockName, GLuint _binding);
+
+	// Register a #define switch for this shader, returns the bit to use in a permutation mask
+	unsigned int addPermutationDefine(const char* _define);
+
+	// Select the variant compiled with the defines in the mask, compiling it on first use
+	void setPermutation(unsigned int _permutationMask);
+	unsigned int getPermutation() const { return m_currentPermutation; }
+
 	// Use the program
 	void Use();
+
+	// Select permutation then use its program
+	void Use(unsigned int _permutationMask);
+
+	// True if the file is one of the stage files or anything they #include
+	bool dependsOn(const std::string& _path) const;
+
+	// Re-read every stage and drop all compiled permutations
+	void Reload();
+
+	// Reload only if a file in the include graph changed on disk since last load
+	bool reloadIfChanged();
+
+	// Files this shader was built from, root stage files and includes
+	const std::map<std::string, time_t>& getDependencies() const { return m_dependencies; }
+
+	// Per-frame uniform upload counters, shared by all shaders
+	static const UniformStats& getUniformStats() { return UniformCache::getStats(); }
+	static void resetUniformStats() { UniformCache::resetStats(); }
+
+	// Normalizes separators and "dir/../" segments so include paths compare equal
+	static std::string normalizePath(const std::string& _path);
+
+	// Load the base permutation from Shaders/SPIRV/*.spv ("premake5 shaders") when the driver supports it.
+	// Experimental, off unless a demo is started with --spirv: the setters find uniforms by name and GL
+	// does not have to keep the names of SPIR-V uniforms, so a module whose uniforms cannot all be
+	// found by name is dropped for the GLSL sources
+	static void setPreferSPIRV(bool _prefer) { s_preferSPIRV = _prefer; }
+	static std::string getSPIRVPath(const std::string& _path);
+
+private:
+	// Preprocessed source of one stage
+	struct StageSource
+	{
+		std::string Path;
+		std::string Code;
+		std::vector<std::string> Files; // index is the source string number used in #line
+	};
+
+	// Compiled program of one permutation with its uniform shadow state
+	struct ProgramVariant
+	{
+		GLuint Program;
+		UniformCache Uniforms;
+	};
+
+	void loadSources();
+	bool loadStage(StageSource& _stage);
+	bool preprocessFile(const std::string& _path, StageSource& _stage, std::set<std::string>& _included, int _depth, std::string& _out);
+	GLuint compileStage(GLenum _type, const StageSource& _stage, unsigned int _permutationMask, const char* _stageName);
+	GLuint compileProgram(unsigned int _permutationMask);
+	GLuint loadSPIRVStage(GLenum _type, const std::string& _binary, const StageSource& _stage, const char* _stageName);
+	GLuint loadSPIRVProgram();
+	GLuint linkProgram(GLuint _vertex, GLuint _fragment, GLuint _geometry);
+	void applyUniformBlockBindings(GLuint _program);
+	std::string injectDefines(const std::string& _code, unsigned int _permutationMask);
+
+	StageSource m_vertex;
+	StageSource m_fragment;
+	StageSource m_geometry;
+
+	// Flattened include graph: every file reached from the stages and its write time at load
+	std::map<std::string, time_t> m_dependencies;
+
+	std::map<std::string, GLuint> m_uniformBlockBindings;
+
+	std::vector<std::string> m_permutationDefines;
+	std::map<unsigned int, ProgramVariant> m_permutationPrograms;
+	ProgramVariant* m_currentVariant;
+	unsigned int m_currentPermutation;
+
+	static bool s_preferSPIRV;
 };
 #endif
-
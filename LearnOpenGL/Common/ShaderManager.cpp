@@ -68,3 +68,14 @@ Shader* ShaderManager::getShaderByType(int _type)
 	}
 	return nullptr;
 }
+
+int ShaderManager::reloadChangedShaders()
+{
+	int reloaded = 0;
+	for (auto shader : m_shaders) {
+		if (shader->reloadIfChanged()) {
+			reloaded++;
+		}
+	}
+	return reloaded;
+}
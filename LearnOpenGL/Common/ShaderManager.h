@@ -41,6 +41,9 @@ public:
 
 	Shader* getShaderByType(int _type);
 
+	// Recompile only shaders whose include graph has a file changed on disk, returns how many were rebuilt
+	int reloadChangedShaders();
+
 private:
 	std::vector<Shader*> m_shaders;
 
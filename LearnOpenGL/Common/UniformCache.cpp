@@ -0,0 +1,87 @@
+#include "UniformCache.h"
+
+#include <cstring>
+
+UniformStats UniformCache::s_stats = { 0, 0 };
+
+// FNV-1a, lets uniform names be looked up without building a std::string
+static size_t hashUniformName(const char* _name)
+{
+	unsigned long long hash = 14695981039346656037ULL;
+	for (const char* c = _name; *c; c++)
+	{
+		hash ^= (unsigned char)*c;
+		hash *= 1099511628211ULL;
+	}
+	return (size_t)hash;
+}
+
+UniformCache::UniformCache()
+	: m_program(0)
+{
+}
+
+void UniformCache::Reset(GLuint _program)
+{
+	m_program = _program;
+	m_slots.clear();
+	m_locations.clear();
+}
+
+UniformCache::Slot* UniformCache::getSlot(const char* _varName)
+{
+	size_t hash = hashUniformName(_varName);
+	auto it = m_slots.find(hash);
+	if (it != m_slots.end())
+	{
+		// Hash collision between two names, leave the second one uncached
+		return (it->second.Name == _varName) ? &it->second : nullptr;
+	}
+
+	Slot& slot = m_slots[hash];
+	slot.Name = _varName;
+	slot.Location = glGetUniformLocation(m_program, _varName);
+	slot.Size = 0;
+	if (slot.Location >= 0)
+	{
+		m_locations[slot.Location] = &slot;
+	}
+	return &slot;
+}
+
+UniformCache::Slot* UniformCache::getSlot(GLint _location)
+{
+	auto it = m_locations.find(_location);
+	return (it != m_locations.end()) ? it->second : nullptr;
+}
+
+GLint UniformCache::getLocation(const char* _varName)
+{
+	Slot* slot = getSlot(_varName);
+	return slot ? slot->Location : glGetUniformLocation(m_program, _varName);
+}
+
+bool UniformCache::Update(Slot* _slot, const void* _value, unsigned int _size)
+{
+	// Inactive uniforms and values the program already holds need no GL call
+	if (_slot && (_slot->Location < 0 || (_slot->Size == _size && memcmp(_slot->Value, _value, _size * sizeof(float)) == 0)))
+	{
+		s_stats.Skipped++;
+		return false;
+	}
+
+	if (_slot && _size <= UNIFORM_CACHE_MAX_FLOATS)
+	{
+		memcpy(_slot->Value, _value, _size * sizeof(float));
+		_slot->Size = _size;
+	}
+
+	s_stats.Issued++;
+	return true;
+}
+
+void UniformCache::resetStats()
+{
+	s_stats.Issued = 0;
+	s_stats.Skipped = 0;
+}
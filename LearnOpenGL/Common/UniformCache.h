@@ -0,0 +1,65 @@
+#ifndef UNIFORM_CACHE_H
+#define UNIFORM_CACHE_H
+
+#include <string>
+#include <unordered_map>
+
+#include <GL/glew.h>
+
+// Largest value a slot shadows, six vec4 frustum planes; bigger arrays keep their location but are uploaded every time
+#define UNIFORM_CACHE_MAX_FLOATS 24
+
+// Uniform uploads counted since the last UniformCache::resetStats()
+struct UniformStats
+{
+	unsigned int Issued;	// glUniform* calls forwarded to GL
+	unsigned int Skipped;	// calls dropped because the program already held the value
+};
+
+// CPU shadow of the active uniforms of one program, used by Shader and ComputeShader.
+// A location is looked up by name once, the value last uploaded is kept so setting what
+// the program already holds issues no GL call.
+class UniformCache
+{
+public:
+	struct Slot
+	{
+		std::string Name;
+		GLint Location;
+		unsigned int Size;	// number of floats/ints in Value, 0 until first upload
+		float Value[UNIFORM_CACHE_MAX_FLOATS];
+	};
+
+	UniformCache();
+
+	// Forgets every slot, for a newly linked program
+	void Reset(GLuint _program);
+
+	// Slot of a uniform, looked up on first use; nullptr when its name hash collides with another one
+	Slot* getSlot(const char* _varName);
+
+	// Slot a getSlot() found at this location, nullptr for locations never looked up
+	Slot* getSlot(GLint _location);
+
+	// Location of the uniform, through its slot when it has one
+	GLint getLocation(const char* _varName);
+
+	// Records the value and returns whether it has to go to GL
+	static bool Update(Slot* _slot, const void* _value, unsigned int _size);
+
+	// Per-frame upload counters, shared by all programs
+	static const UniformStats& getStats() { return s_stats; }
+	static void resetStats();
+
+	// Counts a call dropped without a slot, such as one for location -1
+	static void countSkipped() { s_stats.Skipped++; }
+
+private:
+	GLuint m_program;
+	std::unordered_map<size_t, Slot> m_slots;
+	std::unordered_map<GLint, Slot*> m_locations;	// the same slots by location
+
+	static UniformStats s_stats;
+};
+
+#endif
@@ -5,6 +5,11 @@
 // GLFW
 #include <GLFW/glfw3.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
 #include <iostream>
 #include <fstream>
 #include <map>
@@ -12,6 +17,16 @@
 
 #include "ShaderManager.h"
 #include "Shader.h"
+#include "GLStateCache.h"
+#include "Benchmark.h"
+#include "ComputeShader.h"
+#include "Frustum.h"
+#include "FrustumCulling.h"
+#include "OcclusionCulling.h"
+#include "FrameContext.h"
+#include "InstanceStream.h"
+#include "JobSystem.h"
+#include "PackedInstance.h"
 #include "Camera.h"
 #include "Material.h"
 #include "Light.h"
@@ -60,6 +75,11 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 		glfwSetWindowShouldClose(window, GL_TRUE);
 	}
 
+	// F5 rebuilds the shared shaders whose sources changed on disk
+	if (key == GLFW_KEY_F5 && action == GLFW_PRESS) {
+		std::cout << ShaderManager::getInstance()->reloadChangedShaders() << " shader(s) reloaded" << std::endl;
+	}
+
 	if (action == GLFW_PRESS)
 		keys[key] = true;
 	else if (action == GLFW_RELEASE)
@@ -101,16 +121,216 @@ void do_movement() {
 		camera.ProcessKeyboard(CameraMovement::RIGHT, deltaTime);
 }
 
-int main() {
+// Rocks generated per block of structure of arrays scratch, multiple of 4 for the SIMD packing
+#define ROCK_BLOCK_SIZE 256
+
+// Fill the belt on the job system. Every rock draws from its own split of the seed,
+// so the belt comes out the same however the blocks are spread over threads.
+void generate_rocks(std::vector<PackedInstance>& rocks, uint64_t seed) {
+	const float radius = 100.0f;
+	const float offset = 25.0f;
+	const glm::vec3 axis = glm::normalize(glm::vec3(0.4f, 0.6f, 0.8f));
+	const SplitMix64 belt(seed);
+	unsigned int amount = (unsigned int)rocks.size();
+
+	unsigned int blocks = (amount + ROCK_BLOCK_SIZE - 1) / ROCK_BLOCK_SIZE;
+	JobSystem::getInstance()->ParallelFor(blocks, 0, [&](unsigned int firstBlock, unsigned int endBlock)
+	{
+		unsigned int begin = firstBlock * ROCK_BLOCK_SIZE;
+		unsigned int end = std::min(endBlock * ROCK_BLOCK_SIZE, amount);
+		float x[ROCK_BLOCK_SIZE] = {}, y[ROCK_BLOCK_SIZE] = {}, z[ROCK_BLOCK_SIZE] = {};
+		float scales[ROCK_BLOCK_SIZE] = {}, angles[ROCK_BLOCK_SIZE] = {};
+		for (unsigned int first = begin; first < end; first += ROCK_BLOCK_SIZE)
+		{
+			unsigned int count = std::min((unsigned int)ROCK_BLOCK_SIZE, end - first);
+
+			// 1. translation: displace along circle with 'radius' in range [-offset, offset]
+			for (unsigned int i = 0; i < count; i++)
+			{
+				angles[i] = (float)(first + i) / (float)amount * 360.0f;
+			}
+			for (unsigned int i = 0; i < count; i += 4)
+			{
+				sinCos4(angles + i, x + i, z + i);
+			}
+
+			for (unsigned int i = 0; i < count; i++)
+			{
+				SplitMix64 rng = belt.split(first + i);
+				x[i] = x[i] * radius + rng.nextFloat(-offset, offset);
+				y[i] = rng.nextFloat(-offset, offset) * 0.4f; // keep the height of field smaller compared to with of x and z
+				z[i] = z[i] * radius + rng.nextFloat(-offset, offset);
+
+				// 2. Scale: Scale between 0.05f and 0.25f
+				scales[i] = rng.nextFloat(0.05f, 0.25f);
+
+				// 3 rotation: add random rotation around a (semi)randomly picked rotation axis vector
+				angles[i] = rng.nextFloat(0.0f, 360.0f);
+			}
+
+			packInstances(x, y, z, scales, angles, axis, count, &rocks[first]);
+		}
+	});
+}
+
+// Gravity of the planet in belt units, a rock at radius 100 goes around in about a minute
+#define BELT_GRAVITY 11000.0f
+
+// Circular Kepler orbit and tumble of one rock, its packed transform is rebuilt from this every frame
+struct RockOrbit
+{
+	float Radius;
+	float Phase;			// around the planet, 0 on +z
+	float AngularSpeed;		// sqrt(GM / r^3), inner rocks overtake outer ones
+	float Height;
+	float Angle;			// tumble around the shared rotation axis
+	float SpinSpeed;
+	float Scale;
+};
+
+// Recover the orbit of every generated rock, tumble speeds come from their own split of the seed
+void init_rock_orbits(const std::vector<PackedInstance>& rocks, uint64_t seed, std::vector<RockOrbit>& orbits) {
+	const glm::vec3 axis = glm::normalize(glm::vec3(0.4f, 0.6f, 0.8f));
+	const SplitMix64 spins(seed);
+	orbits.resize(rocks.size());
+	for (unsigned int i = 0; i < rocks.size(); i++)
+	{
+		const PackedInstance& rock = rocks[i];
+		RockOrbit& orbit = orbits[i];
+		orbit.Radius = std::max(1.0f, std::sqrt(rock.Position.x * rock.Position.x + rock.Position.z * rock.Position.z));
+		orbit.Phase = std::atan2(rock.Position.x, rock.Position.z);
+		orbit.AngularSpeed = std::sqrt(BELT_GRAVITY / (orbit.Radius * orbit.Radius * orbit.Radius));
+		orbit.Height = rock.Position.y;
+		orbit.Angle = 2.0f * std::atan2(rock.Rotation.x * axis.x + rock.Rotation.y * axis.y + rock.Rotation.z * axis.z, rock.Rotation.w);
+		orbit.SpinSpeed = spins.split(i).nextFloat(-1.0f, 1.0f);
+		orbit.Scale = rock.Scale;
+	}
+}
+
+// Advance rocks [begin, end) by deltaTime and pack them into out[begin, end)
+void simulate_rocks(RockOrbit* orbits, unsigned int begin, unsigned int end, float deltaTime, PackedInstance* out) {
+	const float pi = 3.14159265359f;
+	const float twoPi = 6.28318530718f;
+	const glm::vec3 axis = glm::normalize(glm::vec3(0.4f, 0.6f, 0.8f));
+
+	float x[ROCK_BLOCK_SIZE] = {}, y[ROCK_BLOCK_SIZE] = {}, z[ROCK_BLOCK_SIZE] = {};
+	float scales[ROCK_BLOCK_SIZE] = {}, angles[ROCK_BLOCK_SIZE] = {}, phases[ROCK_BLOCK_SIZE] = {};
+	for (unsigned int first = begin; first < end; first += ROCK_BLOCK_SIZE)
+	{
+		unsigned int count = std::min((unsigned int)ROCK_BLOCK_SIZE, end - first);
+		RockOrbit* block = orbits + first;
+
+		// Step the orbit and the tumble, wrapped so the angles keep their float precision
+		for (unsigned int i = 0; i < count; i++)
+		{
+			RockOrbit& orbit = block[i];
+			orbit.Phase += orbit.AngularSpeed * deltaTime;
+			if (orbit.Phase > pi)
+			{
+				orbit.Phase -= twoPi;
+			}
+			orbit.Angle += orbit.SpinSpeed * deltaTime;
+			if (orbit.Angle > twoPi)
+			{
+				orbit.Angle -= twoPi;
+			}
+			else if (orbit.Angle < -twoPi)
+			{
+				orbit.Angle += twoPi;
+			}
+
+			phases[i] = orbit.Phase;
+			y[i] = orbit.Height;
+			scales[i] = orbit.Scale;
+			angles[i] = orbit.Angle;
+		}
+
+		for (unsigned int i = 0; i < count; i += 4)
+		{
+			sinCos4(phases + i, x + i, z + i);
+		}
+		for (unsigned int i = 0; i < count; i++)
+		{
+			x[i] *= block[i].Radius;
+			z[i] *= block[i].Radius;
+		}
+
+		packInstances(x, y, z, scales, angles, axis, count, out + first);
+	}
+}
+
+// Time one belt update against the number of rocks, on one thread and on all of them
+void benchmark_rock_simulation() {
+	JobSystem* jobs = JobSystem::getInstance();
+	for (unsigned int count = 1000; count <= 1000000; count *= 10)
+	{
+		std::vector<PackedInstance> rocks(count);
+		std::vector<RockOrbit> orbits;
+		generate_rocks(rocks, 7);
+		init_rock_orbits(rocks, 7, orbits);
+
+		unsigned int iterations = std::max(5u, 2000000u / count);
+		auto start = std::chrono::high_resolution_clock::now();
+		for (unsigned int i = 0; i < iterations; i++)
+		{
+			simulate_rocks(orbits.data(), 0, count, 0.016f, rocks.data());
+		}
+		std::chrono::duration<double, std::milli> serial = std::chrono::high_resolution_clock::now() - start;
+
+		start = std::chrono::high_resolution_clock::now();
+		for (unsigned int i = 0; i < iterations; i++)
+		{
+			jobs->ParallelFor(count, 0, [&](unsigned int begin, unsigned int end)
+			{
+				simulate_rocks(orbits.data(), begin, end, 0.016f, rocks.data());
+			});
+		}
+		std::chrono::duration<double, std::milli> parallel = std::chrono::high_resolution_clock::now() - start;
+
+		double serialMilliseconds = serial.count() / iterations;
+		double parallelMilliseconds = parallel.count() / iterations;
+		std::cout << "Belt update " << count << " rocks: " << serialMilliseconds << " ms, " << parallelMilliseconds << " ms on "
+			<< jobs->getThreadCount() << " threads (" << parallelMilliseconds * 1000000.0 / count << " ns per rock)" << std::endl;
+	}
+}
+
+// Point the instance attributes of every rock mesh at _buffer, starting _offset bytes in
+void bind_rock_instances(Model& rockModel, unsigned int buffer, size_t offset) {
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	for (unsigned int i = 0; i < rockModel.meshes.size(); i++)
+	{
+		GLStateCache::getInstance()->bindVertexArray(rockModel.meshes[i].VAO);
+
+		// PackedInstance: position + scale, then the rotation quaternion
+		GLsizei stride = sizeof(PackedInstance);
+		glEnableVertexAttribArray(3);
+		glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, stride, (void*)offset);
+		glVertexAttribDivisor(3, 1);
+		glEnableVertexAttribArray(4);
+		glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, stride, (void*)(offset + sizeof(glm::vec4)));
+		glVertexAttribDivisor(4, 1);
+	}
+	GLStateCache::getInstance()->bindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+int main(int argc, char* argv[]) {
 
 	glfwInit();
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	Benchmark::Init(argc, argv);
+	// 4.3 for compute culling, the demo still runs on 3.3 without it
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 	glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
 
 	// Create window
 	GLFWwindow* window = glfwCreateWindow(800, 600, "LearnOpenGL", nullptr, nullptr);
+	if (window == nullptr) {
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+		window = glfwCreateWindow(800, 600, "LearnOpenGL", nullptr, nullptr);
+	}
 	if (window == nullptr) {
 		glfwTerminate();
 		std::cout << "Failed to create GLFW window" << std::endl;
@@ -132,72 +352,142 @@ int main() {
 
 	// Setup Shaders
 	ShaderManager::Init();
+	JobSystem::Init();
 	Shader instanceShader("Shaders/AsteroidInstancing/AsteroidInstancing.vs", "Shaders/SimpleShaderUnlitColor.frag");
 
 	// Model Load
 	Model planetModel("Resources/planet/planet.obj");
 	Model rockModel("Resources/rock/rock.obj");
 	
-	// Setup Rock/Asteroids
-	unsigned int amount = 100000;
-	std::vector<glm::mat4> modelMatrices;
-	srand(glfwGetTime());
-	float radius = 100.0f;
-	float offset = 25.0f;
-	for (unsigned int i = 0; i < amount; i++)
-	{
-		glm::mat4 model;
-		// 1. translation: displace along circle with 'radius' in range [-offset, offset]
-		float angle = (float)i / (float)amount * 360.0f;
-		float displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
-		float x = sin(angle) * radius + displacement;
-		displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
-		float y = displacement * 0.4f; // keep the height of field smaller compared to with of x and z
-		displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
-		float z = cos(angle) * radius + displacement;
-		model = glm::translate(model, glm::vec3(x, y, z));
-
-		// 2. Scale: Scale between 0.05f and 0.25f
-		float scale = (rand() % 20) / 100.0f + 0.05;
-		model = glm::scale(model, glm::vec3(scale));
-
-		// 3 rotation: add random rotation around a (semi)randomly picked rotation axis vector
-		float rotAngle = (rand() % 360);
-		model = glm::rotate(model, rotAngle, glm::vec3(0.4f, 0.6f, 0.8f));
-
-		modelMatrices.push_back(model);
-	}
-	
+	// Setup Rock/Asteroids, the belt size can be given on the command line to find where the update stops scaling
+	unsigned int amount = argc > 1 ? (unsigned int)std::max(1, std::atoi(argv[1])) : 100000;
+	std::vector<PackedInstance> rocks(amount);
+	auto generateStart = std::chrono::high_resolution_clock::now();
+	generate_rocks(rocks, 42);
+	std::chrono::duration<double, std::milli> generateElapsed = std::chrono::high_resolution_clock::now() - generateStart;
+	std::cout << "Generated " << amount << " rocks in " << generateElapsed.count() << " ms on " << JobSystem::getInstance()->getThreadCount() << " threads" << std::endl;
+
 	// Vertex Buffer Object for rock instancing
 	unsigned int instanceBuffer;
 	glGenBuffers(1, &instanceBuffer);
 	glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
-	glBufferData(GL_ARRAY_BUFFER, amount * sizeof(glm::mat4), &modelMatrices[0], GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, amount * sizeof(PackedInstance), rocks.data(), GL_STATIC_DRAW);
+
+	// GPU culling: a compute pass appends the rocks inside the frustum to visibleBuffer
+	// and counts them straight into the indirect draw commands, one per rock mesh
+	ComputeShader* cullShader = ComputeShader::isSupported() ? new ComputeShader("Shaders/AsteroidInstancing/AsteroidCull.comp") : nullptr;
+	bool gpuCulling = cullShader && cullShader->isValid();
+	bool cullingEnabled = true;
 
+	float rockRadius = 0.0f;
+	std::vector<DrawElementsIndirectCommand> rockCommands;
 	for (unsigned int i = 0; i < rockModel.meshes.size(); i++)
 	{
-		unsigned int VAO = rockModel.meshes[i].VAO;
-		glBindVertexArray(VAO);
+		const Mesh& mesh = rockModel.meshes[i];
+		rockRadius = std::max(rockRadius, getBoundingRadius(&mesh.vertices[0].Position, (unsigned int)mesh.vertices.size(), sizeof(Vertex)));
 
-		// vertex Attributes
-		GLsizei vec4size = sizeof(glm::vec4);
-		glEnableVertexAttribArray(3);
-		glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, 4 * vec4size, (void*)0);
-		glEnableVertexAttribArray(4);
-		glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, 4 * vec4size, (void*) vec4size);
-		glEnableVertexAttribArray(5);
-		glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, 4 * vec4size, (void*)(2 * vec4size));
-		glEnableVertexAttribArray(6);
-		glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, 4 * vec4size, (void*)(3 * vec4size));
+		DrawElementsIndirectCommand command = { (GLuint)mesh.indices.size(), 0, 0, 0, 0 };
+		rockCommands.push_back(command);
+	}
 
-		glVertexAttribDivisor(3, 1);
-		glVertexAttribDivisor(4, 1);
-		glVertexAttribDivisor(5, 1);
-		glVertexAttribDivisor(6, 1);
+	unsigned int visibleBuffer = 0;
+	unsigned int rockCommandBuffer = 0;
+
+	// The count the title shows is copied out of the command buffer behind a fence and read once the GPU passed it,
+	// reading the command buffer itself would wait for the whole frame
+	unsigned int countReadbackBuffer = 0;
+	GLsync countFence = nullptr;
+	GLuint gpuVisibleCount = 0;
+	if (gpuCulling)
+	{
+		glGenBuffers(1, &visibleBuffer);
+		glBindBuffer(GL_ARRAY_BUFFER, visibleBuffer);
+		glBufferData(GL_ARRAY_BUFFER, amount * sizeof(PackedInstance), NULL, GL_DYNAMIC_COPY);
+
+		glGenBuffers(1, &rockCommandBuffer);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, rockCommandBuffer);
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, rockCommands.size() * sizeof(DrawElementsIndirectCommand), rockCommands.data(), GL_DYNAMIC_COPY);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+		glGenBuffers(1, &countReadbackBuffer);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, countReadbackBuffer);
+		glBufferData(GL_COPY_WRITE_BUFFER, sizeof(GLuint), NULL, GL_STREAM_READ);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
 
-		glBindVertexArray(0);
+	FrustumCuller rockCuller;
+	rockCuller.Reserve(amount);
+	std::vector<glm::vec3> rockMins(amount), rockMaxs(amount);
+	for (unsigned int i = 0; i < amount; i++)
+	{
+		const glm::vec3& center = rocks[i].Position;
+		float scaledRadius = rockRadius * rocks[i].Scale;
+		rockCuller.AddSphere(center, scaledRadius);
+		rockMins[i] = center - glm::vec3(scaledRadius);
+		rockMaxs[i] = center + glm::vec3(scaledRadius);
+	}
+
+	// The planet hides the rocks behind it, V / B switch the CPU occlusion test on and off
+	OcclusionCuller occlusionCuller;
+	bool occlusionEnabled = true;
+	unsigned int cullThreads = JobSystem::getInstance()->getThreadCount();
+	std::vector<unsigned int> visibleRocks;
+
+	// 1 / 2 / 3 set how many frames the CPU may queue ahead of the GPU, the streamed rings follow it
+	FrameContext* frameContext = new FrameContext(2);
+
+	// Without compute the CPU culls and writes the visible rocks straight into a persistently mapped ring
+	InstanceStream* rockStream = gpuCulling ? nullptr : new InstanceStream(amount * sizeof(PackedInstance), frameContext);
+	unsigned int cpuVisibleCount = amount;
+	double cpuCullMilliseconds = 0.0;
+
+	// Startup microbenchmarks, only with --microbench
+	bool microbench = Benchmark::getInstance()->isMicrobenchmarking();
+	if (microbench)
+	{
+		std::cout << "Frustum culling 100k spheres: " << FrustumCuller::benchmark(100000, 20, false) << " ms, "
+			<< FrustumCuller::benchmark(100000, 20, true) << " ms on " << cullThreads << " threads" << std::endl;
+		std::cout << "Frustum culling 1M spheres: " << FrustumCuller::benchmark(1000000, 10, false) << " ms, "
+			<< FrustumCuller::benchmark(1000000, 10, true) << " ms on " << cullThreads << " threads" << std::endl;
+	}
+
+	if (microbench)
+	{
+		std::vector<double> jobScaling;
+		JobSystem::benchmark(cullThreads, jobScaling);
+		std::cout << "Job system scaling:";
+		for (unsigned int i = 0; i < jobScaling.size(); i++)
+		{
+			std::cout << " " << i + 1 << " threads " << jobScaling[i] << " ms (x" << jobScaling[0] / jobScaling[i] << ")";
+		}
+		std::cout << std::endl;
+	}
+
+	if (microbench)
+	{
+		OcclusionStats occlusionBenchmark;
+		unsigned int trulyOccluded, falselyOccluded;
+		OcclusionCuller::benchmark(100000, occlusionBenchmark, trulyOccluded, falselyOccluded);
+		std::cout << "Occlusion culling 100k boxes: " << occlusionBenchmark.Occluded << " of " << trulyOccluded << " hidden boxes culled, "
+			<< falselyOccluded << " wrongly, raster " << occlusionBenchmark.RasterMilliseconds << " ms, test " << occlusionBenchmark.TestMilliseconds << " ms" << std::endl;
 	}
 
+	// M / N start and stop the belt: every rock orbits the planet and tumbles, updated on all cores
+	// and written straight into a streamed instance buffer. Regions stay storage buffer aligned for the cull pass.
+	std::vector<RockOrbit> rockOrbits;
+	init_rock_orbits(rocks, 43, rockOrbits);
+	bool animating = false;
+	InstanceStream* beltStream = new InstanceStream((unsigned int)((amount * sizeof(PackedInstance) + 255) / 256 * 256), frameContext);
+	size_t beltOffset = 0;
+	double beltMilliseconds = 0.0;
+	if (microbench)
+	{
+		benchmark_rock_simulation();
+	}
+
+	// With GPU culling the instances come from the compacted buffer
+	bind_rock_instances(rockModel, gpuCulling ? visibleBuffer : instanceBuffer, 0);
+
 	// set mouse callbacks
 	glfwSetCursorPosCallback(window, mouse_callback);
 	glfwSetScrollCallback(window, scroll_callback);
@@ -206,21 +496,31 @@ int main() {
 	glfwSetKeyCallback(window, key_callback);
 
 	// Setup
-	glEnable(GL_DEPTH_TEST);
+	GLStateCache::getInstance()->enable(GL_DEPTH_TEST);
 
 	// Main loop of drawing
-	glViewport(0, 0, width, height);
+	GLStateCache::getInstance()->viewport(0, 0, width, height);
 	while (!glfwWindowShouldClose(window)) {
 		// Check and call events
 		glfwPollEvents();
 
 
 		// calculate delta time
-		GLfloat currentFrame = glfwGetTime();
+		GLfloat currentFrame = Benchmark::getInstance()->getTime();
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
 
 		do_movement();
+		Benchmark::getInstance()->Update(camera);
+
+		for (unsigned int frames = 1; frames <= FRAME_CONTEXT_MAX_FRAMES; frames++)
+		{
+			if (keys[GLFW_KEY_0 + frames])
+			{
+				frameContext->setFramesInFlight(frames);
+			}
+		}
+		frameContext->BeginFrame();
 
 		// Rendering commands here
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
@@ -242,26 +542,274 @@ int main() {
 		planetModel.Draw(shader);
 		
 
+		if (keys[GLFW_KEY_V])
+		{
+			occlusionEnabled = true;
+		}
+		if (keys[GLFW_KEY_B])
+		{
+			occlusionEnabled = false;
+		}
+
+		// The rocks of this frame, static unless the belt moves
+		unsigned int rockBuffer = instanceBuffer;
+		size_t rockOffset = 0;
+		bool rocksMoved = false;
+
+		if (keys[GLFW_KEY_M])
+		{
+			animating = true;
+		}
+		if (keys[GLFW_KEY_N] && animating)
+		{
+			// Freeze where the rocks are: the last streamed region becomes the static instance buffer
+			animating = false;
+			rocksMoved = true;
+			glBindBuffer(GL_COPY_READ_BUFFER, beltStream->getBuffer());
+			glBindBuffer(GL_COPY_WRITE_BUFFER, instanceBuffer);
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, beltOffset, 0, amount * sizeof(PackedInstance));
+		}
+
+		if (animating)
+		{
+			auto beltStart = std::chrono::high_resolution_clock::now();
+
+			// The CPU culler needs the rocks and their bounds in system memory, the mapped region is only written
+			PackedInstance* belt = static_cast<PackedInstance*>(beltStream->Map());
+			float step = deltaTime;
+			JobSystem::getInstance()->ParallelFor(amount, 0, [&](unsigned int begin, unsigned int end)
+			{
+				if (gpuCulling)
+				{
+					simulate_rocks(rockOrbits.data(), begin, end, step, belt);
+					return;
+				}
+
+				simulate_rocks(rockOrbits.data(), begin, end, step, rocks.data());
+				std::copy(rocks.begin() + begin, rocks.begin() + end, belt + begin);
+				for (unsigned int i = begin; i < end; i++)
+				{
+					const glm::vec3& center = rocks[i].Position;
+					float scaledRadius = rockRadius * rocks[i].Scale;
+					rockCuller.SetSphere(i, center, scaledRadius);
+					rockMins[i] = center - glm::vec3(scaledRadius);
+					rockMaxs[i] = center + glm::vec3(scaledRadius);
+				}
+			});
+			beltStream->Unmap(amount * sizeof(PackedInstance));
+
+			std::chrono::duration<double, std::milli> beltElapsed = std::chrono::high_resolution_clock::now() - beltStart;
+			beltMilliseconds = beltElapsed.count();
+
+			beltOffset = beltStream->getOffset();
+			rockBuffer = beltStream->getBuffer();
+			rockOffset = beltOffset;
+			rocksMoved = true;
+		}
+
+		// C / X switch culling on and off
+		if (keys[GLFW_KEY_C] && !cullingEnabled)
+		{
+			cullingEnabled = true;
+		}
+		if (keys[GLFW_KEY_X] && cullingEnabled)
+		{
+			cullingEnabled = false;
+			rocksMoved = true;
+			cpuVisibleCount = amount;
+			if (gpuCulling)
+			{
+				for (auto& command : rockCommands)
+				{
+					command.instanceCount = amount;
+				}
+				glBindBuffer(GL_DRAW_INDIRECT_BUFFER, rockCommandBuffer);
+				glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, rockCommands.size() * sizeof(DrawElementsIndirectCommand), rockCommands.data());
+				glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+			}
+		}
+
+		// Draw everything: straight from the rocks, or the compacted buffer as a plain copy of them
+		if (!cullingEnabled && rocksMoved)
+		{
+			if (!gpuCulling)
+			{
+				bind_rock_instances(rockModel, rockBuffer, rockOffset);
+			}
+			else
+			{
+				glBindBuffer(GL_COPY_READ_BUFFER, rockBuffer);
+				glBindBuffer(GL_COPY_WRITE_BUFFER, visibleBuffer);
+				glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, rockOffset, 0, amount * sizeof(PackedInstance));
+			}
+		}
+
+		if (cullingEnabled && !gpuCulling)
+		{
+			auto cullStart = std::chrono::high_resolution_clock::now();
+
+			Frustum frustum;
+			frustum.Extract(projection * view);
+			cpuVisibleCount = rockCuller.CullParallel(frustum, visibleRocks);
+
+			if (occlusionEnabled)
+			{
+				occlusionCuller.Begin(projection * view);
+				for (unsigned int i = 0; i < planetModel.meshes.size(); i++)
+				{
+					const Mesh& mesh = planetModel.meshes[i];
+					occlusionCuller.AddOccluder(&mesh.vertices[0].Position, (unsigned int)mesh.vertices.size(), sizeof(Vertex),
+						mesh.indices.data(), (unsigned int)mesh.indices.size(), model);
+				}
+				occlusionCuller.Finish();
+				occlusionCuller.Filter(rockMins.data(), rockMaxs.data(), visibleRocks);
+				cpuVisibleCount = (unsigned int)visibleRocks.size();
+			}
+
+			std::chrono::duration<double, std::milli> cullElapsed = std::chrono::high_resolution_clock::now() - cullStart;
+			cpuCullMilliseconds = cullElapsed.count();
+
+			// Region of this frame is written while the GPU may still draw the other frames in flight
+			PackedInstance* visibleInstances = static_cast<PackedInstance*>(rockStream->Map());
+			for (unsigned int i = 0; i < cpuVisibleCount; i++)
+			{
+				visibleInstances[i] = rocks[visibleRocks[i]];
+			}
+			rockStream->Unmap(cpuVisibleCount * sizeof(PackedInstance));
+			bind_rock_instances(rockModel, rockStream->getBuffer(), rockStream->getOffset());
+		}
+		else if (cullingEnabled)
+		{
+			// Reset the instance counts then let the compute pass fill them
+			for (auto& command : rockCommands)
+			{
+				command.instanceCount = 0;
+			}
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, rockCommandBuffer);
+			glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, rockCommands.size() * sizeof(DrawElementsIndirectCommand), rockCommands.data());
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+			Frustum frustum;
+			frustum.Extract(projection * view);
+
+			cullShader->Use();
+			cullShader->setVec4Array("frustumPlanes", frustum.Planes, 6);
+			cullShader->setUInt("instanceCount", amount);
+			cullShader->setUInt("commandCount", (unsigned int)rockCommands.size());
+			cullShader->setFloat("boundingRadius", rockRadius);
+			glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, rockBuffer, rockOffset, amount * sizeof(PackedInstance));
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, visibleBuffer);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, rockCommandBuffer);
+			cullShader->Dispatch(amount, 256);
+
+			// Draw commands and instance attributes are read after the writes land
+			glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+		}
+
 		// Draw rocks
 		instanceShader.Use();
 		instanceShader.setMat4("view", view);
 		instanceShader.setMat4("projection", projection);
 		instanceShader.setInt("material.diffuse", 0);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, rockModel.textures_loaded[0].id); // note: bind the texture manually, since we draw it manually not from Model class
+		GLStateCache::getInstance()->activeTexture(GL_TEXTURE0);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, rockModel.textures_loaded[0].id); // note: bind the texture manually, since we draw it manually not from Model class
+		if (gpuCulling)
+		{
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, rockCommandBuffer);
+		}
 		for (unsigned int i = 0; i < rockModel.meshes.size(); i++)
 		{
-			glBindVertexArray(rockModel.meshes[i].VAO);
-			glDrawElementsInstanced(GL_TRIANGLES, rockModel.meshes[i].indices.size(), GL_UNSIGNED_INT, 0, amount);
-			glBindVertexArray(0);
+			GLStateCache::getInstance()->bindVertexArray(rockModel.meshes[i].VAO);
+			if (gpuCulling)
+			{
+				glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)(i * sizeof(DrawElementsIndirectCommand)));
+			}
+			else
+			{
+				glDrawElementsInstanced(GL_TRIANGLES, rockModel.meshes[i].indices.size(), GL_UNSIGNED_INT, 0, cpuVisibleCount);
+			}
+		}
+		if (gpuCulling)
+		{
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+			// Instance count of the first rock mesh as the cull pass wrote it, one copy in flight at a time
+			GLenum countStatus = countFence ? glClientWaitSync(countFence, 0, 0) : GL_TIMEOUT_EXPIRED;
+			if (countStatus == GL_ALREADY_SIGNALED || countStatus == GL_CONDITION_SATISFIED)
+			{
+				glDeleteSync(countFence);
+				countFence = nullptr;
+				glBindBuffer(GL_COPY_READ_BUFFER, countReadbackBuffer);
+				glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(gpuVisibleCount), &gpuVisibleCount);
+			}
+			if (!countFence)
+			{
+				glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+				glBindBuffer(GL_COPY_READ_BUFFER, rockCommandBuffer);
+				glBindBuffer(GL_COPY_WRITE_BUFFER, countReadbackBuffer);
+				glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, offsetof(DrawElementsIndirectCommand, instanceCount), 0, sizeof(GLuint));
+				countFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			}
+		}
+
+		// Once per second, show how many rocks survived the culling
+		if ((int)currentFrame != (int)(currentFrame - deltaTime))
+		{
+			std::string title;
+			if (gpuCulling)
+			{
+				title = "LearnOpenGL - rocks drawn: " + std::to_string(gpuVisibleCount) + " / " + std::to_string(amount);
+			}
+			else
+			{
+				title = "LearnOpenGL - rocks drawn: " + std::to_string(cpuVisibleCount) + " / " + std::to_string(amount)
+					+ " - CPU cull " + std::to_string(cpuCullMilliseconds) + " ms";
+				if (occlusionEnabled)
+				{
+					const OcclusionStats& occlusionStats = occlusionCuller.getStats();
+					title += " - occluded " + std::to_string(occlusionStats.Occluded) + " raster " + std::to_string(occlusionStats.RasterMilliseconds)
+						+ " ms test " + std::to_string(occlusionStats.TestMilliseconds) + " ms";
+				}
+			}
+			if (animating)
+			{
+				title += " - belt update " + std::to_string(beltMilliseconds) + " ms";
+			}
+			title += " - frames in flight " + std::to_string(frameContext->getFramesInFlight()) + ", GPU waits " + std::to_string(frameContext->getStats().Waits)
+				+ " (" + std::to_string(frameContext->getStats().TotalWaitMilliseconds) + " ms)";
+			frameContext->resetStats();
+			glfwSetWindowTitle(window, title.c_str());
 		}
 
 		// Swap the buffers
+		frameContext->EndFrame();
+		Benchmark::getInstance()->EndFrame(window);
 		glfwSwapBuffers(window);
 	}
 
+	if (gpuCulling)
+	{
+		glDeleteBuffers(1, &visibleBuffer);
+		glDeleteBuffers(1, &rockCommandBuffer);
+		glDeleteBuffers(1, &countReadbackBuffer);
+		if (countFence)
+		{
+			glDeleteSync(countFence);
+		}
+	}
+	delete rockStream;
+	delete beltStream;
+	delete frameContext;
+	delete cullShader;
+	glDeleteBuffers(1, &instanceBuffer);
+
+	JobSystem::Destroy();
 	ShaderManager::Destroy();
 
+	Benchmark::Destroy();
+
+	GLStateCache::Destroy();
+
 	// Terminate before close
 	glfwTerminate();
 
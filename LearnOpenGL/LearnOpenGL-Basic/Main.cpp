@@ -10,6 +10,8 @@
 
 #include "ShaderManager.h"
 #include "Shader.h"
+#include "GLStateCache.h"
+#include "Benchmark.h"
 #include "Camera.h"
 #include "Material.h"
 #include "Light.h"
@@ -46,6 +48,11 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 		glfwSetWindowShouldClose(window, GL_TRUE);
 	}
 
+	// F5 rebuilds the shared shaders whose sources changed on disk
+	if (key == GLFW_KEY_F5 && action == GLFW_PRESS) {
+		std::cout << ShaderManager::getInstance()->reloadChangedShaders() << " shader(s) reloaded" << std::endl;
+	}
+
 	if (action == GLFW_PRESS)
 		keys[key] = true;
 	else if (action == GLFW_RELEASE)
@@ -88,9 +95,10 @@ void do_movement() {
 		camera.ProcessKeyboard(CameraMovement::RIGHT, deltaTime);
 }
 
-int main() {
+int main(int argc, char* argv[]) {
 
 	glfwInit();
+	Benchmark::Init(argc, argv);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -172,7 +180,7 @@ int main() {
 	GLuint VAO;
 	glGenVertexArrays(1, &VAO);
 
-	glBindVertexArray(VAO);
+	GLStateCache::getInstance()->bindVertexArray(VAO);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(cube_vertices), cube_vertices, GL_STATIC_DRAW);
 
@@ -188,7 +196,7 @@ int main() {
 	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
 	glEnableVertexAttribArray(2);
 
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 
 
 	// setting up Textures
@@ -201,7 +209,7 @@ int main() {
 	
 	glGenTextures(1, &diffuseMap);
 
-	glBindTexture(GL_TEXTURE_2D, diffuseMap);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap);
 	// Set Texture Parameters
 	// Set Wrap function
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
@@ -216,7 +224,7 @@ int main() {
 	
 	stbi_image_free(image);
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
 
 	// Setting up Specular map
 	int s_width, s_height;
@@ -225,7 +233,7 @@ int main() {
 	GLuint specularMap;
 	
 	glGenTextures(1, &specularMap);
-	glBindTexture(GL_TEXTURE_2D, specularMap);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, specularMap);
 	// Set Texture Parameters
 	// Set Wrap Function
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
@@ -240,19 +248,19 @@ int main() {
 
 	stbi_image_free(specular_image);
 	
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
 
 	// Setup light VAO
 	GLuint lightVAO;
 	glGenVertexArrays(1, &lightVAO);
 
-	glBindVertexArray(lightVAO);
+	GLStateCache::getInstance()->bindVertexArray(lightVAO);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO);
 
 	// Position attributes
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)0);
 	glEnableVertexAttribArray(0);
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 
 	glm::vec3 cubePositions[] = {
 		glm::vec3(0.0f,  0.0f,  0.0f),
@@ -308,20 +316,21 @@ int main() {
 	glfwSetKeyCallback(window, key_callback);
 
 	// Setup
-	glEnable(GL_DEPTH_TEST);
+	GLStateCache::getInstance()->enable(GL_DEPTH_TEST);
 
 	// Main loop of drawing
-	glViewport(0, 0, width, height);
+	GLStateCache::getInstance()->viewport(0, 0, width, height);
 	while (!glfwWindowShouldClose(window)) {
 		// Check and call events
 		glfwPollEvents();
 
 		// calculate delta time
-		GLfloat currentFrame = glfwGetTime();
+		GLfloat currentFrame = Benchmark::getInstance()->getTime();
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
 
 		do_movement();
+		Benchmark::getInstance()->Update(camera);
 
 		// Rendering commands here
 		glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
@@ -340,14 +349,14 @@ int main() {
 #if USING_DIFFUSE_MAP
 		_3dShader->setInt("material.diffuse", 0);
 		
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, diffuseMap);
+		GLStateCache::getInstance()->activeTexture(GL_TEXTURE0);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap);
 
 		_3dShader->setBool("material.useSpecular", true);
 		_3dShader->setInt("material.specular", 1);
 
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, specularMap);
+		GLStateCache::getInstance()->activeTexture(GL_TEXTURE1);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, specularMap);
 #else
 		GLint matAmbientLoc = _3dShader->getUniformPosition("material.ambient");
 		GLint matDiffuseLoc = _3dShader->getUniformPosition("material.diffuse");
@@ -423,7 +432,7 @@ int main() {
 		_3dShader->setMat4("view", view);
 		_3dShader->setMat4("projection", projection);
 
-		glBindVertexArray(VAO);
+		GLStateCache::getInstance()->bindVertexArray(VAO);
 
 		for (int i = 0; i < 10; i++) 
 		{
@@ -436,7 +445,7 @@ int main() {
 
 			glDrawArrays(GL_TRIANGLES, 0, 36);
 		}
-		glBindVertexArray(0);
+		GLStateCache::getInstance()->bindVertexArray(0);
 
 		// render the loaded model
 		{
@@ -448,7 +457,7 @@ int main() {
 		}
 		
 #if USING_DIFFUSE_MAP
-		glBindTexture(GL_TEXTURE_2D, 0);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
 #endif
 		// Drawing Light
 		Shader* lightShader = ShaderManager::getInstance()->getShaderByType(SHADER_TYPE_VERTICE_LIGHT_REP);
@@ -458,7 +467,7 @@ int main() {
 		lightShader->setMat4("projection", projection);
 
 		// Setup model
-		glBindVertexArray(lightVAO);
+		GLStateCache::getInstance()->bindVertexArray(lightVAO);
 		for (int i = 0; i < 4; i++)
 		{
 			glm::mat4 model = glm::mat4();
@@ -469,7 +478,9 @@ int main() {
 
 			glDrawArrays(GL_TRIANGLES, 0, 36);
 		}
-		glBindVertexArray(0);
+		GLStateCache::getInstance()->bindVertexArray(0);
+
+		Benchmark::getInstance()->EndFrame(window);
 
 		// Swap the buffers
 		glfwSwapBuffers(window);
@@ -482,6 +493,10 @@ int main() {
 
 	ShaderManager::Destroy();
 	
+	Benchmark::Destroy();
+
+	GLStateCache::Destroy();
+
 	// Terminate before close
 	glfwTerminate();
 
@@ -10,6 +10,9 @@
 #include <map>
 
 #include "Shader.h"
+#include "ShaderManager.h"
+#include "GLStateCache.h"
+#include "Benchmark.h"
 #include "Camera.h"
 #include "Material.h"
 #include "Light.h"
@@ -51,6 +54,11 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 		glfwSetWindowShouldClose(window, GL_TRUE);
 	}
 
+	// F5 rebuilds the shared shaders whose sources changed on disk
+	if (key == GLFW_KEY_F5 && action == GLFW_PRESS) {
+		std::cout << ShaderManager::getInstance()->reloadChangedShaders() << " shader(s) reloaded" << std::endl;
+	}
+
 	if (action == GLFW_PRESS)
 		keys[key] = true;
 	else if (action == GLFW_RELEASE)
@@ -94,9 +102,10 @@ void do_movement()
 		camera.ProcessKeyboard(CameraMovement::RIGHT, deltaTime);
 }
 
-int main() 
+int main(int argc, char* argv[]) 
 {
 	glfwInit();
+	Benchmark::Init(argc, argv);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -142,21 +151,22 @@ int main()
 	glfwSetKeyCallback(window, key_callback);
 
 	// Setup
-	glEnable(GL_DEPTH_TEST);
+	GLStateCache::getInstance()->enable(GL_DEPTH_TEST);
 
 	// Main loop of drawing
-	glViewport(0, 0, width, height);
+	GLStateCache::getInstance()->viewport(0, 0, width, height);
 	while (!glfwWindowShouldClose(window)) 
 	{
 		// Check and call events
 		glfwPollEvents();
 
 		// calculate delta time
-		GLfloat currentFrame = glfwGetTime();
+		GLfloat currentFrame = Benchmark::getInstance()->getTime();
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
 
 		do_movement();
+		Benchmark::getInstance()->Update(camera);
 
 		// Rendering commands here
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
@@ -164,6 +174,8 @@ int main()
 
 		// Draw
 
+		Benchmark::getInstance()->EndFrame(window);
+
 		// Swap the buffers
 		glfwSwapBuffers(window);
 	}
@@ -171,6 +183,10 @@ int main()
 	// Deleting All Buffers
 	ShaderManager::Destroy();
 
+	Benchmark::Destroy();
+
+	GLStateCache::Destroy();
+
 	// Terminate before close
 	glfwTerminate();
 
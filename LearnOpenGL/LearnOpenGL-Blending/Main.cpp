@@ -11,6 +11,9 @@
 
 #include "ShaderManager.h"
 #include "Shader.h"
+#include "GLStateCache.h"
+#include "Benchmark.h"
+#include "RenderQueue.h"
 #include "Camera.h"
 #include "Material.h"
 #include "Light.h"
@@ -51,6 +54,11 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 		glfwSetWindowShouldClose(window, GL_TRUE);
 	}
 
+	// F5 rebuilds the shared shaders whose sources changed on disk
+	if (key == GLFW_KEY_F5 && action == GLFW_PRESS) {
+		std::cout << ShaderManager::getInstance()->reloadChangedShaders() << " shader(s) reloaded" << std::endl;
+	}
+
 	if (action == GLFW_PRESS)
 		keys[key] = true;
 	else if (action == GLFW_RELEASE)
@@ -92,9 +100,10 @@ void do_movement() {
 		camera.ProcessKeyboard(CameraMovement::RIGHT, deltaTime);
 }
 
-int main() {
+int main(int argc, char* argv[]) {
 
 	glfwInit();
+	Benchmark::Init(argc, argv);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -141,7 +150,7 @@ int main() {
 	GLuint VAO_plane;
 	glGenVertexArrays(1, &VAO_plane);
 
-	glBindVertexArray(VAO_plane);
+	GLStateCache::getInstance()->bindVertexArray(VAO_plane);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO_plane);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(plane_vertices), plane_vertices, GL_STATIC_DRAW);
 
@@ -157,7 +166,7 @@ int main() {
 	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
 	glEnableVertexAttribArray(2);
 
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 
 	// 3D cube
 	GLfloat cube_vertices[] = {
@@ -211,7 +220,7 @@ int main() {
 	GLuint VAO_cube;
 	glGenVertexArrays(1, &VAO_cube);
 
-	glBindVertexArray(VAO_cube);
+	GLStateCache::getInstance()->bindVertexArray(VAO_cube);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO_cube);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(cube_vertices), cube_vertices, GL_STATIC_DRAW);
 
@@ -227,7 +236,7 @@ int main() {
 	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
 	glEnableVertexAttribArray(2);
 
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 
 	// Vegetation Plane
 	GLfloat vegetation_vertices[] = {
@@ -246,7 +255,7 @@ int main() {
 	GLuint VAO_vegetation;
 	glGenVertexArrays(1, &VAO_vegetation);
 
-	glBindVertexArray(VAO_vegetation);
+	GLStateCache::getInstance()->bindVertexArray(VAO_vegetation);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO_vegetation);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(vegetation_vertices), vegetation_vertices, GL_STATIC_DRAW);
 	
@@ -262,7 +271,7 @@ int main() {
 	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
 	glEnableVertexAttribArray(1);
 
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 
 
 	// setting up Textures
@@ -273,7 +282,7 @@ int main() {
 
 	glGenTextures(1, &diffuseMap);
 
-	glBindTexture(GL_TEXTURE_2D, diffuseMap);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap);
 	// Set Texture Parameters
 	// Set Wrap function
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
@@ -288,7 +297,7 @@ int main() {
 
 	stbi_image_free(image);
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
 
 	// Texture Container
 	image = stbi_load("Resources/textures/container2.png", &t_width, &t_height, 0, STBI_rgb);
@@ -297,7 +306,7 @@ int main() {
 
 	glGenTextures(1, &diffuseMap_cube);
 
-	glBindTexture(GL_TEXTURE_2D, diffuseMap_cube);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap_cube);
 	// Set Texture Parameters
 	// Set Wrap function
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
@@ -312,7 +321,7 @@ int main() {
 
 	stbi_image_free(image);
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
 
 	// Texture Transparent
 #if 1
@@ -325,7 +334,7 @@ int main() {
 
 	glGenTextures(1, &diffuseMap_transparent);
 
-	glBindTexture(GL_TEXTURE_2D, diffuseMap_transparent);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap_transparent);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
@@ -337,19 +346,19 @@ int main() {
 
 	stbi_image_free(image);
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
 
 	// Setup light VAO
 	GLuint lightVAO;
 	glGenVertexArrays(1, &lightVAO);
 
-	glBindVertexArray(lightVAO);
+	GLStateCache::getInstance()->bindVertexArray(lightVAO);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO_plane);
 
 	// Position attributes
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)0);
 	glEnableVertexAttribArray(0);
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 
 	glm::vec3 cubePositions[] = {
 		glm::vec3(0.0f,  0.5f,  2.0f),
@@ -397,29 +406,36 @@ int main() {
 	glfwSetKeyCallback(window, key_callback);
 
 	// Setup
-	glEnable(GL_DEPTH_TEST);
+	GLStateCache::getInstance()->enable(GL_DEPTH_TEST);
 
 	// Enable Blending
-	glEnable(GL_BLEND);
+	GLStateCache::getInstance()->enable(GL_BLEND);
 #if 0
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	GLStateCache::getInstance()->blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 #else
-	glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ZERO);
+	GLStateCache::getInstance()->blendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ZERO);
 #endif
 
+	RenderQueue renderQueue;
+	if (Benchmark::getInstance()->isMicrobenchmarking())
+	{
+		std::cout << "RenderQueue: radix sort of 100000 items takes " << RenderQueue::benchmarkSort(100000, 10) << " ms" << std::endl;
+	}
+
 	// Main loop of drawing
-	glViewport(0, 0, width, height);
+	GLStateCache::getInstance()->viewport(0, 0, width, height);
 	while (!glfwWindowShouldClose(window)) {
 		// Check and call events
 		glfwPollEvents();
 
 
 		// calculate delta time
-		GLfloat currentFrame = glfwGetTime();
+		GLfloat currentFrame = Benchmark::getInstance()->getTime();
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
 
 		do_movement();
+		Benchmark::getInstance()->Update(camera);
 
 		// Rendering commands here
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
@@ -437,8 +453,8 @@ int main() {
 		// Setting up Material
 		shader->setInt("material.diffuse", 0);
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, diffuseMap);
+		GLStateCache::getInstance()->activeTexture(GL_TEXTURE0);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap);
 
 		shader->setFloat("material.shininess", mat.Shininess);
 
@@ -505,45 +521,9 @@ int main() {
 		shader->setMat4("view", view);
 		shader->setMat4("projection", projection);
 
-		glBindVertexArray(VAO_plane);
-
-		glm::mat4 model;
-		model = glm::scale(model, glm::vec3(5.0f));
-
-		shader->setMat4("model", model);
-		
-		glDrawArrays(GL_TRIANGLES, 0, 6);
-		
-		glBindVertexArray(VAO_cube);
-
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, diffuseMap_cube);
-
-		for (int i = 0; i < 2; i++)
-		{
-			glm::mat4 model_cube;
-			model_cube = glm::translate(model_cube, cubePositions[i]);
-			shader->setMat4("model", model_cube);
-
-			glDrawArrays(GL_TRIANGLES, 0, 36);
-		}
-
-		glBindVertexArray(0);
-
-#if USING_DIFFUSE_MAP
-		glBindTexture(GL_TEXTURE_2D, 0);
-#endif
-		// Sort Transparent objects
-		std::map<float, glm::vec3> sorted;
-		for (int i = 0; i < 5; i++)
-		{
-			float distance = glm::length2(camera.Position - transparentPositions[i]);
-			sorted[distance] = transparentPositions[i];
-		}
-
 		// Draw Transparent objects
 		Shader* transparentShader = ShaderManager::getInstance()->getShaderByType(SHADER_TYPE_VERTICE_TRANSPARENT_COLOR);
-		
+
 		transparentShader->Use();
 
 		transparentShader->setMat4("view", view);
@@ -551,24 +531,32 @@ int main() {
 
 		transparentShader->setInt("texture1", 0);
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, diffuseMap_transparent);
+		// Everything is submitted in any order, the queue sorts opaque front to back and
+		// transparent back to front, so the grass needs no manual distance sort
+		renderQueue.Begin(camera.Position, 100.0f);
 
-		glBindVertexArray(VAO_vegetation);
+		RenderCommand planeCommand = { shader, VAO_plane, diffuseMap, GL_TRIANGLES, 0, 6, false, 0 };
+		renderQueue.Submit(RENDER_PASS_OPAQUE, 0, planeCommand, glm::scale(glm::mat4(), glm::vec3(5.0f)));
 
-		for (std::map<float, glm::vec3>::reverse_iterator it = sorted.rbegin(); it != sorted.rend(); ++it)
+		RenderCommand cubeCommand = { shader, VAO_cube, diffuseMap_cube, GL_TRIANGLES, 0, 36, false, 0 };
+		for (int i = 0; i < 2; i++)
 		{
-			model = glm::mat4();
-			model = glm::translate(model, it->second);
-			model = glm::scale(model, glm::vec3(0.5f, 0.5f, 0.5f));
-
-			transparentShader->setMat4("model", model);
+			renderQueue.Submit(RENDER_PASS_OPAQUE, 0, cubeCommand, glm::translate(glm::mat4(), cubePositions[i]));
+		}
 
-			glDrawArrays(GL_TRIANGLES, 0, 6);
+		RenderCommand vegetationCommand = { transparentShader, VAO_vegetation, diffuseMap_transparent, GL_TRIANGLES, 0, 6, false, 0 };
+		for (int i = 0; i < 5; i++)
+		{
+			glm::mat4 model;
+			model = glm::translate(model, transparentPositions[i]);
+			model = glm::scale(model, glm::vec3(0.5f, 0.5f, 0.5f));
+			renderQueue.Submit(RENDER_PASS_TRANSPARENT, 0, vegetationCommand, model);
 		}
 
-		glBindVertexArray(0);
-		glBindTexture(GL_TEXTURE_2D, 0);
+		renderQueue.Sort();
+		renderQueue.Execute();
+
+		Benchmark::getInstance()->EndFrame(window);
 
 		// Swap the buffers
 		glfwSwapBuffers(window);
@@ -584,6 +572,10 @@ int main() {
 
 	ShaderManager::Destroy();
 
+	Benchmark::Destroy();
+
+	GLStateCache::Destroy();
+
 	// Terminate before close
 	glfwTerminate();
 
@@ -7,6 +7,8 @@
 #include <iostream>
 
 #include "Shader.h"
+#include "GLStateCache.h"
+#include "Benchmark.h"
 #include "Camera.h"
 #include "Material.h"
 #include "Light.h"
@@ -91,9 +93,10 @@ void do_movement()
 		camera.ProcessKeyboard(CameraMovement::RIGHT, deltaTime);
 }
 
-int main() 
+int main(int argc, char* argv[]) 
 {
 	glfwInit();
+	Benchmark::Init(argc, argv);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -145,7 +148,7 @@ int main()
 	GLuint VAO;
 	glGenVertexArrays(1, &VAO);
 
-	glBindVertexArray(VAO);
+	GLStateCache::getInstance()->bindVertexArray(VAO);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(plane), plane, GL_STATIC_DRAW);
 
@@ -161,7 +164,7 @@ int main()
 	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (void*)(6 * sizeof(GLfloat)));
 	glEnableVertexAttribArray(2);
 
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 
 	// Setting up Textures
 	
@@ -173,7 +176,7 @@ int main()
 
 	glGenTextures(1, &diffuseMap);
 
-	glBindTexture(GL_TEXTURE_2D, diffuseMap);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_MIRRORED_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
@@ -199,19 +202,19 @@ int main()
 	glfwSetKeyCallback(window, key_callback);
 
 	// Setup
-	glEnable(GL_DEPTH_TEST);
+	GLStateCache::getInstance()->enable(GL_DEPTH_TEST);
 
 	bool bUseBlinn = true;
 
 	// Main loop of drawing
-	glViewport(0, 0, width, height);
+	GLStateCache::getInstance()->viewport(0, 0, width, height);
 	while (!glfwWindowShouldClose(window)) 
 	{
 		// Check and call events
 		glfwPollEvents();
 
 		// calculate delta time
-		GLfloat currentFrame = (GLfloat)glfwGetTime();
+		GLfloat currentFrame = (GLfloat)Benchmark::getInstance()->getTime();
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
 
@@ -224,6 +227,7 @@ int main()
 			bUseBlinn = true;
 		}
 		do_movement();
+		Benchmark::getInstance()->Update(camera);
 
 		// Rendering commands here
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
@@ -243,8 +247,8 @@ int main()
 		renderShader.setInt("material.diffuse", 0);
 		renderShader.setBool("useSpecular", false);
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, diffuseMap);
+		GLStateCache::getInstance()->activeTexture(GL_TEXTURE0);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap);
 
 		renderShader.setFloat("material.shininess", material.Shininess);
 
@@ -278,9 +282,11 @@ int main()
 		renderShader.setMat4("projection", projection);
 		renderShader.setMat4("model", model);
 
-		glBindVertexArray(VAO);
+		GLStateCache::getInstance()->bindVertexArray(VAO);
 		glDrawArrays(GL_TRIANGLES, 0, 6);
-		glBindVertexArray(0);
+		GLStateCache::getInstance()->bindVertexArray(0);
+
+		Benchmark::getInstance()->EndFrame(window);
 
 		// Swap the buffers
 		glfwSwapBuffers(window);
@@ -291,6 +297,10 @@ int main()
 	glDeleteBuffers(1, &VBO);
 	glDeleteTextures(1, &diffuseMap);
 
+	Benchmark::Destroy();
+
+	GLStateCache::Destroy();
+
 	// Terminate before close
 	glfwTerminate();
 
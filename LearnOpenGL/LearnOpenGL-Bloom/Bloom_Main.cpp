@@ -7,9 +7,14 @@
 #include <string>
 
 #include "Shader.h"
+#include "GLStateCache.h"
+#include "Benchmark.h"
 #include "Camera.h"
 #include "Material.h"
 #include "PointLight.h"
+#include "RenderGraph.h"
+#include "RenderTargetPool.h"
+#include "Profiler.h"
 
 #include "stb_image.h"
 
@@ -21,6 +26,9 @@
 
 #include "glm/gtx/norm.hpp"
 
+// Gaussian blur passes, alternating horizontal and vertical
+#define BLOOM_BLUR_PASSES 10
+
 // TODO for NVIDIA Optimus :  This enable the program to use NVIDIA instead of integrated Intel graphics
 #if WIN32 || WIN64
 extern "C" {
@@ -95,9 +103,10 @@ void do_movement()
 		camera.ProcessKeyboard(CameraMovement::RIGHT, deltaTime);
 }
 
-int main() 
+int main(int argc, char* argv[]) 
 {
 	glfwInit();
+	Benchmark::Init(argc, argv);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -185,7 +194,7 @@ int main()
 
 	glGenVertexArrays(1, &VAO_cube);
 
-	glBindVertexArray(VAO_cube);
+	GLStateCache::getInstance()->bindVertexArray(VAO_cube);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO_cube);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(cube_vertices), cube_vertices, GL_STATIC_DRAW);
 
@@ -201,7 +210,7 @@ int main()
 	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
 	glEnableVertexAttribArray(2);
 
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 
 	// Quad buffer
 	GLfloat quadVertices[] =
@@ -218,64 +227,14 @@ int main()
 	GLuint quadVBO;
 	glGenVertexArrays(1, &quadVAO);
 	glGenBuffers(1, &quadVBO);
-	glBindVertexArray(quadVAO);
+	GLStateCache::getInstance()->bindVertexArray(quadVAO);
 	glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 5, (GLvoid*)0);
 	glEnableVertexAttribArray(1);
 	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 5, (GLvoid*)(sizeof(GLfloat) * 3));
-	glBindVertexArray(0);
-
-	// Configure floating point FrameBuffer
-	GLuint hdrFBO;
-	glGenFramebuffers(1, &hdrFBO);
-	glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
-	// Create floating point color buffer
-	GLuint colorBuffer[2];
-	glGenTextures(2, colorBuffer);
-	for (unsigned int i = 0; i < 2; i++)
-	{
-		glBindTexture(GL_TEXTURE_2D, colorBuffer[i]);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, NULL);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		// Attach texture to fram buffer
-		glFramebufferTexture2D(
-			GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, colorBuffer[i], 0);
-	}
-	// create depth buffer (renderbuffer)
-	GLuint rboDepth;
-	glGenRenderbuffers(1, &rboDepth);
-	glBindRenderbuffer(GL_RENDERBUFFER, rboDepth);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, width, height);
-	// attach buffer
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rboDepth);
-	unsigned int attachments[2] = { GL_COLOR_ATTACHMENT0 , GL_COLOR_ATTACHMENT1 };
-	glDrawBuffers(2, attachments);
-	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-		std::cout << "Framebuffer not complete!" << std::endl;
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-	// Creating PingPong Frame Buffer for Two-pass Gaussian Blur
-	GLuint pingpongFBO[2];
-	GLuint pingpongBuffer[2];
-	glGenFramebuffers(2, pingpongFBO);
-	glGenTextures(2, pingpongBuffer);
-	for (unsigned int i = 0; i < 2; i++)
-	{
-		glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[i]);
-		glBindTexture(GL_TEXTURE_2D, pingpongBuffer[i]);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, width, height, 0, GL_RGB, GL_FLOAT, NULL);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, pingpongBuffer[i], 0);
-	}
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 
 	// Setting up Textures
 	GLuint diffuseMap;
@@ -285,7 +244,7 @@ int main()
 
 	glGenTextures(1, &diffuseMap);
 
-	glBindTexture(GL_TEXTURE_2D, diffuseMap);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap);
 	// Set Texture Parameters
 	// Set Wrap function
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
@@ -300,7 +259,7 @@ int main()
 
 	stbi_image_free(image);
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
 
 	// Setup Lights
 	// Setup Directional Light
@@ -345,147 +304,220 @@ int main()
 	glfwSetKeyCallback(window, key_callback);
 
 	// Setup
-	glEnable(GL_DEPTH_TEST);
+	GLStateCache::getInstance()->enable(GL_DEPTH_TEST);
 
 	bool bloom = true;
 	float exposure = 1.0f; // higher: focus on dark area; lower: focus on bright area
 
-	// Main loop of drawing
-	glViewport(0, 0, width, height);
-	while (!glfwWindowShouldClose(window)) 
+	glm::mat4 view;
+	glm::mat4 projection;
+
+	// Scene to HDR, blur the bright parts, composite. The graph is rebuilt when bloom toggles,
+	// without bloom nothing reads the blur so its passes are culled.
+	RenderGraph* graph = new RenderGraph();
+	auto build_graph = [&]()
 	{
-		// Check and call events
-		glfwPollEvents();
+		graph->Reset();
 
-		// calculate delta time
-		GLfloat currentFrame = glfwGetTime();
-		deltaTime = currentFrame - lastFrame;
-		lastFrame = currentFrame;
+		RenderGraphTextureDesc hdrDesc = { width, height, GL_RGBA16F, GL_LINEAR };
+		RenderGraphTextureDesc blurDesc = { width, height, GL_RGB16F, GL_LINEAR };
+		RenderGraphTextureDesc depthDesc = { width, height, GL_DEPTH_COMPONENT24, GL_NEAREST };
 
-		if (keys['B'])
+		RenderGraphResource scene, bright;
+		graph->AddPass("Scene", [&](RenderGraphBuilder& builder)
 		{
-			bloom = true;
-		}
-		else if(keys['N'])
+			scene = builder.Create("Scene", hdrDesc);
+			bright = builder.Create("Bright", hdrDesc);
+			builder.Create("Depth", depthDesc);
+		},
+		[&](const RenderGraph&)
+		{
+			glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			// Draw Lights
+			lightBoxShader.Use();
+			lightBoxShader.setMat4("view", view);
+			lightBoxShader.setMat4("projection", projection);
+
+			GLStateCache::getInstance()->bindVertexArray(VAO_cube);
+
+			for (int i = 0; i < lightPositions.size(); i++)
+			{
+				glm::mat4 model;
+				model = glm::translate(model, lightPositions[i]);
+				model = glm::scale(model, glm::vec3(0.25f));
+				lightBoxShader.setMat4("model", model);
+				lightBoxShader.setVec3("lightColor", lightColors[i]);
+
+				glDrawArrays(GL_TRIANGLES, 0, 36);
+			}
+
+			// Draw Objects
+			bloomShader.Use();
+
+			GLStateCache::getInstance()->activeTexture(GL_TEXTURE0);
+			GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap);
+			bloomShader.setInt("diffuseTexture", 0);
+
+			for (int i = 0; i < lightPositions.size(); i++)
+			{
+				bloomShader.setVec3(("lights[" + std::to_string(i) + "].Position").c_str(), lightPositions[i]);
+				bloomShader.setVec3(("lights[" + std::to_string(i) + "].Color").c_str(), lightColors[i]);
+			}
+
+			bloomShader.setVec3("viewPos", camera.Position);
+			bloomShader.setMat4("view", view);
+			bloomShader.setMat4("projection", projection);
+
+			for (int i = 0; i < cubePositions.size(); i++)
+			{
+				glm::mat4 model;
+				model = glm::translate(model, cubePositions[i]);
+				model = glm::scale(model, cubeScales[i]);
+
+				bloomShader.setMat4("model", model);
+				glDrawArrays(GL_TRIANGLES, 0, 36);
+			}
+
+			GLStateCache::getInstance()->bindVertexArray(0);
+			GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
+		});
+
+		// Every blur pass writes a new transient, the graph folds them back onto a ping-pong pair
+		RenderGraphResource blurred = bright;
+		for (unsigned int i = 0; i < BLOOM_BLUR_PASSES; i++)
 		{
-			bloom = false;
+			bool horizontal = i % 2 == 0;
+			RenderGraphResource source = blurred;
+			graph->AddPass(horizontal ? "BlurH" : "BlurV", [&](RenderGraphBuilder& builder)
+			{
+				builder.Read(source);
+				blurred = builder.Create("Blur", blurDesc);
+			},
+			[&shaderBlur, &quadVAO, horizontal, source](const RenderGraph& _graph)
+			{
+				shaderBlur.Use();
+				shaderBlur.setBool("horizontal", horizontal);
+				GLStateCache::getInstance()->activeTexture(GL_TEXTURE0);
+				GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, _graph.getTexture(source));
+
+				GLStateCache::getInstance()->bindVertexArray(quadVAO);
+				glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+				GLStateCache::getInstance()->bindVertexArray(0);
+			});
 		}
 
-		do_movement();
-
-		// 1. First render Lighted Scene to HDR Frame buffer
-		glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
-
-		// Configure shader and matrices
-		// Light Projection
-		glViewport(0, 0, width, height);
-		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		graph->AddPass("Composite", [&](RenderGraphBuilder& builder)
+		{
+			builder.Read(scene);
+			if (bloom)
+			{
+				builder.Read(blurred);
+			}
+			builder.WriteBackbuffer();
+		},
+		[&, scene, blurred](const RenderGraph& _graph)
+		{
+			GLStateCache::getInstance()->viewport(0, 0, width, height);
+			glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		glm::mat4 view = camera.GetViewMatrix();
-		glm::mat4 projection = glm::perspective(camera.Zoom, width / (float)height, 0.1f, 100.0f);
+			GLStateCache::getInstance()->bindVertexArray(quadVAO);
 
-		// Draw Lights
-		lightBoxShader.Use();
-		lightBoxShader.setMat4("view", view);
-		lightBoxShader.setMat4("projection", projection);
+			hdrBloomShader.Use();
 
-		glBindVertexArray(VAO_cube);
+			GLStateCache::getInstance()->activeTexture(GL_TEXTURE0);
+			GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, _graph.getTexture(scene));
+			hdrBloomShader.setInt("scene", 0);
 
-		for (int i = 0; i < lightPositions.size(); i++)
-		{
-			glm::mat4 model;
-			model = glm::translate(model, lightPositions[i]);
-			model = glm::scale(model, glm::vec3(0.25f));
-			lightBoxShader.setMat4("model", model);
-			lightBoxShader.setVec3("lightColor", lightColors[i]);
+			GLStateCache::getInstance()->activeTexture(GL_TEXTURE1);
+			GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, bloom ? _graph.getTexture(blurred) : 0);
+			hdrBloomShader.setInt("bloomBlur", 1);
 
-			glDrawArrays(GL_TRIANGLES, 0, 36);
-		}
+			// Set HDR Uniforms
+			hdrBloomShader.setFloat("exposure", exposure);
+			hdrBloomShader.setBool("bloom", bloom);
 
-		glBindVertexArray(0);
+			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 
-		// Draw Objects
-		bloomShader.Use();
+			GLStateCache::getInstance()->bindVertexArray(0);
+			GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
+			GLStateCache::getInstance()->activeTexture(GL_TEXTURE0);
+		});
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, diffuseMap);
-		bloomShader.setInt("diffuseTexture", 0);
+		graph->Compile();
+		graph->printReport(bloom ? "Bloom" : "Bloom off");
+	};
+	build_graph();
 
-		for (int i = 0; i < lightPositions.size(); i++)
-		{
-			bloomShader.setVec3(("lights[" + std::to_string(i) + "].Position").c_str(), lightPositions[i]);
-			bloomShader.setVec3(("lights[" + std::to_string(i) + "].Color").c_str(), lightColors[i]);
-		}
+	bool captureKeyDown = false;
 
-		bloomShader.setVec3("viewPos", camera.Position);
-		bloomShader.setMat4("view", view);
-		bloomShader.setMat4("projection", projection);
+	// Main loop of drawing
+	GLStateCache::getInstance()->viewport(0, 0, width, height);
+	while (!glfwWindowShouldClose(window)) 
+	{
+		// Check and call events
+		glfwPollEvents();
 
-		glBindVertexArray(VAO_cube);
+		// calculate delta time
+		GLfloat currentFrame = Benchmark::getInstance()->getTime();
+		deltaTime = currentFrame - lastFrame;
+		lastFrame = currentFrame;
 
-		for(int i=0; i < cubePositions.size(); i++)
-		{ 
-			glm::mat4 model;
-			model = glm::translate(model, cubePositions[i]);
-			model = glm::scale(model, cubeScales[i]);
+		Profiler::getInstance()->BeginFrame();
 
-			bloomShader.setMat4("model", model);
-			glDrawArrays(GL_TRIANGLES, 0, 36);
+		// Show once per second where the frame went
+		if ((int)currentFrame != (int)(currentFrame - deltaTime))
+		{
+			std::string title = "LearnOpenGL - ms:" + Profiler::getInstance()->getSummary();
+			glfwSetWindowTitle(window, title.c_str());
 		}
 
-		glBindVertexArray(0);
-
-		glBindTexture(GL_TEXTURE_2D, 0);
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-		// 2. Do Gaussian Blur
-		bool horizontal = true;
-		bool first_iteration = true;
-		int amount = 10;
-		shaderBlur.Use();
-		for (unsigned int i = 0; i < amount; i++)
+		// P starts a profiler capture, the next P writes it as a Chrome trace
+		if (keys[GLFW_KEY_P] && !captureKeyDown)
 		{
-			glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[horizontal]);
-			shaderBlur.setBool("horizontal", horizontal);
-			glActiveTexture(GL_TEXTURE0);
-			glBindTexture(GL_TEXTURE_2D, first_iteration ? colorBuffer[1] : pingpongBuffer[!horizontal]);
-
-			glBindVertexArray(quadVAO);
-			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-
-			horizontal = !horizontal;
-			if (first_iteration) first_iteration = false;
+			if (Profiler::getInstance()->isCapturing())
+			{
+				Profiler::getInstance()->StopCapture("Bloom_Trace.json");
+			}
+			else
+			{
+				Profiler::getInstance()->StartCapture();
+			}
 		}
+		captureKeyDown = keys[GLFW_KEY_P];
 
-		glBindVertexArray(0);
-
-		// 2. Render HDR Frame buffer to screen
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-		glViewport(0, 0, width, height);
-		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		bool wantBloom = bloom;
+		if (keys['B'])
+		{
+			wantBloom = true;
+		}
+		else if(keys['N'])
+		{
+			wantBloom = false;
+		}
 
-		glBindVertexArray(quadVAO);
+		if (wantBloom != bloom)
+		{
+			ProfilerScope scope("BuildGraph", false);
+			bloom = wantBloom;
+			build_graph();
+		}
 
-		hdrBloomShader.Use();
+		do_movement();
+		Benchmark::getInstance()->Update(camera);
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, colorBuffer[0]);
-		hdrBloomShader.setInt("scene", 0);
+		view = camera.GetViewMatrix();
+		projection = glm::perspective(camera.Zoom, width / (float)height, 0.1f, 100.0f);
 
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, pingpongBuffer[1]);
-		hdrBloomShader.setInt("bloomBlur", 1);
+		graph->Execute();
 
-		// Set HDR Uniforms
-		hdrBloomShader.setFloat("exposure", exposure);
-		hdrBloomShader.setBool("bloom", bloom);
+		RenderTargetPool::getInstance()->EndFrame();
 
-		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		Profiler::getInstance()->EndFrame();
 
-		glBindVertexArray(0);
-		glBindTexture(GL_TEXTURE_2D, 0);
+		Benchmark::getInstance()->EndFrame(window);
 
 		// Swap the buffers
 		glfwSwapBuffers(window);
@@ -494,14 +526,19 @@ int main()
 	// Deleting Buffer vertex array, vertex buffer and Element Buffer
 	glDeleteVertexArrays(1, &VAO_cube);
 	glDeleteBuffers(1, &VBO_cube);
-	glDeleteRenderbuffers(1, &rboDepth);
-	glDeleteTextures(2, colorBuffer);
-	glDeleteTextures(2, pingpongBuffer);
-	glDeleteFramebuffers(2, pingpongFBO);
-	glDeleteFramebuffers(1, &hdrFBO);
 	glDeleteBuffers(1, &quadVBO);
 	glDeleteVertexArrays(1, &quadVAO);
 
+	delete graph;
+
+	RenderTargetPool::Destroy();
+
+	Profiler::Destroy();
+
+	Benchmark::Destroy();
+
+	GLStateCache::Destroy();
+
 	// Terminate before close
 	glfwTerminate();
 
@@ -0,0 +1,175 @@
+#include "Checks.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include "BVH.h"
+
+#define BVH_CHECK_OBJECTS 2000
+#define BVH_CHECK_QUERIES 200
+
+// Ray hit distances of the tree and of the brute force may round differently
+#define BVH_CHECK_DISTANCE_TOLERANCE 1e-4f
+
+static float random_float(float _min, float _max)
+{
+	return _min + (float)rand() / RAND_MAX * (_max - _min);
+}
+
+static glm::vec3 random_vec3(float _min, float _max)
+{
+	return glm::vec3(random_float(_min, _max), random_float(_min, _max), random_float(_min, _max));
+}
+
+// Entry distance of the ray into the box, -1 when it misses it within _maxDistance
+static float ray_box_distance(const glm::vec3& _origin, const glm::vec3& _direction, float _maxDistance, const glm::vec3& _min, const glm::vec3& _max)
+{
+	glm::vec3 inverseDirection = 1.0f / _direction;
+	glm::vec3 t0 = (_min - _origin) * inverseDirection;
+	glm::vec3 t1 = (_max - _origin) * inverseDirection;
+	glm::vec3 tMin = glm::min(t0, t1);
+	glm::vec3 tMax = glm::max(t0, t1);
+
+	float entry = std::max(std::max(tMin.x, tMin.y), std::max(tMin.z, 0.0f));
+	float exit = std::min(std::min(tMax.x, tMax.y), std::min(tMax.z, _maxDistance));
+	return entry <= exit ? entry : -1.0f;
+}
+
+// Every query of the tree against a test of each object box, _stage names the tree state in failures
+static bool compare_with_brute_force(const BVH& _bvh, const std::vector<glm::vec3>& _mins, const std::vector<glm::vec3>& _maxs, const char* _stage)
+{
+	bool passed = true;
+	std::vector<unsigned int> found;
+	std::vector<unsigned int> expected;
+
+	for (unsigned int query = 0; query < BVH_CHECK_QUERIES; query++)
+	{
+		// Camera somewhere in the scene looking at another point of it
+		glm::vec3 eye = random_vec3(-100.0f, 100.0f);
+		glm::vec3 target = random_vec3(-100.0f, 100.0f);
+		Frustum frustum;
+		frustum.Extract(glm::perspective(glm::radians(random_float(30.0f, 90.0f)), 16.0f / 9.0f, 0.1f, random_float(20.0f, 300.0f))
+			* glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f)));
+
+		found.clear();
+		expected.clear();
+		_bvh.QueryFrustum(frustum, found);
+		for (unsigned int i = 0; i < _mins.size(); i++)
+		{
+			if (frustum.ClassifyBox(_mins[i], _maxs[i]) != FRUSTUM_OUTSIDE)
+			{
+				expected.push_back(i);
+			}
+		}
+		std::sort(found.begin(), found.end());
+		if (!expect(found == expected, std::string("BVH_FRUSTUM_MISMATCH ") + _stage + " query " + std::to_string(query) + ", "
+			+ std::to_string(found.size()) + " found, " + std::to_string(expected.size()) + " expected"))
+		{
+			passed = false;
+			break;
+		}
+	}
+
+	for (unsigned int query = 0; query < BVH_CHECK_QUERIES; query++)
+	{
+		glm::vec3 center = random_vec3(-100.0f, 100.0f);
+		float radius = random_float(0.5f, 30.0f);
+
+		found.clear();
+		expected.clear();
+		_bvh.QuerySphere(center, radius, found);
+		for (unsigned int i = 0; i < _mins.size(); i++)
+		{
+			glm::vec3 offset = glm::clamp(center, _mins[i], _maxs[i]) - center;
+			if (glm::dot(offset, offset) <= radius * radius)
+			{
+				expected.push_back(i);
+			}
+		}
+		std::sort(found.begin(), found.end());
+		if (!expect(found == expected, std::string("BVH_SPHERE_MISMATCH ") + _stage + " query " + std::to_string(query) + ", "
+			+ std::to_string(found.size()) + " found, " + std::to_string(expected.size()) + " expected"))
+		{
+			passed = false;
+			break;
+		}
+	}
+
+	for (unsigned int query = 0; query < BVH_CHECK_QUERIES; query++)
+	{
+		glm::vec3 origin = random_vec3(-120.0f, 120.0f);
+		glm::vec3 direction = glm::normalize(random_vec3(-1.0f, 1.0f));
+		float maxDistance = random_float(10.0f, 400.0f);
+
+		float closest = maxDistance;
+		bool expectedHit = false;
+		for (unsigned int i = 0; i < _mins.size(); i++)
+		{
+			float distance = ray_box_distance(origin, direction, closest, _mins[i], _maxs[i]);
+			if (distance >= 0.0f && distance <= closest)
+			{
+				closest = distance;
+				expectedHit = true;
+			}
+		}
+
+		// Boxes hit at the same distance may come back in either order, so the index only has to be one of them
+		unsigned int index = 0;
+		float distance = -1.0f;
+		bool hit = _bvh.Raycast(origin, direction, maxDistance, index, distance);
+		bool same = hit == expectedHit;
+		if (same && hit)
+		{
+			same = std::abs(distance - closest) <= BVH_CHECK_DISTANCE_TOLERANCE && index < _mins.size()
+				&& std::abs(ray_box_distance(origin, direction, maxDistance, _mins[index], _maxs[index]) - closest) <= BVH_CHECK_DISTANCE_TOLERANCE;
+		}
+		if (!expect(same, std::string("BVH_RAYCAST_MISMATCH ") + _stage + " ray " + std::to_string(query) + ", hit " + std::to_string(hit)
+			+ " at " + std::to_string(distance) + ", expected " + std::to_string(expectedHit) + " at " + std::to_string(closest)))
+		{
+			passed = false;
+			break;
+		}
+	}
+
+	return passed;
+}
+
+// Frustum, sphere and ray queries find what testing every object finds, right after a build
+// and after the objects moved and the tree was only refit
+bool check_bvh()
+{
+	bool passed = true;
+
+	// Mostly small boxes with a few large ones that straddle many splits
+	srand(1);
+	std::vector<glm::vec3> mins(BVH_CHECK_OBJECTS), maxs(BVH_CHECK_OBJECTS);
+	for (unsigned int i = 0; i < BVH_CHECK_OBJECTS; i++)
+	{
+		glm::vec3 center = random_vec3(-100.0f, 100.0f);
+		glm::vec3 extents = (i % 50 == 0) ? random_vec3(5.0f, 20.0f) : random_vec3(0.1f, 2.0f);
+		mins[i] = center - extents;
+		maxs[i] = center + extents;
+	}
+
+	BVH bvh;
+	bvh.Build(mins.data(), maxs.data(), BVH_CHECK_OBJECTS);
+	passed &= expect(bvh.getObjectCount() == BVH_CHECK_OBJECTS, "BVH_OBJECT_COUNT " + std::to_string(bvh.getObjectCount()));
+	passed &= compare_with_brute_force(bvh, mins, maxs, "build");
+
+	// Far enough for objects to leave their leaves' original bounds, some of them also grow
+	for (unsigned int i = 0; i < BVH_CHECK_OBJECTS; i++)
+	{
+		glm::vec3 offset = random_vec3(-15.0f, 15.0f);
+		glm::vec3 growth = (i % 7 == 0) ? random_vec3(0.0f, 3.0f) : glm::vec3(0.0f);
+		mins[i] += offset - growth;
+		maxs[i] += offset + growth;
+	}
+	bvh.Refit(mins.data(), maxs.data());
+	passed &= compare_with_brute_force(bvh, mins, maxs, "refit");
+
+	return passed;
+}
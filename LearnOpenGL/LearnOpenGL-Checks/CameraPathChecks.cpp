@@ -0,0 +1,67 @@
+#include "Checks.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+#include "CameraPath.h"
+
+#define CAMERA_PATH_CHECK_FILE "CameraPathCheck.camp"
+
+static bool same_camera(const Camera& _a, const Camera& _b)
+{
+	return _a.Position == _b.Position && _a.Yaw == _b.Yaw && _a.Pitch == _b.Pitch && _a.Zoom == _b.Zoom;
+}
+
+// A saved path loads back step for step, a file cut short or claiming more frames than it holds is refused
+// and leaves the loaded path as it was
+bool check_camera_path()
+{
+	bool passed = true;
+
+	CameraPath recording(1.0 / 60.0);
+	Camera camera(glm::vec3(0.0f, 1.0f, 3.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	recording.Clear();
+	for (unsigned int frame = 0; frame <= 90; frame++)
+	{
+		// Uneven live frames, as a session would have them
+		double time = frame * 0.023;
+		camera.SetState(glm::vec3(frame * 0.1f, 1.0f, 3.0f - frame * 0.05f), -90.0f + frame, frame * 0.2f, 45.0f - frame * 0.1f);
+		recording.Record(camera, time);
+	}
+	passed &= expect(recording.Save(CAMERA_PATH_CHECK_FILE), "CAMERA_PATH_NOT_SAVED");
+
+	CameraPath loaded(1.0);
+	passed &= expect(loaded.Load(CAMERA_PATH_CHECK_FILE), "CAMERA_PATH_NOT_LOADED");
+	passed &= expect(loaded.getFrameCount() == recording.getFrameCount() && loaded.getTimestep() == recording.getTimestep(),
+		"CAMERA_PATH_HEADER_CHANGED " + std::to_string(loaded.getFrameCount()) + " frames loaded, " + std::to_string(recording.getFrameCount()) + " saved");
+
+	Camera expected(glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	Camera actual(glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	for (unsigned int frame = 0; frame < recording.getFrameCount(); frame++)
+	{
+		recording.Apply(expected, frame);
+		loaded.Apply(actual, frame);
+		if (!expect(same_camera(expected, actual), "CAMERA_PATH_FRAME_CHANGED " + std::to_string(frame)))
+		{
+			passed = false;
+			break;
+		}
+	}
+
+	// Header and all frames but the last half of one
+	std::ifstream source(CAMERA_PATH_CHECK_FILE, std::ios::binary);
+	std::string bytes((std::istreambuf_iterator<char>(source)), std::istreambuf_iterator<char>());
+	source.close();
+	std::ofstream(CAMERA_PATH_CHECK_FILE, std::ios::binary).write(bytes.data(), bytes.size() - CAMERA_PATH_FRAME_BYTES / 2);
+	passed &= expect(!loaded.Load(CAMERA_PATH_CHECK_FILE), "CAMERA_PATH_TRUNCATED_LOADED");
+
+	// Header claiming about four billion frames, refused before anything that size is allocated
+	std::string corrupt = bytes.substr(0, 8) + std::string(4, '\xFF') + bytes.substr(12);
+	std::ofstream(CAMERA_PATH_CHECK_FILE, std::ios::binary).write(corrupt.data(), corrupt.size());
+	passed &= expect(!loaded.Load(CAMERA_PATH_CHECK_FILE), "CAMERA_PATH_BAD_COUNT_LOADED");
+	passed &= expect(loaded.getFrameCount() == recording.getFrameCount(), "CAMERA_PATH_CHANGED_BY_FAILED_LOAD");
+
+	std::remove(CAMERA_PATH_CHECK_FILE);
+	return passed;
+}
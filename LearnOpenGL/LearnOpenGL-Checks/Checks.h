@@ -0,0 +1,23 @@
+#ifndef CHECKS_H
+#define CHECKS_H
+
+#include <string>
+
+// Checks of the shared code that need a GL context or real threads, run by "premake5 checks".
+// Each check returns true when it passed and prints an ERROR::CHECKS:: line for every failure.
+
+// Prints _what as a failure when _condition is false, returns _condition
+bool expect(bool _condition, const std::string& _what);
+
+// operator new calls of the whole process so far
+unsigned long long get_allocation_count();
+
+bool check_mesh_draw();
+bool check_job_system();
+bool check_dynamic_resolution();
+bool check_camera_path();
+bool check_occlusion_culling();
+bool check_bvh();
+bool check_render_graph();
+
+#endif
@@ -0,0 +1,87 @@
+#include "Checks.h"
+
+#include <deque>
+#include <utility>
+
+#include "DynamicResolution.h"
+
+// Frames a timer result takes to come back, like the query ring of a GPU a few frames behind
+#define DYNAMIC_RESOLUTION_CHECK_LATENCY 3
+
+// GPU of a fill bound scene: a fixed cost plus one that follows the pixel count
+struct SimulatedLoad
+{
+	double FixedMilliseconds;
+	double FillMilliseconds;	// at full scale
+};
+
+// Renders _frames frames at the scale the controller picks, results arriving late with the scale they were measured at.
+// Returns the GPU time of the last frame.
+static double simulate(DynamicResolution& _resolution, const SimulatedLoad& _load, unsigned int _frames, std::deque<std::pair<double, float>>& _inFlight)
+{
+	double milliseconds = 0.0;
+	for (unsigned int frame = 0; frame < _frames; frame++)
+	{
+		float scale = _resolution.getScale();
+		milliseconds = _load.FixedMilliseconds + _load.FillMilliseconds * scale * scale;
+		_inFlight.push_back(std::make_pair(milliseconds, scale));
+		while (_inFlight.size() > DYNAMIC_RESOLUTION_CHECK_LATENCY)
+		{
+			_resolution.AddResult(_inFlight.front().first, _inFlight.front().second);
+			_inFlight.pop_front();
+		}
+		_resolution.Decide();
+	}
+	return milliseconds;
+}
+
+// The controller settles under its budget on a heavy load, stops at the lowest scale on a load it cannot meet,
+// and returns to full size once the load drops; locked it keeps its scale
+bool check_dynamic_resolution()
+{
+	const double target = 1000.0 / 60.0;
+	DynamicResolution resolution(1280, 720, target, 0.5f, 1.0f);
+	std::deque<std::pair<double, float>> inFlight;
+	bool passed = true;
+
+	// 34 ms at full size, about 0.65 of the size fits the budget and the first step goes most of the way there
+	SimulatedLoad heavy = { 2.0, 32.0 };
+	for (unsigned int frame = 0; frame < 100 && resolution.getStats().Decreases == 0; frame++)
+	{
+		simulate(resolution, heavy, 1, inFlight);
+	}
+	passed &= expect(resolution.getScale() >= 0.6f && resolution.getScale() <= 0.7f, "DYNAMIC_RESOLUTION_FIRST_STEP " + std::to_string(resolution.getScale()));
+	simulate(resolution, heavy, 300, inFlight);
+	unsigned int changes = resolution.getStats().Decreases + resolution.getStats().Increases;
+	double settled = simulate(resolution, heavy, 200, inFlight);
+	const DynamicResolutionStats& stats = resolution.getStats();
+	passed &= expect(stats.Scale < 1.0f && stats.Scale > 0.5f, "DYNAMIC_RESOLUTION_HEAVY_SCALE " + std::to_string(stats.Scale));
+	passed &= expect(settled <= target && settled >= target * DYNAMIC_RESOLUTION_HEADROOM,
+		"DYNAMIC_RESOLUTION_HEAVY_TIME " + std::to_string(settled) + " ms at scale " + std::to_string(stats.Scale));
+	passed &= expect(stats.Decreases + stats.Increases == changes, "DYNAMIC_RESOLUTION_OSCILLATES " + std::to_string(stats.Decreases + stats.Increases - changes) + " changes once settled");
+	passed &= expect(stats.Width == (int)(1280 * stats.Scale + 0.5f) && stats.Height == (int)(720 * stats.Scale + 0.5f), "DYNAMIC_RESOLUTION_SIZE "
+		+ std::to_string(stats.Width) + "x" + std::to_string(stats.Height));
+
+	// A result measured before the last change says nothing about the current scale
+	unsigned int samples = stats.Samples;
+	resolution.AddResult(1000.0, stats.Scale + DYNAMIC_RESOLUTION_STEP);
+	passed &= expect(resolution.getStats().Samples == samples, "DYNAMIC_RESOLUTION_OLD_RESULT_COUNTED");
+
+	SimulatedLoad impossible = { 2.0, 200.0 };
+	simulate(resolution, impossible, 300, inFlight);
+	passed &= expect(stats.Scale == 0.5f && stats.Decision == DYNAMIC_RESOLUTION_MIN,
+		"DYNAMIC_RESOLUTION_MIN " + std::to_string(stats.Scale) + " " + DynamicResolution::getDecisionName(stats.Decision));
+
+	SimulatedLoad light = { 2.0, 8.0 };
+	simulate(resolution, light, 600, inFlight);
+	passed &= expect(stats.Scale == 1.0f && stats.Decision == DYNAMIC_RESOLUTION_MAX,
+		"DYNAMIC_RESOLUTION_MAX " + std::to_string(stats.Scale) + " " + DynamicResolution::getDecisionName(stats.Decision));
+
+	// Locked, not even an impossible load moves the scale
+	resolution.setLocked(true);
+	simulate(resolution, impossible, 300, inFlight);
+	passed &= expect(stats.Scale == 1.0f && stats.Decision == DYNAMIC_RESOLUTION_HOLD,
+		"DYNAMIC_RESOLUTION_LOCKED " + std::to_string(stats.Scale) + " " + DynamicResolution::getDecisionName(stats.Decision));
+
+	return passed;
+}
@@ -0,0 +1,193 @@
+#include "Checks.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "JobSystem.h"
+#include "Frustum.h"
+#include "FrustumCulling.h"
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+// Workers of the job system under check, more than most machines have so the queues get contended
+#define JOB_CHECK_THREADS 8
+
+// Rounds of each scheduling check, races show up as a round that went wrong
+#define JOB_CHECK_ROUNDS 200
+
+// Jobs held back by a dependency start only after every job of the counter they wait on finished
+static bool check_dependencies(JobSystem* _jobs)
+{
+	const unsigned int jobCount = 64;
+	const unsigned int chainLength = 16;
+	unsigned int failures = 0;
+	for (unsigned int round = 0; round < JOB_CHECK_ROUNDS; round++)
+	{
+		std::atomic<unsigned int> done(0);
+		std::atomic<unsigned int> early(0);
+		JobCounter first;
+		JobCounter second;
+		for (unsigned int i = 0; i < jobCount; i++)
+		{
+			_jobs->Run([&done]() { done++; }, &first);
+		}
+		for (unsigned int i = 0; i < jobCount; i++)
+		{
+			_jobs->Run([&done, &early, jobCount]() { early += (done != jobCount) ? 1 : 0; }, &second, &first);
+		}
+		// Both counters live on this stack, no job may be left referring to them
+		_jobs->Wait(&second);
+		_jobs->Wait(&first);
+
+		// Each link of a chain waits on the one before it
+		std::atomic<unsigned int> step(0);
+		std::atomic<unsigned int> outOfOrder(0);
+		std::vector<JobCounter> chain(chainLength);
+		for (unsigned int i = 0; i < chainLength; i++)
+		{
+			_jobs->Run([&step, &outOfOrder, i]() { outOfOrder += (step.exchange(i + 1) != i) ? 1 : 0; }, &chain[i], i > 0 ? &chain[i - 1] : nullptr);
+		}
+		for (JobCounter& link : chain)
+		{
+			_jobs->Wait(&link);
+		}
+
+		failures += (done != jobCount || early != 0 || step != chainLength || outOfOrder != 0) ? 1 : 0;
+	}
+	return expect(failures == 0, "JOB_SYSTEM_DEPENDENCY " + std::to_string(failures) + " of " + std::to_string(JOB_CHECK_ROUNDS) + " rounds ran a job too early");
+}
+
+// Main thread jobs, queued from workers or the main thread, only ever run on the main thread
+static bool check_main_affinity(JobSystem* _jobs)
+{
+	const unsigned int jobCount = 32;
+	unsigned int failures = 0;
+	for (unsigned int round = 0; round < JOB_CHECK_ROUNDS; round++)
+	{
+		std::atomic<unsigned int> ran(0);
+		std::atomic<unsigned int> elsewhere(0);
+		JobCounter decodes;
+		JobCounter uploads;
+		for (unsigned int i = 0; i < jobCount; i++)
+		{
+			// Like a texture decode on a worker followed by its upload on the main thread
+			_jobs->Run([_jobs, &ran, &elsewhere, &uploads]()
+			{
+				_jobs->Run([_jobs, &ran, &elsewhere]()
+				{
+					ran++;
+					elsewhere += _jobs->isMainThread() ? 0 : 1;
+				}, &uploads, nullptr, JOB_AFFINITY_MAIN);
+			}, &decodes);
+		}
+		_jobs->Wait(&decodes);
+		_jobs->Wait(&uploads);
+
+		JobCounter pumped;
+		for (unsigned int i = 0; i < jobCount; i++)
+		{
+			_jobs->Run([_jobs, &ran, &elsewhere]()
+			{
+				ran++;
+				elsewhere += _jobs->isMainThread() ? 0 : 1;
+			}, &pumped, nullptr, JOB_AFFINITY_MAIN);
+		}
+		unsigned int pumpedCount = _jobs->PumpMainThread();
+		bool pumpedAll = pumped.isDone();
+		_jobs->Wait(&pumped);
+
+		failures += (ran != 2 * jobCount || elsewhere != 0 || pumpedCount != jobCount || !pumpedAll) ? 1 : 0;
+	}
+	return expect(failures == 0, "JOB_SYSTEM_MAIN_AFFINITY " + std::to_string(failures) + " of " + std::to_string(JOB_CHECK_ROUNDS) + " rounds lost a main thread job or ran it elsewhere");
+}
+
+// Every index of a ParallelFor runs exactly once, adaptive or not, even when the work is uneven
+static bool check_parallel_for(JobSystem* _jobs)
+{
+	const unsigned int count = 10000;
+	unsigned int failures = 0;
+	for (unsigned int round = 0; round < JOB_CHECK_ROUNDS; round++)
+	{
+		std::vector<std::atomic<unsigned int>> visits(count);
+		for (auto& visit : visits)
+		{
+			visit = 0;
+		}
+
+		JobRange body = [&visits](unsigned int _begin, unsigned int _end)
+		{
+			for (unsigned int i = _begin; i < _end; i++)
+			{
+				// Later indices cost more, so adaptive ranges have to split
+				volatile unsigned int work = 0;
+				for (unsigned int j = 0; j < i / 1000; j++)
+				{
+					work += j;
+				}
+				visits[i]++;
+			}
+		};
+		_jobs->ParallelFor(count, 0, body);
+		_jobs->ParallelFor(count, 97, body);
+
+		for (auto& visit : visits)
+		{
+			if (visit != 2)
+			{
+				failures++;
+				break;
+			}
+		}
+	}
+	return expect(failures == 0, "JOB_SYSTEM_PARALLEL_FOR " + std::to_string(failures) + " of " + std::to_string(JOB_CHECK_ROUNDS) + " rounds skipped or repeated an index");
+}
+
+// The parallel cull returns exactly what the serial one does
+static bool check_cull_parallel()
+{
+	const unsigned int count = 100000;
+	FrustumCuller culler;
+	culler.Reserve(count);
+	std::srand(7);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		glm::vec3 center((float)(std::rand() % 2000) - 1000.0f, (float)(std::rand() % 200) - 100.0f, (float)(std::rand() % 2000) - 1000.0f);
+		culler.AddSphere(center, 0.5f + (float)(std::rand() % 100) / 20.0f);
+	}
+
+	bool passed = true;
+	std::vector<unsigned int> serial;
+	std::vector<unsigned int> parallel;
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 1000.0f);
+	for (unsigned int view = 0; view < 16; view++)
+	{
+		float angle = glm::radians(view * 22.5f);
+		glm::vec3 eye(0.0f, 10.0f, 0.0f);
+		Frustum frustum;
+		frustum.Extract(projection * glm::lookAt(eye, eye + glm::vec3(glm::cos(angle), -0.1f, glm::sin(angle)), glm::vec3(0.0f, 1.0f, 0.0f)));
+
+		unsigned int serialCount = culler.Cull(frustum, serial);
+		unsigned int parallelCount = culler.CullParallel(frustum, parallel);
+		passed &= expect(serialCount == parallelCount && serial == parallel,
+			"JOB_SYSTEM_CULL_PARALLEL view " + std::to_string(view) + ": " + std::to_string(parallelCount) + " visible, serial cull " + std::to_string(serialCount));
+	}
+	return passed;
+}
+
+bool check_job_system()
+{
+	JobSystem::Init(JOB_CHECK_THREADS);
+	JobSystem* jobs = JobSystem::getInstance();
+
+	bool passed = true;
+	passed &= check_dependencies(jobs);
+	passed &= check_main_affinity(jobs);
+	passed &= check_parallel_for(jobs);
+	passed &= check_cull_parallel();
+
+	JobSystem::Destroy();
+	return passed;
+}
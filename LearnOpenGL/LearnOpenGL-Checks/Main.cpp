@@ -0,0 +1,119 @@
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+#include "GLStateCache.h"
+
+#include "Checks.h"
+
+struct CheckEntry
+{
+	const char* Name;
+	bool (*Run)();
+};
+
+static const CheckEntry s_checks[] =
+{
+	{ "mesh_draw", check_mesh_draw },
+	{ "job_system", check_job_system },
+	{ "dynamic_resolution", check_dynamic_resolution },
+	{ "camera_path", check_camera_path },
+	{ "occlusion_culling", check_occlusion_culling },
+	{ "bvh", check_bvh },
+	{ "render_graph", check_render_graph },
+};
+
+// Every allocation of the process goes through here, so a check can count the ones a call makes
+static std::atomic<unsigned long long> s_allocations(0);
+
+void* operator new(std::size_t _size)
+{
+	s_allocations++;
+	void* memory = std::malloc(_size ? _size : 1);
+	if (!memory)
+	{
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void operator delete(void* _memory) noexcept
+{
+	std::free(_memory);
+}
+
+void operator delete(void* _memory, std::size_t) noexcept
+{
+	std::free(_memory);
+}
+
+unsigned long long get_allocation_count()
+{
+	return s_allocations;
+}
+
+bool expect(bool _condition, const std::string& _what)
+{
+	if (!_condition)
+	{
+		std::cout << "ERROR::CHECKS::" << _what << std::endl;
+	}
+	return _condition;
+}
+
+// Runs every check, or the ones named on the command line, exits with EXIT_FAILURE if any failed
+int main(int argc, char* argv[])
+{
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+
+	GLFWwindow* window = glfwCreateWindow(64, 64, "LearnOpenGL-Checks", nullptr, nullptr);
+	if (window == nullptr) {
+		glfwTerminate();
+		std::cout << "Failed to create GLFW window" << std::endl;
+		return EXIT_FAILURE;
+	}
+	glfwMakeContextCurrent(window);
+
+	glewExperimental = GL_TRUE;
+	GLenum err = glewInit();
+	if (err != GLEW_OK) {
+		glfwTerminate();
+		std::cout << "Failed to init GLEW: " << glewGetErrorString(err) << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	unsigned int failed = 0;
+	unsigned int run = 0;
+	for (const CheckEntry& check : s_checks)
+	{
+		bool selected = argc < 2;
+		for (int i = 1; i < argc; i++)
+		{
+			selected = selected || std::strcmp(argv[i], check.Name) == 0;
+		}
+		if (!selected)
+		{
+			continue;
+		}
+
+		bool passed = check.Run();
+		std::cout << "Check " << check.Name << ": " << (passed ? "passed" : "FAILED") << std::endl;
+		failed += passed ? 0 : 1;
+		run++;
+	}
+	std::cout << run << " check(s) run, " << failed << " failed" << std::endl;
+
+	GLStateCache::Destroy();
+	glfwTerminate();
+
+	return failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,65 @@
+#include "Checks.h"
+
+#include <vector>
+
+#include "GLStateCache.h"
+#include "Mesh.h"
+#include "Shader.h"
+
+// Mesh::Draw caches the sampler locations per program: once a program has drawn the mesh,
+// drawing again allocates nothing and uploads nothing, and another program gets its own locations
+bool check_mesh_draw()
+{
+	GLuint textures[2];
+	glGenTextures(2, textures);
+
+	std::vector<Vertex> vertices(3, Vertex());
+	std::vector<unsigned int> indices = { 0, 1, 2 };
+	std::vector<Texture> meshTextures(2);
+	meshTextures[0].id = textures[0];
+	meshTextures[0].type = "diffuse";
+	meshTextures[1].id = textures[1];
+	meshTextures[1].type = "specular";
+	Mesh mesh(vertices, indices, meshTextures);
+
+	// Two programs of one source, the second stands for any other shader drawing the mesh
+	Shader first("Shaders/Simple3DShaderLightTut.vs", "Shaders/SimpleShaderLightColor.frag");
+	Shader second("Shaders/Simple3DShaderLightTut.vs", "Shaders/SimpleShaderLightColor.frag");
+
+	bool passed = true;
+	first.Use();
+	mesh.Draw(&first);
+
+	const unsigned int draws = 1000;
+	Shader::resetUniformStats();
+	unsigned long long allocations = get_allocation_count();
+	for (unsigned int i = 0; i < draws; i++)
+	{
+		mesh.Draw(&first);
+	}
+	allocations = get_allocation_count() - allocations;
+	UniformStats uniforms = Shader::getUniformStats();
+
+	passed &= expect(allocations == 0, "MESH_DRAW_ALLOCATES " + std::to_string(allocations) + " allocations in " + std::to_string(draws) + " draws");
+	passed &= expect(uniforms.Issued == 0, "MESH_DRAW_UPLOADS " + std::to_string(uniforms.Issued) + " sampler uploads in " + std::to_string(draws) + " draws");
+
+	second.Use();
+	mesh.Draw(&second);
+	for (const TextureBinding& binding : mesh.textureBindings)
+	{
+		GLint value = -1;
+		if (binding.location >= 0)
+		{
+			glGetUniformiv(second.Program, binding.location, &value);
+		}
+		passed &= expect(binding.program == second.Program && binding.location == second.getUniformPosition(binding.uniformName.c_str()),
+			"MESH_DRAW_STALE_LOCATION " + binding.uniformName);
+		passed &= expect(binding.location >= 0 && value == (GLint)binding.unit, "MESH_DRAW_SAMPLER_NOT_SET " + binding.uniformName);
+	}
+
+	mesh.Release();
+	GLStateCache::getInstance()->forgetTexture(textures[0]);
+	GLStateCache::getInstance()->forgetTexture(textures[1]);
+	glDeleteTextures(2, textures);
+	return passed;
+}
@@ -0,0 +1,47 @@
+#include "Checks.h"
+
+#include <cstdlib>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include "OcclusionCulling.h"
+
+// Box of half size _extent around _center, tested against the culler
+static bool is_visible(const OcclusionCuller& _culler, const glm::vec3& _center, float _extent)
+{
+	return _culler.IsVisible(_center - glm::vec3(_extent), _center + glm::vec3(_extent));
+}
+
+// The culler never hides a box that can be seen and does hide some on a known scene;
+// around a single wall, boxes in front or past its edge stay visible and boxes behind it are culled
+bool check_occlusion_culling()
+{
+	bool passed = true;
+
+	// Random boxes behind and around a wall, compared with the exact answer
+	srand(1);
+	OcclusionStats stats;
+	unsigned int trulyOccluded = 0;
+	unsigned int falselyOccluded = 0;
+	OcclusionCuller::benchmark(10000, stats, trulyOccluded, falselyOccluded);
+	passed &= expect(falselyOccluded == 0, "OCCLUSION_CULLING_FALSELY_OCCLUDED " + std::to_string(falselyOccluded) + " of 10000 boxes");
+	passed &= expect(stats.Occluded > 0 && trulyOccluded > 0, "OCCLUSION_CULLING_NOTHING_CULLED " + std::to_string(stats.Occluded) + " culled, "
+		+ std::to_string(trulyOccluded) + " hidden");
+
+	// Camera at the origin looking down -z, a 20 x 10 wall from z = -21 to z = -20
+	OcclusionCuller culler;
+	culler.Begin(glm::perspective(glm::radians(60.0f), 2.0f, 0.1f, 200.0f));
+	culler.AddOccluderBox(glm::vec3(-10.0f, -5.0f, -21.0f), glm::vec3(10.0f, 5.0f, -20.0f), glm::mat4(1.0f));
+	culler.Finish();
+
+	passed &= expect(is_visible(culler, glm::vec3(0.0f, 0.0f, -10.0f), 1.0f), "OCCLUSION_CULLING_FRONT_CULLED");
+	passed &= expect(is_visible(culler, glm::vec3(0.0f, 0.0f, -19.0f), 0.5f), "OCCLUSION_CULLING_TOUCHING_FRONT_CULLED");
+	passed &= expect(!is_visible(culler, glm::vec3(0.0f, 0.0f, -40.0f), 1.0f), "OCCLUSION_CULLING_BEHIND_VISIBLE");
+	passed &= expect(!is_visible(culler, glm::vec3(4.0f, -2.0f, -80.0f), 2.0f), "OCCLUSION_CULLING_FAR_BEHIND_VISIBLE");
+
+	// Behind the wall but reaching past its edge as seen from the camera
+	passed &= expect(is_visible(culler, glm::vec3(20.0f, 0.0f, -40.0f), 1.0f), "OCCLUSION_CULLING_EDGE_CULLED");
+	passed &= expect(is_visible(culler, glm::vec3(30.0f, 0.0f, -40.0f), 1.0f), "OCCLUSION_CULLING_BESIDE_CULLED");
+
+	return passed;
+}
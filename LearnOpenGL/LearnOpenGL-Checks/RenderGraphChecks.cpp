@@ -0,0 +1,150 @@
+#include "Checks.h"
+
+#include <vector>
+
+#include "Profiler.h"
+#include "RenderGraph.h"
+#include "RenderTargetPool.h"
+
+// Lifetime of a transient in execution order, from its writer to its last reader
+struct TransientUse
+{
+	RenderGraphResource Handle;
+	RenderGraphTextureDesc Desc;
+	int First;
+	int Last;
+};
+
+static bool same_desc(const RenderGraphTextureDesc& _a, const RenderGraphTextureDesc& _b)
+{
+	return _a.Width == _b.Width && _a.Height == _b.Height && _a.InternalFormat == _b.InternalFormat && _a.Filter == _b.Filter;
+}
+
+// Pass that only records its name when it runs
+static void add_pass(RenderGraph& _graph, const char* _name, std::vector<std::string>& _executed, const RenderGraphSetup& _setup)
+{
+	_graph.AddPass(_name, _setup, [_name, &_executed](const RenderGraph&) { _executed.push_back(_name); });
+}
+
+// Every transient is backed, and two of them only share a texture when they have the same description
+// and one is dead before the other is written
+static bool check_texture_sharing(const RenderGraph& _graph, const std::vector<TransientUse>& _uses)
+{
+	bool passed = true;
+	for (unsigned int a = 0; a < _uses.size(); a++)
+	{
+		passed &= expect(_graph.getTexture(_uses[a].Handle) != 0, "RENDER_GRAPH_TRANSIENT_NOT_BACKED " + std::to_string(_uses[a].Handle));
+		for (unsigned int b = a + 1; b < _uses.size(); b++)
+		{
+			if (_graph.getTexture(_uses[a].Handle) != _graph.getTexture(_uses[b].Handle))
+			{
+				continue;
+			}
+			bool disjoint = _uses[a].Last < _uses[b].First || _uses[b].Last < _uses[a].First;
+			passed &= expect(same_desc(_uses[a].Desc, _uses[b].Desc) && disjoint, "RENDER_GRAPH_BAD_SHARING " + std::to_string(_uses[a].Handle)
+				+ " and " + std::to_string(_uses[b].Handle));
+		}
+	}
+	return passed;
+}
+
+// Passes nobody reads from are culled with everything only they feed, the rest runs writers before readers,
+// and transients share textures only when their descriptions match and their lifetimes do not overlap
+bool check_render_graph()
+{
+	bool passed = true;
+
+	const RenderGraphTextureDesc color = { 64, 64, GL_RGBA8, GL_LINEAR };
+	const RenderGraphTextureDesc colorNearest = { 64, 64, GL_RGBA8, GL_NEAREST };
+	const RenderGraphTextureDesc colorHalf = { 32, 32, GL_RGBA8, GL_LINEAR };
+	const RenderGraphTextureDesc colorFloat = { 64, 64, GL_RGBA16F, GL_LINEAR };
+	const RenderGraphTextureDesc depth = { 64, 64, GL_DEPTH_COMPONENT24, GL_NEAREST };
+
+	{
+		// A debug view nobody shows and a two pass chain feeding nothing, around a deferred frame
+		RenderGraph graph;
+		std::vector<std::string> executed;
+		RenderGraphResource gbuffer = 0, lit = 0, post = 0, unused = 0, chain = 0;
+		add_pass(graph, "gbuffer", executed, [&](RenderGraphBuilder& _builder) { gbuffer = _builder.Create("albedo", color); _builder.Create("depth", depth); });
+		add_pass(graph, "debug_view", executed, [&](RenderGraphBuilder& _builder) { _builder.Read(gbuffer); unused = _builder.Create("debug", color); });
+		add_pass(graph, "chain_head", executed, [&](RenderGraphBuilder& _builder) { chain = _builder.Create("chain", colorHalf); });
+		add_pass(graph, "lighting", executed, [&](RenderGraphBuilder& _builder) { _builder.Read(gbuffer); lit = _builder.Create("lit", colorFloat); });
+		add_pass(graph, "chain_tail", executed, [&](RenderGraphBuilder& _builder) { _builder.Read(chain); _builder.Create("chain_out", colorHalf); });
+		add_pass(graph, "post", executed, [&](RenderGraphBuilder& _builder) { _builder.Read(lit); post = _builder.Create("post", color); });
+		add_pass(graph, "final", executed, [&](RenderGraphBuilder& _builder) { _builder.Read(post); _builder.Read(gbuffer); _builder.WriteBackbuffer(); });
+		graph.Compile();
+		graph.Execute();
+
+		std::vector<std::string> expected = { "gbuffer", "lighting", "post", "final" };
+		std::string order;
+		for (const std::string& name : executed)
+		{
+			order += " " + name;
+		}
+		passed &= expect(executed == expected, "RENDER_GRAPH_WRONG_PASSES" + order);
+		passed &= expect(graph.getStats().Passes == 7 && graph.getStats().CulledPasses == 3, "RENDER_GRAPH_CULLED_COUNT "
+			+ std::to_string(graph.getStats().CulledPasses) + " of " + std::to_string(graph.getStats().Passes));
+		passed &= expect(graph.getTexture(unused) == 0 && graph.getTexture(chain) == 0, "RENDER_GRAPH_CULLED_OUTPUT_BACKED");
+		passed &= expect(graph.getStats().Resources == 4, "RENDER_GRAPH_LIVE_RESOURCES " + std::to_string(graph.getStats().Resources));
+	}
+
+	{
+		// a -> b -> c -> d -> e, each reading what the one before wrote
+		RenderGraph graph;
+		std::vector<std::string> executed;
+		RenderGraphResource t0 = 0, t1 = 0, t2 = 0, t2Half = 0, t3 = 0, t3Nearest = 0, t3Float = 0;
+		add_pass(graph, "a", executed, [&](RenderGraphBuilder& _builder) { t0 = _builder.Create("t0", color); });
+		add_pass(graph, "b", executed, [&](RenderGraphBuilder& _builder) { _builder.Read(t0); t1 = _builder.Create("t1", color); });
+		add_pass(graph, "c", executed, [&](RenderGraphBuilder& _builder)
+		{
+			_builder.Read(t1);
+			t2 = _builder.Create("t2", color);
+			t2Half = _builder.Create("t2_half", colorHalf);
+		});
+		add_pass(graph, "d", executed, [&](RenderGraphBuilder& _builder)
+		{
+			_builder.Read(t2);
+			_builder.Read(t2Half);
+			// Created first, so it is offered t1's texture that only differs from it in the filter
+			t3Nearest = _builder.Create("t3_nearest", colorNearest);
+			t3 = _builder.Create("t3", color);
+			t3Float = _builder.Create("t3_float", colorFloat);
+		});
+		add_pass(graph, "e", executed, [&](RenderGraphBuilder& _builder)
+		{
+			_builder.Read(t3);
+			_builder.Read(t3Nearest);
+			_builder.Read(t3Float);
+			_builder.WriteBackbuffer();
+		});
+		graph.Compile();
+		graph.Execute();
+
+		std::vector<std::string> expected = { "a", "b", "c", "d", "e" };
+		passed &= expect(executed == expected, "RENDER_GRAPH_CHAIN_OUT_OF_ORDER");
+
+		std::vector<TransientUse> uses =
+		{
+			{ t0, color, 0, 1 },
+			{ t1, color, 1, 2 },
+			{ t2, color, 2, 3 },
+			{ t2Half, colorHalf, 2, 3 },
+			{ t3Nearest, colorNearest, 3, 4 },
+			{ t3, color, 3, 4 },
+			{ t3Float, colorFloat, 3, 4 },
+		};
+		passed &= check_texture_sharing(graph, uses);
+
+		// t2 takes over t0 once b read it, t3 takes over t1 once c read it
+		passed &= expect(graph.getTexture(t2) == graph.getTexture(t0) && graph.getTexture(t3) == graph.getTexture(t1), "RENDER_GRAPH_NOT_SHARED");
+		passed &= expect(graph.getStats().Resources == 7 && graph.getStats().Textures == 5, "RENDER_GRAPH_TEXTURE_COUNT "
+			+ std::to_string(graph.getStats().Textures) + " for " + std::to_string(graph.getStats().Resources) + " transients");
+		passed &= expect(graph.getStats().AliasedBytes < graph.getStats().UnaliasedBytes, "RENDER_GRAPH_NO_BYTES_SAVED");
+	}
+
+	// The graphs handed their textures back, the pool and the profiler scopes of Execute() go with the check
+	RenderTargetPool::Destroy();
+	Profiler::Destroy();
+
+	return passed;
+}
@@ -12,6 +12,8 @@
 
 #include "ShaderManager.h"
 #include "Shader.h"
+#include "GLStateCache.h"
+#include "Benchmark.h"
 #include "Camera.h"
 #include "Material.h"
 #include "Light.h"
@@ -52,6 +54,11 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 		glfwSetWindowShouldClose(window, GL_TRUE);
 	}
 
+	// F5 rebuilds the shared shaders whose sources changed on disk
+	if (key == GLFW_KEY_F5 && action == GLFW_PRESS) {
+		std::cout << ShaderManager::getInstance()->reloadChangedShaders() << " shader(s) reloaded" << std::endl;
+	}
+
 	if (action == GLFW_PRESS)
 		keys[key] = true;
 	else if (action == GLFW_RELEASE)
@@ -96,7 +103,7 @@ void do_movement() {
 unsigned int loadCubemap(std::vector<std::string> faces) {
 	unsigned int textureID;
 	glGenTextures(1, &textureID);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_CUBE_MAP, textureID);
 
 	int width, height, nrChannels;
 	for (unsigned int i = 0; i < faces.size(); ++i)
@@ -122,9 +129,10 @@ unsigned int loadCubemap(std::vector<std::string> faces) {
 	return textureID;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
 
 	glfwInit();
+	Benchmark::Init(argc, argv);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -206,7 +214,7 @@ int main() {
 	GLuint VAO_cube;
 	glGenVertexArrays(1, &VAO_cube);
 
-	glBindVertexArray(VAO_cube);
+	GLStateCache::getInstance()->bindVertexArray(VAO_cube);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO_cube);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(cube_vertices), cube_vertices, GL_STATIC_DRAW);
 
@@ -222,7 +230,7 @@ int main() {
 	//glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
 	//glEnableVertexAttribArray(2);
 
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 
 	// Skybox Vertices
 	GLfloat skybox_vertices[] = 
@@ -277,14 +285,14 @@ int main() {
 	GLuint skyBox_VAO;
 	glGenVertexArrays(1, &skyBox_VAO);
 
-	glBindVertexArray(skyBox_VAO);
+	GLStateCache::getInstance()->bindVertexArray(skyBox_VAO);
 	glBindBuffer(GL_ARRAY_BUFFER, skyBox_VBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(skybox_vertices), skybox_vertices, GL_STATIC_DRAW);
 
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid*)0);
 	glEnableVertexAttribArray(0);
 
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 
 	// setting up Textures
 	int t_width, t_height;
@@ -294,7 +302,7 @@ int main() {
 
 	glGenTextures(1, &diffuseMap);
 
-	glBindTexture(GL_TEXTURE_2D, diffuseMap);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap);
 	// Set Texture Parameters
 	// Set Wrap function
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
@@ -309,7 +317,7 @@ int main() {
 
 	stbi_image_free(image);
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
 
 	// Texture Container
 	image = stbi_load("Resources/textures/container2.png", &t_width, &t_height, 0, STBI_rgb);
@@ -318,7 +326,7 @@ int main() {
 
 	glGenTextures(1, &diffuseMap_cube);
 
-	glBindTexture(GL_TEXTURE_2D, diffuseMap_cube);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap_cube);
 	// Set Texture Parameters
 	// Set Wrap function
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
@@ -333,7 +341,7 @@ int main() {
 
 	stbi_image_free(image);
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
 
 	// Load Cubemap
 	std::vector<std::string> faces =
@@ -383,10 +391,10 @@ int main() {
 	glfwSetKeyCallback(window, key_callback);
 
 	// Setup
-	glEnable(GL_DEPTH_TEST);
+	GLStateCache::getInstance()->enable(GL_DEPTH_TEST);
 
 	// Main loop of drawing
-	glViewport(0, 0, width, height);
+	GLStateCache::getInstance()->viewport(0, 0, width, height);
 
 	while (!glfwWindowShouldClose(window)) {
 		
@@ -395,7 +403,7 @@ int main() {
 
 
 		// calculate delta time
-		GLfloat currentFrame = glfwGetTime();
+		GLfloat currentFrame = Benchmark::getInstance()->getTime();
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
 
@@ -418,6 +426,7 @@ int main() {
 		}
 
 		do_movement();
+		Benchmark::getInstance()->Update(camera);
 
 		// Rendering commands here
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
@@ -450,7 +459,7 @@ int main() {
 		glm::mat4 model;
 		shader->setMat4("model", model);
 		
-		glBindTexture(GL_TEXTURE_CUBE_MAP, skyBoxMap);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_CUBE_MAP, skyBoxMap);
 
 		if (modelIndex == 1)
 		{
@@ -458,32 +467,34 @@ int main() {
 		}
 		else
 		{
-			glBindVertexArray(VAO_cube);
+			GLStateCache::getInstance()->bindVertexArray(VAO_cube);
 
 			glDrawArrays(GL_TRIANGLES, 0, 36);
 
-			glBindVertexArray(0);
+			GLStateCache::getInstance()->bindVertexArray(0);
 		}
 
-		glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_CUBE_MAP, 0);
 
 
 
 		// Draw Skybox at last
 		{
-			glDepthFunc(GL_LEQUAL); // change depth function so depth test passes when values are equal to depth buffer's content
+			GLStateCache::getInstance()->depthFunc(GL_LEQUAL); // change depth function so depth test passes when values are equal to depth buffer's content
 			Shader* skyboxShader = ShaderManager::getInstance()->getShaderByType(SHADER_TYPE_SKYBOX);
 			skyboxShader->Use();
 			skyboxShader->setMat4("view", glm::mat4(glm::mat3(view)));
 			skyboxShader->setMat4("projection", projection);
 
-			glBindVertexArray(skyBox_VAO);
-			glBindTexture(GL_TEXTURE_CUBE_MAP, skyBoxMap);
+			GLStateCache::getInstance()->bindVertexArray(skyBox_VAO);
+			GLStateCache::getInstance()->bindTexture(GL_TEXTURE_CUBE_MAP, skyBoxMap);
 			glDrawArrays(GL_TRIANGLES, 0, 36);
-			glDepthFunc(GL_LESS);
-			glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+			GLStateCache::getInstance()->depthFunc(GL_LESS);
+			GLStateCache::getInstance()->bindTexture(GL_TEXTURE_CUBE_MAP, 0);
 		}
 
+		Benchmark::getInstance()->EndFrame(window);
+
 		// Swap the buffers
 		glfwSwapBuffers(window);
 	}
@@ -497,6 +508,10 @@ int main() {
 
 	ShaderManager::Destroy();
 
+	Benchmark::Destroy();
+
+	GLStateCache::Destroy();
+
 	// Terminate before close
 	glfwTerminate();
 
@@ -1,12 +1,19 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <fstream>
 #include <vector>
 #include <string>
+#include <thread>
 
 #include "Shader.h"
+#include "GLStateCache.h"
+#include "Benchmark.h"
+#include "CommandBuffer.h"
+#include "BVH.h"
 #include "Camera.h"
 #include "Material.h"
 #include "PointLight.h"
@@ -96,9 +103,10 @@ void do_movement()
 		camera.ProcessKeyboard(CameraMovement::RIGHT, deltaTime);
 }
 
-int main() 
+int main(int argc, char* argv[]) 
 {
 	glfwInit();
+	Benchmark::Init(argc, argv);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -185,7 +193,7 @@ int main()
 
 	glGenVertexArrays(1, &VAO_cube);
 
-	glBindVertexArray(VAO_cube);
+	GLStateCache::getInstance()->bindVertexArray(VAO_cube);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO_cube);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(cube_vertices), cube_vertices, GL_STATIC_DRAW);
 
@@ -201,7 +209,7 @@ int main()
 	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
 	glEnableVertexAttribArray(2);
 
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 
 	// Quad buffer
 	GLfloat quadVertices[] =
@@ -221,24 +229,24 @@ int main()
 	GLuint quadVBO;
 	glGenVertexArrays(1, &quadVAO);
 	glGenBuffers(1, &quadVBO);
-	glBindVertexArray(quadVAO);
+	GLStateCache::getInstance()->bindVertexArray(quadVAO);
 	glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 5, (GLvoid*)0);
 	glEnableVertexAttribArray(1);
 	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 5, (GLvoid*)(sizeof(GLfloat) * 3));
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 
 	// Configure GBuffer
 	GLuint gBuffer;
 	glGenFramebuffers(1, &gBuffer);
-	glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
+	GLStateCache::getInstance()->bindFramebuffer(GL_FRAMEBUFFER, gBuffer);
 	GLuint gPosition, gNormal, gColorSpec;
 
 	// - position color buffer
 	glGenTextures(1, &gPosition);
-	glBindTexture(GL_TEXTURE_2D, gPosition);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, gPosition);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, width, height, 0, GL_RGB, GL_FLOAT, NULL);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -246,7 +254,7 @@ int main()
 
 	// - normal color buffer
 	glGenTextures(1, &gNormal);
-	glBindTexture(GL_TEXTURE_2D, gNormal);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, gNormal);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, width, height, 0, GL_RGB, GL_FLOAT, NULL);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -254,7 +262,7 @@ int main()
 
 	// - color + specular color buffer
 	glGenTextures(1, &gColorSpec);
-	glBindTexture(GL_TEXTURE_2D, gColorSpec);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, gColorSpec);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -272,7 +280,7 @@ int main()
 	
 	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
 		std::cout << "Framebuffer not complete!" << std::endl;
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	GLStateCache::getInstance()->bindFramebuffer(GL_FRAMEBUFFER, 0);
 
 	// Setup Lights
 	// Light attributes
@@ -299,7 +307,7 @@ int main()
 
 		// Calculate radius of lights
 		float lightMax = std::fmaxf(std::fmaxf(rColor, gColor), bColor);
-		float radius = (-linear + std::sqrtf(linear * linear - 4 * quadratic * (constant - (256.0 / 5.0) * lightMax))) / (2 * quadratic);
+		float radius = (-linear + std::sqrt(linear * linear - 4 * quadratic * (constant - (256.0 / 5.0) * lightMax))) / (2 * quadratic);
 		lightRadius.push_back(radius);
 	}
 
@@ -315,6 +323,22 @@ int main()
 	modelPositions.push_back(glm::vec3(4.0f, 0.0f, -4.0f));
 	modelPositions.push_back(glm::vec3(-4.0f, 0.0f, -4.0f));
 
+	// view and projection live in one uniform buffer shared by the geometry and light box programs
+	GLuint cameraUBO;
+	glGenBuffers(1, &cameraUBO);
+	glBindBuffer(GL_UNIFORM_BUFFER, cameraUBO);
+	glBufferData(GL_UNIFORM_BUFFER, 2 * sizeof(glm::mat4), NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, 0, cameraUBO);
+	geometryPassShader.setUniformBlockBinding("CameraMatrices", 0);
+	lightBoxShader.setUniformBlockBinding("CameraMatrices", 0);
+
+	// Draws are recorded on worker threads, one buffer each, then replayed here in order
+	unsigned int recordThreads = std::max(1u, std::min(4u, std::thread::hardware_concurrency()));
+	std::vector<CommandBuffer> geometryCommands(recordThreads);
+	std::vector<CommandBuffer> lightBoxCommands(recordThreads);
+	CommandBuffer frameCommands;
+
 	// set mouse callbacks
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 	glfwSetCursorPosCallback(window, mouse_callback);
@@ -324,24 +348,80 @@ int main()
 	glfwSetKeyCallback(window, key_callback);
 
 	// Setup
-	glEnable(GL_DEPTH_TEST);
+	GLStateCache::getInstance()->enable(GL_DEPTH_TEST);
 
 	bool drawLight = true;
+
+	// I / O switch the nanosuit copies between multi-draw indirect and per mesh command buffers
+	bool drawIndirect = true;
+	unsigned int instancedModel = geometryPassShader.addPermutationDefine("INSTANCED_MODEL");
+	std::vector<glm::mat4> modelMatrices(modelPositions.size());
+
+	// Scene objects live in a BVH queried for the view and for each light. The copies never move, so it is
+	// built once; an object that moves would update its box and Refit() the tree in the frame it moved.
+	glm::vec3 modelMin, modelMax;
+	for (unsigned int i = 0; i < ourModel.meshes.size(); i++)
+	{
+		const Mesh& mesh = ourModel.meshes[i];
+		glm::vec3 meshMin, meshMax;
+		getBoundingBox(&mesh.vertices[0].Position, (unsigned int)mesh.vertices.size(), sizeof(Vertex), meshMin, meshMax);
+		modelMin = (i == 0) ? meshMin : glm::min(modelMin, meshMin);
+		modelMax = (i == 0) ? meshMax : glm::max(modelMax, meshMax);
+	}
+	std::vector<glm::vec3> objectMins(modelPositions.size());
+	std::vector<glm::vec3> objectMaxs(modelPositions.size());
+	for (unsigned int i = 0; i < modelPositions.size(); i++)
+	{
+		glm::mat4 model;
+		model = glm::translate(model, modelPositions[i]);
+		model = glm::scale(model, glm::vec3(0.4f));
+		modelMatrices[i] = model;
+		transformBoundingBox(modelMin, modelMax, model, objectMins[i], objectMaxs[i]);
+	}
+	BVH sceneBVH;
+	sceneBVH.Build(objectMins.data(), objectMaxs.data(), (unsigned int)modelPositions.size());
+
+	std::vector<unsigned int> visibleObjects;
+	std::vector<bool> objectVisible(modelPositions.size());
+	std::vector<glm::mat4> visibleMatrices;
+	std::vector<unsigned int> litObjects;
+	std::vector<unsigned int> shadedLights;
+
+	if (Benchmark::getInstance()->isMicrobenchmarking())
+	{
+		double bvhBuild, bvhRefit, bvhQuery;
+		BVH::benchmark(100000, bvhBuild, bvhRefit, bvhQuery);
+		std::cout << "BVH 100k objects: build " << bvhBuild << " ms, refit " << bvhRefit << " ms, frustum query " << bvhQuery << " ms" << std::endl;
+	}
 	float exposure = 1.0f; // higher: focus on dark area; lower: focus on bright area
 
 	// Main loop of drawing
-	glViewport(0, 0, width, height);
+	GLStateCache::getInstance()->viewport(0, 0, width, height);
 	while (!glfwWindowShouldClose(window)) 
 	{
 		// Check and call events
 		glfwPollEvents();
 
 		// calculate delta time
-		GLfloat currentFrame = glfwGetTime();
+		GLfloat currentFrame = Benchmark::getInstance()->getTime();
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
 
 		do_movement();
+		Benchmark::getInstance()->Update(camera);
+
+		// Show once per second how many uniform uploads the last frame issued and skipped
+		if ((int)currentFrame != (int)(currentFrame - deltaTime))
+		{
+			const UniformStats& uniformStats = Shader::getUniformStats();
+			const GLStateStats& stateStats = GLStateCache::getInstance()->getStats();
+			std::string title = "LearnOpenGL - uniforms issued: " + std::to_string(uniformStats.Issued) + " skipped: " + std::to_string(uniformStats.Skipped) +
+				" | state changes issued: " + std::to_string(stateStats.Issued) + " requested: " + std::to_string(stateStats.Requested) +
+				" | visible: " + std::to_string(visibleMatrices.size()) + "/" + std::to_string(modelPositions.size()) + " lights shaded: " + std::to_string(shadedLights.size()) + "/" + std::to_string(NR_LIGHTS);
+			glfwSetWindowTitle(window, title.c_str());
+		}
+		Shader::resetUniformStats();
+		GLStateCache::getInstance()->resetStats();
 
 		if (keys['L'])
 		{
@@ -353,40 +433,117 @@ int main()
 			drawLight = false;
 		}
 
+		if (keys['I'])
+		{
+			drawIndirect = true;
+		}
+
+		if (keys['O'])
+		{
+			drawIndirect = false;
+		}
+
 		// 1. First render Lighted Scene to HDR Frame buffer
-		glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
+		GLStateCache::getInstance()->bindFramebuffer(GL_FRAMEBUFFER, gBuffer);
 
 		// Configure shader and matrices
 		// Light Projection
-		glViewport(0, 0, width, height);
+		GLStateCache::getInstance()->viewport(0, 0, width, height);
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 		glm::mat4 view = camera.GetViewMatrix();
 		glm::mat4 projection = glm::perspective(camera.Zoom, width / (float)height, 0.1f, 100.0f);
 
+		glm::mat4 cameraMatrices[2] = { view, projection };
+		frameCommands.Reset();
+		frameCommands.updateUniformBuffer(cameraUBO, 0, cameraMatrices, sizeof(cameraMatrices));
+
+		Frustum frustum;
+		frustum.Extract(projection * view);
+		visibleObjects.clear();
+		sceneBVH.QueryFrustum(frustum, visibleObjects);
+		visibleMatrices.resize(visibleObjects.size());
+		std::fill(objectVisible.begin(), objectVisible.end(), false);
+		for (unsigned int i = 0; i < visibleObjects.size(); i++)
+		{
+			visibleMatrices[i] = modelMatrices[visibleObjects[i]];
+			objectVisible[visibleObjects[i]] = true;
+		}
+
+		// The light pass skips fragments beyond a light's radius, so a light whose volume reaches
+		// no visible object lights no G-buffer pixel and is left out of it
+		shadedLights.clear();
+		for (unsigned int i = 0; i < NR_LIGHTS; i++)
+		{
+			litObjects.clear();
+			sceneBVH.QuerySphere(lightPositions[i], lightRadius[i], litObjects);
+			for (unsigned int object : litObjects)
+			{
+				if (objectVisible[object])
+				{
+					shadedLights.push_back(i);
+					break;
+				}
+			}
+		}
+
+		// Record the model copies and the light boxes, disjoint slices per thread
+		if (!drawIndirect)
+		{
+			CommandBuffer::RecordParallel(geometryCommands, (unsigned int)visibleMatrices.size(),
+				[&](CommandBuffer& buffer, unsigned int begin, unsigned int end)
+			{
+				buffer.useShader(&geometryPassShader);
+				for (unsigned int i = begin; i < end; i++)
+				{
+					buffer.setMat4("model", visibleMatrices[i]);
+					ourModel.Record(buffer);
+				}
+			});
+		}
+
+		if (drawLight)
+		{
+			CommandBuffer::RecordParallel(lightBoxCommands, NR_LIGHTS,
+				[&](CommandBuffer& buffer, unsigned int begin, unsigned int end)
+			{
+				buffer.useShader(&lightBoxShader);
+				buffer.bindVertexArray(VAO_cube);
+				for (unsigned int i = begin; i < end; i++)
+				{
+					glm::mat4 model;
+					model = glm::translate(model, lightPositions[i]);
+					model = glm::scale(model, glm::vec3(0.25f));
+					buffer.setMat4("model", model);
+					buffer.setVec3("lightColor", lightColors[i]);
+
+					buffer.drawArrays(GL_TRIANGLES, 0, 36);
+				}
+			});
+		}
+
 		// Draw Objects
-		geometryPassShader.Use();
-		geometryPassShader.setMat4("view", view);
-		geometryPassShader.setMat4("projection", projection);
-
-		for(int i=0; i < modelPositions.size(); i++)
-		{ 
-			glm::mat4 model;
-			model = glm::translate(model, modelPositions[i]);
-			model = glm::scale(model, glm::vec3(0.4f));
-
-			geometryPassShader.setMat4("model", model);
-			ourModel.Draw(&geometryPassShader);
+		frameCommands.Execute();
+		if (drawIndirect)
+		{
+			// Every copy of every sub-mesh in one call per material
+			geometryPassShader.Use(instancedModel);
+			ourModel.DrawIndirect(&geometryPassShader, visibleMatrices.data(), (unsigned int)visibleMatrices.size());
+		}
+		else
+		{
+			geometryPassShader.setPermutation(0);
+			CommandBuffer::ExecuteAll(geometryCommands);
 		}
 
 		// Render Deferred Shading
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
- 		//glViewport(0, 0, width, height);
+		GLStateCache::getInstance()->bindFramebuffer(GL_FRAMEBUFFER, 0);
+ 		//GLStateCache::getInstance()->viewport(0, 0, width, height);
  		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		glBindVertexArray(quadVAO);
+		GLStateCache::getInstance()->bindVertexArray(quadVAO);
 
 		deferredLightPassShader.Use();
 		deferredLightPassShader.setVec3("viewPos", camera.Position);
@@ -394,53 +551,42 @@ int main()
 		deferredLightPassShader.setInt("gNormal", 1);
 		deferredLightPassShader.setInt("gAlbedoSpec", 2);
 
-		for (unsigned int i = 0; i < NR_LIGHTS; i++)
+		deferredLightPassShader.setInt("nrLights", (int)shadedLights.size());
+		for (unsigned int i = 0; i < shadedLights.size(); i++)
 		{
-			deferredLightPassShader.setVec3(("lights[" + std::to_string(i) + "].Position").c_str(), lightPositions[i]);
-			deferredLightPassShader.setVec3(("lights[" + std::to_string(i) + "].Color").c_str(), lightColors[i]);
-			deferredLightPassShader.setFloat(("lights[" + std::to_string(i) + "].Radius").c_str(), lightRadius[i]);
+			unsigned int light = shadedLights[i];
+			deferredLightPassShader.setVec3(("lights[" + std::to_string(i) + "].Position").c_str(), lightPositions[light]);
+			deferredLightPassShader.setVec3(("lights[" + std::to_string(i) + "].Color").c_str(), lightColors[light]);
+			deferredLightPassShader.setFloat(("lights[" + std::to_string(i) + "].Radius").c_str(), lightRadius[light]);
 			deferredLightPassShader.setFloat(("lights[" + std::to_string(i) + "].Linear").c_str(), linear);
 			deferredLightPassShader.setFloat(("lights[" + std::to_string(i) + "].Quadratic").c_str(), quadratic);
 		}
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, gPosition);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, gNormal);
-		glActiveTexture(GL_TEXTURE2);
-		glBindTexture(GL_TEXTURE_2D, gColorSpec);
+		GLStateCache::getInstance()->activeTexture(GL_TEXTURE0);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, gPosition);
+		GLStateCache::getInstance()->activeTexture(GL_TEXTURE1);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, gNormal);
+		GLStateCache::getInstance()->activeTexture(GL_TEXTURE2);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, gColorSpec);
 
 		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 
-		glBindVertexArray(0);
-		glBindTexture(GL_TEXTURE_2D, 0);
+		GLStateCache::getInstance()->bindVertexArray(0);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
 
 		if (drawLight)
 		{
-			glBindFramebuffer(GL_READ_FRAMEBUFFER, gBuffer);
-			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0); // Write to default framebuffer
+			GLStateCache::getInstance()->bindFramebuffer(GL_READ_FRAMEBUFFER, gBuffer);
+			GLStateCache::getInstance()->bindFramebuffer(GL_DRAW_FRAMEBUFFER, 0); // Write to default framebuffer
 			glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
-			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			GLStateCache::getInstance()->bindFramebuffer(GL_FRAMEBUFFER, 0);
 
 			// Draw Lights
-			lightBoxShader.Use();
-			lightBoxShader.setMat4("view", view);
-			lightBoxShader.setMat4("projection", projection);
-
-			glBindVertexArray(VAO_cube);
-			for (int i = 0; i < NR_LIGHTS; i++)
-			{
-				glm::mat4 model;
-				model = glm::translate(model, lightPositions[i]);
-				model = glm::scale(model, glm::vec3(0.25f));
-				lightBoxShader.setMat4("model", model);
-				lightBoxShader.setVec3("lightColor", lightColors[i]);
-
-				glDrawArrays(GL_TRIANGLES, 0, 36);
-			}
-			glBindVertexArray(0);
+			CommandBuffer::ExecuteAll(lightBoxCommands);
 		}
 
+		Benchmark::getInstance()->EndFrame(window);
+
 		// Swap the buffers
 		glfwSwapBuffers(window);
 	}
@@ -455,6 +601,11 @@ int main()
 	glDeleteFramebuffers(1, &gBuffer);
 	glDeleteBuffers(1, &quadVBO);
 	glDeleteVertexArrays(1, &quadVAO);
+	glDeleteBuffers(1, &cameraUBO);
+
+	Benchmark::Destroy();
+
+	GLStateCache::Destroy();
 
 	// Terminate before close
 	glfwTerminate();
@@ -10,6 +10,8 @@
 
 #include "ShaderManager.h"
 #include "Shader.h"
+#include "GLStateCache.h"
+#include "Benchmark.h"
 #include "Camera.h"
 #include "Material.h"
 #include "Light.h"
@@ -46,6 +48,11 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 		glfwSetWindowShouldClose(window, GL_TRUE);
 	}
 
+	// F5 rebuilds the shared shaders whose sources changed on disk
+	if (key == GLFW_KEY_F5 && action == GLFW_PRESS) {
+		std::cout << ShaderManager::getInstance()->reloadChangedShaders() << " shader(s) reloaded" << std::endl;
+	}
+
 	if (action == GLFW_PRESS)
 		keys[key] = true;
 	else if (action == GLFW_RELEASE)
@@ -87,9 +94,10 @@ void do_movement() {
 		camera.ProcessKeyboard(CameraMovement::RIGHT, deltaTime);
 }
 
-int main() {
+int main(int argc, char* argv[]) {
 
 	glfwInit();
+	Benchmark::Init(argc, argv);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -136,7 +144,7 @@ int main() {
 	GLuint VAO_plane;
 	glGenVertexArrays(1, &VAO_plane);
 
-	glBindVertexArray(VAO_plane);
+	GLStateCache::getInstance()->bindVertexArray(VAO_plane);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO_plane);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(plane_vertices), plane_vertices, GL_STATIC_DRAW);
 
@@ -152,7 +160,7 @@ int main() {
 	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
 	glEnableVertexAttribArray(2);
 
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 
 	// 3D cube
 	GLfloat cube_vertices[] = {
@@ -206,7 +214,7 @@ int main() {
 	GLuint VAO_cube;
 	glGenVertexArrays(1, &VAO_cube);
 
-	glBindVertexArray(VAO_cube);
+	GLStateCache::getInstance()->bindVertexArray(VAO_cube);
 	glBindBuffer(GL_ARRAY_BUFFER, VAO_cube);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(cube_vertices), cube_vertices, GL_STATIC_DRAW);
 
@@ -222,7 +230,7 @@ int main() {
 	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
 	glEnableVertexAttribArray(2);
 
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 
 
 	// setting up Textures
@@ -233,7 +241,7 @@ int main() {
 
 	glGenTextures(1, &diffuseMap);
 
-	glBindTexture(GL_TEXTURE_2D, diffuseMap);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap);
 	// Set Texture Parameters
 	// Set Wrap function
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
@@ -248,7 +256,7 @@ int main() {
 
 	stbi_image_free(image);
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
 
 	image = stbi_load("Resources/textures/container2.png", &t_width, &t_height, 0, STBI_rgb);
 
@@ -256,7 +264,7 @@ int main() {
 
 	glGenTextures(1, &diffuseMap_cube);
 
-	glBindTexture(GL_TEXTURE_2D, diffuseMap_cube);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap_cube);
 	// Set Texture Parameters
 	// Set Wrap function
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
@@ -271,19 +279,19 @@ int main() {
 
 	stbi_image_free(image);
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
 
 	// Setup light VAO
 	GLuint lightVAO;
 	glGenVertexArrays(1, &lightVAO);
 
-	glBindVertexArray(lightVAO);
+	GLStateCache::getInstance()->bindVertexArray(lightVAO);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO_plane);
 
 	// Position attributes
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)0);
 	glEnableVertexAttribArray(0);
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 
 	glm::vec3 cubePositions[] = {
 		glm::vec3(0.0f,  0.5f,  2.0f),
@@ -324,23 +332,24 @@ int main() {
 	glfwSetKeyCallback(window, key_callback);
 
 	// Setup
-	glEnable(GL_DEPTH_TEST);
+	GLStateCache::getInstance()->enable(GL_DEPTH_TEST);
 
 	bool bShowDepthOnly = false;
 
 	// Main loop of drawing
-	glViewport(0, 0, width, height);
+	GLStateCache::getInstance()->viewport(0, 0, width, height);
 	while (!glfwWindowShouldClose(window)) {
 		// Check and call events
 		glfwPollEvents();
 
 
 		// calculate delta time
-		GLfloat currentFrame = glfwGetTime();
+		GLfloat currentFrame = Benchmark::getInstance()->getTime();
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
 
 		do_movement();
+		Benchmark::getInstance()->Update(camera);
 
 		// Rendering commands here
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
@@ -349,42 +358,42 @@ int main() {
 		// Select Depth function
 		if (keys[GLFW_KEY_1])
 		{
-			glDepthFunc(GL_ALWAYS);
+			GLStateCache::getInstance()->depthFunc(GL_ALWAYS);
 			std::cout << "Change Depth function to Always" << std::endl;
 		}
 		else if (keys[GLFW_KEY_2])
 		{
-			glDepthFunc(GL_NEVER);
+			GLStateCache::getInstance()->depthFunc(GL_NEVER);
 			std::cout << "Change Depth function to Never" << std::endl;
 		}
 		else if (keys[GLFW_KEY_3])
 		{
-			glDepthFunc(GL_LESS);
+			GLStateCache::getInstance()->depthFunc(GL_LESS);
 			std::cout << "Change Depth function to Less" << std::endl;
 		}
 		else if (keys[GLFW_KEY_4])
 		{
-			glDepthFunc(GL_EQUAL);
+			GLStateCache::getInstance()->depthFunc(GL_EQUAL);
 			std::cout << "Change Depth function to Equal" << std::endl;
 		}
 		else if (keys[GLFW_KEY_5])
 		{
-			glDepthFunc(GL_LEQUAL);
+			GLStateCache::getInstance()->depthFunc(GL_LEQUAL);
 			std::cout << "Change Depth function to Less Equal" << std::endl;
 		}
 		else if (keys[GLFW_KEY_6])
 		{
-			glDepthFunc(GL_GREATER);
+			GLStateCache::getInstance()->depthFunc(GL_GREATER);
 			std::cout << "Change Depth function to Greater" << std::endl;
 		}
 		else if (keys[GLFW_KEY_7])
 		{
-			glDepthFunc(GL_NOTEQUAL);
+			GLStateCache::getInstance()->depthFunc(GL_NOTEQUAL);
 			std::cout << "Change Depth function to Not Equal" << std::endl;
 		}
 		else if (keys[GLFW_KEY_8])
 		{
-			glDepthFunc(GL_GEQUAL);
+			GLStateCache::getInstance()->depthFunc(GL_GEQUAL);
 			std::cout << "Change Depth function to Greater Equal" << std::endl;
 		}
 
@@ -415,8 +424,8 @@ int main() {
 			// Setting up Material
 			shader->setInt("material.diffuse", 0);
 
-			glActiveTexture(GL_TEXTURE0);
-			glBindTexture(GL_TEXTURE_2D, diffuseMap);
+			GLStateCache::getInstance()->activeTexture(GL_TEXTURE0);
+			GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap);
 
 			shader->setFloat("material.shininess", mat.Shininess);
 
@@ -484,7 +493,7 @@ int main() {
 		shader->setMat4("view", view);
 		shader->setMat4("projection", projection);
 
-		glBindVertexArray(VAO_plane);
+		GLStateCache::getInstance()->bindVertexArray(VAO_plane);
 
 		glm::mat4 model;
 		model = glm::scale(model, glm::vec3(5.0f));
@@ -493,10 +502,10 @@ int main() {
 
 		glDrawArrays(GL_TRIANGLES, 0, 6);
 		
-		glBindVertexArray(VAO_cube);
+		GLStateCache::getInstance()->bindVertexArray(VAO_cube);
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, diffuseMap_cube);
+		GLStateCache::getInstance()->activeTexture(GL_TEXTURE0);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap_cube);
 
 		for (int i = 0; i < 2; i++)
 		{
@@ -508,12 +517,14 @@ int main() {
 			glDrawArrays(GL_TRIANGLES, 0, 36);
 		}
 
-		glBindVertexArray(0);
+		GLStateCache::getInstance()->bindVertexArray(0);
 
 #if USING_DIFFUSE_MAP
-		glBindTexture(GL_TEXTURE_2D, 0);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
 #endif
 
+		Benchmark::getInstance()->EndFrame(window);
+
 		// Swap the buffers
 		glfwSwapBuffers(window);
 	}
@@ -526,6 +537,10 @@ int main() {
 
 	ShaderManager::Destroy();
 
+	Benchmark::Destroy();
+
+	GLStateCache::Destroy();
+
 	// Terminate before close
 	glfwTerminate();
 
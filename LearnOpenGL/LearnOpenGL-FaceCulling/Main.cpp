@@ -11,6 +11,8 @@
 
 #include "ShaderManager.h"
 #include "Shader.h"
+#include "GLStateCache.h"
+#include "Benchmark.h"
 #include "Camera.h"
 #include "Material.h"
 #include "Light.h"
@@ -51,6 +53,11 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 		glfwSetWindowShouldClose(window, GL_TRUE);
 	}
 
+	// F5 rebuilds the shared shaders whose sources changed on disk
+	if (key == GLFW_KEY_F5 && action == GLFW_PRESS) {
+		std::cout << ShaderManager::getInstance()->reloadChangedShaders() << " shader(s) reloaded" << std::endl;
+	}
+
 	if (action == GLFW_PRESS)
 		keys[key] = true;
 	else if (action == GLFW_RELEASE)
@@ -92,9 +99,10 @@ void do_movement() {
 		camera.ProcessKeyboard(CameraMovement::RIGHT, deltaTime);
 }
 
-int main() {
+int main(int argc, char* argv[]) {
 
 	glfwInit();
+	Benchmark::Init(argc, argv);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -142,7 +150,7 @@ int main() {
 	GLuint VAO_plane;
 	glGenVertexArrays(1, &VAO_plane);
 
-	glBindVertexArray(VAO_plane);
+	GLStateCache::getInstance()->bindVertexArray(VAO_plane);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO_plane);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(plane_vertices), plane_vertices, GL_STATIC_DRAW);
 
@@ -158,7 +166,7 @@ int main() {
 	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
 	glEnableVertexAttribArray(2);
 
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 
 	// 3D cube
 	GLfloat cube_vertices[] = {
@@ -212,7 +220,7 @@ int main() {
 	GLuint VAO_cube;
 	glGenVertexArrays(1, &VAO_cube);
 
-	glBindVertexArray(VAO_cube);
+	GLStateCache::getInstance()->bindVertexArray(VAO_cube);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO_cube);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(cube_vertices), cube_vertices, GL_STATIC_DRAW);
 
@@ -228,7 +236,7 @@ int main() {
 	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
 	glEnableVertexAttribArray(2);
 
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 
 
 	// setting up Textures
@@ -239,7 +247,7 @@ int main() {
 
 	glGenTextures(1, &diffuseMap);
 
-	glBindTexture(GL_TEXTURE_2D, diffuseMap);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap);
 	// Set Texture Parameters
 	// Set Wrap function
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
@@ -254,7 +262,7 @@ int main() {
 
 	stbi_image_free(image);
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
 
 	// Texture Container
 	image = stbi_load("Resources/textures/container2.png", &t_width, &t_height, 0, STBI_rgb);
@@ -263,7 +271,7 @@ int main() {
 
 	glGenTextures(1, &diffuseMap_cube);
 
-	glBindTexture(GL_TEXTURE_2D, diffuseMap_cube);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap_cube);
 	// Set Texture Parameters
 	// Set Wrap function
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
@@ -278,19 +286,19 @@ int main() {
 
 	stbi_image_free(image);
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
 
 	// Setup light VAO
 	GLuint lightVAO;
 	glGenVertexArrays(1, &lightVAO);
 
-	glBindVertexArray(lightVAO);
+	GLStateCache::getInstance()->bindVertexArray(lightVAO);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO_plane);
 
 	// Position attributes
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)0);
 	glEnableVertexAttribArray(0);
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 
 	glm::vec3 cubePositions[] = {
 		glm::vec3(0.0f,  0.5f,  2.0f),
@@ -338,13 +346,13 @@ int main() {
 	glfwSetKeyCallback(window, key_callback);
 
 	// Setup
-	glEnable(GL_DEPTH_TEST);
+	GLStateCache::getInstance()->enable(GL_DEPTH_TEST);
 
 	// Main loop of drawing
-	glViewport(0, 0, width, height);
+	GLStateCache::getInstance()->viewport(0, 0, width, height);
 
 	// Enable Culling
-	glEnable(GL_CULL_FACE);
+	GLStateCache::getInstance()->enable(GL_CULL_FACE);
 
 	while (!glfwWindowShouldClose(window)) {
 		
@@ -353,11 +361,12 @@ int main() {
 
 
 		// calculate delta time
-		GLfloat currentFrame = glfwGetTime();
+		GLfloat currentFrame = Benchmark::getInstance()->getTime();
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
 
 		do_movement();
+		Benchmark::getInstance()->Update(camera);
 
 		// Rendering commands here
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
@@ -365,22 +374,22 @@ int main() {
 
 		if (keys['F'])
 		{
-			glCullFace(GL_FRONT);
+			GLStateCache::getInstance()->cullFace(GL_FRONT);
 		}
 
 		if (keys['B'])
 		{
-			glCullFace(GL_BACK);
+			GLStateCache::getInstance()->cullFace(GL_BACK);
 		}
 
 		if (keys['C'])
 		{
-			glFrontFace(GL_CCW);
+			GLStateCache::getInstance()->frontFace(GL_CCW);
 		}
 
 		if (keys['W'])
 		{
-			glFrontFace(GL_CW);
+			GLStateCache::getInstance()->frontFace(GL_CW);
 		}
 
 		// Draw 3D
@@ -395,8 +404,8 @@ int main() {
 		// Setting up Material
 		shader->setInt("material.diffuse", 0);
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, diffuseMap);
+		GLStateCache::getInstance()->activeTexture(GL_TEXTURE0);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap);
 
 		shader->setFloat("material.shininess", mat.Shininess);
 
@@ -464,7 +473,7 @@ int main() {
 		shader->setMat4("view", view);
 		shader->setMat4("projection", projection);
 
-		glBindVertexArray(VAO_plane);
+		GLStateCache::getInstance()->bindVertexArray(VAO_plane);
 
 		glm::mat4 model;
 		model = glm::scale(model, glm::vec3(5.0f));
@@ -473,10 +482,10 @@ int main() {
 		
 		glDrawArrays(GL_TRIANGLES, 0, 6);
 		
-		glBindVertexArray(VAO_cube);
+		GLStateCache::getInstance()->bindVertexArray(VAO_cube);
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, diffuseMap_cube);
+		GLStateCache::getInstance()->activeTexture(GL_TEXTURE0);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap_cube);
 
 		for (int i = 0; i < 2; i++)
 		{
@@ -487,12 +496,14 @@ int main() {
 			glDrawArrays(GL_TRIANGLES, 0, 36);
 		}
 
-		glBindVertexArray(0);
+		GLStateCache::getInstance()->bindVertexArray(0);
 
 #if USING_DIFFUSE_MAP
-		glBindTexture(GL_TEXTURE_2D, 0);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
 #endif
 
+		Benchmark::getInstance()->EndFrame(window);
+
 		// Swap the buffers
 		glfwSwapBuffers(window);
 	}
@@ -505,6 +516,10 @@ int main() {
 
 	ShaderManager::Destroy();
 
+	Benchmark::Destroy();
+
+	GLStateCache::Destroy();
+
 	// Terminate before close
 	glfwTerminate();
 
@@ -11,6 +11,8 @@
 
 #include "ShaderManager.h"
 #include "Shader.h"
+#include "GLStateCache.h"
+#include "Benchmark.h"
 #include "Camera.h"
 #include "Material.h"
 #include "Light.h"
@@ -51,6 +53,11 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 		glfwSetWindowShouldClose(window, GL_TRUE);
 	}
 
+	// F5 rebuilds the shared shaders whose sources changed on disk
+	if (key == GLFW_KEY_F5 && action == GLFW_PRESS) {
+		std::cout << ShaderManager::getInstance()->reloadChangedShaders() << " shader(s) reloaded" << std::endl;
+	}
+
 	if (action == GLFW_PRESS)
 		keys[key] = true;
 	else if (action == GLFW_RELEASE)
@@ -92,9 +99,10 @@ void do_movement() {
 		camera.ProcessKeyboard(CameraMovement::RIGHT, deltaTime);
 }
 
-int main() {
+int main(int argc, char* argv[]) {
 
 	glfwInit();
+	Benchmark::Init(argc, argv);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -147,7 +155,7 @@ int main() {
 	GLuint VAO_plane;
 	glGenVertexArrays(1, &VAO_plane);
 
-	glBindVertexArray(VAO_plane);
+	GLStateCache::getInstance()->bindVertexArray(VAO_plane);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO_plane);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(plane_vertices), plane_vertices, GL_STATIC_DRAW);
 
@@ -163,7 +171,7 @@ int main() {
 	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
 	glEnableVertexAttribArray(2);
 
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 
 	// 3D cube
 	GLfloat cube_vertices[] = {
@@ -217,7 +225,7 @@ int main() {
 	GLuint VAO_cube;
 	glGenVertexArrays(1, &VAO_cube);
 
-	glBindVertexArray(VAO_cube);
+	GLStateCache::getInstance()->bindVertexArray(VAO_cube);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO_cube);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(cube_vertices), cube_vertices, GL_STATIC_DRAW);
 
@@ -233,7 +241,7 @@ int main() {
 	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
 	glEnableVertexAttribArray(2);
 
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 
 
 	// setting up Textures
@@ -244,7 +252,7 @@ int main() {
 
 	glGenTextures(1, &diffuseMap);
 
-	glBindTexture(GL_TEXTURE_2D, diffuseMap);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap);
 	// Set Texture Parameters
 	// Set Wrap function
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
@@ -259,7 +267,7 @@ int main() {
 
 	stbi_image_free(image);
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
 
 	// Texture Container
 	image = stbi_load("Resources/textures/container2.png", &t_width, &t_height, 0, STBI_rgb);
@@ -268,7 +276,7 @@ int main() {
 
 	glGenTextures(1, &diffuseMap_cube);
 
-	glBindTexture(GL_TEXTURE_2D, diffuseMap_cube);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap_cube);
 	// Set Texture Parameters
 	// Set Wrap function
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
@@ -283,31 +291,31 @@ int main() {
 
 	stbi_image_free(image);
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
 
 	// Setup light VAO
 	GLuint lightVAO;
 	glGenVertexArrays(1, &lightVAO);
 
-	glBindVertexArray(lightVAO);
+	GLStateCache::getInstance()->bindVertexArray(lightVAO);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO_plane);
 
 	// Position attributes
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)0);
 	glEnableVertexAttribArray(0);
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 
 	// FRAME BUFFER
 
 	// Setup Frame Buffer
 	unsigned int framebuffer;
 	glGenFramebuffers(1, &framebuffer);
-	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	GLStateCache::getInstance()->bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
 
 	// create a color attachment texture
 	unsigned int textureColorbuffer;
 	glGenTextures(1, &textureColorbuffer);
-	glBindTexture(GL_TEXTURE_2D, textureColorbuffer);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, textureColorbuffer);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -322,7 +330,7 @@ int main() {
 																								  // now that we actually created the framebuffer and added all attachments we want to check if it is actually complete now
 	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
 		std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	GLStateCache::getInstance()->bindFramebuffer(GL_FRAMEBUFFER, 0);
 
 	// Setup quad
 	float quadVertices[] = 
@@ -342,7 +350,7 @@ int main() {
 	GLuint VAO_quad;
 	glGenVertexArrays(1, &VAO_quad);
 
-	glBindVertexArray(VAO_quad);
+	GLStateCache::getInstance()->bindVertexArray(VAO_quad);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO_quad);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
 
@@ -354,7 +362,7 @@ int main() {
 	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (GLvoid*)(2 * sizeof(GLfloat)));
 	glEnableVertexAttribArray(1);
 
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 
 	// Additional Data
 	glm::vec3 cubePositions[] = {
@@ -399,7 +407,7 @@ int main() {
 
 	// Setup
 	// Main loop of drawing
-	glViewport(0, 0, width, height);
+	GLStateCache::getInstance()->viewport(0, 0, width, height);
 
 	// Screen effect mode
 	// 0 : No effect
@@ -415,11 +423,12 @@ int main() {
 
 
 		// calculate delta time
-		GLfloat currentFrame = glfwGetTime();
+		GLfloat currentFrame = Benchmark::getInstance()->getTime();
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
 
 		do_movement();
+		Benchmark::getInstance()->Update(camera);
 		
 		if (keys['0'])
 		{
@@ -442,8 +451,8 @@ int main() {
 		}
 
 		// Draw to off-screen buffer ( First pass )
-		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
-		glEnable(GL_DEPTH_TEST);
+		GLStateCache::getInstance()->bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		GLStateCache::getInstance()->enable(GL_DEPTH_TEST);
 
 		// Rendering commands here
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
@@ -461,8 +470,8 @@ int main() {
 		// Setting up Material
 		shader->setInt("material.diffuse", 0);
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, diffuseMap);
+		GLStateCache::getInstance()->activeTexture(GL_TEXTURE0);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap);
 
 		shader->setFloat("material.shininess", mat.Shininess);
 
@@ -531,7 +540,7 @@ int main() {
 		shader->setMat4("view", view);
 		shader->setMat4("projection", projection);
 
-		glBindVertexArray(VAO_plane);
+		GLStateCache::getInstance()->bindVertexArray(VAO_plane);
 
 		glm::mat4 model;
 		model = glm::scale(model, glm::vec3(5.0f));
@@ -540,10 +549,10 @@ int main() {
 		
 		glDrawArrays(GL_TRIANGLES, 0, 6);
 		
-		glBindVertexArray(VAO_cube);
+		GLStateCache::getInstance()->bindVertexArray(VAO_cube);
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, diffuseMap_cube);
+		GLStateCache::getInstance()->activeTexture(GL_TEXTURE0);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap_cube);
 
 		for (int i = 0; i < 2; i++)
 		{
@@ -554,12 +563,12 @@ int main() {
 			glDrawArrays(GL_TRIANGLES, 0, 36);
 		}
 
-		glBindVertexArray(0);
+		GLStateCache::getInstance()->bindVertexArray(0);
 
-		glBindTexture(GL_TEXTURE_2D, 0);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
 
 		// Second pass: Draw to actual screen
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		GLStateCache::getInstance()->bindFramebuffer(GL_FRAMEBUFFER, 0);
 		glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT);
 
@@ -579,12 +588,14 @@ int main() {
 			break;
 		}
 
-		glBindVertexArray(VAO_quad);
-		glDisable(GL_DEPTH_TEST);
-		glBindTexture(GL_TEXTURE_2D, textureColorbuffer);
+		GLStateCache::getInstance()->bindVertexArray(VAO_quad);
+		GLStateCache::getInstance()->disable(GL_DEPTH_TEST);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, textureColorbuffer);
 		glDrawArrays(GL_TRIANGLES, 0, 6);
 
-		glBindVertexArray(0);
+		GLStateCache::getInstance()->bindVertexArray(0);
+
+		Benchmark::getInstance()->EndFrame(window);
 
 		// Swap the buffers
 		glfwSwapBuffers(window);
@@ -600,6 +611,10 @@ int main() {
 
 	ShaderManager::Destroy();
 
+	Benchmark::Destroy();
+
+	GLStateCache::Destroy();
+
 	// Terminate before close
 	glfwTerminate();
 
@@ -7,6 +7,10 @@
 #include <string>
 
 #include "Shader.h"
+#include "GLStateCache.h"
+#include "Benchmark.h"
+#include "RenderTargetPool.h"
+#include "Profiler.h"
 #include "Camera.h"
 #include "Material.h"
 #include "PointLight.h"
@@ -95,9 +99,10 @@ void do_movement()
 		camera.ProcessKeyboard(CameraMovement::RIGHT, deltaTime);
 }
 
-int main() 
+int main(int argc, char* argv[]) 
 {
 	glfwInit();
+	Benchmark::Init(argc, argv);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -126,6 +131,7 @@ int main()
 
 	// Setup Shaders
 	Shader hdrShader("Shaders/HDR/HDRShader.vs", "Shaders/HDR/HDRToneMappingShader.frag");
+	const unsigned int HDR_TONEMAP = hdrShader.addPermutationDefine("HDR_TONEMAP");
 	Shader shader("Shaders/HDR/Simple3DShader.vs", "Shaders/HDR/Simple3DShader.frag");
 	
 	// Initialize all buffers
@@ -182,7 +188,7 @@ int main()
 
 	glGenVertexArrays(1, &VAO_cube);
 
-	glBindVertexArray(VAO_cube);
+	GLStateCache::getInstance()->bindVertexArray(VAO_cube);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO_cube);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(cube_vertices), cube_vertices, GL_STATIC_DRAW);
 
@@ -198,7 +204,7 @@ int main()
 	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
 	glEnableVertexAttribArray(2);
 
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 
 	// Quad buffer
 	GLfloat quadVertices[] =
@@ -215,37 +221,17 @@ int main()
 	GLuint quadVBO;
 	glGenVertexArrays(1, &quadVAO);
 	glGenBuffers(1, &quadVBO);
-	glBindVertexArray(quadVAO);
+	GLStateCache::getInstance()->bindVertexArray(quadVAO);
 	glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 5, (GLvoid*)0);
 	glEnableVertexAttribArray(1);
 	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 5, (GLvoid*)(sizeof(GLfloat) * 3));
-	glBindVertexArray(0);
-
-	// Configure floating point FrameBuffer
-	GLuint hdrFBO;
-	glGenFramebuffers(1, &hdrFBO);
-	// Create floating point color buffer
-	GLuint colorBuffer;
-	glGenTextures(1, &colorBuffer);
-	glBindTexture(GL_TEXTURE_2D, colorBuffer);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, NULL);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	// create depth buffer (renderbuffer)
-	GLuint rboDepth;
-	glGenRenderbuffers(1, &rboDepth);
-	glBindRenderbuffer(GL_RENDERBUFFER, rboDepth);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, width, height);
-	// attach buffer
-	glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorBuffer, 0);
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rboDepth);
-	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-		std::cout << "Framebuffer not complete!" << std::endl;
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	GLStateCache::getInstance()->bindVertexArray(0);
+
+	// Floating point color with a depth buffer, taken from the pool every frame
+	RenderTargetDesc hdrDesc = { width, height, GL_RGBA16F, 0, GL_DEPTH_COMPONENT24 };
 
 	// Setting up Textures
 	GLuint diffuseMap;
@@ -255,7 +241,7 @@ int main()
 
 	glGenTextures(1, &diffuseMap);
 
-	glBindTexture(GL_TEXTURE_2D, diffuseMap);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap);
 	// Set Texture Parameters
 	// Set Wrap function
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
@@ -270,7 +256,7 @@ int main()
 
 	stbi_image_free(image);
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
 
 	// Setup Lights
 	// Setup Directional Light
@@ -299,31 +285,59 @@ int main()
 	glfwSetKeyCallback(window, key_callback);
 
 	// Setup
-	glEnable(GL_DEPTH_TEST);
+	GLStateCache::getInstance()->enable(GL_DEPTH_TEST);
 
 	bool hdr = true;
 	float exposure = 1.0f; // higher: focus on dark area; lower: focus on bright area
 
+	bool captureKeyDown = false;
+
 	// Main loop of drawing
-	glViewport(0, 0, width, height);
+	GLStateCache::getInstance()->viewport(0, 0, width, height);
 	while (!glfwWindowShouldClose(window)) 
 	{
 		// Check and call events
 		glfwPollEvents();
 
 		// calculate delta time
-		GLfloat currentFrame = glfwGetTime();
+		GLfloat currentFrame = Benchmark::getInstance()->getTime();
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
 
+		Profiler::getInstance()->BeginFrame();
+
+		// Show once per second where the frame went
+		if ((int)currentFrame != (int)(currentFrame - deltaTime))
+		{
+			std::string title = "LearnOpenGL - ms:" + Profiler::getInstance()->getSummary();
+			glfwSetWindowTitle(window, title.c_str());
+		}
+
+		// P starts a profiler capture, the next P writes it as a Chrome trace
+		if (keys[GLFW_KEY_P] && !captureKeyDown)
+		{
+			if (Profiler::getInstance()->isCapturing())
+			{
+				Profiler::getInstance()->StopCapture("HDR_Trace.json");
+			}
+			else
+			{
+				Profiler::getInstance()->StartCapture();
+			}
+		}
+		captureKeyDown = keys[GLFW_KEY_P];
+
 		do_movement();
+		Benchmark::getInstance()->Update(camera);
 
 		// 1. First render Lighted Scene to HDR Frame buffer
-		glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
+		Profiler::getInstance()->Begin("Scene");
+		RenderTarget* hdrTarget = RenderTargetPool::getInstance()->Acquire(hdrDesc, GL_LINEAR);
+		GLStateCache::getInstance()->bindFramebuffer(GL_FRAMEBUFFER, hdrTarget->Framebuffer);
 
 		// Configure shader and matrices
 		// Light Projection
-		glViewport(0, 0, width, height);
+		GLStateCache::getInstance()->viewport(0, 0, width, height);
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -338,8 +352,8 @@ int main()
 		// Setting up Material
 		shader.setInt("material.diffuse", 0);
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, diffuseMap);
+		GLStateCache::getInstance()->activeTexture(GL_TEXTURE0);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap);
 		shader.setInt("diffuseTexture", 0);
 
 		// Setting up Point Light
@@ -354,7 +368,7 @@ int main()
 		shader.setMat4("view", view);
 		shader.setMat4("projection", projection);
 
-		glBindVertexArray(VAO_cube);
+		GLStateCache::getInstance()->bindVertexArray(VAO_cube);
 
 		glm::mat4 model;
 		model = glm::translate(model, glm::vec3(0.0f, 0.0f, 25.0f));
@@ -367,31 +381,42 @@ int main()
 
 		shader.setBool("reverse_normals", false);
 
-		glBindVertexArray(0);
+		GLStateCache::getInstance()->bindVertexArray(0);
 
-		glBindTexture(GL_TEXTURE_2D, 0);
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
+		GLStateCache::getInstance()->bindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		Profiler::getInstance()->End();
 
 		// 2. Render HDR Frame buffer to screen
-		glViewport(0, 0, width, height);
+		Profiler::getInstance()->Begin("Tonemap");
+		GLStateCache::getInstance()->viewport(0, 0, width, height);
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		glBindVertexArray(quadVAO);
+		GLStateCache::getInstance()->bindVertexArray(quadVAO);
 
-		hdrShader.Use();
+		hdrShader.Use(hdr ? HDR_TONEMAP : 0);
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, colorBuffer);
+		GLStateCache::getInstance()->activeTexture(GL_TEXTURE0);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, hdrTarget->Texture);
 		hdrShader.setInt("hdrBuffer", 0);
 
-		hdrShader.setBool("hdr", hdr);
 		hdrShader.setFloat("exposure", exposure);
 
 		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 
-		glBindVertexArray(0);
-		glBindTexture(GL_TEXTURE_2D, 0);
+		GLStateCache::getInstance()->bindVertexArray(0);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
+
+		Profiler::getInstance()->End();
+
+		RenderTargetPool::getInstance()->Release(hdrTarget);
+		RenderTargetPool::getInstance()->EndFrame();
+
+		Profiler::getInstance()->EndFrame();
+
+		Benchmark::getInstance()->EndFrame(window);
 
 		// Swap the buffers
 		glfwSwapBuffers(window);
@@ -400,12 +425,17 @@ int main()
 	// Deleting Buffer vertex array, vertex buffer and Element Buffer
 	glDeleteVertexArrays(1, &VAO_cube);
 	glDeleteBuffers(1, &VBO_cube);
-	glDeleteRenderbuffers(1, &rboDepth);
-	glDeleteTextures(1, &colorBuffer);
-	glDeleteFramebuffers(1, &hdrFBO);
 	glDeleteBuffers(1, &quadVBO);
 	glDeleteVertexArrays(1, &quadVAO);
 
+	RenderTargetPool::Destroy();
+
+	Profiler::Destroy();
+
+	Benchmark::Destroy();
+
+	GLStateCache::Destroy();
+
 	// Terminate before close
 	glfwTerminate();
 
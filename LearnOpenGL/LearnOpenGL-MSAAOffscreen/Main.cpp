@@ -11,6 +11,9 @@
 
 #include "ShaderManager.h"
 #include "Shader.h"
+#include "GLStateCache.h"
+#include "Benchmark.h"
+#include "RenderTargetPool.h"
 #include "Camera.h"
 #include "Material.h"
 #include "Light.h"
@@ -37,7 +40,10 @@ int width, height;
 
 // input callback function
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode) {
-	
+	// F5 rebuilds the shared shaders whose sources changed on disk
+	if (key == GLFW_KEY_F5 && action == GLFW_PRESS) {
+		std::cout << ShaderManager::getInstance()->reloadChangedShaders() << " shader(s) reloaded" << std::endl;
+	}
 }
 
 void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
@@ -51,9 +57,10 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
 void do_movement() {
 }
 
-int main() {
+int main(int argc, char* argv[]) {
 
 	glfwInit();
+	Benchmark::Init(argc, argv);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -137,7 +144,7 @@ int main() {
 	GLuint VAO;
 	glGenVertexArrays(1, &VAO);
 
-	glBindVertexArray(VAO);
+	GLStateCache::getInstance()->bindVertexArray(VAO);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(cube_vertices), cube_vertices, GL_STATIC_DRAW);
 
@@ -153,7 +160,7 @@ int main() {
 	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
 	glEnableVertexAttribArray(2);
 
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 
 	// Setup quad
 	float quadVertices[] =
@@ -173,7 +180,7 @@ int main() {
 	GLuint VAO_quad;
 	glGenVertexArrays(1, &VAO_quad);
 
-	glBindVertexArray(VAO_quad);
+	GLStateCache::getInstance()->bindVertexArray(VAO_quad);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO_quad);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
 
@@ -185,7 +192,7 @@ int main() {
 	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (GLvoid*)(2 * sizeof(GLfloat)));
 	glEnableVertexAttribArray(1);
 
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 
 	// Setup Textures
 
@@ -197,7 +204,7 @@ int main() {
 
 	glGenTextures(1, &diffuseMap);
 
-	glBindTexture(GL_TEXTURE_2D, diffuseMap);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap);
 	// Set Texture Parameters
 	// Set Wrap function
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
@@ -214,58 +221,10 @@ int main() {
 
 
 	// SETUP FRAME BUFFER
-	unsigned int multiSampleFrameBuffer;
-	glGenFramebuffers(1, &multiSampleFrameBuffer);
-	glBindFramebuffer(GL_FRAMEBUFFER, multiSampleFrameBuffer);
-
-	// Create a color attachment texture
+	// Multisampled color and depth-stencil to draw into, resolved into a plain texture to sample
 	const int samples = 4;
-	unsigned int textureColorBufferMultisampled;
-	glGenTextures(1, &textureColorBufferMultisampled);
-	glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, textureColorBufferMultisampled);
-	glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, samples, GL_RGB, width, height, GL_TRUE);
-	glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D_MULTISAMPLE, textureColorBufferMultisampled, 0);
-
-	// create a render buffer
-	unsigned int multisampleRBO;
-	glGenRenderbuffers(1, &multisampleRBO);
-	glBindRenderbuffer(GL_RENDERBUFFER, multisampleRBO);
-	glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH24_STENCIL8, width, height);
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, multisampleRBO);
-
-	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-		std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-	// intermediate frame buffer
-	unsigned int intermediateFrameBuffer;
-	glGenFramebuffers(1, &intermediateFrameBuffer);
-	glBindFramebuffer(GL_FRAMEBUFFER, intermediateFrameBuffer);
-
-	// Create a color attachment texture
-	unsigned int textureColorbuffer;
-	glGenTextures(1, &textureColorbuffer);
-	glBindTexture(GL_TEXTURE_2D, textureColorbuffer);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textureColorbuffer, 0);
-
-	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-		std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-	// create a render buffer
-	unsigned int intermedateRBO;
-	glGenRenderbuffers(1, &intermedateRBO);
-	glBindRenderbuffer(GL_RENDERBUFFER, intermedateRBO);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, intermedateRBO);
-
-	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-		std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	RenderTargetDesc multiSampleDesc = { width, height, GL_RGB8, samples, GL_DEPTH24_STENCIL8 };
+	RenderTargetDesc resolveDesc = { width, height, GL_RGB8, 0, GL_NONE };
 
 	// set mouse callbacks
 	glfwSetCursorPosCallback(window, mouse_callback);
@@ -280,21 +239,23 @@ int main() {
 	glm::mat4 view = glm::lookAt(glm::vec3(1.0f, 0.75f, -1.0f), glm::vec3(), glm::vec3(0.0f, 1.0f, 0.0f));
 
 	// Main loop of drawing
-	glViewport(0, 0, width, height);
+	GLStateCache::getInstance()->viewport(0, 0, width, height);
 	while (!glfwWindowShouldClose(window)) {
 		// Check and call events
 		glfwPollEvents();
 
 		// calculate delta time
-		GLfloat currentFrame = glfwGetTime();
+		GLfloat currentFrame = Benchmark::getInstance()->getTime();
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
 
 		do_movement();
 
 		// 1. Draw to off-screen multi sample frame buffer (First pass)
-		glBindFramebuffer(GL_FRAMEBUFFER, multiSampleFrameBuffer);
-		glEnable(GL_DEPTH_TEST);
+		RenderTarget* multiSampleTarget = RenderTargetPool::getInstance()->Acquire(multiSampleDesc);
+		RenderTarget* resolveTarget = RenderTargetPool::getInstance()->Acquire(resolveDesc, GL_LINEAR);
+		GLStateCache::getInstance()->bindFramebuffer(GL_FRAMEBUFFER, multiSampleTarget->Framebuffer);
+		GLStateCache::getInstance()->enable(GL_DEPTH_TEST);
 
 		// Rendering commands here
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
@@ -310,33 +271,39 @@ int main() {
 
 		drawShader->setInt("material.diffuse", 0);
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, diffuseMap);
+		GLStateCache::getInstance()->activeTexture(GL_TEXTURE0);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap);
 
-		glBindVertexArray(VAO);
+		GLStateCache::getInstance()->bindVertexArray(VAO);
 		glDrawArrays(GL_TRIANGLES, 0, 36);
-		glBindVertexArray(0);
+		GLStateCache::getInstance()->bindVertexArray(0);
 
-		glBindTexture(GL_TEXTURE_2D, 0);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
 
 		// 2. now blit multisampled buffer(s) to normal colorbuffer if intermediate FBO.
-		glBindFramebuffer(GL_READ_FRAMEBUFFER, multiSampleFrameBuffer);
-		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, intermediateFrameBuffer);
+		GLStateCache::getInstance()->bindFramebuffer(GL_READ_FRAMEBUFFER, multiSampleTarget->Framebuffer);
+		GLStateCache::getInstance()->bindFramebuffer(GL_DRAW_FRAMEBUFFER, resolveTarget->Framebuffer);
 		glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
 
 		// 3. Draw Intermediate to actual screen
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		GLStateCache::getInstance()->bindFramebuffer(GL_FRAMEBUFFER, 0);
 		glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT);
 
 		BaseScreenShader.Use();
 
-		glBindVertexArray(VAO_quad);
-		glDisable(GL_DEPTH_TEST);
-		glBindTexture(GL_TEXTURE_2D, textureColorbuffer);
+		GLStateCache::getInstance()->bindVertexArray(VAO_quad);
+		GLStateCache::getInstance()->disable(GL_DEPTH_TEST);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, resolveTarget->Texture);
 		glDrawArrays(GL_TRIANGLES, 0, 6);
 
-		glBindVertexArray(0);
+		GLStateCache::getInstance()->bindVertexArray(0);
+
+		RenderTargetPool::getInstance()->Release(multiSampleTarget);
+		RenderTargetPool::getInstance()->Release(resolveTarget);
+		RenderTargetPool::getInstance()->EndFrame();
+
+		Benchmark::getInstance()->EndFrame(window);
 
 		// Swap the buffers
 		glfwSwapBuffers(window);
@@ -347,8 +314,14 @@ int main() {
 	glDeleteBuffers(1, &VBO);
 	glDeleteTextures(1, &diffuseMap);
 
+	RenderTargetPool::Destroy();
+
 	ShaderManager::Destroy();
 
+	Benchmark::Destroy();
+
+	GLStateCache::Destroy();
+
 	// Terminate before close
 	glfwTerminate();
 
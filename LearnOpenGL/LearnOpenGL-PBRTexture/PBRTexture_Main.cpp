@@ -11,6 +11,8 @@
 #include <vector>
 
 #include "Shader.h"
+#include "GLStateCache.h"
+#include "Benchmark.h"
 #include "Camera.h"
 #include "Material.h"
 #include "Light.h"
@@ -112,7 +114,7 @@ unsigned int loadTexture(char const * path)
 		else if (nrComponents == 4)
 			format = GL_RGBA;
 
-		glBindTexture(GL_TEXTURE_2D, textureID);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, textureID);
 		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, image);
 		
 		glGenerateMipmap(GL_TEXTURE_2D);
@@ -132,9 +134,10 @@ unsigned int loadTexture(char const * path)
 	return textureID;
 }
 
-int main() 
+int main(int argc, char* argv[]) 
 {
 	glfwInit();
+	Benchmark::Init(argc, argv);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -242,7 +245,7 @@ int main()
 				data.push_back(normals[i].z);
 			}
 		}
-		glBindVertexArray(sphereVAO);
+		GLStateCache::getInstance()->bindVertexArray(sphereVAO);
 		glBindBuffer(GL_ARRAY_BUFFER, sphereVBO);
 		glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(float), &data[0], GL_STATIC_DRAW);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sphereEBO);
@@ -301,37 +304,38 @@ int main()
 	glfwSetKeyCallback(window, key_callback);
 
 	// Setup
-	glEnable(GL_DEPTH_TEST);
+	GLStateCache::getInstance()->enable(GL_DEPTH_TEST);
 
 	// Main loop of drawing
-	glViewport(0, 0, width, height);
+	GLStateCache::getInstance()->viewport(0, 0, width, height);
 	while (!glfwWindowShouldClose(window)) 
 	{
 		// Check and call events
 		glfwPollEvents();
 
 		// calculate delta time
-		GLfloat currentFrame = glfwGetTime();
+		GLfloat currentFrame = Benchmark::getInstance()->getTime();
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
 
 		do_movement();
+		Benchmark::getInstance()->Update(camera);
 
 		// Rendering commands here
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 		PBRShader.Use();
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, albedoMap);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, normalMap);
-		glActiveTexture(GL_TEXTURE2);
-		glBindTexture(GL_TEXTURE_2D, metalicMap);
-		glActiveTexture(GL_TEXTURE3);
-		glBindTexture(GL_TEXTURE_2D, roughnessMap);
-		glActiveTexture(GL_TEXTURE4);
-		glBindTexture(GL_TEXTURE_2D, aoMap);
+		GLStateCache::getInstance()->activeTexture(GL_TEXTURE0);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, albedoMap);
+		GLStateCache::getInstance()->activeTexture(GL_TEXTURE1);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, normalMap);
+		GLStateCache::getInstance()->activeTexture(GL_TEXTURE2);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, metalicMap);
+		GLStateCache::getInstance()->activeTexture(GL_TEXTURE3);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, roughnessMap);
+		GLStateCache::getInstance()->activeTexture(GL_TEXTURE4);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, aoMap);
 
 		PBRShader.setInt("albedoMap", 0);
 		PBRShader.setInt("normalMap", 1);
@@ -345,7 +349,7 @@ int main()
 		PBRShader.setVec3("camPos", camera.Position);
 
 		// Draw
-		glBindVertexArray(sphereVAO);
+		GLStateCache::getInstance()->bindVertexArray(sphereVAO);
 
 		for (unsigned int i = 0; i < sizeof(lightPositions) / sizeof(lightPositions[0]); ++i)
 		{
@@ -370,6 +374,8 @@ int main()
 			}
 		}
 
+		Benchmark::getInstance()->EndFrame(window);
+
 		// Swap the buffers
 		glfwSwapBuffers(window);
 	}
@@ -379,6 +385,10 @@ int main()
 	glDeleteBuffers(1, &sphereEBO);
 	glDeleteBuffers(1, &sphereVBO);
 
+	Benchmark::Destroy();
+
+	GLStateCache::Destroy();
+
 	// Terminate before close
 	glfwTerminate();
 
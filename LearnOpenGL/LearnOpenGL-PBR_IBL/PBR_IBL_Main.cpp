@@ -11,6 +11,10 @@
 #include <vector>
 
 #include "Shader.h"
+#include "GLStateCache.h"
+#include "Benchmark.h"
+#include "RenderTargetPool.h"
+#include "DynamicResolution.h"
 #include "Camera.h"
 #include "Material.h"
 #include "Light.h"
@@ -118,7 +122,7 @@ GLuint loadHDRImage(const char* imagePath)
 	if (data)
 	{
 		glGenTextures(1, &hdrTexture);
-		glBindTexture(GL_TEXTURE_2D, hdrTexture);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, hdrTexture);
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, width, height, 0, GL_RGB, GL_FLOAT, data);
 
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -153,7 +157,7 @@ GLuint loadTexture(char const * path)
 		else if (nrComponents == 4)
 			format = GL_RGBA;
 
-		glBindTexture(GL_TEXTURE_2D, textureID);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, textureID);
 		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, image);
 
 		glGenerateMipmap(GL_TEXTURE_2D);
@@ -181,35 +185,35 @@ void drawTexturedSphere(TexturedSphere* sphere, Shader* shader)
 	shader->setMat4("model", model);
 
 	shader->setInt("albedoMap", 3);
-	glActiveTexture(GL_TEXTURE3);
-	glBindTexture(GL_TEXTURE_2D, sphere->albedoMap);
+	GLStateCache::getInstance()->activeTexture(GL_TEXTURE3);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, sphere->albedoMap);
 
 	shader->setInt("normalMap", 4);
-	glActiveTexture(GL_TEXTURE4);
-	glBindTexture(GL_TEXTURE_2D, sphere->normalMap);
+	GLStateCache::getInstance()->activeTexture(GL_TEXTURE4);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, sphere->normalMap);
 
 	shader->setInt("metalicMap", 5);
-	glActiveTexture(GL_TEXTURE5);
-	glBindTexture(GL_TEXTURE_2D, sphere->metalicMap);
+	GLStateCache::getInstance()->activeTexture(GL_TEXTURE5);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, sphere->metalicMap);
 
 	shader->setInt("roughnessMap", 6);
-	glActiveTexture(GL_TEXTURE6);
-	glBindTexture(GL_TEXTURE_2D, sphere->roughnessMap);
+	GLStateCache::getInstance()->activeTexture(GL_TEXTURE6);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, sphere->roughnessMap);
 
 	shader->setInt("aoMap", 7);
-	glActiveTexture(GL_TEXTURE7);
-	glBindTexture(GL_TEXTURE_2D, sphere->aoMap);
+	GLStateCache::getInstance()->activeTexture(GL_TEXTURE7);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, sphere->aoMap);
 
-	glBindVertexArray(sphere->VAO);
+	GLStateCache::getInstance()->bindVertexArray(sphere->VAO);
 	glDrawElements(GL_TRIANGLE_STRIP, sphere->indexCount, GL_UNSIGNED_INT, 0);
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 }
 
 GLuint generateCubeMap()
 {
 	GLuint cubeMap;
 	glGenTextures(1, &cubeMap);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, cubeMap);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_CUBE_MAP, cubeMap);
 	for (unsigned int i = 0; i < 6; i++)
 	{
 		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 512, 512, 0, GL_RGB, GL_FLOAT, nullptr);
@@ -223,9 +227,10 @@ GLuint generateCubeMap()
 	return cubeMap;
 }
 
-int main() 
+int main(int argc, char* argv[]) 
 {
 	glfwInit();
+	Benchmark::Init(argc, argv);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -254,12 +259,12 @@ int main()
 	glfwGetFramebufferSize(window, &width, &height);
 
 	// global openGL state
-	glEnable(GL_DEPTH_TEST);
+	GLStateCache::getInstance()->enable(GL_DEPTH_TEST);
 
 	// Enable Cubemap seamless interpolation between faces
-	glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+	GLStateCache::getInstance()->enable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
 
-	glDepthFunc(GL_LEQUAL);
+	GLStateCache::getInstance()->depthFunc(GL_LEQUAL);
 
 	// Setup Shaders
 	Shader PBRShader("Shaders/PBR/PBRShader.vs", "Shaders/PBR/PBRShader_IBL.frag");
@@ -347,7 +352,7 @@ int main()
 				data.push_back(normals[i].z);
 			}
 		}
-		glBindVertexArray(sphereVAO);
+		GLStateCache::getInstance()->bindVertexArray(sphereVAO);
 		glBindBuffer(GL_ARRAY_BUFFER, sphereVBO);
 		glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(float), &data[0], GL_STATIC_DRAW);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sphereEBO);
@@ -416,7 +421,7 @@ int main()
 	glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 	// link vertex attributes
-	glBindVertexArray(cubeVAO);
+	GLStateCache::getInstance()->bindVertexArray(cubeVAO);
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
 	glEnableVertexAttribArray(1);
@@ -424,7 +429,7 @@ int main()
 	glEnableVertexAttribArray(2);
 	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 
 	// Setup Quad VBO/VAO
 	GLfloat quadVertices[] =
@@ -440,14 +445,14 @@ int main()
 	GLuint quadVBO;
 	glGenVertexArrays(1, &quadVAO);
 	glGenBuffers(1, &quadVBO);
-	glBindVertexArray(quadVAO);
+	GLStateCache::getInstance()->bindVertexArray(quadVAO);
 	glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 5, (GLvoid*)0);
 	glEnableVertexAttribArray(1);
 	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 5, (GLvoid*)(sizeof(GLfloat) * 3));
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 
 	// Setting up Textures
 	GLuint hdrTexture = loadHDRImage("Resources/textures/PBR/EnvMap/Footprint_Court_2k.hdr");
@@ -457,7 +462,7 @@ int main()
 	glGenFramebuffers(1, &captureFBO);
 	glGenRenderbuffers(1, &captureRBO);
 
-	glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+	GLStateCache::getInstance()->bindFramebuffer(GL_FRAMEBUFFER, captureFBO);
 	glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
 	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 512, 512);
 	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, captureRBO);
@@ -477,11 +482,11 @@ int main()
 	equirectangularToCubeMapShader.Use();
 	equirectangularToCubeMapShader.setInt("equirectangularMap", 0);
 	equirectangularToCubeMapShader.setMat4("projection", captureProjection);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, hdrTexture);
+	GLStateCache::getInstance()->activeTexture(GL_TEXTURE0);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, hdrTexture);
 
-	glViewport(0, 0, 512, 512);
-	glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+	GLStateCache::getInstance()->viewport(0, 0, 512, 512);
+	GLStateCache::getInstance()->bindFramebuffer(GL_FRAMEBUFFER, captureFBO);
 	for (unsigned int i = 0; i < 6; i++)
 	{
 		equirectangularToCubeMapShader.setMat4("view", captureViews[i]);
@@ -489,21 +494,21 @@ int main()
 
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		glBindVertexArray(cubeVAO);
+		GLStateCache::getInstance()->bindVertexArray(cubeVAO);
 		glDrawArrays(GL_TRIANGLES, 0, 36);
-		glBindVertexArray(0);
+		GLStateCache::getInstance()->bindVertexArray(0);
 	}
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	GLStateCache::getInstance()->bindFramebuffer(GL_FRAMEBUFFER, 0);
 
 	// Generate mipmap after env cube map converted
-	glBindTexture(GL_TEXTURE_CUBE_MAP, envCubeMap);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_CUBE_MAP, envCubeMap);
 	glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
 	
 	// Create and Compute Irradiance Diffuse Map
 	GLuint irradianceMap;
 	glGenTextures(1, &irradianceMap);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceMap);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_CUBE_MAP, irradianceMap);
 	for (GLuint i = 0; i < 6; i++)
 	{
 		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 32, 32, 0, GL_RGB, GL_FLOAT, nullptr);
@@ -514,34 +519,34 @@ int main()
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	
-	glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+	GLStateCache::getInstance()->bindFramebuffer(GL_FRAMEBUFFER, captureFBO);
 	glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
 	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 32, 32);
 
 	irradianceShader.Use();
 	irradianceShader.setInt("environmentMap", 0);
 	irradianceShader.setMat4("projection", captureProjection);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, envCubeMap);
+	GLStateCache::getInstance()->activeTexture(GL_TEXTURE0);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_CUBE_MAP, envCubeMap);
 
-	glViewport(0, 0, 32, 32);
-	glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+	GLStateCache::getInstance()->viewport(0, 0, 32, 32);
+	GLStateCache::getInstance()->bindFramebuffer(GL_FRAMEBUFFER, captureFBO);
 	for (GLuint i = 0; i < 6; i++)
 	{
 		irradianceShader.setMat4("view", captureViews[i]);
 		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, irradianceMap, 0);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		glBindVertexArray(cubeVAO);
+		GLStateCache::getInstance()->bindVertexArray(cubeVAO);
 		glDrawArrays(GL_TRIANGLES, 0, 36);
-		glBindVertexArray(0);
+		GLStateCache::getInstance()->bindVertexArray(0);
 	}
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	GLStateCache::getInstance()->bindFramebuffer(GL_FRAMEBUFFER, 0);
 
 	// Create and Compute Pre-filtered map of the environment map
 	GLuint prefilterMap;
 	glGenTextures(1, &prefilterMap);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, prefilterMap);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_CUBE_MAP, prefilterMap);
 	for (unsigned int i = 0; i < 6; i++)
 	{
 		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 128, 128, 0, GL_RGB, GL_FLOAT, nullptr);
@@ -557,10 +562,10 @@ int main()
 	prefilterShader.Use();
 	prefilterShader.setInt("environmentMap", 0);
 	prefilterShader.setMat4("projection", captureProjection);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, envCubeMap);
+	GLStateCache::getInstance()->activeTexture(GL_TEXTURE0);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_CUBE_MAP, envCubeMap);
 
-	glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+	GLStateCache::getInstance()->bindFramebuffer(GL_FRAMEBUFFER, captureFBO);
 	unsigned int maxMipLevels = 5;
 	for (unsigned int mip = 0; mip < maxMipLevels; ++mip)
 	{
@@ -569,7 +574,7 @@ int main()
 		unsigned int mipHeight = 128 >> mip;
 		glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
 		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, mipWidth, mipHeight);
-		glViewport(0, 0, mipWidth, mipHeight);
+		GLStateCache::getInstance()->viewport(0, 0, mipWidth, mipHeight);
 
 		float roughness = (float)mip / (float)(maxMipLevels - 1);
 		prefilterShader.setFloat("roughness", roughness);
@@ -580,39 +585,39 @@ int main()
 
 			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 			
-			glBindVertexArray(cubeVAO);
+			GLStateCache::getInstance()->bindVertexArray(cubeVAO);
 			glDrawArrays(GL_TRIANGLES, 0, 36);
-			glBindVertexArray(0);
+			GLStateCache::getInstance()->bindVertexArray(0);
 		}
 	}
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	GLStateCache::getInstance()->bindFramebuffer(GL_FRAMEBUFFER, 0);
 
 	// Create and compute brdf LUT map
 	GLuint brdfLUTTexture;
 	glGenTextures(1, &brdfLUTTexture);
 
 	// prea-allocate enough memory for the LUT texture
-	glBindTexture(GL_TEXTURE_2D, brdfLUTTexture);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, brdfLUTTexture);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, 512, 512, 0, GL_RG, GL_FLOAT, 0);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-	glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+	GLStateCache::getInstance()->bindFramebuffer(GL_FRAMEBUFFER, captureFBO);
 	glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
 	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 512, 512);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, brdfLUTTexture, 0);
 
-	glViewport(0, 0, 512, 512);
+	GLStateCache::getInstance()->viewport(0, 0, 512, 512);
 	brdfShader.Use();
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	glBindVertexArray(quadVAO);
+	GLStateCache::getInstance()->bindVertexArray(quadVAO);
 	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	GLStateCache::getInstance()->bindFramebuffer(GL_FRAMEBUFFER, 0);
 
 	// Setup Textured Sphere
 	const int texturedSpheresCount = 5;
@@ -694,19 +699,48 @@ int main()
 	// set key callbacks
 	glfwSetKeyCallback(window, key_callback);
 
+	// Render below window size when the GPU cannot hold 60 fps, upscale to the window
+	DynamicResolution* dynamicResolution = new DynamicResolution(width, height, 1000.0 / 60.0);
+
+	// Golden images need the same pixels on every run, the scale holds still
+	dynamicResolution->setLocked(Benchmark::getInstance()->isComparingImages());
+
 	// Main loop of drawing
-	glViewport(0, 0, width, height);
+	GLStateCache::getInstance()->viewport(0, 0, width, height);
 	while (!glfwWindowShouldClose(window)) 
 	{
 		// Check and call events
 		glfwPollEvents();
 
 		// calculate delta time
-		GLfloat currentFrame = glfwGetTime();
+		GLfloat currentFrame = Benchmark::getInstance()->getTime();
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
 
 		do_movement();
+		Benchmark::getInstance()->Update(camera);
+
+		// Show once per second how many uniform uploads the last frame issued and skipped
+		if ((int)currentFrame != (int)(currentFrame - deltaTime))
+		{
+			const UniformStats& uniformStats = Shader::getUniformStats();
+			const GLStateStats& stateStats = GLStateCache::getInstance()->getStats();
+			std::string title = "LearnOpenGL - uniforms issued: " + std::to_string(uniformStats.Issued) + " skipped: " + std::to_string(uniformStats.Skipped) +
+				" | state changes issued: " + std::to_string(stateStats.Issued) + " requested: " + std::to_string(stateStats.Requested);
+			const DynamicResolutionStats& resolutionStats = dynamicResolution->getStats();
+			title += " | " + std::to_string(resolutionStats.Width) + "x" + std::to_string(resolutionStats.Height) +
+				" GPU " + std::to_string(resolutionStats.AverageMilliseconds) + " ms, " + DynamicResolution::getDecisionName(resolutionStats.Decision);
+			glfwSetWindowTitle(window, title.c_str());
+		}
+		Shader::resetUniformStats();
+		GLStateCache::getInstance()->resetStats();
+
+		dynamicResolution->BeginFrame();
+
+		RenderTargetDesc sceneDesc = { dynamicResolution->getWidth(), dynamicResolution->getHeight(), GL_RGBA8, 0, GL_DEPTH_COMPONENT24 };
+		RenderTarget* sceneTarget = RenderTargetPool::getInstance()->Acquire(sceneDesc, GL_LINEAR);
+		GLStateCache::getInstance()->bindFramebuffer(GL_FRAMEBUFFER, sceneTarget->Framebuffer);
+		GLStateCache::getInstance()->viewport(0, 0, sceneDesc.Width, sceneDesc.Height);
 
 		// Rendering commands here
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
@@ -724,18 +758,18 @@ int main()
 
 		// Bind the irradiance map
 		PBRShader.setInt("irradianceMap", 0);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceMap);
+		GLStateCache::getInstance()->activeTexture(GL_TEXTURE0);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_CUBE_MAP, irradianceMap);
 
 		// Bind prefilterMap
 		PBRShader.setInt("prefilterMap", 1);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_CUBE_MAP, prefilterMap);
+		GLStateCache::getInstance()->activeTexture(GL_TEXTURE1);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_CUBE_MAP, prefilterMap);
 
 		// Bind brdfLUT
 		PBRShader.setInt("brdfLUT", 2);
-		glActiveTexture(GL_TEXTURE2);
-		glBindTexture(GL_TEXTURE_2D, brdfLUTTexture);
+		GLStateCache::getInstance()->activeTexture(GL_TEXTURE2);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, brdfLUTTexture);
 
 		for (unsigned int i = 0; i < sizeof(lightPositions) / sizeof(lightPositions[0]); ++i)
 		{
@@ -744,7 +778,7 @@ int main()
 		}
 
 		// Draw
-		glBindVertexArray(sphereVAO);
+		GLStateCache::getInstance()->bindVertexArray(sphereVAO);
 		
 		for (int row = 0; row < nrRows; row++)
 		{
@@ -773,18 +807,18 @@ int main()
 
 		// Bind the irradiance map
 		PBRTextureShader.setInt("irradianceMap", 0);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceMap);
+		GLStateCache::getInstance()->activeTexture(GL_TEXTURE0);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_CUBE_MAP, irradianceMap);
 
 		// Bind prefilterMap
 		PBRTextureShader.setInt("prefilterMap", 1);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_CUBE_MAP, prefilterMap);
+		GLStateCache::getInstance()->activeTexture(GL_TEXTURE1);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_CUBE_MAP, prefilterMap);
 
 		// Bind brdfLUT
 		PBRTextureShader.setInt("brdfLUT", 2);
-		glActiveTexture(GL_TEXTURE2);
-		glBindTexture(GL_TEXTURE_2D, brdfLUTTexture);
+		GLStateCache::getInstance()->activeTexture(GL_TEXTURE2);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, brdfLUTTexture);
 
 		for (unsigned int i = 0; i < sizeof(lightPositions) / sizeof(lightPositions[0]); ++i)
 		{
@@ -800,11 +834,19 @@ int main()
 		backgroundShader.Use();
 		backgroundShader.setMat4("projection", projection);
 		backgroundShader.setMat4("view", view);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_CUBE_MAP, envCubeMap);
-		glBindVertexArray(cubeVAO);
+		GLStateCache::getInstance()->activeTexture(GL_TEXTURE0);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_CUBE_MAP, envCubeMap);
+		GLStateCache::getInstance()->bindVertexArray(cubeVAO);
 		glDrawArrays(GL_TRIANGLES, 0, 36);
-		glBindVertexArray(0);
+		GLStateCache::getInstance()->bindVertexArray(0);
+
+		dynamicResolution->Upscale(sceneTarget->Framebuffer);
+		RenderTargetPool::getInstance()->Release(sceneTarget);
+		RenderTargetPool::getInstance()->EndFrame();
+
+		dynamicResolution->EndFrame();
+
+		Benchmark::getInstance()->EndFrame(window);
 
 		// Swap the buffers
 		glfwSwapBuffers(window);
@@ -827,6 +869,14 @@ int main()
 		glDeleteTextures(1, &texturedSpheres[i].aoMap);
 	}
 
+	delete dynamicResolution;
+
+	RenderTargetPool::Destroy();
+
+	Benchmark::Destroy();
+
+	GLStateCache::Destroy();
+
 	// Terminate before close
 	glfwTerminate();
 
@@ -2,8 +2,13 @@
 #include <GLFW/glfw3.h>
 
 #include <iostream>
+#include <string>
 
 #include "Shader.h"
+#include "GLStateCache.h"
+#include "Benchmark.h"
+#include "RenderTargetPool.h"
+#include "DynamicResolution.h"
 #include "Camera.h"
 #include "Material.h"
 #include "PointLight.h"
@@ -109,7 +114,7 @@ void do_movement()
 
 void renderScene(Shader& shader)
 {
-	glBindVertexArray(VAO_plane);
+	GLStateCache::getInstance()->bindVertexArray(VAO_plane);
 
 	glm::mat4 model = glm::mat4();
 	model = glm::scale(model, glm::vec3(20.0f));
@@ -118,10 +123,10 @@ void renderScene(Shader& shader)
 
 	glDrawArrays(GL_TRIANGLES, 0, 6);
 
-	glBindVertexArray(VAO_cube);
+	GLStateCache::getInstance()->bindVertexArray(VAO_cube);
 
-	glActiveTexture(GL_TEXTURE1);
-	glBindTexture(GL_TEXTURE_2D, diffuseMap_cube);
+	GLStateCache::getInstance()->activeTexture(GL_TEXTURE1);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap_cube);
 	shader.setInt("material.diffuse", 1);
 
 	for (int i = 0; i < cubeCount; i++)
@@ -133,13 +138,14 @@ void renderScene(Shader& shader)
 		glDrawArrays(GL_TRIANGLES, 0, 36);
 	}
 
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 }
 
-int main()
+int main(int argc, char* argv[])
 {
 
 	glfwInit();
+	Benchmark::Init(argc, argv);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -242,7 +248,7 @@ int main()
 	GLuint VAO_quad;
 	glGenVertexArrays(1, &VAO_quad);
 
-	glBindVertexArray(VAO_quad);
+	GLStateCache::getInstance()->bindVertexArray(VAO_quad);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO_quad);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(quad_vertices), quad_vertices, GL_STATIC_DRAW);
 
@@ -266,7 +272,7 @@ int main()
 	glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(GLfloat), (GLvoid*)(11 * sizeof(GLfloat)));
 	glEnableVertexAttribArray(4);
 
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 
 	// Setting up Textures
@@ -283,7 +289,7 @@ int main()
 #endif
 	glGenTextures(1, &diffuseMap);
 
-	glBindTexture(GL_TEXTURE_2D, diffuseMap);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap);
 
 	// Set Texture Parameters
 	// Set Wrap function
@@ -301,7 +307,7 @@ int main()
 
 	stbi_image_free(image);
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
 
 	// Normal Maps
 	GLuint normalMap;
@@ -312,7 +318,7 @@ int main()
 #endif
 	glGenTextures(1, &normalMap);
 
-	glBindTexture(GL_TEXTURE_2D, normalMap);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, normalMap);
 
 	// Set Texture Parameters and Wrap Functiion
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
@@ -327,7 +333,7 @@ int main()
 
 	stbi_image_free(image);
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
 
 	// Displacement Maps
 	GLuint dispMap;
@@ -340,7 +346,7 @@ int main()
 
 	glGenTextures(1, &dispMap);
 
-	glBindTexture(GL_TEXTURE_2D, dispMap);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, dispMap);
 
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_MIRRORED_REPEAT);
@@ -353,7 +359,7 @@ int main()
 
 	stbi_image_free(image);
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
 
 	// Setup Lights
 	// Setup Directional Light
@@ -368,23 +374,46 @@ int main()
 	glfwSetKeyCallback(window, key_callback);
 
 	// Setup
-	glEnable(GL_DEPTH_TEST);
+	GLStateCache::getInstance()->enable(GL_DEPTH_TEST);
 
 	bool renderDebugDepth = false;
 
+	// Render below window size when the GPU cannot hold 60 fps, upscale to the window
+	DynamicResolution* dynamicResolution = new DynamicResolution(width, height, 1000.0 / 60.0);
+
+	// Golden images need the same pixels on every run, the scale holds still
+	dynamicResolution->setLocked(Benchmark::getInstance()->isComparingImages());
+
 	// Main loop of drawing
-	glViewport(0, 0, width, height);
+	GLStateCache::getInstance()->viewport(0, 0, width, height);
 	while (!glfwWindowShouldClose(window))
 	{
 		// Check and call events
 		glfwPollEvents();
 
 		// calculate delta time
-		GLfloat currentFrame = (GLfloat)glfwGetTime();
+		GLfloat currentFrame = (GLfloat)Benchmark::getInstance()->getTime();
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
 
 		do_movement();
+		Benchmark::getInstance()->Update(camera);
+
+		// Show once per second what the resolution controller decided
+		if ((int)currentFrame != (int)(currentFrame - deltaTime))
+		{
+			const DynamicResolutionStats& resolutionStats = dynamicResolution->getStats();
+			std::string title = "LearnOpenGL - " + std::to_string(resolutionStats.Width) + "x" + std::to_string(resolutionStats.Height) +
+				" GPU " + std::to_string(resolutionStats.AverageMilliseconds) + " ms, " + DynamicResolution::getDecisionName(resolutionStats.Decision);
+			glfwSetWindowTitle(window, title.c_str());
+		}
+
+		dynamicResolution->BeginFrame();
+
+		RenderTargetDesc sceneDesc = { dynamicResolution->getWidth(), dynamicResolution->getHeight(), GL_RGBA8, 0, GL_DEPTH_COMPONENT24 };
+		RenderTarget* sceneTarget = RenderTargetPool::getInstance()->Acquire(sceneDesc, GL_LINEAR);
+		GLStateCache::getInstance()->bindFramebuffer(GL_FRAMEBUFFER, sceneTarget->Framebuffer);
+		GLStateCache::getInstance()->viewport(0, 0, sceneDesc.Width, sceneDesc.Height);
 
 		// Draw
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
@@ -413,27 +442,35 @@ int main()
 
 		parallaxMapShader.setFloat("shininess", 8.0f);
 
-		glBindVertexArray(VAO_quad);
+		GLStateCache::getInstance()->bindVertexArray(VAO_quad);
 
 		// Bind Diffuse Map
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, diffuseMap);
+		GLStateCache::getInstance()->activeTexture(GL_TEXTURE0);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap);
 		parallaxMapShader.setInt("diffuseMap", 0);
 
 		// Normal Map
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, normalMap);
+		GLStateCache::getInstance()->activeTexture(GL_TEXTURE1);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, normalMap);
 		parallaxMapShader.setInt("normalMap", 1);
 
 		// Displacement Map
-		glActiveTexture(GL_TEXTURE2);
-		glBindTexture(GL_TEXTURE_2D, dispMap);
+		GLStateCache::getInstance()->activeTexture(GL_TEXTURE2);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, dispMap);
 		parallaxMapShader.setInt("displacementMap", 2);
 
 		glDrawArrays(GL_TRIANGLES, 0, 6);
 
-		glBindTexture(GL_TEXTURE_2D, 0);
-		glBindVertexArray(0);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
+		GLStateCache::getInstance()->bindVertexArray(0);
+
+		dynamicResolution->Upscale(sceneTarget->Framebuffer);
+		RenderTargetPool::getInstance()->Release(sceneTarget);
+		RenderTargetPool::getInstance()->EndFrame();
+
+		dynamicResolution->EndFrame();
+
+		Benchmark::getInstance()->EndFrame(window);
 
 		// Swap the buffers
 		glfwSwapBuffers(window);
@@ -446,6 +483,14 @@ int main()
 	glDeleteTextures(1, &normalMap);
 	glDeleteTextures(1, &dispMap);
 
+	delete dynamicResolution;
+
+	RenderTargetPool::Destroy();
+
+	Benchmark::Destroy();
+
+	GLStateCache::Destroy();
+
 	// Terminate before close
 	glfwTerminate();
 
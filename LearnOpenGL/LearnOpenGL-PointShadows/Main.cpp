@@ -6,6 +6,8 @@
 #include <fstream>
 
 #include "Shader.h"
+#include "GLStateCache.h"
+#include "Benchmark.h"
 #include "Camera.h"
 #include "Material.h"
 #include "PointLight.h"
@@ -112,22 +114,22 @@ void do_movement()
 
 void renderScene(Shader& shader)
 {
-	glBindVertexArray(VAO_cube);
+	GLStateCache::getInstance()->bindVertexArray(VAO_cube);
 
 	glm::mat4 model;
 	model = glm::scale(model, glm::vec3(15.0f));
 
-	glDisable(GL_CULL_FACE);
+	GLStateCache::getInstance()->disable(GL_CULL_FACE);
 	shader.setBool("reverse_normals", true);
 
 	shader.setMat4("model", model);
 	glDrawArrays(GL_TRIANGLES, 0, 36);
 
 	shader.setBool("reverse_normals", false);
-	glEnable(GL_CULL_FACE);
+	GLStateCache::getInstance()->enable(GL_CULL_FACE);
 
- 	glActiveTexture(GL_TEXTURE1);
- 	glBindTexture(GL_TEXTURE_2D, diffuseMap_cube);
+ 	GLStateCache::getInstance()->activeTexture(GL_TEXTURE1);
+ 	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap_cube);
  	shader.setInt("material.diffuse", 1);
 
 	for (int i = 0; i < cubeCounts; i++)
@@ -139,12 +141,13 @@ void renderScene(Shader& shader)
 		glDrawArrays(GL_TRIANGLES, 0, 36);
 	}
 
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 }
 
-int main() 
+int main(int argc, char* argv[]) 
 {
 	glfwInit();
+	Benchmark::Init(argc, argv);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -228,7 +231,7 @@ int main()
 
 	glGenVertexArrays(1, &VAO_cube);
 
-	glBindVertexArray(VAO_cube);
+	GLStateCache::getInstance()->bindVertexArray(VAO_cube);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO_cube);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(cube_vertices), cube_vertices, GL_STATIC_DRAW);
 
@@ -244,7 +247,7 @@ int main()
 	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
 	glEnableVertexAttribArray(2);
 
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 
 	// Depth Map : Shadow Map FBO
 	unsigned int depthMapFBO;
@@ -255,7 +258,7 @@ int main()
 
 	unsigned int depthCubeMap;
 	glGenTextures(1, &depthCubeMap);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, depthCubeMap);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_CUBE_MAP, depthCubeMap);
 	for(unsigned int i = 0; i < 6; i++)
 		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_DEPTH_COMPONENT, 
 			SHADOW_WIDTH, SHADOW_HEIGHT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
@@ -266,11 +269,11 @@ int main()
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
 
-	glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
+	GLStateCache::getInstance()->bindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
 	glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthCubeMap, 0);
 	glDrawBuffer(GL_NONE);
 	glReadBuffer(GL_NONE);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	GLStateCache::getInstance()->bindFramebuffer(GL_FRAMEBUFFER, 0);
 
 	// Setting up Textures
 	int t_width, t_height;
@@ -278,7 +281,7 @@ int main()
 
 	glGenTextures(1, &diffuseMap);
 
-	glBindTexture(GL_TEXTURE_2D, diffuseMap);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap);
 	// Set Texture Parameters
 	// Set Wrap function
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
@@ -293,13 +296,13 @@ int main()
 
 	stbi_image_free(image);
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
 
 	// Texture Container
 	image = stbi_load("Resources/textures/container2.png", &t_width, &t_height, 0, STBI_rgb);
 	glGenTextures(1, &diffuseMap_cube);
 
-	glBindTexture(GL_TEXTURE_2D, diffuseMap_cube);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap_cube);
 	// Set Texture Parameters
 	// Set Wrap function
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
@@ -314,7 +317,7 @@ int main()
 
 	stbi_image_free(image);
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
 
 	// Setup Lights
 	// Setup Directional Light
@@ -330,16 +333,16 @@ int main()
 	glfwSetKeyCallback(window, key_callback);
 
 	// Setup
-	glEnable(GL_DEPTH_TEST);
+	GLStateCache::getInstance()->enable(GL_DEPTH_TEST);
 
 	// Main loop of drawing
-	glViewport(0, 0, width, height);
+	GLStateCache::getInstance()->viewport(0, 0, width, height);
 	while (!glfwWindowShouldClose(window)) {
 		// Check and call events
 		glfwPollEvents();
 
 		// calculate delta time
-		GLfloat currentFrame = glfwGetTime();
+		GLfloat currentFrame = Benchmark::getInstance()->getTime();
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
 
@@ -347,10 +350,11 @@ int main()
 		pointLight.Position.z = sin(currentFrame * 0.5f) * 3.0f;
 
 		do_movement();
+		Benchmark::getInstance()->Update(camera);
 
 		// 1. First render to depth map
-		glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
-		glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
+		GLStateCache::getInstance()->viewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
+		GLStateCache::getInstance()->bindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
 		glClear(GL_DEPTH_BUFFER_BIT);
 
 		// Configure shader and matrices
@@ -386,14 +390,14 @@ int main()
 		pointShadowDepthShader.setFloat("far_plane", far_plane);
 
 
-		glCullFace(GL_FRONT); // Generate shadow based on GL_Front cull, to prevent Peter Panning
+		GLStateCache::getInstance()->cullFace(GL_FRONT); // Generate shadow based on GL_Front cull, to prevent Peter Panning
 		renderScene(pointShadowDepthShader);
-		glCullFace(GL_BACK);
+		GLStateCache::getInstance()->cullFace(GL_BACK);
 
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		GLStateCache::getInstance()->bindFramebuffer(GL_FRAMEBUFFER, 0);
 
 		// 2. then render scene as normal with shadow mapping (using depth map)
-		glViewport(0, 0, width, height);
+		GLStateCache::getInstance()->viewport(0, 0, width, height);
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -408,12 +412,13 @@ int main()
 		// Setting up Material
 		shaderWithShadow.setInt("material.diffuse", 0);
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_CUBE_MAP, depthCubeMap);
-		shaderWithShadow.setInt("shadowMap", 0);
+		// A unit of its own: the sampler2Ds left unset stay on unit 0, and a samplerCube sharing it fails the draw
+		GLStateCache::getInstance()->activeTexture(GL_TEXTURE2);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_CUBE_MAP, depthCubeMap);
+		shaderWithShadow.setInt("shadowMap", 2);
 
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, diffuseMap);
+		GLStateCache::getInstance()->activeTexture(GL_TEXTURE1);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap);
 		shaderWithShadow.setInt("material.diffuse", 1);
 
 		shaderWithShadow.setFloat("material.shininess", mat.Shininess);
@@ -435,7 +440,9 @@ int main()
 
 		renderScene(shaderWithShadow);
 
-		glBindTexture(GL_TEXTURE_2D, 0);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
+
+		Benchmark::getInstance()->EndFrame(window);
 
 		// Swap the buffers
 		glfwSwapBuffers(window);
@@ -447,6 +454,10 @@ int main()
 	glDeleteTextures(1, &depthCubeMap);
 	glDeleteFramebuffers(1, &depthMapFBO);
 
+	Benchmark::Destroy();
+
+	GLStateCache::Destroy();
+
 	// Terminate before close
 	glfwTerminate();
 
@@ -8,10 +8,16 @@
 #include <random>
 
 #include "Shader.h"
+#include "GLStateCache.h"
+#include "Benchmark.h"
 #include "Camera.h"
 #include "Material.h"
 #include "PointLight.h"
 #include "Model.h"
+#include "RenderGraph.h"
+#include "RenderTargetPool.h"
+#include "DynamicResolution.h"
+#include "Profiler.h"
 
 #include "stb_image.h"
 
@@ -102,9 +108,10 @@ float lerp(float a, float b, float f)
 	return a + f * (b - a);
 }
 
-int main() 
+int main(int argc, char* argv[]) 
 {
 	glfwInit();
+	Benchmark::Init(argc, argv);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -158,7 +165,7 @@ int main()
 
 	glGenVertexArrays(1, &VAO_plane);
 
-	glBindVertexArray(VAO_plane);
+	GLStateCache::getInstance()->bindVertexArray(VAO_plane);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO_plane);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(plane_vertices), plane_vertices, GL_STATIC_DRAW);
 
@@ -174,7 +181,7 @@ int main()
 	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
 	glEnableVertexAttribArray(2);
 
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 
 	// Quad buffer
 	GLfloat quadVertices[] =
@@ -194,14 +201,14 @@ int main()
 	GLuint quadVBO;
 	glGenVertexArrays(1, &quadVAO);
 	glGenBuffers(1, &quadVBO);
-	glBindVertexArray(quadVAO);
+	GLStateCache::getInstance()->bindVertexArray(quadVAO);
 	glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 5, (GLvoid*)0);
 	glEnableVertexAttribArray(1);
 	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(GLfloat) * 5, (GLvoid*)(sizeof(GLfloat) * 3));
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 
 	// Setting up Diffuse Map
 	int t_width, t_height;
@@ -211,7 +218,7 @@ int main()
 
 	glGenTextures(1, &diffuseMap);
 
-	glBindTexture(GL_TEXTURE_2D, diffuseMap);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap);
 	// Set Texture Parameters
 	// Set Wrap function
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
@@ -233,7 +240,7 @@ int main()
 
 	glGenTextures(1, &specularMap);
 
-	glBindTexture(GL_TEXTURE_2D, specularMap);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, specularMap);
 	// Set Texture Parameters
 	// Set Wrap function
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
@@ -248,84 +255,6 @@ int main()
 
 	stbi_image_free(image);
 
-	// Configure GBuffer
-	GLuint gBuffer;
-	glGenFramebuffers(1, &gBuffer);
-	glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
-	GLuint gPosition, gNormal, gColorSpec;
-
-	// - position color buffer
-	glGenTextures(1, &gPosition);
-	glBindTexture(GL_TEXTURE_2D, gPosition);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, width, height, 0, GL_RGB, GL_FLOAT, NULL);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, gPosition, 0);
-
-	// - normal color buffer
-	glGenTextures(1, &gNormal);
-	glBindTexture(GL_TEXTURE_2D, gNormal);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, width, height, 0, GL_RGB, GL_FLOAT, NULL);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, gNormal, 0);
-
-	// - color + specular color buffer
-	glGenTextures(1, &gColorSpec);
-	glBindTexture(GL_TEXTURE_2D, gColorSpec);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, gColorSpec, 0);
-
-	// create depth buffer (renderbuffer)
-	GLuint rboDepth;
-	glGenRenderbuffers(1, &rboDepth);
-	glBindRenderbuffer(GL_RENDERBUFFER, rboDepth);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, width, height);
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rboDepth);
-	
-	unsigned int attachments[3] = { GL_COLOR_ATTACHMENT0 , GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
-	glDrawBuffers(3, attachments);
-	
-	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-		std::cout << "Framebuffer not complete!" << std::endl;
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-	// Create SSAO Frame Buffer
-	GLuint ssaoFBO;
-	glGenFramebuffers(1, &ssaoFBO);
-	glBindFramebuffer(GL_FRAMEBUFFER, ssaoFBO);
-
-	GLuint ssaoColorBuffer;
-	glGenTextures(1, &ssaoColorBuffer);
-	glBindTexture(GL_TEXTURE_2D, ssaoColorBuffer);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, width, height, 0, GL_RGB, GL_FLOAT, NULL);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, ssaoColorBuffer, 0);
-
-	// Create SSAO Blur Frame Buffer
-	GLuint ssaoBlurFBO;
-	glGenFramebuffers(1, &ssaoBlurFBO);
-	glBindFramebuffer(GL_FRAMEBUFFER, ssaoBlurFBO);
-
-	GLuint ssaoColorBufferBlur;
-	glGenTextures(1, &ssaoColorBufferBlur);
-	glBindTexture(GL_TEXTURE_2D, ssaoColorBufferBlur);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, width, height, 0, GL_RGB, GL_FLOAT, NULL);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, ssaoColorBufferBlur, 0);
-
 	// Setup Light
 	// Light attributes
 	const unsigned int NR_LIGHTS = 32;
@@ -369,7 +298,7 @@ int main()
 	// Setup SSA Noise Texture
 	GLuint noiseTexture;
 	glGenTextures(1, &noiseTexture);
-	glBindTexture(GL_TEXTURE_2D, noiseTexture);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, noiseTexture);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, 4, 4, 0, GL_RGB, GL_FLOAT, &ssaNoise[0]);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -397,154 +326,299 @@ int main()
 	glfwSetKeyCallback(window, key_callback);
 
 	// Setup
-	glEnable(GL_DEPTH_TEST);
+	GLStateCache::getInstance()->enable(GL_DEPTH_TEST);
 
-	// Main loop of drawing
-	glViewport(0, 0, width, height);
-	while (!glfwWindowShouldClose(window)) 
+	glm::mat4 view;
+	glm::mat4 projection;
+
+	// G-buffer, SSAO, blur, lighting, upscale when rendering below window size
+	RenderGraph* graph = new RenderGraph();
+
+	// Render below window size when the GPU cannot hold 60 fps
+	DynamicResolution* dynamicResolution = new DynamicResolution(width, height, 1000.0 / 60.0);
+
+	// Golden images need the same pixels on every run, the scale holds still
+	dynamicResolution->setLocked(Benchmark::getInstance()->isComparingImages());
+	int renderWidth = width;
+	int renderHeight = height;
+
+	RenderGraphResource gPosition, gNormal, gColorSpec, ssaoColor, ssaoBlur, lit;
+	auto build_graph = [&]()
 	{
-		// Check and call events
-		glfwPollEvents();
+		graph->Reset();
 
-		// calculate delta time
-		GLfloat currentFrame = glfwGetTime();
-		deltaTime = currentFrame - lastFrame;
-		lastFrame = currentFrame;
+		RenderGraphTextureDesc vectorDesc = { renderWidth, renderHeight, GL_RGB16F, GL_NEAREST };
+		RenderGraphTextureDesc colorDesc = { renderWidth, renderHeight, GL_RGBA8, GL_NEAREST };
+		RenderGraphTextureDesc depthDesc = { renderWidth, renderHeight, GL_DEPTH_COMPONENT24, GL_NEAREST };
+		RenderGraphTextureDesc occlusionDesc = { renderWidth, renderHeight, GL_R8, GL_NEAREST };
+		RenderGraphTextureDesc litDesc = { renderWidth, renderHeight, GL_RGBA8, GL_LINEAR };
 
-		do_movement();
+		// Below window size the lighting goes to a texture that is stretched over the window
+		bool scaled = renderWidth != width || renderHeight != height;
 
 		// 1. Geometry Pass. Note: This SSAO implemented in ViewSpace so gPosition and gNormal must be in View-Space as well
-		glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
+		graph->AddPass("GBuffer", [&](RenderGraphBuilder& builder)
+		{
+			gPosition = builder.Create("Position", vectorDesc);
+			gNormal = builder.Create("Normal", vectorDesc);
+			gColorSpec = builder.Create("ColorSpec", colorDesc);
+			builder.Create("Depth", depthDesc);
+		},
+		[&](const RenderGraph&)
+		{
+			glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		// Configure shader and matrices
-		// Light Projection
-		glViewport(0, 0, width, height);
-		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			// Draw Objects
+			geometryPassShader.Use();
+			geometryPassShader.setMat4("view", view);
+			geometryPassShader.setMat4("projection", projection);
 
-		glm::mat4 view = camera.GetViewMatrix();
-		glm::mat4 projection = glm::perspective(camera.Zoom, width / (float)height, 0.1f, 100.0f);
+			glm::mat4 model;
+			model = glm::translate(model, glm::vec3(0.0f, 0.5f, 3.0f));
+			model = glm::scale(model, glm::vec3(0.4f));
+			model = glm::rotate(model, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
 
-		// Draw Objects
-		geometryPassShader.Use();
-		geometryPassShader.setMat4("view", view);
-		geometryPassShader.setMat4("projection", projection);
+			geometryPassShader.setMat4("model", model);
+			ourModel.Draw(&geometryPassShader);
 
-		glm::mat4 model;
-		model = glm::translate(model, glm::vec3(0.0f, 0.5f, 3.0f));
-		model = glm::scale(model, glm::vec3(0.4f));
-		model = glm::rotate(model, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+			// Draw Planes
+			GLStateCache::getInstance()->bindVertexArray(VAO_plane);
 
-		geometryPassShader.setMat4("model", model);
-		ourModel.Draw(&geometryPassShader);
+			GLStateCache::getInstance()->activeTexture(GL_TEXTURE0);
+			GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap);
 
-		// Draw Planes
-		glBindVertexArray(VAO_plane);
+			GLStateCache::getInstance()->activeTexture(GL_TEXTURE1);
+			GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, specularMap);
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, diffuseMap);
+			model = glm::mat4();
+			model = glm::scale(model, glm::vec3(5.0f));
+			geometryPassShader.setMat4("model", model);
 
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, specularMap);
+			glDrawArrays(GL_TRIANGLES, 0, 6);
 
-		model = glm::mat4();
-		model = glm::scale(model, glm::vec3(5.0f));
-		geometryPassShader.setMat4("model", model);
+			model = glm::translate(model, glm::vec3(0.0f, 1.0f, -1.0f));
+			model = glm::rotate(model, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+			geometryPassShader.setMat4("model", model);
 
-		glDrawArrays(GL_TRIANGLES, 0, 6);
+			glDrawArrays(GL_TRIANGLES, 0, 6);
 
-		model = glm::translate(model, glm::vec3(0.0f, 1.0f, -1.0f));
-		model = glm::rotate(model, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-		geometryPassShader.setMat4("model", model);
+			model = glm::mat4();
+			model = glm::rotate(model, glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+			model = glm::scale(model, glm::vec3(5.0f));
+			model = glm::translate(model, glm::vec3(0.0f, 1.0f, -1.0f));
+			model = glm::rotate(model, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+			geometryPassShader.setMat4("model", model);
+			glDrawArrays(GL_TRIANGLES, 0, 6);
 
-		glDrawArrays(GL_TRIANGLES, 0, 6);
+			GLStateCache::getInstance()->bindVertexArray(0);
+		});
 
-		model = glm::mat4();
-		model = glm::rotate(model, glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-		model = glm::scale(model, glm::vec3(5.0f));
-		model = glm::translate(model, glm::vec3(0.0f, 1.0f, -1.0f));
-		model = glm::rotate(model, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-		geometryPassShader.setMat4("model", model);
-		glDrawArrays(GL_TRIANGLES, 0, 6);
+		// 2. Render SSAO
+		graph->AddPass("SSAO", [&](RenderGraphBuilder& builder)
+		{
+			builder.Read(gPosition);
+			builder.Read(gNormal);
+			ssaoColor = builder.Create("SSAO", occlusionDesc);
+		},
+		[&](const RenderGraph& _graph)
+		{
+			glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+			ssaoShader.Use();
+			ssaoShader.setInt("gPosition", 0);
+			ssaoShader.setInt("gNormal", 1);
+			ssaoShader.setInt("texNoise", 2);
+
+			GLStateCache::getInstance()->activeTexture(GL_TEXTURE0);
+			GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, _graph.getTexture(gPosition));
+			GLStateCache::getInstance()->activeTexture(GL_TEXTURE1);
+			GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, _graph.getTexture(gNormal));
+			GLStateCache::getInstance()->activeTexture(GL_TEXTURE2);
+			GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, noiseTexture);
+
+			ssaoShader.setMat4("projection", projection);
+
+			for (unsigned int i = 0; i < 64; i++)
+			{
+				ssaoShader.setVec3(("samples[" + std::to_string(i) + "]").c_str(), ssaoKernel[i]);
+			}
+
+			glm::vec2 noiseScale = glm::vec2(renderWidth / 4.0f, renderHeight / 4.0f);
+			ssaoShader.setVec2("noiseScale", noiseScale);
+
+			GLStateCache::getInstance()->bindVertexArray(quadVAO);
+			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+			GLStateCache::getInstance()->bindVertexArray(0);
+		});
 
-		glBindVertexArray(0);
+		// 3. SSAO Blur
+		graph->AddPass("SSAOBlur", [&](RenderGraphBuilder& builder)
+		{
+			builder.Read(ssaoColor);
+			ssaoBlur = builder.Create("SSAOBlur", occlusionDesc);
+		},
+		[&](const RenderGraph& _graph)
+		{
+			glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+			ssaoBlurShader.Use();
 
-		// 2. Render SSAO
-		glBindFramebuffer(GL_FRAMEBUFFER, ssaoFBO);
-		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-		ssaoShader.Use();
-		ssaoShader.setInt("gPosition", 0);
-		ssaoShader.setInt("gNormal", 1);
-		ssaoShader.setInt("texNoise", 2);
-
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, gPosition);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, gNormal);
-		glActiveTexture(GL_TEXTURE2);
-		glBindTexture(GL_TEXTURE_2D, noiseTexture);
-
-		ssaoShader.setMat4("projection", projection);
-
-		for (unsigned int i = 0; i < 64; i++)
+			GLStateCache::getInstance()->activeTexture(GL_TEXTURE0);
+			GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, _graph.getTexture(ssaoColor));
+
+			GLStateCache::getInstance()->bindVertexArray(quadVAO);
+			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+			GLStateCache::getInstance()->bindVertexArray(0);
+		});
+
+		// 4. Render Deferred Shading With SSAO
+		graph->AddPass("Lighting", [&](RenderGraphBuilder& builder)
+		{
+			builder.Read(gPosition);
+			builder.Read(gNormal);
+			builder.Read(gColorSpec);
+			builder.Read(ssaoBlur);
+			if (scaled)
+			{
+				lit = builder.Create("Lit", litDesc);
+			}
+			else
+			{
+				builder.WriteBackbuffer();
+			}
+		},
+		[&](const RenderGraph& _graph)
+		{
+			GLStateCache::getInstance()->viewport(0, 0, renderWidth, renderHeight);
+			glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			GLStateCache::getInstance()->bindVertexArray(quadVAO);
+
+			deferredLightPassShader.Use();
+			deferredLightPassShader.setInt("gPosition", 0);
+			deferredLightPassShader.setInt("gNormal", 1);
+			deferredLightPassShader.setInt("gAlbedoSpec", 2);
+			deferredLightPassShader.setInt("ssao", 3);
+
+			// Because SSAO which implemented in View-Space, gPosition and gNormal also in view space
+			// so the light position also need to be in View-Space (multiply by view matrix)
+			deferredLightPassShader.setVec3("light.position", view * glm::vec4(lightPosition, 1.0f));
+			deferredLightPassShader.setVec3("light.Color", lightColor);
+			deferredLightPassShader.setFloat("light.Radius", 10.0f);
+			deferredLightPassShader.setFloat("light.Linear", linear);
+			deferredLightPassShader.setFloat("light.Quadratic", quadratic);
+
+			GLStateCache::getInstance()->activeTexture(GL_TEXTURE0);
+			GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, _graph.getTexture(gPosition));
+			GLStateCache::getInstance()->activeTexture(GL_TEXTURE1);
+			GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, _graph.getTexture(gNormal));
+			GLStateCache::getInstance()->activeTexture(GL_TEXTURE2);
+			GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, _graph.getTexture(gColorSpec));
+			GLStateCache::getInstance()->activeTexture(GL_TEXTURE3);
+			GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, _graph.getTexture(ssaoBlur));
+
+			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+			GLStateCache::getInstance()->bindVertexArray(0);
+			GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
+		});
+
+		// 5. Upscale to the window
+		if (scaled)
 		{
-			ssaoShader.setVec3(("samples[" + std::to_string(i) + "]").c_str(), ssaoKernel[i]);
+			graph->AddPass("Upscale", [&](RenderGraphBuilder& builder)
+			{
+				builder.Read(lit);
+				builder.WriteBackbuffer();
+			},
+			[&](const RenderGraph& _graph)
+			{
+				GLStateCache::getInstance()->viewport(0, 0, width, height);
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+				screenShader.Use();
+				screenShader.setInt("inTexture", 0);
+				GLStateCache::getInstance()->activeTexture(GL_TEXTURE0);
+				GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, _graph.getTexture(lit));
+
+				GLStateCache::getInstance()->bindVertexArray(quadVAO);
+				glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+				GLStateCache::getInstance()->bindVertexArray(0);
+				GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
+			});
 		}
 
-		glm::vec2 noiseScale = glm::vec2(width / 4.0f, height / 4.0f);
-		ssaoShader.setVec2("noiseScale", noiseScale);
+		graph->Compile();
+	};
+	build_graph();
+	graph->printReport("SSAO");
 
-		glBindVertexArray(quadVAO);
-		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-		glBindVertexArray(0);
+	bool captureKeyDown = false;
 
-		// 3. SSAO Blur
-		glBindFramebuffer(GL_FRAMEBUFFER, ssaoBlurFBO);
-		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-		ssaoBlurShader.Use();
+	// Main loop of drawing
+	GLStateCache::getInstance()->viewport(0, 0, width, height);
+	while (!glfwWindowShouldClose(window)) 
+	{
+		// Check and call events
+		glfwPollEvents();
+
+		// calculate delta time
+		GLfloat currentFrame = Benchmark::getInstance()->getTime();
+		deltaTime = currentFrame - lastFrame;
+		lastFrame = currentFrame;
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, ssaoColorBuffer);
+		Profiler::getInstance()->BeginFrame();
 
-		glBindVertexArray(quadVAO);
-		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-		glBindVertexArray(0);
+		// P starts a profiler capture, the next P writes it as a Chrome trace
+		if (keys[GLFW_KEY_P] && !captureKeyDown)
+		{
+			if (Profiler::getInstance()->isCapturing())
+			{
+				Profiler::getInstance()->StopCapture("SSAO_Trace.json");
+			}
+			else
+			{
+				Profiler::getInstance()->StartCapture();
+			}
+		}
+		captureKeyDown = keys[GLFW_KEY_P];
 
-		// 4. Render Deferred Shading With SSAO
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
- 		//glViewport(0, 0, width, height);
- 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		glBindVertexArray(quadVAO);
-
-		deferredLightPassShader.Use();
-		deferredLightPassShader.setInt("gPosition", 0);
-		deferredLightPassShader.setInt("gNormal", 1);
-		deferredLightPassShader.setInt("gAlbedoSpec", 2);
-		deferredLightPassShader.setInt("ssao", 3);
-
-		// Because SSAO which implemented in View-Space, gPosition and gNormal also in view space
-		// so the light position also need to be in View-Space (multiply by view matrix)
-		deferredLightPassShader.setVec3("light.position", view * glm::vec4(lightPosition, 1.0f));
-		deferredLightPassShader.setVec3("light.Color", lightColor);
-		deferredLightPassShader.setFloat("light.Radius", 10.0f);
-		deferredLightPassShader.setFloat("light.Linear", linear);
-		deferredLightPassShader.setFloat("light.Quadratic", quadratic);
-
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, gPosition);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, gNormal);
-		glActiveTexture(GL_TEXTURE2);
-		glBindTexture(GL_TEXTURE_2D, gColorSpec);
-		glActiveTexture(GL_TEXTURE3);
-		glBindTexture(GL_TEXTURE_2D, ssaoColorBufferBlur);
-
-		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-
-		glBindVertexArray(0);
-		glBindTexture(GL_TEXTURE_2D, 0);
+		do_movement();
+		Benchmark::getInstance()->Update(camera);
+
+		// Show once per second what the resolution controller decided
+		if ((int)currentFrame != (int)(currentFrame - deltaTime))
+		{
+			const DynamicResolutionStats& resolutionStats = dynamicResolution->getStats();
+			std::string title = "LearnOpenGL - " + std::to_string(resolutionStats.Width) + "x" + std::to_string(resolutionStats.Height) +
+				" GPU " + std::to_string(resolutionStats.AverageMilliseconds) + " ms, " + DynamicResolution::getDecisionName(resolutionStats.Decision) +
+				" (down " + std::to_string(resolutionStats.Decreases) + ", up " + std::to_string(resolutionStats.Increases) + ") |" +
+				Profiler::getInstance()->getSummary();
+			glfwSetWindowTitle(window, title.c_str());
+		}
+
+		dynamicResolution->BeginFrame();
+
+		if (dynamicResolution->hasChanged())
+		{
+			ProfilerScope scope("BuildGraph", false);
+			renderWidth = dynamicResolution->getWidth();
+			renderHeight = dynamicResolution->getHeight();
+			build_graph();
+		}
+
+		view = camera.GetViewMatrix();
+		projection = glm::perspective(camera.Zoom, width / (float)height, 0.1f, 100.0f);
+
+		graph->Execute();
+
+		RenderTargetPool::getInstance()->EndFrame();
+
+		dynamicResolution->EndFrame();
+
+		Profiler::getInstance()->EndFrame();
+
+		Benchmark::getInstance()->EndFrame(window);
 
 		// Swap the buffers
 		glfwSwapBuffers(window);
@@ -553,20 +627,23 @@ int main()
 	// Deleting Buffer vertex array, vertex buffer and Element Buffer
 	glDeleteVertexArrays(1, &VAO_plane);
 	glDeleteBuffers(1, &VBO_plane);
-	glDeleteRenderbuffers(1, &rboDepth);
-	glDeleteTextures(1, &gPosition);
-	glDeleteTextures(1, &gNormal);
-	glDeleteTextures(1, &gColorSpec);
-	glDeleteFramebuffers(1, &gBuffer);
 	glDeleteBuffers(1, &quadVBO);
 	glDeleteVertexArrays(1, &quadVAO);
-	glDeleteFramebuffers(1, &ssaoFBO);
-	glDeleteFramebuffers(1, &ssaoBlurFBO);
-	glDeleteTextures(1, &ssaoColorBuffer);
-	glDeleteTextures(1, &ssaoColorBufferBlur);
 	glDeleteTextures(1, &diffuseMap);
 	glDeleteTextures(1, &specularMap);
 
+	delete graph;
+
+	delete dynamicResolution;
+
+	RenderTargetPool::Destroy();
+
+	Profiler::Destroy();
+
+	Benchmark::Destroy();
+
+	GLStateCache::Destroy();
+
 	// Terminate before close
 	glfwTerminate();
 
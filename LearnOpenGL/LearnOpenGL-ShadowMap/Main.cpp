@@ -7,6 +7,8 @@
 #include <iostream>
 
 #include "Shader.h"
+#include "GLStateCache.h"
+#include "Benchmark.h"
 #include "Camera.h"
 #include "Material.h"
 #include "DirLight.h"
@@ -104,7 +106,7 @@ void do_movement()
 
 void renderScene(Shader& shader)
 {
-	glBindVertexArray(VAO_plane);
+	GLStateCache::getInstance()->bindVertexArray(VAO_plane);
 
 	glm::mat4 model = glm::mat4();
 	model = glm::scale(model, glm::vec3(20.0f));
@@ -113,10 +115,10 @@ void renderScene(Shader& shader)
 
 	glDrawArrays(GL_TRIANGLES, 0, 6);
 
-	glBindVertexArray(VAO_cube);
+	GLStateCache::getInstance()->bindVertexArray(VAO_cube);
 
-	glActiveTexture(GL_TEXTURE1);
-	glBindTexture(GL_TEXTURE_2D, diffuseMap_cube);
+	GLStateCache::getInstance()->activeTexture(GL_TEXTURE1);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap_cube);
 	shader.setInt("material.diffuse", 1);
 
 	for (int i = 0; i < cubeCount; i++)
@@ -128,13 +130,14 @@ void renderScene(Shader& shader)
 		glDrawArrays(GL_TRIANGLES, 0, 36);
 	}
 
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 }
 
-int main() 
+int main(int argc, char* argv[]) 
 {
 
 	glfwInit();
+	Benchmark::Init(argc, argv);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -167,6 +170,11 @@ int main()
 	Shader simpleDepthShader("Shaders/Shadow/SimpleDepthShader.vs", "Shaders/Shadow/SimpleDepthShader.frag");
 	Shader baseScreenShader("Shaders/ScreenShader.vs", "Shaders/RenderDepthScreenShader.frag");
 	Shader shaderWithShadow("Shaders/Shadow/Shadow.vs", "Shaders/Shadow/Shadow.frag");
+
+	// Shader permutations: compiled variants instead of per pixel branching
+	const unsigned int SHADOW_USE_BLINN = shaderWithShadow.addPermutationDefine("USE_BLINN");
+	const unsigned int SHADOW_USE_PCF = shaderWithShadow.addPermutationDefine("USE_PCF");
+	unsigned int shadowPermutation = SHADOW_USE_PCF;
 	
 	// Initialize all buffers
 	// 3D cube
@@ -188,7 +196,7 @@ int main()
 	// Generate VAO
 	glGenVertexArrays(1, &VAO_plane);
 
-	glBindVertexArray(VAO_plane);
+	GLStateCache::getInstance()->bindVertexArray(VAO_plane);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO_plane);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(plane_vertices), plane_vertices, GL_STATIC_DRAW);
 
@@ -204,7 +212,7 @@ int main()
 	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
 	glEnableVertexAttribArray(2);
 
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 
 	// 3D cube
 	GLfloat cube_vertices[] = 
@@ -259,7 +267,7 @@ int main()
 	// generate VAO
 	glGenVertexArrays(1, &VAO_cube);
 
-	glBindVertexArray(VAO_cube);
+	GLStateCache::getInstance()->bindVertexArray(VAO_cube);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO_cube);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(cube_vertices), cube_vertices, GL_STATIC_DRAW);
 
@@ -275,7 +283,7 @@ int main()
 	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
 	glEnableVertexAttribArray(2);
 
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 
 	// Setup quad
 	float quadVertices[] =
@@ -295,7 +303,7 @@ int main()
 	GLuint VAO_quad;
 	glGenVertexArrays(1, &VAO_quad);
 
-	glBindVertexArray(VAO_quad);
+	GLStateCache::getInstance()->bindVertexArray(VAO_quad);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO_quad);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
 
@@ -307,7 +315,7 @@ int main()
 	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (GLvoid*)(2 * sizeof(GLfloat)));
 	glEnableVertexAttribArray(1);
 
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 
 	// Depth Map : Shadow Map FBO
 	unsigned int depthMapFBO;
@@ -318,7 +326,7 @@ int main()
 
 	unsigned int depthMap;
 	glGenTextures(1, &depthMap);
-	glBindTexture(GL_TEXTURE_2D, depthMap);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, depthMap);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, SHADOW_WIDTH, SHADOW_HEIGHT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -327,11 +335,11 @@ int main()
 	float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
 	glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
 
-	glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
+	GLStateCache::getInstance()->bindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthMap, 0);
 	glDrawBuffer(GL_NONE);
 	glReadBuffer(GL_NONE);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	GLStateCache::getInstance()->bindFramebuffer(GL_FRAMEBUFFER, 0);
 
 	// Setting up Textures
 	int t_width, t_height;
@@ -341,7 +349,7 @@ int main()
 
 	glGenTextures(1, &diffuseMap);
 
-	glBindTexture(GL_TEXTURE_2D, diffuseMap);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap);
 	// Set Texture Parameters
 	// Set Wrap function
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
@@ -356,14 +364,14 @@ int main()
 
 	stbi_image_free(image);
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
 
 	// Texture Container
 	image = stbi_load("Resources/textures/container2.png", &t_width, &t_height, 0, STBI_rgb);
 
 	glGenTextures(1, &diffuseMap_cube);
 
-	glBindTexture(GL_TEXTURE_2D, diffuseMap_cube);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap_cube);
 	// Set Texture Parameters
 	// Set Wrap function
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
@@ -378,7 +386,7 @@ int main()
 
 	stbi_image_free(image);
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
 
 	// Setup Lights
 	// Setup Directional Light
@@ -395,19 +403,19 @@ int main()
 	glfwSetKeyCallback(window, key_callback);
 
 	// Setup
-	glEnable(GL_DEPTH_TEST);
+	GLStateCache::getInstance()->enable(GL_DEPTH_TEST);
 
 	bool renderDebugDepth = false;
 
 	// Main loop of drawing
-	glViewport(0, 0, width, height);
+	GLStateCache::getInstance()->viewport(0, 0, width, height);
 	while (!glfwWindowShouldClose(window)) 
 	{
 		// Check and call events
 		glfwPollEvents();
 
 		// calculate delta time
-		GLfloat currentFrame = (GLfloat)glfwGetTime();
+		GLfloat currentFrame = (GLfloat)Benchmark::getInstance()->getTime();
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
 
@@ -420,11 +428,15 @@ int main()
 			renderDebugDepth = false;
 		}
 
+		// Hold B to switch to Blinn-Phong specular
+		shadowPermutation = keys[GLFW_KEY_B] ? (SHADOW_USE_PCF | SHADOW_USE_BLINN) : SHADOW_USE_PCF;
+
 		do_movement();
+		Benchmark::getInstance()->Update(camera);
 
 		// 1. First render to depth map
-		glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
-		glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
+		GLStateCache::getInstance()->viewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
+		GLStateCache::getInstance()->bindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
 		glClear(GL_DEPTH_BUFFER_BIT);
 
 		// Configure shader and matrices
@@ -438,19 +450,19 @@ int main()
 
 		simpleDepthShader.setMat4("lightSpaceMatrix", lightSpaceMatrix);
 
-		glCullFace(GL_FRONT);
+		GLStateCache::getInstance()->cullFace(GL_FRONT);
 		renderScene(simpleDepthShader);
-		glCullFace(GL_BACK);
+		GLStateCache::getInstance()->cullFace(GL_BACK);
 
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		GLStateCache::getInstance()->bindFramebuffer(GL_FRAMEBUFFER, 0);
 
 		// 2. then render scene as normal with shadow mapping (using depth map)
-		glViewport(0, 0, width, height);
+		GLStateCache::getInstance()->viewport(0, 0, width, height);
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 		// Draw
-		shaderWithShadow.Use();
+		shaderWithShadow.Use(shadowPermutation);
 
 		glm::mat4 view = camera.GetViewMatrix();
 
@@ -460,12 +472,12 @@ int main()
 		// Setting up Material
 		shaderWithShadow.setInt("material.diffuse", 0);
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, depthMap);
+		GLStateCache::getInstance()->activeTexture(GL_TEXTURE0);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, depthMap);
 		shaderWithShadow.setInt("shadowMap", 0);
 
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, diffuseMap);
+		GLStateCache::getInstance()->activeTexture(GL_TEXTURE1);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, diffuseMap);
 		shaderWithShadow.setInt("material.diffuse", 1);
 
 		shaderWithShadow.setFloat("material.shininess", mat.Shininess);
@@ -484,22 +496,24 @@ int main()
 
 		renderScene(shaderWithShadow);
 
-		glBindTexture(GL_TEXTURE_2D, 0);
+		GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, 0);
 
 		if (renderDebugDepth)
 		{
 			baseScreenShader.Use();
 
-			glBindVertexArray(VAO_quad);
-			glDisable(GL_DEPTH_TEST);
-			glBindTexture(GL_TEXTURE_2D, depthMap);
+			GLStateCache::getInstance()->bindVertexArray(VAO_quad);
+			GLStateCache::getInstance()->disable(GL_DEPTH_TEST);
+			GLStateCache::getInstance()->bindTexture(GL_TEXTURE_2D, depthMap);
 			baseScreenShader.setInt("inTexture", 0);
 			glDrawArrays(GL_TRIANGLES, 0, 6);
 
-			glBindVertexArray(0);
-			glEnable(GL_DEPTH_TEST);
+			GLStateCache::getInstance()->bindVertexArray(0);
+			GLStateCache::getInstance()->enable(GL_DEPTH_TEST);
 		}
 
+		Benchmark::getInstance()->EndFrame(window);
+
 		// Swap the buffers
 		glfwSwapBuffers(window);
 	}
@@ -512,6 +526,10 @@ int main()
 	glDeleteTextures(1, &depthMap);
 	glDeleteFramebuffers(1, &depthMapFBO);
 
+	Benchmark::Destroy();
+
+	GLStateCache::Destroy();
+
 	// Terminate before close
 	glfwTerminate();
 
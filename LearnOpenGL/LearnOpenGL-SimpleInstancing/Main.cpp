@@ -11,6 +11,9 @@
 
 #include "ShaderManager.h"
 #include "Shader.h"
+#include "GLStateCache.h"
+#include "Benchmark.h"
+#include "InstanceStream.h"
 #include "Camera.h"
 #include "Material.h"
 #include "Light.h"
@@ -51,6 +54,11 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 		glfwSetWindowShouldClose(window, GL_TRUE);
 	}
 
+	// F5 rebuilds the shared shaders whose sources changed on disk
+	if (key == GLFW_KEY_F5 && action == GLFW_PRESS) {
+		std::cout << ShaderManager::getInstance()->reloadChangedShaders() << " shader(s) reloaded" << std::endl;
+	}
+
 	if (action == GLFW_PRESS)
 		keys[key] = true;
 	else if (action == GLFW_RELEASE)
@@ -92,16 +100,23 @@ void do_movement() {
 		camera.ProcessKeyboard(CameraMovement::RIGHT, deltaTime);
 }
 
-int main() {
+int main(int argc, char* argv[]) {
 
 	glfwInit();
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	Benchmark::Init(argc, argv);
+	// 4.4 for persistently mapped instance data, the demo still runs on 3.3 without it
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 4);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 	glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
 
 	// Create window
 	GLFWwindow* window = glfwCreateWindow(800, 600, "LearnOpenGL", nullptr, nullptr);
+	if (window == nullptr) {
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+		window = glfwCreateWindow(800, 600, "LearnOpenGL", nullptr, nullptr);
+	}
 	if (window == nullptr) {
 		glfwTerminate();
 		std::cout << "Failed to create GLFW window" << std::endl;
@@ -140,11 +155,8 @@ int main() {
 		}
 	}
 
-	unsigned int instanceVBO;
-	glGenBuffers(1, &instanceVBO);
-	glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec2) * 100, &offsetPos[0], GL_STATIC_DRAW);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	// Offsets wobble every frame, written into a ring of three regions
+	InstanceStream* instanceStream = new InstanceStream(sizeof(glm::vec2) * 100);
 
 	// Initialize all buffers
 	float quadVertices[] = {
@@ -164,7 +176,7 @@ int main() {
 	GLuint VAO;
 	glGenVertexArrays(1, &VAO);
 
-	glBindVertexArray(VAO);
+	GLStateCache::getInstance()->bindVertexArray(VAO);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
 
@@ -176,14 +188,11 @@ int main() {
 	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (GLvoid*)(2 * sizeof(GLfloat)));
 	glEnableVertexAttribArray(1);
 
-	// instance Buffer
-	glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), (GLvoid*)(0));
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	// instance Buffer, pointed at this frame's region in the loop
 	glVertexAttribDivisor(2, 1);
 	glEnableVertexAttribArray(2);
 
-	glBindVertexArray(0);
+	GLStateCache::getInstance()->bindVertexArray(0);
 
 	// Setting up Textures
 	
@@ -197,32 +206,57 @@ int main() {
 	glfwSetKeyCallback(window, key_callback);
 
 	// Setup
-	glEnable(GL_DEPTH_TEST);
+	GLStateCache::getInstance()->enable(GL_DEPTH_TEST);
 
 	// Main loop of drawing
-	glViewport(0, 0, width, height);
+	GLStateCache::getInstance()->viewport(0, 0, width, height);
 	while (!glfwWindowShouldClose(window)) {
 		// Check and call events
 		glfwPollEvents();
 
 
 		// calculate delta time
-		GLfloat currentFrame = glfwGetTime();
+		GLfloat currentFrame = Benchmark::getInstance()->getTime();
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
 
 		do_movement();
+		Benchmark::getInstance()->Update(camera);
 
 		// Rendering commands here
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+		// Update the offsets
+		glm::vec2* offsets = static_cast<glm::vec2*>(instanceStream->Map());
+		for (int i = 0; i < 100; i++)
+		{
+			offsets[i] = offsetPos[i] + glm::vec2(sin(currentFrame * 2.0f + i), cos(currentFrame * 2.0f + i)) * 0.01f;
+		}
+		instanceStream->Unmap(sizeof(glm::vec2) * 100);
+
 		// Draw
 		shader.Use();
-		glBindVertexArray(VAO);
+		GLStateCache::getInstance()->bindVertexArray(VAO);
+		glBindBuffer(GL_ARRAY_BUFFER, instanceStream->getBuffer());
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), (GLvoid*)(size_t)instanceStream->getOffset());
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
 		glDrawArraysInstanced(GL_TRIANGLES, 0, 6, 100);
-		glBindVertexArray(0);
+		GLStateCache::getInstance()->bindVertexArray(0);
+		instanceStream->Fence();
+
+		// Once per second, show how long the CPU waited for regions still in use
+		if ((int)currentFrame != (int)(currentFrame - deltaTime))
+		{
+			const InstanceStreamStats& streamStats = instanceStream->getStats();
+			std::string title = std::string("LearnOpenGL - ") + (instanceStream->isPersistent() ? "persistent" : "orphaned") + " instance stream, stalls: "
+				+ std::to_string(streamStats.Stalls) + " / " + std::to_string(streamStats.Frames) + " frames, " + std::to_string(streamStats.TotalStallMilliseconds) + " ms";
+			glfwSetWindowTitle(window, title.c_str());
+			instanceStream->resetStats();
+		}
 		
+		Benchmark::getInstance()->EndFrame(window);
+
 		// Swap the buffers
 		glfwSwapBuffers(window);
 	}
@@ -230,9 +264,14 @@ int main() {
 	// Deleting All Buffers
 	glDeleteVertexArrays(1, &VAO);
 	glDeleteBuffers(1, &VBO);
+	delete instanceStream;
 
 	ShaderManager::Destroy();
 
+	Benchmark::Destroy();
+
+	GLStateCache::Destroy();
+
 	// Terminate before close
 	glfwTerminate();
 
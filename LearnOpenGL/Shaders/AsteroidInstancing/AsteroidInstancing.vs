@@ -3,7 +3,10 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 normal;
 layout (location = 2) in vec2 texCoords;
-layout (location = 3) in mat4 instanceMatrix; // this takes place as 4 vec4
+layout (location = 3) in vec4 instancePositionScale;	// PackedInstance, 2 vec4 instead of a mat4
+layout (location = 4) in vec4 instanceRotation;
+
+#include "../Include/PackedInstance.glsl"
 
 uniform mat4 view;
 uniform mat4 projection;
@@ -14,6 +17,7 @@ out vec2 TexCoords;
 
 void main()
 {
-	gl_Position = projection * view * instanceMatrix * vec4(aPos, 1.0f);
+	vec3 worldPosition = transformPackedInstance(instancePositionScale, instanceRotation, aPos);
+	gl_Position = projection * view * vec4(worldPosition, 1.0f);
 	TexCoords = texCoords;
-}
\ No newline at end of file
+}
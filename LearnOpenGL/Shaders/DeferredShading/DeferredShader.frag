@@ -19,6 +19,7 @@ struct Light
 
 const int NR_LIGHTS = 32;
 uniform Light lights[NR_LIGHTS];
+uniform int nrLights; // lights reaching a visible object, the first ones of lights[]
 uniform vec3 viewPos;
 
 void main()
@@ -32,7 +33,7 @@ void main()
     // then calculate lighting as usual
     vec3 lighting = Albedo * 0.001; // hard-coded ambient component
     vec3 viewDir = normalize(viewPos - FragPos);
-    for(int i=0; i < NR_LIGHTS; i++)
+    for(int i=0; i < nrLights; i++)
     {
         // calculate distance between light source and current fragment
         float distance = length(lights[i].Position - FragPos);
@@ -3,9 +3,13 @@ layout (location=0) in vec3 position;
 layout (location=1) in vec3 normal;
 layout (location=2) in vec2 texCoords;
 
+#ifdef INSTANCED_MODEL
+// Model::DrawIndirect copies
+layout (location=3) in mat4 instanceModel;
+#else
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#endif
+#include "../Include/CameraMatrices.glsl"
 
 out VS_OUT
 {
@@ -16,6 +20,9 @@ out VS_OUT
 
 void main()
 {
+#ifdef INSTANCED_MODEL
+    mat4 model = instanceModel;
+#endif
     gl_Position = projection * view * model * vec4(position, 1.0);
     vs_out.FragPos = vec3(model * vec4(position, 1.0));
     vs_out.Normal = mat3(transpose(inverse(model))) * normal;
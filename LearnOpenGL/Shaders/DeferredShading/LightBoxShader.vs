@@ -2,8 +2,7 @@
 layout (location=0) in vec3 position;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#include "../Include/CameraMatrices.glsl"
 
 void main()
 {
@@ -3,31 +3,29 @@ out vec4 FragColor;
 
 in vec2 TexCoords;
 
+// Permutation define HDR_TONEMAP (injected by Shader::setPermutation) enables exposure tone mapping
+
 uniform sampler2D hdrBuffer;
-uniform bool hdr;
 uniform float exposure;
 
 void main()
 {
 	const float gamma = 2.2;
 	vec3 hdrColor = texture(hdrBuffer, TexCoords).rgb;
-	if(hdr)
-	{
-		// reinhard
-		//vec3 result = hdrColor / (hdrColor + vec3(1.0));
+#ifdef HDR_TONEMAP
+	// reinhard
+	//vec3 result = hdrColor / (hdrColor + vec3(1.0));
 
-		// Exposure tone mapping
-		vec3 result = vec3(1.0) - exp(-hdrColor * exposure);
+	// Exposure tone mapping
+	vec3 result = vec3(1.0) - exp(-hdrColor * exposure);
 
-		// gamma correction
-		result = pow(result, vec3(1.0/gamma));
+	// gamma correction
+	result = pow(result, vec3(1.0/gamma));
 
-		FragColor = vec4(result, 1.0);
-	}
-	else
-	{
-		// gamma correction
-		vec3 result = pow(hdrColor, vec3(1.0/gamma));
-		FragColor = vec4(result, 1.0);
-	}
+	FragColor = vec4(result, 1.0);
+#else
+	// gamma correction
+	vec3 result = pow(hdrColor, vec3(1.0/gamma));
+	FragColor = vec4(result, 1.0);
+#endif
 }
\ No newline at end of file
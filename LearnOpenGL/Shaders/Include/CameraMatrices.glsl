@@ -0,0 +1,6 @@
+// Camera matrices shared by every program through one uniform buffer, see Shader::setUniformBlockBinding
+layout (std140) uniform CameraMatrices
+{
+	mat4 view;
+	mat4 projection;
+};
@@ -0,0 +1,3 @@
+// Shared constants, pulled in with #include "Constants.glsl"
+
+const float PI = 3.14159265359;
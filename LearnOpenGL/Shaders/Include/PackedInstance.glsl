@@ -0,0 +1,10 @@
+// Decoding of the 32 byte PackedInstance: position + uniform scale, rotation quaternion
+vec3 rotateByQuaternion(vec4 q, vec3 v)
+{
+	return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+vec3 transformPackedInstance(vec4 positionScale, vec4 rotation, vec3 localPosition)
+{
+	return positionScale.xyz + positionScale.w * rotateByQuaternion(rotation, localPosition);
+}
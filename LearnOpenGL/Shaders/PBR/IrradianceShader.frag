@@ -4,7 +4,7 @@ in vec3 localPos;
 
 uniform samplerCube environmentMap;
 
-const float PI = 3.14159265359;
+#include "../Include/Constants.glsl"
 
 void main()
 {		
@@ -15,47 +15,7 @@ uniform sampler2D aoMap;
 uniform vec3 lightPositions[4];
 uniform vec3 lightColors[4];
 
-const float PI = 3.14159265359;
-
-vec3 fresnelShlick(float cosTheta, vec3 F0)
-{
-    return F0 + (1.0 - F0) * pow((1.0 - cosTheta), 5);
-}
-
-float DistributionGGX(vec3 N, vec3 H, float roughness)
-{
-    float a = roughness * roughness;
-    float a2 = a * a;
-    float NdotH = max(dot(N,H), 0.0);
-    float NdotH2 = NdotH * NdotH;
-
-    float num = a2;
-    float denom = (NdotH2 * (a2 - 1.0) + 1.0);
-    denom = PI * denom * denom;
-
-    return num / denom;
-}
-
-float GeometrySchlickGGX(float NdotV, float roughness)
-{
-    float r = (roughness + 1.0);
-    float k = (r * r) / 8.0;
-    
-    float num = NdotV;
-    float denom = NdotV * (1 - k) + k;
-
-    return num/denom;
-}
-
-float GeometrySmith(vec3 N, vec3 V, vec3 L, float roughness)
-{
-    float NdotV = max(dot(N,V), 0.0);
-    float NdotL = max(dot(N,L), 0.0);
-    float ggx2 = GeometrySchlickGGX(NdotV, roughness);
-    float ggx1 = GeometrySchlickGGX(NdotL, roughness);
-
-    return ggx1 * ggx2;
-}
+#include "../Include/PBRCommon.glsl"
 
 // Easy trick to get tangent-normal to world-space
 vec3 getNormalFromMap()
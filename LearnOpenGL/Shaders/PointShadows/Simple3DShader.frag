@@ -20,18 +20,7 @@ struct Material {
 	float shininess;
 };
 
-// Point Light
-struct PointLight{
-	vec3 position;
-
-	float constant;
-	float linear;
-	float quadratic;
-
-	vec3 ambient;
-	vec3 diffuse;
-	vec3 specular;
-};
+#include "../Include/Lights.glsl"
 
 out vec4 color;
 
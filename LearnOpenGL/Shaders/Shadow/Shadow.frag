@@ -1,6 +1,10 @@
 #version 330 core
 #define NUMBER_POINT_LIGHTS 4
 
+// Permutation defines (injected by Shader::setPermutation):
+// USE_BLINN        - Blinn-Phong specular instead of Phong
+// USE_PCF          - 3x3 PCF filtered shadow instead of a single hard tap
+
 struct Material {
 	
 	// This is old version, only using ambient and diffuse color
@@ -13,21 +17,13 @@ struct Material {
 	sampler2D diffuse1;
 	sampler2D diffuse2;
 
-	bool useSpecular;
 	sampler2D specular;
 	sampler2D specular1;
 	
 	float shininess;
 };
 
-// Directional light structure
-struct DirLight {
-	vec3 direction;
-
-	vec3 ambient;
-	vec3 diffuse;
-	vec3 specular;
-};
+#include "../Include/Lights.glsl"
 
 out vec4 color;
 
@@ -40,12 +36,6 @@ uniform vec3 viewPos;
 
 uniform DirLight dirLight;
 
-uniform bool useDirLight;
-uniform int pointLightCount;
-uniform bool useSpotLight;
-
-uniform bool useBlinn;
-
 uniform Material material;
 
 // Shadow Map
@@ -116,26 +106,22 @@ vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir)
 	// diffuse shading
 	float diff = max(dot( normal, lightDir), 0.0);
 	// specular shading
-	float spec = 0.0;
-	if( useBlinn )
-	{
-		vec3 halfwayDir = normalize( lightDir + viewDir );
-		spec = pow(max(dot(normal, halfwayDir), 0.0), material.shininess);
-	}
-	else
-	{
-		vec3 reflectDir = reflect(-lightDir, normal);
-		spec = pow(max(dot(viewDir, reflectDir),0.0), material.shininess);
-	}
+#ifdef USE_BLINN
+	vec3 halfwayDir = normalize( lightDir + viewDir );
+	float spec = pow(max(dot(normal, halfwayDir), 0.0), material.shininess);
+#else
+	vec3 reflectDir = reflect(-lightDir, normal);
+	float spec = pow(max(dot(viewDir, reflectDir),0.0), material.shininess);
+#endif
 	// combine results
+#ifdef USE_PCF
 	float shadow = ShadowCalculationPCF(FragPosLightSpace, normal, lightDir);
+#else
+	float shadow = ShadowCalculation(FragPosLightSpace, normal, lightDir);
+#endif
 	vec3 ambient = (light.ambient) * vec3(texture(material.diffuse, TexCoords));
 	vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, TexCoords));
 	vec3 specularColor = vec3(1.0f);
-	if( material.useSpecular )
-	{
-		specularColor = vec3(texture(material.specular, TexCoords));
-	}
 	vec3 specular = light.specular * spec * specularColor;
 
 	return (ambient + (1.0 - shadow) * (diffuse + specular));
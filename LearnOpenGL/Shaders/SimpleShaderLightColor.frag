@@ -20,44 +20,7 @@ struct Material {
 	float shininess;
 };
 
-// Directional light structure
-struct DirLight {
-	vec3 direction;
-
-	vec3 ambient;
-	vec3 diffuse;
-	vec3 specular;
-};
-
-// Point Light
-struct PointLight{
-	vec3 position;
-
-	float constant;
-	float linear;
-	float quadratic;
-
-	vec3 ambient;
-	vec3 diffuse;
-	vec3 specular;
-};
-
-// Spot Light
-struct SpotLight{
-	vec3 position;
-	vec3 direction;
-
-	float cutOff;
-	float outerCutOff;
-
-	vec3 ambient;
-	vec3 diffuse;
-	vec3 specular;
-
-	float constant;
-	float linear;
-	float quadratic;
-};
+#include "Include/Lights.glsl"
 
 struct Light {
 	vec3 position;
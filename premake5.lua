@@ -15,6 +15,348 @@ newaction {
     end
 }
 
+-- Offline shader validation, run with "premake5 shaders" before shipping shader changes
+shader_dir = "./LearnOpenGL/Shaders"
+spirv_dir = shader_dir .. "/SPIRV"
+
+newoption {
+    trigger = "glslang",
+    value = "PATH",
+    description = "glslangValidator executable used by the shaders action"
+}
+
+local shader_stages = {
+    [".vs"] = "vert",
+    [".frag"] = "frag",
+    [".gs"] = "geom",
+    [".comp"] = "comp"
+}
+
+-- Expands #include like Shader::preprocessFile: once per file, with #line source numbers
+local function preprocess_shader(file, included, files)
+    local source = io.readfile(file)
+    if source == nil then
+        return nil, "cannot read " .. file
+    end
+    included[file] = true
+    table.insert(files, file)
+    local file_index = #files - 1
+
+    local out = {}
+    local line_number = 0
+    for line in (source .. "\n"):gmatch("(.-)\r?\n") do
+        line_number = line_number + 1
+        local include = line:match('^%s*#include%s*["<](.-)[">]')
+        if include == nil then
+            table.insert(out, line)
+        else
+            local include_path = path.normalize(path.join(path.getdirectory(file), include))
+            if included[include_path] then
+                table.insert(out, "")
+            else
+                table.insert(out, "#line 1 " .. #files)
+                local include_source, err = preprocess_shader(include_path, included, files)
+                if include_source == nil then
+                    return nil, err
+                end
+                table.insert(out, include_source)
+                table.insert(out, "#line " .. (line_number + 1) .. " " .. file_index)
+            end
+        end
+    end
+    return table.concat(out, "\n")
+end
+
+-- Same placement as Shader::injectDefines: right after #version, line numbers kept
+local function inject_define(source, define)
+    if define == nil then
+        return source
+    end
+    local version_end = source:find("\n", source:find("#version") or 1) or #source
+    local head = source:sub(1, version_end)
+    local _, newlines = head:gsub("\n", "")
+    return head .. "#define " .. define .. "\n#line " .. (newlines + 1) .. "\n" .. source:sub(version_end + 1)
+end
+
+newaction {
+    trigger = "shaders",
+    description = "validate every shader with glslang and emit GL SPIR-V where possible",
+    execute = function()
+        local glslang = _OPTIONS["glslang"] or "glslangValidator"
+        local cache_dir = project_dir .. "/ShaderCache"
+        local failed = 0
+        local validated = 0
+        local spirv = 0
+
+        for _, file in ipairs(os.matchfiles(shader_dir .. "/**")) do
+            local stage = shader_stages[path.getextension(file)]
+            if stage ~= nil then
+                local relative = path.getrelative(shader_dir, file)
+                local source, err = preprocess_shader(path.normalize(file), {}, {})
+                if source == nil then
+                    print("ERROR: " .. relative .. ": " .. err)
+                    failed = failed + 1
+                else
+                    -- Validate the base variant and every permutation define on its own
+                    local variants = { false }
+                    for define in source:gmatch("#ifn?def%s+([%w_]+)") do
+                        table.insert(variants, define)
+                    end
+
+                    for _, define in ipairs(variants) do
+                        local expanded = path.join(cache_dir, relative .. (define and ("." .. define) or "") .. "." .. stage)
+                        os.mkdir(path.getdirectory(expanded))
+                        io.writefile(expanded, inject_define(source, define or nil))
+
+                        local output, code = os.outputof(glslang .. " -S " .. stage .. " \"" .. expanded .. "\"")
+                        if code ~= 0 then
+                            print("ERROR: " .. relative .. (define and (" [" .. define .. "]") or ""))
+                            print(output)
+                            failed = failed + 1
+                        else
+                            validated = validated + 1
+                        end
+                    end
+
+                    -- GL SPIR-V needs explicit locations on every uniform and varying,
+                    -- shaders that do not have them yet simply keep loading from GLSL
+                    local target = path.join(spirv_dir, relative .. ".spv")
+                    os.mkdir(path.getdirectory(target))
+                    local output, code = os.outputof(glslang .. " -G -S " .. stage .. " -o \"" .. target .. "\" \"" .. path.join(cache_dir, relative .. "." .. stage) .. "\"")
+                    if code == 0 then
+                        spirv = spirv + 1
+                    else
+                        os.remove(target)
+                    end
+                end
+            end
+        end
+
+        print(validated .. " shader variant(s) validated, " .. spirv .. " SPIR-V module(s) written to " .. spirv_dir)
+        if failed > 0 then
+            print(failed .. " shader variant(s) failed validation")
+            os.exit(1)
+        end
+    end
+}
+
+-- Headless benchmark of every built demo, run with "premake5 benchmark" after a build
+newoption {
+    trigger = "frames",
+    value = "COUNT",
+    description = "Frames each demo renders in the benchmark and regression actions"
+}
+
+newoption {
+    trigger = "config",
+    value = "NAME",
+    description = "Build configuration the benchmark, regression and checks actions run, Release by default"
+}
+
+newoption {
+    trigger = "context",
+    value = "API",
+    description = "Context API of the benchmark and regression actions: egl, or osmesa for a machine without display or GPU"
+}
+
+newoption {
+    trigger = "cameras",
+    value = "DIR",
+    description = "Camera paths of the benchmark and regression actions, <demo>.camp recorded with --record-camera, scripted camera for the others"
+}
+
+-- Runs every built demo with the benchmark arguments, returns the JSON reports and the demos that failed
+local function run_benchmarks(config, out_dir, arguments)
+    os.mkdir(out_dir)
+    arguments = " --benchmark" .. (_OPTIONS["frames"] ~= nil and "=" .. _OPTIONS["frames"] or "") .. arguments
+    if _OPTIONS["context"] ~= nil then
+        arguments = arguments .. " --benchmark-context " .. _OPTIONS["context"]
+    end
+
+    -- Demos load their resources relative to ./LearnOpenGL, like debugdir
+    local reports = {}
+    local failed = 0
+    for _, binary in ipairs(os.matchfiles("Binaries/" .. config .. "/LearnOpenGL-*")) do
+        local extension = path.getextension(binary)
+        if (extension == "" or extension == ".exe") and path.getbasename(binary) ~= "LearnOpenGL-Checks" then
+            local demo = path.getbasename(binary)
+            local report = path.join(out_dir, demo .. ".json")
+            os.remove(report)
+            local camera_arguments = ""
+            if _OPTIONS["cameras"] ~= nil then
+                local camera = path.getabsolute(path.join(_OPTIONS["cameras"], demo .. ".camp"))
+                if os.isfile(camera) then
+                    camera_arguments = " --benchmark-camera \"" .. camera .. "\""
+                end
+            end
+            local command = "cd LearnOpenGL && \"" .. path.getabsolute(binary) .. "\"" .. arguments .. camera_arguments .. " --benchmark-out \"" .. report .. "\""
+            local output, code = os.outputof(command)
+            local text = io.readfile(report)
+            if code ~= 0 or text == nil then
+                print("ERROR: " .. demo)
+                print(output)
+                failed = failed + 1
+            else
+                print(demo .. " done")
+                table.insert(reports, text)
+            end
+        end
+    end
+    return reports, failed
+end
+
+newaction {
+    trigger = "benchmark",
+    description = "run every demo offscreen for a fixed number of frames and collect the JSON reports",
+    execute = function()
+        local config = _OPTIONS["config"] or "Release"
+        local out_dir = path.getabsolute(project_dir .. "/Benchmark/" .. config)
+        local reports, failed = run_benchmarks(config, out_dir, "")
+
+        -- One file per run to diff against another build
+        io.writefile(path.join(out_dir, "Benchmark.json"), "[\n" .. table.concat(reports, ",\n") .. "]\n")
+        print(#reports .. " demo(s) benchmarked, reports in " .. out_dir)
+        if failed > 0 then
+            print(failed .. " demo(s) failed")
+            os.exit(1)
+        end
+    end
+}
+
+-- Output and performance check of every built demo, run with "premake5 regression" before merging render changes
+newoption {
+    trigger = "golden",
+    value = "DIR",
+    description = "Golden images of the regression action, LearnOpenGL/Golden by default; a missing one fails the demo"
+}
+
+newoption {
+    trigger = "update-golden",
+    description = "Make the regression action replace the golden images and their renderer with what this build renders"
+}
+
+newoption {
+    trigger = "baseline",
+    value = "FILE",
+    description = "Benchmark.json the regression action wrote for the reference build, frame times and primitives are compared to it"
+}
+
+newoption {
+    trigger = "max-frame-time",
+    value = "PERCENT",
+    description = "Median frame time increase over the baseline the regression action tolerates, 10 by default"
+}
+
+newoption {
+    trigger = "max-primitives",
+    value = "PERCENT",
+    description = "Mean primitives per frame increase over the baseline the regression action tolerates, 1 by default"
+}
+
+newaction {
+    trigger = "regression",
+    description = "compare every demo against its golden images and the baseline timings, fails on any regression",
+    execute = function()
+        -- Golden images are only comparable on the rasterizer that made them, the software one by default
+        if _OPTIONS["context"] == nil then
+            _OPTIONS["context"] = "osmesa"
+        end
+
+        local config = _OPTIONS["config"] or "Release"
+        local out_dir = path.getabsolute(project_dir .. "/Regression/" .. config)
+        local golden_dir = path.getabsolute(_OPTIONS["golden"] or "./LearnOpenGL/Golden")
+        local golden_arguments = " --benchmark-golden \"" .. golden_dir .. "\""
+        if _OPTIONS["update-golden"] ~= nil then
+            os.mkdir(golden_dir)
+            golden_arguments = golden_arguments .. " --benchmark-update-golden"
+        elseif not os.isdir(golden_dir) then
+            print("ERROR: no golden images in " .. golden_dir .. ", write them with --update-golden")
+            os.exit(1)
+        end
+        local reports, failed = run_benchmarks(config, out_dir, golden_arguments)
+        io.writefile(path.join(out_dir, "Benchmark.json"), "[\n" .. table.concat(reports, ",\n") .. "]\n")
+
+        local baseline = {}
+        if _OPTIONS["baseline"] ~= nil then
+            local text = io.readfile(_OPTIONS["baseline"])
+            local entries = text and json.decode(text)
+            if entries == nil then
+                print("ERROR: cannot read baseline " .. _OPTIONS["baseline"])
+                os.exit(1)
+            end
+            for _, entry in ipairs(entries) do
+                baseline[entry.demo] = entry
+            end
+        else
+            print("No --baseline given, only images are checked")
+        end
+
+        local max_frame_time = 1 + tonumber(_OPTIONS["max-frame-time"] or "10") / 100
+        local max_primitives = 1 + tonumber(_OPTIONS["max-primitives"] or "1") / 100
+        for _, text in ipairs(reports) do
+            local report = json.decode(text)
+            local problems = {}
+            if report.imagesFailed > 0 then
+                table.insert(problems, report.imagesFailed .. " image(s) differ from or are missing in " .. golden_dir)
+            end
+            if report.goldenRenderer ~= report.renderer then
+                table.insert(problems, "rendered on " .. report.renderer .. ", golden images are from " .. (report.goldenRenderer ~= "" and report.goldenRenderer or "an unknown renderer"))
+            end
+
+            local base = baseline[report.demo]
+            if base ~= nil then
+                if report.frameMilliseconds.p50 ~= nil and base.frameMilliseconds.p50 ~= nil
+                    and report.frameMilliseconds.p50 > base.frameMilliseconds.p50 * max_frame_time then
+                    table.insert(problems, string.format("median frame %.3f ms, baseline %.3f ms", report.frameMilliseconds.p50, base.frameMilliseconds.p50))
+                end
+                if report.primitives.mean > base.primitives.mean * max_primitives then
+                    table.insert(problems, string.format("%.0f primitives per frame, baseline %.0f", report.primitives.mean, base.primitives.mean))
+                end
+            end
+
+            if #problems > 0 then
+                print("ERROR: " .. report.demo .. ": " .. table.concat(problems, ", "))
+                failed = failed + 1
+            end
+        end
+
+        if _OPTIONS["update-golden"] ~= nil then
+            print("Golden images of " .. #reports .. " demo(s) written to " .. golden_dir)
+        end
+        print(#reports .. " demo(s) checked, reports and differing images in " .. out_dir)
+        if failed > 0 then
+            print(failed .. " demo(s) regressed or failed to run")
+            os.exit(1)
+        end
+    end
+}
+
+newaction {
+    trigger = "checks",
+    description = "run the checks of the shared code, LearnOpenGL-Checks, and fail if any of them does",
+    execute = function()
+        local config = _OPTIONS["config"] or "Release"
+        local binary = nil
+        for _, file in ipairs(os.matchfiles("Binaries/" .. config .. "/LearnOpenGL-Checks*")) do
+            local extension = path.getextension(file)
+            if extension == "" or extension == ".exe" then
+                binary = file
+            end
+        end
+        if binary == nil then
+            print("ERROR: LearnOpenGL-Checks is not built in Binaries/" .. config)
+            os.exit(1)
+        end
+
+        -- Shaders load relative to ./LearnOpenGL, like debugdir
+        local output, code = os.outputof("cd LearnOpenGL && \"" .. path.getabsolute(binary) .. "\"")
+        print(output)
+        if code ~= 0 then
+            os.exit(1)
+        end
+    end
+}
+
 workspace "LearnOpenGL"
     location ("./")
     configurations { "Debug", "Release" }
@@ -416,3 +758,19 @@ project "LearnOpenGL-PBR_IBL"
     }
 
     setup_project()
+
+group "Checks"
+
+-- Checks of the shared code, not a demo: "premake5 checks" runs it
+project "LearnOpenGL-Checks"
+    location (project_dir .. "/".. _ACTION)
+    kind "ConsoleApp"
+    language "C++"
+
+    files
+    {
+        "LearnOpenGL/Common/**",
+        "LearnOpenGL/LearnOpenGL-Checks/**"
+    }
+
+    setup_project()